@@ -189,24 +189,52 @@ void LLCharacter::requestStopMotion( LLMotion* motion)
 // updateMotions()
 //-----------------------------------------------------------------------------
 void LLCharacter::updateMotions(e_update_t update_type)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    if (prepareMotions(update_type))
+    {
+        evaluateMotions(update_type);
+        finishMotions();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+bool LLCharacter::prepareMotions(e_update_t update_type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
     if (update_type == HIDDEN_UPDATE)
     {
         mMotionController.updateMotionsMinimal();
+        return false;
     }
-    else
+
+    // unpause if the number of outstanding pause requests has dropped to the initial one
+    if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
     {
-        // unpause if the number of outstanding pause requests has dropped to the initial one
-        if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
-        {
-            mMotionController.unpauseAllMotions();
-        }
-        bool force_update = (update_type == FORCE_UPDATE);
-        {
-            mMotionController.updateMotions(force_update);
-        }
+        mMotionController.unpauseAllMotions();
     }
+    return mMotionController.prepareMotions();
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLCharacter::evaluateMotions(e_update_t update_type)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    llassert(update_type != HIDDEN_UPDATE);
+    bool force_update = (update_type == FORCE_UPDATE);
+    mMotionController.evaluateMotions(force_update);
+}
+
+//-----------------------------------------------------------------------------
+// finishMotions()
+//-----------------------------------------------------------------------------
+void LLCharacter::finishMotions()
+{
+    mMotionController.finishMotions();
 }
 
 
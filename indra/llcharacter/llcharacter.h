@@ -54,6 +54,12 @@ typedef LLPointer<LLPauseRequestHandle> LLAnimPauseRequest;
 
 //-----------------------------------------------------------------------------
 // class LLCharacter
+// A character, its motion controller, motions and joints are updated by one
+// thread at a time but not necessarily the main one: evaluateMotions() may
+// run on a worker while other characters are evaluated on other workers.
+// Creating, starting, stopping, loading and deleting motions stay on the
+// main thread, see finishMotions().  Characters animated on workers defer
+// updateVisualParams() calls made by their motions to the main thread too.
 //-----------------------------------------------------------------------------
 class LLCharacter
 {
@@ -158,6 +164,14 @@ class LLCharacter
     enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
     void updateMotions(e_update_t update_type);
 
+    // updateMotions() split for characters animated on worker threads, see
+    // LLMotionController::prepareMotions().  prepareMotions() is main thread
+    // only and returns true when evaluateMotions() has work to do;
+    // finishMotions() follows evaluateMotions() on the main thread.
+    bool prepareMotions(e_update_t update_type);
+    void evaluateMotions(e_update_t update_type);
+    void finishMotions();
+
     LLAnimPauseRequest requestPause();
     BOOL areAnimationsPaused() const { return mMotionController.isPaused(); }
     void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
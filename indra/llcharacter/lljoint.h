@@ -86,6 +86,9 @@ inline bool operator!=(const LLVector3OverrideMap& a, const LLVector3OverrideMap
 
 //-----------------------------------------------------------------------------
 // class LLJoint
+// A joint is only ever updated by the thread updating its skeleton.  World
+// matrices are refreshed lazily through the parent chain, so reading one
+// from another skeleton while that skeleton is being animated is a race.
 //-----------------------------------------------------------------------------
 LL_ALIGN_PREFIX(16)
 class LLJoint
@@ -158,9 +161,10 @@ class LLJoint
     typedef std::vector<LLJoint*> joints_t;
     joints_t mChildren;
 
-    // debug statics
-    static S32      sNumTouches;
-    static S32      sNumUpdates;
+    // debug statics, per thread so skeletons updating on worker threads
+    // don't share them; those add their counts to the main thread's
+    static thread_local S32 sNumTouches;
+    static thread_local S32 sNumUpdates;
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
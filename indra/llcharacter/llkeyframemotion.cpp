@@ -39,6 +39,8 @@
 #include "llendianswizzle.h"
 #include "llkeyframemotion.h"
 #include "llquantize.h"
+#include "llthread.h"
+#include "llvector4a.h"
 #include "m3math.h"
 #include "message.h"
 #include "llfilesystem.h"
@@ -47,6 +49,10 @@
 // Static Definitions
 //-----------------------------------------------------------------------------
 LLKeyframeDataCache::keyframe_data_map_t    LLKeyframeDataCache::sKeyframeDataMap;
+std::list<LLUUID>                           LLKeyframeDataCache::sIdle;
+U64                                         LLKeyframeDataCache::sBytes = 0;
+U64                                         LLKeyframeDataCache::sLimit = 0;
+bool                                        LLKeyframeDataCache::sDiskCacheEnabled = false;
 
 //-----------------------------------------------------------------------------
 // Globals
@@ -61,6 +67,28 @@ static F32 MIN_ACCELERATION_SQUARED = 0.0005f * 0.0005f;
 
 static F32 MAX_CONSTRAINTS = 10;
 
+// Decoded keyframe data in the disk cache: a header, then
+// JointMotionList::pack().  Bump the version whenever pack() changes.
+static const U32 DECODED_KEYFRAME_MAGIC = 0x4b465044;   // "DPFK"
+static const U32 DECODED_KEYFRAME_VERSION = 1;
+static const S32 DECODED_KEYFRAME_HEADER_SIZE = 5 * sizeof(U32);
+// Upper bound on stored keys per curve, well past anything the uploader makes
+static const U32 DECODED_KEYFRAME_MAX_KEYS = 1 << 20;
+
+// Decoded copies are stored under the asset id combined with this
+static const LLUUID DECODED_KEYFRAME_ID("3a6f2b4e-8c1d-4f7a-9e25-b0d4c7e81f63");
+
+// FNV-1a over the payload, catches truncated and damaged files
+static U32 decoded_keyframe_checksum(const U8* data, S32 size)
+{
+    U32 hash = 2166136261u;
+    for (S32 i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
 //-----------------------------------------------------------------------------
 // JointMotionList
 //-----------------------------------------------------------------------------
@@ -73,7 +101,8 @@ LLKeyframeMotion::JointMotionList::JointMotionList()
       mEaseOutDuration(0.f),
       mBasePriority(LLJoint::LOW_PRIORITY),
       mHandPose(LLHandMotion::HAND_POSE_SPREAD),
-      mMaxPriority(LLJoint::LOW_PRIORITY)
+      mMaxPriority(LLJoint::LOW_PRIORITY),
+      mUsers(0)
 {
 }
 
@@ -121,16 +150,418 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
     return total_size;
 }
 
+U64 LLKeyframeMotion::JointMotionList::getAllocatedBytes() const
+{
+    U64 bytes = sizeof(JointMotionList) + mEmoteName.capacity() +
+                mJointMotionArray.capacity() * sizeof(JointMotion*);
+    for (const JointMotion* joint_motion : mJointMotionArray)
+    {
+        bytes += sizeof(JointMotion) + joint_motion->mJointName.capacity();
+        bytes += joint_motion->mRotationCurve.mKeys.size() * sizeof(RotationCurve::key_map_t::value_type);
+        bytes += joint_motion->mPositionCurve.mKeys.size() * sizeof(PositionCurve::key_map_t::value_type);
+        bytes += joint_motion->mScaleCurve.mKeys.size() * sizeof(ScaleCurve::key_map_t::value_type);
+    }
+    for (const JointConstraintSharedData* constraint : mConstraints)
+    {
+        bytes += sizeof(JointConstraintSharedData) + (constraint->mChainLength + 1) * sizeof(S32);
+    }
+    return bytes;
+}
+
+//-----------------------------------------------------------------------------
+// JointMotionList pack() and unpack()
+//-----------------------------------------------------------------------------
+static F32* key_components(LLVector3& value)            { return value.mV; }
+static const F32* key_components(const LLVector3& value) { return value.mV; }
+static F32* key_components(LLQuaternion& value)         { return value.mQ; }
+static const F32* key_components(const LLQuaternion& value) { return value.mQ; }
+
+// Keys go out as one block of time and value floats
+template<typename T>
+static BOOL pack_curve(LLDataPacker& dp, const LLKeyframeMotion::Curve<T>& curve)
+{
+    const U32 components = sizeof(T) / sizeof(F32);
+    std::vector<F32> values;
+    values.reserve(curve.mKeys.size() * (components + 1));
+    for (const auto& key : curve.mKeys)
+    {
+        values.push_back(key.first);
+        const F32* value = key_components(key.second.mValue);
+        values.insert(values.end(), value, value + components);
+    }
+
+    BOOL success = dp.packS32(curve.mNumKeys, "num_keys");
+    success &= dp.packU8((U8)curve.mInterpolationType, "interpolation");
+    success &= dp.packU32((U32)curve.mKeys.size(), "stored_keys");
+    if (!values.empty())
+    {
+        success &= dp.packBinaryDataFixed((const U8*)values.data(), (S32)(values.size() * sizeof(F32)), "keys");
+    }
+    return success;
+}
+
+template<typename T>
+static BOOL unpack_curve(LLDataPacker& dp, LLKeyframeMotion::Curve<T>& curve)
+{
+    const U32 components = sizeof(T) / sizeof(F32);
+    U8 interpolation = 0;
+    U32 stored_keys = 0;
+    if (!dp.unpackS32(curve.mNumKeys, "num_keys") ||
+        !dp.unpackU8(interpolation, "interpolation") ||
+        !dp.unpackU32(stored_keys, "stored_keys") ||
+        curve.mNumKeys < 0 || stored_keys > (U32)curve.mNumKeys ||
+        stored_keys > DECODED_KEYFRAME_MAX_KEYS || interpolation > LLKeyframeMotion::IT_SPLINE)
+    {
+        return FALSE;
+    }
+    curve.mInterpolationType = (LLKeyframeMotion::InterpolationType)interpolation;
+
+    if (stored_keys)
+    {
+        std::vector<F32> values(stored_keys * (components + 1));
+        if (!dp.unpackBinaryDataFixed((U8*)values.data(), (S32)(values.size() * sizeof(F32)), "keys"))
+        {
+            return FALSE;
+        }
+        for (U32 k = 0; k < stored_keys; ++k)
+        {
+            const F32* value = &values[k * (components + 1)];
+            typename LLKeyframeMotion::Curve<T>::Key key;
+            key.mTime = value[0];
+            std::copy(value + 1, value + 1 + components, key_components(key.mValue));
+            curve.mKeys[key.mTime] = key;
+        }
+    }
+    return TRUE;
+}
+
+BOOL LLKeyframeMotion::JointMotionList::pack(LLDataPacker& dp) const
+{
+    BOOL success = TRUE;
+    success &= dp.packF32(mDuration, "duration");
+    success &= dp.packS32(mLoop, "loop");
+    success &= dp.packF32(mLoopInPoint, "loop_in_point");
+    success &= dp.packF32(mLoopOutPoint, "loop_out_point");
+    success &= dp.packF32(mEaseInDuration, "ease_in_duration");
+    success &= dp.packF32(mEaseOutDuration, "ease_out_duration");
+    success &= dp.packS32(mBasePriority, "base_priority");
+    success &= dp.packS32(mMaxPriority, "max_priority");
+    success &= dp.packU32(mHandPose, "hand_pose");
+    success &= dp.packString(mEmoteName, "emote_name");
+    success &= dp.packVector3(mPelvisBBox.getMin(), "pelvis_min");
+    success &= dp.packVector3(mPelvisBBox.getMax(), "pelvis_max");
+
+    success &= dp.packU32(getNumJointMotions(), "num_joints");
+    for (const JointMotion* joint_motion : mJointMotionArray)
+    {
+        success &= dp.packString(joint_motion->mJointName, "joint_name");
+        success &= dp.packU32(joint_motion->mUsage, "usage");
+        success &= dp.packS32(joint_motion->mPriority, "joint_priority");
+        success &= pack_curve(dp, joint_motion->mRotationCurve);
+        success &= pack_curve(dp, joint_motion->mPositionCurve);
+        success &= pack_curve(dp, joint_motion->mScaleCurve);
+    }
+
+    success &= dp.packU32((U32)mConstraints.size(), "num_constraints");
+    for (const JointConstraintSharedData* constraint : mConstraints)
+    {
+        success &= dp.packS32(constraint->mChainLength, "chain_length");
+        success &= dp.packU8((U8)constraint->mConstraintType, "constraint_type");
+        success &= dp.packU8((U8)constraint->mConstraintTargetType, "target_type");
+        success &= dp.packS32(constraint->mSourceConstraintVolume, "source_volume");
+        success &= dp.packVector3(constraint->mSourceConstraintOffset, "source_offset");
+        success &= dp.packS32(constraint->mTargetConstraintVolume, "target_volume");
+        success &= dp.packVector3(constraint->mTargetConstraintOffset, "target_offset");
+        success &= dp.packVector3(constraint->mTargetConstraintDir, "target_dir");
+        success &= dp.packU8(constraint->mUseTargetOffset ? 1 : 0, "use_target_offset");
+        success &= dp.packF32(constraint->mEaseInStartTime, "ease_in_start");
+        success &= dp.packF32(constraint->mEaseInStopTime, "ease_in_stop");
+        success &= dp.packF32(constraint->mEaseOutStartTime, "ease_out_start");
+        success &= dp.packF32(constraint->mEaseOutStopTime, "ease_out_stop");
+        for (S32 i = 0; i < constraint->mChainLength + 1; ++i)
+        {
+            success &= dp.packS32(constraint->mJointStateIndices[i], "joint_state_index");
+        }
+    }
+    return success;
+}
+
+BOOL LLKeyframeMotion::JointMotionList::unpack(LLDataPacker& dp, LLCharacter* character)
+{
+    S32 loop = 0;
+    S32 base_priority = 0;
+    S32 max_priority = 0;
+    U32 hand_pose = 0;
+    LLVector3 pelvis_min, pelvis_max;
+    if (!dp.unpackF32(mDuration, "duration") ||
+        !dp.unpackS32(loop, "loop") ||
+        !dp.unpackF32(mLoopInPoint, "loop_in_point") ||
+        !dp.unpackF32(mLoopOutPoint, "loop_out_point") ||
+        !dp.unpackF32(mEaseInDuration, "ease_in_duration") ||
+        !dp.unpackF32(mEaseOutDuration, "ease_out_duration") ||
+        !dp.unpackS32(base_priority, "base_priority") ||
+        !dp.unpackS32(max_priority, "max_priority") ||
+        !dp.unpackU32(hand_pose, "hand_pose") ||
+        !dp.unpackString(mEmoteName, "emote_name") ||
+        !dp.unpackVector3(pelvis_min, "pelvis_min") ||
+        !dp.unpackVector3(pelvis_max, "pelvis_max") ||
+        hand_pose >= LLHandMotion::NUM_HAND_POSES)
+    {
+        return FALSE;
+    }
+    mLoop = loop;
+    mBasePriority = (LLJoint::JointPriority)base_priority;
+    mMaxPriority = (LLJoint::JointPriority)max_priority;
+    mHandPose = (LLHandMotion::eHandPose)hand_pose;
+    mPelvisBBox.setMin(pelvis_min);
+    mPelvisBBox.setMax(pelvis_max);
+
+    U32 num_motions = 0;
+    if (!dp.unpackU32(num_motions, "num_joints") ||
+        num_motions == 0 || num_motions > LL_CHARACTER_MAX_ANIMATED_JOINTS)
+    {
+        return FALSE;
+    }
+    mJointMotionArray.reserve(num_motions);
+    for (U32 i = 0; i < num_motions; ++i)
+    {
+        JointMotion* joint_motion = new JointMotion;
+        mJointMotionArray.push_back(joint_motion);
+
+        S32 priority = 0;
+        if (!dp.unpackString(joint_motion->mJointName, "joint_name") ||
+            !dp.unpackU32(joint_motion->mUsage, "usage") ||
+            !dp.unpackS32(priority, "joint_priority") ||
+            !unpack_curve(dp, joint_motion->mRotationCurve) ||
+            !unpack_curve(dp, joint_motion->mPositionCurve) ||
+            !unpack_curve(dp, joint_motion->mScaleCurve))
+        {
+            return FALSE;
+        }
+        joint_motion->mPriority = (LLJoint::JointPriority)priority;
+    }
+
+    U32 num_constraints = 0;
+    if (!dp.unpackU32(num_constraints, "num_constraints") || num_constraints > MAX_CONSTRAINTS)
+    {
+        return FALSE;
+    }
+    for (U32 c = 0; c < num_constraints; ++c)
+    {
+        auto constraintp = std::make_unique<JointConstraintSharedData>();
+        U8 type = 0;
+        U8 target_type = 0;
+        U8 use_target_offset = 0;
+        if (!dp.unpackS32(constraintp->mChainLength, "chain_length") ||
+            !dp.unpackU8(type, "constraint_type") ||
+            !dp.unpackU8(target_type, "target_type") ||
+            !dp.unpackS32(constraintp->mSourceConstraintVolume, "source_volume") ||
+            !dp.unpackVector3(constraintp->mSourceConstraintOffset, "source_offset") ||
+            !dp.unpackS32(constraintp->mTargetConstraintVolume, "target_volume") ||
+            !dp.unpackVector3(constraintp->mTargetConstraintOffset, "target_offset") ||
+            !dp.unpackVector3(constraintp->mTargetConstraintDir, "target_dir") ||
+            !dp.unpackU8(use_target_offset, "use_target_offset") ||
+            !dp.unpackF32(constraintp->mEaseInStartTime, "ease_in_start") ||
+            !dp.unpackF32(constraintp->mEaseInStopTime, "ease_in_stop") ||
+            !dp.unpackF32(constraintp->mEaseOutStartTime, "ease_out_start") ||
+            !dp.unpackF32(constraintp->mEaseOutStopTime, "ease_out_stop") ||
+            constraintp->mChainLength < 0 || (U32)constraintp->mChainLength > num_motions ||
+            type >= NUM_CONSTRAINT_TYPES || target_type >= NUM_CONSTRAINT_TARGET_TYPES)
+        {
+            return FALSE;
+        }
+        constraintp->mConstraintType = (EConstraintType)type;
+        constraintp->mConstraintTargetType = (EConstraintTargetType)target_type;
+        constraintp->mUseTargetOffset = use_target_offset;
+
+        // Volumes are ids into the skeleton the list was decoded against
+        if (!character || !character->findCollisionVolume(constraintp->mSourceConstraintVolume) ||
+            (constraintp->mConstraintTargetType == CONSTRAINT_TARGET_TYPE_BODY &&
+             !character->findCollisionVolume(constraintp->mTargetConstraintVolume)))
+        {
+            return FALSE;
+        }
+
+        constraintp->mJointStateIndices = new S32[constraintp->mChainLength + 1];
+        for (S32 i = 0; i < constraintp->mChainLength + 1; ++i)
+        {
+            S32& index = constraintp->mJointStateIndices[i];
+            if (!dp.unpackS32(index, "joint_state_index") || index < 0 || (U32)index >= num_motions)
+            {
+                return FALSE;
+            }
+        }
+        mConstraints.push_back(constraintp.release());
+    }
+    return TRUE;
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // JointMotion class
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// LLKeyframeMotionLerp::nlerp()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotionLerp::nlerp(U32 count, const F32* t, const LLQuaternion* const* before, const LLQuaternion* const* after, LLQuaternion* out)
+{
+    // Same arithmetic as lerp() and LLQuaternion::normalize(), in the same
+    // order, with the four quaternions of a block transposed so each
+    // LLVector4a holds one component of all of them
+    LLVector4a one, zero, mag_threshold, unit_threshold;
+    one.splat(1.f);
+    zero.clear();
+    mag_threshold.splat(FP_MAG_THRESHOLD);
+    unit_threshold.splat(ONE_PART_IN_A_MILLION);
+
+    for (U32 first = 0; first < count; first += 4)
+    {
+        // A short last block repeats its last pair in the spare lanes
+        U32 lanes = llmin(count - first, 4U);
+        U32 i0 = first;
+        U32 i1 = first + llmin(1U, lanes - 1);
+        U32 i2 = first + llmin(2U, lanes - 1);
+        U32 i3 = first + llmin(3U, lanes - 1);
+
+        LLQuad ax = _mm_loadu_ps(before[i0]->mQ);
+        LLQuad ay = _mm_loadu_ps(before[i1]->mQ);
+        LLQuad az = _mm_loadu_ps(before[i2]->mQ);
+        LLQuad aw = _mm_loadu_ps(before[i3]->mQ);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        LLQuad bx = _mm_loadu_ps(after[i0]->mQ);
+        LLQuad by = _mm_loadu_ps(after[i1]->mQ);
+        LLQuad bz = _mm_loadu_ps(after[i2]->mQ);
+        LLQuad bw = _mm_loadu_ps(after[i3]->mQ);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+        LLVector4a u, inv_u;
+        u = _mm_setr_ps(t[i0], t[i1], t[i2], t[i3]);
+        inv_u.setSub(one, u);
+
+        // r = t * q + (inv_t * p)
+        LLVector4a rx, ry, rz, rw, tmp;
+        rx.setMul(u, LLVector4a(bx));
+        tmp.setMul(inv_u, LLVector4a(ax));
+        rx.add(tmp);
+        ry.setMul(u, LLVector4a(by));
+        tmp.setMul(inv_u, LLVector4a(ay));
+        ry.add(tmp);
+        rz.setMul(u, LLVector4a(bz));
+        tmp.setMul(inv_u, LLVector4a(az));
+        rz.add(tmp);
+        rw.setMul(u, LLVector4a(bw));
+        tmp.setMul(inv_u, LLVector4a(aw));
+        rw.add(tmp);
+
+        LLVector4a mag;
+        mag.setMul(rx, rx);
+        tmp.setMul(ry, ry);
+        mag.add(tmp);
+        tmp.setMul(rz, rz);
+        mag.add(tmp);
+        tmp.setMul(rw, rw);
+        mag.add(tmp);
+        mag = _mm_sqrt_ps(mag);
+
+        // Renormalize only when far enough from unit length, fall back to
+        // identity for degenerate results
+        LLVector4a oomag, distance;
+        oomag.setDiv(one, mag);
+        distance.setSub(one, mag);
+        distance.setAbs(distance);
+        LLVector4Logical renormalize = distance.greaterThan(unit_threshold);
+        LLVector4Logical valid = mag.greaterThan(mag_threshold);
+
+        tmp.setMul(rx, oomag);
+        rx.setSelectWithMask(renormalize, tmp, rx);
+        rx.setSelectWithMask(valid, rx, zero);
+        tmp.setMul(ry, oomag);
+        ry.setSelectWithMask(renormalize, tmp, ry);
+        ry.setSelectWithMask(valid, ry, zero);
+        tmp.setMul(rz, oomag);
+        rz.setSelectWithMask(renormalize, tmp, rz);
+        rz.setSelectWithMask(valid, rz, zero);
+        tmp.setMul(rw, oomag);
+        rw.setSelectWithMask(renormalize, tmp, rw);
+        rw.setSelectWithMask(valid, rw, one);
+
+        LLQuad qr[4] = { rx, ry, rz, rw };
+        _MM_TRANSPOSE4_PS(qr[0], qr[1], qr[2], qr[3]);
+
+        // nlerp() takes the other way round with slerp() when the pair
+        // points into opposite hemispheres
+        LLVector4a dot;
+        dot.setMul(LLVector4a(ax), LLVector4a(bx));
+        tmp.setMul(LLVector4a(ay), LLVector4a(by));
+        dot.add(tmp);
+        tmp.setMul(LLVector4a(az), LLVector4a(bz));
+        dot.add(tmp);
+        tmp.setMul(LLVector4a(aw), LLVector4a(bw));
+        dot.add(tmp);
+        U32 negative = dot.lessThan(zero).getGatheredBits();
+
+        for (U32 lane = 0; lane < lanes; ++lane)
+        {
+            U32 i = first + lane;
+            if (negative & (1 << lane))
+            {
+                out[i] = slerp(t[i], *before[i], *after[i]);
+            }
+            else
+            {
+                _mm_storeu_ps(out[i].mQ, qr[lane]);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// RotationBatch
+//-----------------------------------------------------------------------------
+struct LLKeyframeMotion::RotationBatch
+{
+    // One SIMD block's worth, interpolated as soon as it fills up
+    static constexpr U32 SIZE = 4;
+
+    void add(LLJointState* joint_state, F32 u, const LLQuaternion& before, const LLQuaternion& after)
+    {
+        mStates[mCount] = joint_state;
+        mU[mCount] = u;
+        mBefore[mCount] = &before;
+        mAfter[mCount] = &after;
+        if (++mCount == SIZE)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (mCount)
+        {
+            LLQuaternion results[SIZE];
+            LLKeyframeMotionLerp::nlerp(mCount, mU, mBefore, mAfter, results);
+            for (U32 i = 0; i < mCount; ++i)
+            {
+                mStates[i]->setRotation(results[i]);
+            }
+            mCount = 0;
+        }
+    }
+
+    LLJointState*       mStates[SIZE];
+    F32                 mU[SIZE];
+    const LLQuaternion* mBefore[SIZE];
+    const LLQuaternion* mAfter[SIZE];
+    U32                 mCount = 0;
+};
+
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, U32* cursors, RotationBatch& rotations) const
 {
     // this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't
     // managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -146,7 +577,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
     {
-        joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+        joint_state->setScale( mScaleCurve.getValue( time, cursors[0] ) );
     }
 
     //-------------------------------------------------------------------------
@@ -154,7 +585,21 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
     {
-        joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+        const RotationKey* before;
+        const RotationKey* after;
+        F32 u;
+        if (!mRotationCurve.findKeys(time, cursors[1], before, after, u))
+        {
+            joint_state->setRotation( LLQuaternion() );
+        }
+        else if (!after || mRotationCurve.mInterpolationType == IT_STEP)
+        {
+            joint_state->setRotation( before->mValue );
+        }
+        else
+        {
+            rotations.add(joint_state, u, before->mValue, after->mValue);
+        }
     }
 
     //-------------------------------------------------------------------------
@@ -162,10 +607,34 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
     {
-        joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+        joint_state->setPosition( mPositionCurve.getValue( time, cursors[2] ) );
     }
 }
 
+//-----------------------------------------------------------------------------
+// JointMotionList::evaluate()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotionList::evaluate(F32 time, const LLPointer<LLJointState>* joint_states, U32* cursors, bool extended_joints) const
+{
+    RotationBatch rotations;
+
+    for (U32 i = 0; i < getNumJointMotions(); i++)
+    {
+        LLJointState* joint_state = joint_states[i];
+        if (!extended_joints)
+        {
+            LLJoint* joint = joint_state ? joint_state->getJoint() : NULL;
+            if (joint && joint->getSupport() == LLJoint::SUPPORT_EXTENDED)
+            {
+                continue;
+            }
+        }
+        getJointMotion(i)->update(joint_state, time, cursors + i * JointMotion::KEY_CURSORS, rotations);
+    }
+
+    rotations.flush();
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -199,6 +668,8 @@ LLKeyframeMotion::~LLKeyframeMotion()
 {
     for_each(mConstraints.begin(), mConstraints.end(), DeletePointer());
     mConstraints.clear();
+
+    LLKeyframeDataCache::releaseKeyframeData(getID(), mJointMotionList);
 }
 
 //-----------------------------------------------------------------------------
@@ -277,34 +748,15 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 
     LLKeyframeMotion::JointMotionList* joint_motion_list = LLKeyframeDataCache::getKeyframeData(getID());
 
-    if(joint_motion_list)
+    if (!joint_motion_list)
     {
-        // motion already existed in cache, so grab it
-        mJointMotionList = joint_motion_list;
-
-        mJointStates.reserve(mJointMotionList->getNumJointMotions());
+        // decoded in an earlier session?
+        joint_motion_list = LLKeyframeDataCache::loadKeyframeData(getID(), mCharacter);
+    }
 
-        // don't forget to allocate joint states
-        // set up joint states to point to character joints
-        for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-        {
-            JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-            if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
-            {
-                LLPointer<LLJointState> joint_state = new LLJointState;
-                mJointStates.push_back(joint_state);
-                joint_state->setJoint(joint);
-                joint_state->setUsage(joint_motion->mUsage);
-                joint_state->setPriority(joint_motion->mPriority);
-            }
-            else
-            {
-                // add dummy joint state with no associated joint
-                mJointStates.push_back(new LLJointState);
-            }
-        }
-        mAssetStatus = ASSET_LOADED;
-        setupPose();
+    if(joint_motion_list)
+    {
+        adoptKeyframeData(joint_motion_list);
         return STATUS_SUCCESS;
     }
 
@@ -363,10 +815,46 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 
     delete []anim_data;
 
+    LLKeyframeDataCache::saveKeyframeData(getID(), mJointMotionList);
+
     mAssetStatus = ASSET_LOADED;
     return STATUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+// adoptKeyframeData()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::adoptKeyframeData(JointMotionList* joint_motion_list)
+{
+    // motion already existed in cache, so grab it
+    LLKeyframeDataCache::useKeyframeData(getID(), joint_motion_list);
+    mJointMotionList = joint_motion_list;
+
+    mJointStates.reserve(mJointMotionList->getNumJointMotions());
+
+    // don't forget to allocate joint states
+    // set up joint states to point to character joints
+    for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
+    {
+        JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
+        if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
+        {
+            LLPointer<LLJointState> joint_state = new LLJointState;
+            mJointStates.push_back(joint_state);
+            joint_state->setJoint(joint);
+            joint_state->setUsage(joint_motion->mUsage);
+            joint_state->setPriority(joint_motion->mPriority);
+        }
+        else
+        {
+            // add dummy joint state with no associated joint
+            mJointStates.push_back(new LLJointState);
+        }
+    }
+    mAssetStatus = ASSET_LOADED;
+    setupPose();
+}
+
 //-----------------------------------------------------------------------------
 // setupPose()
 //-----------------------------------------------------------------------------
@@ -484,13 +972,15 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
-    llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-    for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+    U32 num_motions = mJointMotionList->getNumJointMotions();
+    llassert_always (num_motions <= mJointStates.size());
+    if (mKeyCursors.size() != num_motions * JointMotion::KEY_CURSORS)
     {
-        mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-                                                      time,
-                                                      mJointMotionList->mDuration );
+        mKeyCursors.assign(num_motions * JointMotion::KEY_CURSORS, 0);
     }
+    // the pose blender leaves extended joints alone at low animation LOD
+    bool extended_joints = mCharacter->getMotionController().getAnimateExtendedJoints();
+    mJointMotionList->evaluate(time, mJointStates.data(), mKeyCursors.data(), extended_joints);
 
     LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
     if (pose_priority)
@@ -1734,9 +2224,10 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
         }
     }
 
-    // *FIX: support cleanup of old keyframe data
+    LLKeyframeDataCache::releaseKeyframeData(getID(), mJointMotionList);
     mJointMotionList = joint_motion_list.release();
     LLKeyframeDataCache::addKeyframeData(getID(),  mJointMotionList);
+    LLKeyframeDataCache::useKeyframeData(getID(), mJointMotionList);
     mAssetStatus = ASSET_LOADED;
 
     setupPose();
@@ -2137,6 +2628,12 @@ void LLKeyframeMotion::onLoadComplete(const LLUUID& asset_uuid,
                 // asset already loaded
                 return;
             }
+            if (LLKeyframeMotion::JointMotionList* joint_motion_list = LLKeyframeDataCache::getKeyframeData(asset_uuid))
+            {
+                // another avatar's fetch of the same asset got here first
+                motionp->adoptKeyframeData(joint_motion_list);
+                return;
+            }
             LLFileSystem file(asset_uuid, type, LLFileSystem::READ);
             S32 size = file.getSize();
 
@@ -2149,6 +2646,7 @@ void LLKeyframeMotion::onLoadComplete(const LLUUID& asset_uuid,
             if (motionp->deserialize(dp, asset_uuid))
             {
                 motionp->mAssetStatus = ASSET_LOADED;
+                LLKeyframeDataCache::saveKeyframeData(asset_uuid, motionp->mJointMotionList);
             }
             else
             {
@@ -2189,7 +2687,7 @@ void LLKeyframeDataCache::dumpDiagInfo()
     {
         U32 joint_motion_kb;
 
-        LLKeyframeMotion::JointMotionList *motion_list_p = data_pair.second;
+        LLKeyframeMotion::JointMotionList *motion_list_p = data_pair.second.mList;
 
         LL_INFOS() << "Motion: " << data_pair.first << LL_ENDL;
 
@@ -2202,6 +2700,7 @@ void LLKeyframeDataCache::dumpDiagInfo()
     LL_INFOS() << "Motions\tTotal Size" << LL_ENDL;
     snprintf(buf, sizeof(buf), "%d\t\t%d bytes", (S32)sKeyframeDataMap.size(), total_size );        /* Flawfinder: ignore */
     LL_INFOS() << buf << LL_ENDL;
+    LL_INFOS() << "Unused: " << sIdle.size() << " motions, " << sBytes << " of " << sLimit << " bytes" << LL_ENDL;
     LL_INFOS() << "-----------------------------------------------------" << LL_ENDL;
 }
 
@@ -2211,7 +2710,76 @@ void LLKeyframeDataCache::dumpDiagInfo()
 //--------------------------------------------------------------------
 void LLKeyframeDataCache::addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* joint_motion_listp)
 {
-    sKeyframeDataMap[id] = joint_motion_listp;
+    llassert(on_main_thread());
+    keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
+    if (found_data != sKeyframeDataMap.end())
+    {
+        if (found_data->second.mList == joint_motion_listp)
+        {
+            return;
+        }
+        // two fetches of the same asset both decoded it, keep the newest
+        forget(found_data);
+    }
+
+    Entry entry;
+    entry.mList = joint_motion_listp;
+    entry.mBytes = joint_motion_listp->getAllocatedBytes();
+    entry.mIdle = sIdle.end();
+    sKeyframeDataMap.emplace(id, entry);
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::useKeyframeData()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::useKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* joint_motion_listp)
+{
+    llassert(on_main_thread());
+    if (!joint_motion_listp)
+    {
+        return;
+    }
+
+    if (joint_motion_listp->mUsers++ == 0)
+    {
+        keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
+        if (found_data != sKeyframeDataMap.end() && found_data->second.mList == joint_motion_listp &&
+            found_data->second.mIdle != sIdle.end())
+        {
+            sIdle.erase(found_data->second.mIdle);
+            found_data->second.mIdle = sIdle.end();
+            sBytes -= found_data->second.mBytes;
+        }
+    }
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::releaseKeyframeData()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::releaseKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* joint_motion_listp)
+{
+    llassert(on_main_thread());
+    // lists handed straight to a motion were never counted
+    if (!joint_motion_listp || joint_motion_listp->mUsers <= 0)
+    {
+        return;
+    }
+
+    if (--joint_motion_listp->mUsers == 0)
+    {
+        keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
+        if (found_data == sKeyframeDataMap.end() || found_data->second.mList != joint_motion_listp)
+        {
+            // replaced or removed while in use
+            delete joint_motion_listp;
+            return;
+        }
+
+        sIdle.push_front(id);
+        found_data->second.mIdle = sIdle.begin();
+        sBytes += found_data->second.mBytes;
+        trim();
+    }
 }
 
 //--------------------------------------------------------------------
@@ -2219,11 +2787,11 @@ void LLKeyframeDataCache::addKeyframeData(const LLUUID& id, LLKeyframeMotion::Jo
 //--------------------------------------------------------------------
 void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 {
+    llassert(on_main_thread());
     keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
     if (found_data != sKeyframeDataMap.end())
     {
-        delete found_data->second;
-        sKeyframeDataMap.erase(found_data);
+        forget(found_data);
     }
 }
 
@@ -2232,12 +2800,138 @@ void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 //--------------------------------------------------------------------
 LLKeyframeMotion::JointMotionList* LLKeyframeDataCache::getKeyframeData(const LLUUID& id)
 {
+    llassert(on_main_thread());
     keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
     if (found_data == sKeyframeDataMap.end())
     {
         return NULL;
     }
-    return found_data->second;
+    return found_data->second.mList;
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::setLimit()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::setLimit(U64 bytes)
+{
+    llassert(on_main_thread());
+    sLimit = bytes;
+    trim();
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::forget()
+// Drop an entry; a list still in use is deleted by its last release
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::forget(keyframe_data_map_t::iterator entry)
+{
+    LLKeyframeMotion::JointMotionList* joint_motion_listp = entry->second.mList;
+    if (entry->second.mIdle != sIdle.end())
+    {
+        sIdle.erase(entry->second.mIdle);
+        sBytes -= entry->second.mBytes;
+    }
+    sKeyframeDataMap.erase(entry);
+
+    if (joint_motion_listp->mUsers <= 0)
+    {
+        delete joint_motion_listp;
+    }
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::trim()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::trim()
+{
+    while (sBytes > sLimit && !sIdle.empty())
+    {
+        keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(sIdle.back());
+        llassert(found_data != sKeyframeDataMap.end());
+        forget(found_data);
+    }
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::saveKeyframeData()
+//--------------------------------------------------------------------
+bool LLKeyframeDataCache::saveKeyframeData(const LLUUID& id, const LLKeyframeMotion::JointMotionList* joint_motion_listp)
+{
+    if (!sDiskCacheEnabled || !joint_motion_listp || id.isNull())
+    {
+        return false;
+    }
+
+    // sizing pass, then the real one
+    LLDataPackerBinaryBuffer sizer;
+    joint_motion_listp->pack(sizer);
+    S32 payload_size = sizer.getCurrentSize();
+
+    std::vector<U8> buffer(DECODED_KEYFRAME_HEADER_SIZE + payload_size);
+    LLDataPackerBinaryBuffer dp(buffer.data() + DECODED_KEYFRAME_HEADER_SIZE, payload_size);
+    if (!joint_motion_listp->pack(dp))
+    {
+        LL_WARNS("Animation") << "Failed to pack decoded keyframe data for " << id << LL_ENDL;
+        return false;
+    }
+
+    U32 header[] = { DECODED_KEYFRAME_MAGIC, DECODED_KEYFRAME_VERSION, LL_CHARACTER_MAX_ANIMATED_JOINTS,
+                     (U32)payload_size,
+                     decoded_keyframe_checksum(buffer.data() + DECODED_KEYFRAME_HEADER_SIZE, payload_size) };
+    memcpy(buffer.data(), header, DECODED_KEYFRAME_HEADER_SIZE);
+
+    LLFileSystem file(id.combine(DECODED_KEYFRAME_ID), LLAssetType::AT_ANIMATION, LLFileSystem::WRITE);
+    return file.write(buffer.data(), (S32)buffer.size());
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::loadKeyframeData()
+//--------------------------------------------------------------------
+LLKeyframeMotion::JointMotionList* LLKeyframeDataCache::loadKeyframeData(const LLUUID& id, LLCharacter* character)
+{
+    if (!sDiskCacheEnabled || id.isNull())
+    {
+        return NULL;
+    }
+
+    LLFileSystem file(id.combine(DECODED_KEYFRAME_ID), LLAssetType::AT_ANIMATION, LLFileSystem::READ);
+    S32 size = file.getSize();
+    if (size <= DECODED_KEYFRAME_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    // one spare zero so a damaged string can't run off the end
+    std::vector<U8> buffer(size + 1, 0);
+    if (!file.read(buffer.data(), size))
+    {
+        return NULL;
+    }
+
+    U32 header[DECODED_KEYFRAME_HEADER_SIZE / sizeof(U32)];
+    memcpy(header, buffer.data(), DECODED_KEYFRAME_HEADER_SIZE);
+    S32 payload_size = size - DECODED_KEYFRAME_HEADER_SIZE;
+    U8* payload = buffer.data() + DECODED_KEYFRAME_HEADER_SIZE;
+    if (header[0] != DECODED_KEYFRAME_MAGIC || header[1] != DECODED_KEYFRAME_VERSION ||
+        header[2] != LL_CHARACTER_MAX_ANIMATED_JOINTS || header[3] != (U32)payload_size ||
+        header[4] != decoded_keyframe_checksum(payload, payload_size))
+    {
+        LL_DEBUGS("Animation") << "Ignoring stale decoded keyframe data for " << id << LL_ENDL;
+        return NULL;
+    }
+
+    LLDataPackerBinaryBuffer dp(payload, payload_size);
+    std::unique_ptr<LLKeyframeMotion::JointMotionList> joint_motion_list(new LLKeyframeMotion::JointMotionList);
+    if (!joint_motion_list->unpack(dp, character))
+    {
+        LL_WARNS("Animation") << "Failed to unpack decoded keyframe data for " << id << LL_ENDL;
+        return NULL;
+    }
+
+    LL_DEBUGS("Animation") << "Loaded decoded keyframe data for " << id << LL_ENDL;
+    LLKeyframeMotion::JointMotionList* joint_motion_listp = joint_motion_list.release();
+    addKeyframeData(id, joint_motion_listp);
+    return joint_motion_listp;
 }
 
 //--------------------------------------------------------------------
@@ -2253,8 +2947,13 @@ LLKeyframeDataCache::~LLKeyframeDataCache()
 //-----------------------------------------------------------------------------
 void LLKeyframeDataCache::clear()
 {
-    std::for_each(sKeyframeDataMap.begin(), sKeyframeDataMap.end(), DeletePairedPointer());
-    sKeyframeDataMap.clear();
+    llassert(on_main_thread());
+    while (!sKeyframeDataMap.empty())
+    {
+        forget(sKeyframeDataMap.begin());
+    }
+    sIdle.clear();
+    sBytes = 0;
 }
 
 //-----------------------------------------------------------------------------
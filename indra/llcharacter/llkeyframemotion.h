@@ -31,6 +31,7 @@
 // Header files
 //-----------------------------------------------------------------------------
 
+#include <list>
 #include <string>
 
 #include "llassetstorage.h"
@@ -72,6 +73,10 @@ namespace LLKeyframeMotionLerp
     {
         return nlerp(t, before, after);
     }
+
+    // nlerp() for count pairs at once, four to a SIMD block:
+    // out[i] = nlerp(t[i], *before[i], *after[i])
+    void nlerp(U32 count, const F32* t, const LLQuaternion* const* before, const LLQuaternion* const* after, LLQuaternion* out);
 }
 
 class LLKeyframeMotion :
@@ -308,7 +313,7 @@ class LLKeyframeMotion :
             T           mValue;
         };
 
-        T interp(F32 u, Key& before, Key& after)
+        T interp(F32 u, const Key& before, const Key& after) const
         {
             switch (mInterpolationType)
             {
@@ -321,6 +326,75 @@ class LLKeyframeMotion :
             }
         }
 
+        // Find where time falls on the curve: the value there is
+        // before->mValue when after is null, otherwise
+        // interp(u, *before, *after).  cursor is the key index the last
+        // lookup ended on; animations mostly move forward by less than a
+        // key between updates, so checking around it first saves the
+        // binary search.  Returns false when there are no keys.
+        bool findKeys(F32 time, U32& cursor, const Key*& before, const Key*& after, F32& u) const
+        {
+            U32 count = (U32) mKeys.size();
+            if (!count)
+            {
+                return false;
+            }
+
+            // right is the first key at or after time, like std::lower_bound()
+            typename key_map_t::const_iterator keys = mKeys.begin();
+            auto is_right = [&](U32 right)
+                {
+                    return (right == count || keys[right].first >= time) &&
+                           (right == 0 || keys[right - 1].first < time);
+                };
+            U32 right = llmin(cursor, count);
+            if (!is_right(right))
+            {
+                if (right < count && is_right(right + 1))
+                {
+                    ++right;
+                }
+                else
+                {
+                    right = (U32) (std::lower_bound(mKeys.begin(), mKeys.end(), time, [](const auto& a, const auto& b) { return a.first < b; }) - keys);
+                }
+            }
+            cursor = right;
+
+            after = NULL;
+            u = 0.f;
+            if (right == count)
+            {
+                // Past last key
+                before = &keys[count - 1].second;
+            }
+            else if (right == 0 || keys[right].first == time)
+            {
+                // Before first key or exactly on a key
+                before = &keys[right].second;
+            }
+            else
+            {
+                // Between two keys
+                before = &keys[right - 1].second;
+                after = &keys[right].second;
+                u = (time - keys[right - 1].first) / (keys[right].first - keys[right - 1].first);
+            }
+            return true;
+        }
+
+        T getValue(F32 time, U32& cursor) const
+        {
+            const Key* before;
+            const Key* after;
+            F32 u;
+            if (!findKeys(time, cursor, before, after, u))
+            {
+                return T();
+            }
+            return after ? interp(u, *before, *after) : before->mValue;
+        }
+
         T getValue(F32 time, F32 duration)
         {
             if (mKeys.empty())
@@ -376,6 +450,9 @@ class LLKeyframeMotion :
     typedef Curve<LLVector3> PositionCurve;
     typedef PositionCurve::Key PositionKey;
 
+    // Rotations waiting to be interpolated together, see JointMotion::update()
+    struct RotationBatch;
+
     //-------------------------------------------------------------------------
     // JointMotion
     //-------------------------------------------------------------------------
@@ -389,7 +466,12 @@ class LLKeyframeMotion :
         U32             mUsage;
         LLJoint::JointPriority  mPriority;
 
-        void update(LLJointState* joint_state, F32 time, F32 duration);
+        // Key cursors kept per joint motion: scale, rotation, position
+        static constexpr U32 KEY_CURSORS = 3;
+
+        // Sample the curves into joint_state.  Rotations that need
+        // interpolating are queued on rotations to be done in bulk.
+        void update(LLJointState* joint_state, F32 time, U32* cursors, RotationBatch& rotations) const;
     };
 
     //-------------------------------------------------------------------------
@@ -415,17 +497,40 @@ class LLKeyframeMotion :
         // TODO: LLKeyframeDataCache::getKeyframeData should probably return a class containing
         // JointMotionList and mEmoteName, see LLKeyframeMotion::onInitialize.
         std::string             mEmoteName;
+        // LLKeyframeMotions using this list, see LLKeyframeDataCache
+        S32                     mUsers;
     public:
         JointMotionList();
         ~JointMotionList();
         U32 dumpDiagInfo();
+        U64 getAllocatedBytes() const;
         JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
         U32 getNumJointMotions() const { return mJointMotionArray.size(); }
+
+        // Sample every joint motion at time into joint_states, one per
+        // joint motion, skipping null states and, unless extended_joints,
+        // SUPPORT_EXTENDED joints.  cursors holds JointMotion::KEY_CURSORS
+        // entries per joint motion and is kept by the caller between calls;
+        // any values are safe, they only speed up the key search.
+        void evaluate(F32 time, const LLPointer<LLJointState>* joint_states, U32* cursors, bool extended_joints) const;
+
+        // Decoded form for LLKeyframeDataCache's disk copies: keys are
+        // stored unquantized and joints, volumes and constraint chains
+        // already resolved, so unpack() only bounds checks.  character is
+        // only needed to check constraint volumes.
+        BOOL pack(LLDataPacker& dp) const;
+        BOOL unpack(LLDataPacker& dp, LLCharacter* character);
     };
 
+private:
+    // Use decoded keyframe data from LLKeyframeDataCache and set up the
+    // joint states and pose for it
+    void    adoptKeyframeData(JointMotionList* joint_motion_list);
+
 protected:
     JointMotionList*                mJointMotionList;
     std::vector<LLPointer<LLJointState> > mJointStates;
+    std::vector<U32>                mKeyCursors;
     LLJoint*                        mPelvisp;
     LLCharacter*                    mCharacter;
     typedef std::list<JointConstraint*> constraint_list_t;
@@ -443,6 +548,15 @@ class LLKeyframeMotion :
     void setJointMotionList(JointMotionList* list) { mJointMotionList = list; }
 };
 
+//
+// Decoded keyframe data shared by every motion playing the same asset.
+// Each LLKeyframeMotion holds a use on its JointMotionList; lists nothing
+// uses any more are kept, least recently released evicted first, while
+// the cache is over its byte limit.  With the disk copy enabled, decoded
+// lists are also written next to the asset in the disk cache so later
+// sessions skip parsing and validating the asset.  Main thread only:
+// animation workers leave deleting retired motions to finishMotions().
+//
 class LLKeyframeDataCache
 {
 public:
@@ -450,17 +564,49 @@ class LLKeyframeDataCache
     LLKeyframeDataCache() = default;
     ~LLKeyframeDataCache();
 
-    typedef boost::unordered_flat_map<LLUUID, class LLKeyframeMotion::JointMotionList*> keyframe_data_map_t;
+    struct Entry
+    {
+        LLKeyframeMotion::JointMotionList*  mList;
+        U64                                 mBytes;
+        std::list<LLUUID>::iterator         mIdle;  // valid while mList->mUsers is 0
+    };
+    typedef boost::unordered_flat_map<LLUUID, Entry> keyframe_data_map_t;
     static keyframe_data_map_t sKeyframeDataMap;
 
+    // Cache a freshly decoded list, replacing any older one for id.  The
+    // caller is expected to start using it right away.
     static void addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList*);
     static LLKeyframeMotion::JointMotionList* getKeyframeData(const LLUUID& id);
 
+    // A motion starts or stops using list.  A list no longer in the cache
+    // (replaced or removed while in use) is deleted with its last use.
+    static void useKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* list);
+    static void releaseKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* list);
+
     static void removeKeyframeData(const LLUUID& id);
 
+    // Bytes of unused lists kept around, zero keeps none
+    static void setLimit(U64 bytes);
+    static U64 getBytes() { return sBytes; }
+
+    // Decoded copies in the disk cache
+    static void setDiskCacheEnabled(bool enabled) { sDiskCacheEnabled = enabled; }
+    static bool saveKeyframeData(const LLUUID& id, const LLKeyframeMotion::JointMotionList* list);
+    // Read and cache the decoded copy of id, if there is a valid one
+    static LLKeyframeMotion::JointMotionList* loadKeyframeData(const LLUUID& id, LLCharacter* character);
+
     //print out diagnostic info
     static void dumpDiagInfo();
     static void clear();
+
+private:
+    static void forget(keyframe_data_map_t::iterator entry);
+    static void trim();
+
+    static std::list<LLUUID> sIdle;    // most recently released first
+    static U64 sBytes;
+    static U64 sLimit;
+    static bool sDiskCacheEnabled;
 };
 
 #endif // LL_LLKEYFRAMEMOTION_H
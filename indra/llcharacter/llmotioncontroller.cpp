@@ -129,6 +129,11 @@ LLMotionController::LLMotionController()
       mTimeStep(0.f),
       mTimeStepCount(0),
       mLastInterp(0.f),
+      mUpdatePeriod(1),
+      mFramesSinceUpdate(0),
+      mInterpolateOnly(FALSE),
+      mEvaluating(FALSE),
+      mAnimateExtendedJoints(TRUE),
       mIsSelf(FALSE),
       mLastCountAfterPurge(0)
 {
@@ -171,6 +176,10 @@ void LLMotionController::deleteAllMotions()
     // up the mDeprecatedMotions list as well.
     std::for_each(mDeprecatedMotions.begin(), mDeprecatedMotions.end(), DeletePointer());
     mDeprecatedMotions.clear();
+
+    // deactivated by an evaluation that finishMotions() didn't follow
+    std::for_each(mRetiredMotions.begin(), mRetiredMotions.end(), DeletePointer());
+    mRetiredMotions.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -278,6 +287,30 @@ void LLMotionController::setTimeStep(F32 step)
     }
 }
 
+//-----------------------------------------------------------------------------
+// setUpdatePeriod()
+//-----------------------------------------------------------------------------
+void LLMotionController::setUpdatePeriod(S32 period)
+{
+    period = llmax(period, 1);
+    if (period == mUpdatePeriod)
+    {
+        return;
+    }
+
+    if (mUpdatePeriod > 1 && mTimeStep == 0.f)
+    {
+        // settle on the cached pose
+        mPoseBlender.interpolate(1.f);
+        clearBlenders();
+        mLastInterp = 0.f;
+    }
+
+    // evaluate on the next update whatever the new period
+    mUpdatePeriod = period;
+    mFramesSinceUpdate = period - 1;
+}
+
 //-----------------------------------------------------------------------------
 // setTimeFactor()
 //-----------------------------------------------------------------------------
@@ -753,7 +786,7 @@ void LLMotionController::updateMotionsByType(LLMotion::LLMotionBlendType anim_ty
         }
 
         // even if onupdate returns FALSE, add this motion in to the blend one last time
-        mPoseBlender.addMotion(motionp);
+        mPoseBlender.addMotion(motionp, mAnimateExtendedJoints);
     }
 }
 
@@ -809,6 +842,19 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    if (prepareMotions())
+    {
+        evaluateMotions(force_update);
+        finishMotions();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+BOOL LLMotionController::prepareMotions()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
     // SL-763: "Distant animated objects run at super fast speed"
@@ -821,7 +867,12 @@ void LLMotionController::updateMotions(bool force_update)
     F32 cur_time = mTimer.getElapsedTimeF32();
     F32 delta_time = cur_time - mPrevTimerElapsed;
     mPrevTimerElapsed = cur_time;
-    mLastTime = mAnimTime;
+    // updates skipped by the animation LOD leave mLastTime at the last
+    // evaluated time so that no stop or ease event falls in between
+    if (!mInterpolateOnly)
+    {
+        mLastTime = mAnimTime;
+    }
 
     // Always cap the number of loaded motions
     purgeExcessMotions();
@@ -848,7 +899,7 @@ void LLMotionController::updateMotions(bool force_update)
 
                 updateLoadingMotions();
 
-                return;
+                return FALSE;
             }
 
             // is calculating a new keyframe pose, make sure the last one gets applied
@@ -868,6 +919,44 @@ void LLMotionController::updateMotions(bool force_update)
 
     updateLoadingMotions();
 
+    mInterpolateOnly = FALSE;
+    if (mUpdatePeriod > 1 && !mPaused && !use_quantum)
+    {
+        if (++mFramesSinceUpdate < mUpdatePeriod)
+        {
+            mInterpolateOnly = TRUE;
+        }
+        else
+        {
+            mFramesSinceUpdate = 0;
+        }
+    }
+
+    return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    BOOL use_quantum = (mTimeStep != 0.f);
+    BOOL cache_pose = use_quantum || mUpdatePeriod > 1;
+
+    if (mInterpolateOnly)
+    {
+        // ease towards the pose cached by the last evaluation, scaling the
+        // step so that the joints move linearly from the pose they had then
+        F32 interp = (F32)mFramesSinceUpdate / (F32)mUpdatePeriod;
+        mPoseBlender.interpolate((interp - mLastInterp) / (1.f - mLastInterp));
+        mLastInterp = interp;
+        return;
+    }
+
+    // deprecated motions that finish now are deleted by finishMotions()
+    mEvaluating = TRUE;
+
     resetJointSignatures();
 
     if (mPaused && !force_update)
@@ -876,6 +965,14 @@ void LLMotionController::updateMotions(bool force_update)
     }
     else
     {
+        if (cache_pose && !use_quantum)
+        {
+            // land on the last cached pose before blending the next one
+            mPoseBlender.interpolate(1.f);
+            clearBlenders();
+            mLastInterp = 0.f;
+        }
+
         // update additive motions
         updateAdditiveMotions();
 
@@ -884,7 +981,7 @@ void LLMotionController::updateMotions(bool force_update)
         // update all regular motions
         updateRegularMotions();
 
-        if (use_quantum)
+        if (cache_pose)
         {
             mPoseBlender.blendAndCache(TRUE);
         }
@@ -895,9 +992,22 @@ void LLMotionController::updateMotions(bool force_update)
     }
 
     mHasRunOnce = TRUE;
+    mEvaluating = FALSE;
 //  LL_INFOS() << "Motion controller time " << motionTimer.getElapsedTimeF32() << LL_ENDL;
 }
 
+//-----------------------------------------------------------------------------
+// finishMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::finishMotions()
+{
+    for (LLMotion* motionp : mRetiredMotions)
+    {
+        removeMotionInstance(motionp);
+    }
+    mRetiredMotions.clear();
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
@@ -993,8 +1103,19 @@ BOOL LLMotionController::deactivateMotionInstance(LLMotion *motion)
     if (found_it != mDeprecatedMotions.end())
     {
         // deprecated motions need to be completely excised
-        removeMotionInstance(motion);
         mDeprecatedMotions.erase(found_it);
+        if (mEvaluating)
+        {
+            // evaluateMotions() may be running on a worker and deleting a
+            // motion releases data shared with other characters, so leave
+            // that to finishMotions() on the main thread
+            mActiveMotions.remove(motion);
+            mRetiredMotions.push_back(motion);
+        }
+        else
+        {
+            removeMotionInstance(motion);
+        }
     }
     else
     {
@@ -33,6 +33,7 @@
 #include <string>
 #include <map>
 #include <deque>
+#include <vector>
 
 #include "llmotion.h"
 #include "llpose.h"
@@ -136,6 +137,19 @@ class LLMotionController
     // deactivates terminated motions`
     void updateMotions(bool force_update = false);
 
+    // updateMotions() in two halves, for characters animated on worker
+    // threads.  prepareMotions() steps the clock, purges excess motions and
+    // polls loading ones, which may start asset fetches, so it stays on the
+    // main thread; it returns FALSE when there is nothing to evaluate this
+    // frame.  evaluateMotions() runs the active motions and blends them onto
+    // the joints.  It only touches this controller, its motions and its
+    // character's joints and visual params, so controllers of different
+    // characters can be evaluated concurrently.  Deprecated motions it
+    // deactivates are deleted by finishMotions(), back on the main thread.
+    BOOL prepareMotions();
+    void evaluateMotions(bool force_update = false);
+    void finishMotions();
+
     // minimal update (e.g. while hidden)
     void updateMotionsMinimal();
 
@@ -157,6 +171,19 @@ class LLMotionController
     void setTimeStep(F32 step);
     F32 getTimeStep() const { return mTimeStep; }
 
+    // Animation LOD.  With an update period above 1 the motions are only
+    // evaluated every period-th update and the joints ease towards the last
+    // evaluated pose in between, trailing the motions by one period.
+    void setUpdatePeriod(S32 period);
+    S32 getUpdatePeriod() const { return mUpdatePeriod; }
+    // TRUE when the update prepared last only eases towards the cached pose
+    BOOL isInterpolating() const { return mInterpolateOnly; }
+
+    // When FALSE, SUPPORT_EXTENDED joints (fingers, face, wings...) are left
+    // out of keyframe evaluation and blending and keep their last pose
+    void setAnimateExtendedJoints(BOOL animate) { mAnimateExtendedJoints = animate; }
+    BOOL getAnimateExtendedJoints() const { return mAnimateExtendedJoints; }
+
     void setTimeFactor(F32 time_factor);
     F32 getTimeFactor() const { return mTimeFactor; }
 
@@ -230,6 +257,12 @@ class LLMotionController
     F32                 mTimeStep;
     S32                 mTimeStepCount;
     F32                 mLastInterp;
+    S32                 mUpdatePeriod;
+    S32                 mFramesSinceUpdate;
+    BOOL                mInterpolateOnly;
+    BOOL                mEvaluating;            // inside evaluateMotions()
+    std::vector<LLMotion*> mRetiredMotions;     // deactivated there, for finishMotions() to delete
+    BOOL                mAnimateExtendedJoints;
 
     U8                  mJointSignature[2][LL_CHARACTER_MAX_ANIMATED_JOINTS];
 private:
@@ -456,13 +456,17 @@ LLPoseBlender::~LLPoseBlender()
 //-----------------------------------------------------------------------------
 // addMotion()
 //-----------------------------------------------------------------------------
-BOOL LLPoseBlender::addMotion(LLMotion* motion)
+BOOL LLPoseBlender::addMotion(LLMotion* motion, BOOL extended_joints)
 {
     LLPose* pose = motion->getPose();
 
     for(LLJointState* jsp = pose->getFirstJointState(); jsp; jsp = pose->getNextJointState())
     {
         LLJoint *jointp = jsp->getJoint();
+        if (!extended_joints && jointp && jointp->getSupport() == LLJoint::SUPPORT_EXTENDED)
+        {
+            continue;
+        }
         LLJointStateBlender* joint_blender;
         auto joint_iter = mJointStateBlenderPool.find(jointp);
         if (joint_iter == mJointStateBlenderPool.end())
@@ -121,8 +121,9 @@ class LLPoseBlender
     // Destructor
     ~LLPoseBlender();
 
-    // request motion joint states to be added to pose blender joint state records
-    BOOL addMotion(LLMotion* motion);
+    // request motion joint states to be added to pose blender joint state records,
+    // leaving out SUPPORT_EXTENDED joints unless extended_joints is set
+    BOOL addMotion(LLMotion* motion, BOOL extended_joints = TRUE);
 
     // blend all joint states and apply to skeleton
     void blendAndApply();
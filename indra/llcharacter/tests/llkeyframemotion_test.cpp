@@ -0,0 +1,332 @@
+/**
+ * @file   llkeyframemotion_test.cpp
+ * @date   2024-07
+ * @brief  Checks batched keyframe evaluation against Curve::getValue()
+ *         and exercises the decoded keyframe cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include "../llkeyframemotion.h"
+#include "lldatapacker.h"
+
+#include <random>
+#include <vector>
+
+namespace tut
+{
+    struct LLKeyframeMotionData
+    {
+        typedef LLKeyframeMotion::JointMotionList JointMotionList;
+        typedef LLKeyframeMotion::JointMotion JointMotion;
+
+        // Shaped like a full body .anim from the upload floater: 30 keys a
+        // second on every joint, a moving pelvis and the odd stepped or
+        // scaled joint
+        LLKeyframeMotionData()
+        :   mRandom(1234)
+        {
+            const S32 num_joints = 80;
+            const S32 num_keys = 150;
+            mList.mDuration = 5.f;
+
+            std::uniform_real_distribution<F32> angle(-F_PI, F_PI);
+            std::uniform_real_distribution<F32> coord(-1.f, 1.f);
+            for (S32 j = 0; j < num_joints; ++j)
+            {
+                JointMotion* motion = new JointMotion;
+                motion->mJointName = stringize("joint", j);
+                motion->mUsage = LLJointState::ROT;
+                motion->mPriority = LLJoint::USE_MOTION_PRIORITY;
+
+                LLVector3 axis(coord(mRandom), coord(mRandom), coord(mRandom));
+                axis.normalize();
+                F32 start = angle(mRandom);
+                F32 speed = angle(mRandom);
+                for (S32 k = 0; k < num_keys; ++k)
+                {
+                    F32 time = mList.mDuration * k / (num_keys - 1);
+                    LLQuaternion rot;
+                    rot.setAngleAxis(start + speed * time, axis);
+                    // Flip the odd key into the other hemisphere so both
+                    // halves of nlerp() get exercised
+                    if (k % 17 == 5)
+                    {
+                        rot = -rot;
+                    }
+                    motion->mRotationCurve.mKeys[time] = LLKeyframeMotion::RotationKey(time, rot);
+                }
+                motion->mRotationCurve.mNumKeys = num_keys;
+                if (j % 11 == 3)
+                {
+                    motion->mRotationCurve.mInterpolationType = LLKeyframeMotion::IT_STEP;
+                }
+
+                if (j == 0 || j % 13 == 7)
+                {
+                    motion->mUsage |= LLJointState::POS;
+                    for (S32 k = 0; k < num_keys; k += 3)
+                    {
+                        F32 time = mList.mDuration * k / (num_keys - 1);
+                        LLVector3 pos(coord(mRandom), coord(mRandom), coord(mRandom));
+                        motion->mPositionCurve.mKeys[time] = LLKeyframeMotion::PositionKey(time, pos);
+                        ++motion->mPositionCurve.mNumKeys;
+                    }
+                }
+
+                if (j % 19 == 9)
+                {
+                    motion->mUsage |= LLJointState::SCALE;
+                    for (S32 k = 0; k < 4; ++k)
+                    {
+                        F32 time = mList.mDuration * k / 3;
+                        LLVector3 scale(1.f + coord(mRandom) * 0.1f, 1.f, 1.f);
+                        motion->mScaleCurve.mKeys[time] = LLKeyframeMotion::ScaleKey(time, scale);
+                    }
+                    motion->mScaleCurve.mNumKeys = 4;
+                }
+
+                mList.mJointMotionArray.push_back(motion);
+                mStates.push_back(makeStates(motion));
+                mReference.push_back(makeStates(motion));
+            }
+            mCursors.assign(num_joints * JointMotion::KEY_CURSORS, 0);
+        }
+
+        static LLPointer<LLJointState> makeStates(const JointMotion* motion)
+        {
+            LLPointer<LLJointState> state = new LLJointState;
+            state->setUsage(motion->mUsage);
+            return state;
+        }
+
+        // What LLKeyframeMotion::applyKeyframes() did before batching
+        void evaluateReference(F32 time)
+        {
+            for (U32 j = 0; j < mList.getNumJointMotions(); ++j)
+            {
+                JointMotion* motion = mList.getJointMotion(j);
+                LLJointState* state = mReference[j];
+                if (motion->mRotationCurve.mNumKeys)
+                {
+                    state->setRotation(motion->mRotationCurve.getValue(time, mList.mDuration));
+                }
+                if (motion->mPositionCurve.mNumKeys)
+                {
+                    state->setPosition(motion->mPositionCurve.getValue(time, mList.mDuration));
+                }
+                if (motion->mScaleCurve.mNumKeys)
+                {
+                    state->setScale(motion->mScaleCurve.getValue(time, mList.mDuration));
+                }
+            }
+        }
+
+        void evaluate(F32 time)
+        {
+            mList.evaluate(time, mStates.data(), mCursors.data(), true);
+        }
+
+        // Forward at 60fps through two loops, then some scrubbing
+        std::vector<F32> makeTimes()
+        {
+            std::vector<F32> times;
+            for (F32 time = 0.f; time < mList.mDuration * 2.f; time += 1.f / 60.f)
+            {
+                times.push_back(fmodf(time, mList.mDuration));
+            }
+            std::uniform_real_distribution<F32> scrub(-0.5f, mList.mDuration + 0.5f);
+            for (S32 i = 0; i < 200; ++i)
+            {
+                times.push_back(scrub(mRandom));
+            }
+            // Exactly on keys
+            times.push_back(0.f);
+            times.push_back(mList.mDuration);
+            times.push_back(mList.mDuration * 10.f / 149.f);
+            return times;
+        }
+
+        std::mt19937 mRandom;
+        JointMotionList mList;
+        std::vector<LLPointer<LLJointState> > mStates;
+        std::vector<LLPointer<LLJointState> > mReference;
+        std::vector<U32> mCursors;
+    };
+
+    typedef test_group<LLKeyframeMotionData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llkeyframemotion_test_factory("LLKeyframeMotion");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("batched evaluation matches Curve::getValue()");
+
+        U32 inexact = 0;
+        U32 compared = 0;
+        for (F32 time : makeTimes())
+        {
+            evaluateReference(time);
+            evaluate(time);
+            for (U32 j = 0; j < mStates.size(); ++j)
+            {
+                const std::string where(stringize("joint ", j, " at ", time));
+                const LLJointState* state = mStates[j];
+                const LLJointState* ref = mReference[j];
+                ensure(where + " position", state->getPosition() == ref->getPosition());
+                ensure(where + " scale", state->getScale() == ref->getScale());
+
+                const LLQuaternion& rot = state->getRotation();
+                const LLQuaternion& ref_rot = ref->getRotation();
+                for (S32 c = 0; c < 4; ++c)
+                {
+                    ensure(stringize(where, " rotation ", c, ": ", rot.mQ[c], " vs ", ref_rot.mQ[c]),
+                           fabsf(rot.mQ[c] - ref_rot.mQ[c]) <= 1e-6f);
+                }
+                inexact += rot != ref_rot;
+                ++compared;
+            }
+        }
+        LL_INFOS() << compared << " rotations compared, " << inexact << " not bit-identical" << LL_ENDL;
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("decoded keyframe data survives pack() and unpack()");
+
+        mList.mEmoteName = "express_smile";
+        mList.mLoop = TRUE;
+        mList.mLoopInPoint = 1.f;
+        mList.mLoopOutPoint = 4.f;
+        mList.mHandPose = LLHandMotion::HAND_POSE_FIST;
+        mList.mPelvisBBox.setMin(LLVector3(-1.f, -2.f, -3.f));
+        mList.mPelvisBBox.setMax(LLVector3(1.f, 2.f, 3.f));
+
+        LLDataPackerBinaryBuffer sizer;
+        ensure("sized", mList.pack(sizer));
+        std::vector<U8> buffer(sizer.getCurrentSize());
+        LLDataPackerBinaryBuffer packer(buffer.data(), (S32)buffer.size());
+        ensure("packed", mList.pack(packer));
+        ensure_equals("sizing pass", packer.getCurrentSize(), (S32)buffer.size());
+
+        JointMotionList copy;
+        LLDataPackerBinaryBuffer unpacker(buffer.data(), (S32)buffer.size());
+        ensure("unpacked", copy.unpack(unpacker, NULL));
+        ensure_equals("emote", copy.mEmoteName, mList.mEmoteName);
+        ensure_equals("hand pose", (S32)copy.mHandPose, (S32)mList.mHandPose);
+        ensure("pelvis box", copy.mPelvisBBox.getMax() == mList.mPelvisBBox.getMax());
+        ensure_equals("joints", copy.getNumJointMotions(), mList.getNumJointMotions());
+
+        // The copy must play back exactly like the original
+        std::vector<LLPointer<LLJointState> > states;
+        for (U32 j = 0; j < copy.getNumJointMotions(); ++j)
+        {
+            const JointMotion* motion = copy.getJointMotion(j);
+            ensure_equals(stringize("joint ", j, " name"), motion->mJointName, mList.getJointMotion(j)->mJointName);
+            states.push_back(makeStates(motion));
+        }
+        std::vector<U32> cursors(mCursors.size(), 0);
+        for (F32 time : makeTimes())
+        {
+            evaluate(time);
+            copy.evaluate(time, states.data(), cursors.data(), true);
+            for (U32 j = 0; j < states.size(); ++j)
+            {
+                ensure(stringize("joint ", j, " at ", time),
+                       states[j]->getRotation() == mStates[j]->getRotation() &&
+                       states[j]->getPosition() == mStates[j]->getPosition() &&
+                       states[j]->getScale() == mStates[j]->getScale());
+            }
+        }
+
+        // Truncated data fails cleanly
+        JointMotionList truncated;
+        LLDataPackerBinaryBuffer short_unpacker(buffer.data(), (S32)buffer.size() / 2);
+        ensure("truncated", !truncated.unpack(short_unpacker, NULL));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("unused decoded keyframe data is kept and evicted by size");
+
+        LLKeyframeDataCache::clear();
+        LLKeyframeDataCache::setLimit(1024 * 1024);
+
+        std::vector<LLUUID> ids(4);
+        std::vector<JointMotionList*> lists;
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+            JointMotionList* list = new JointMotionList;
+            list->mJointMotionArray.push_back(new JointMotion);
+            LLKeyframeDataCache::addKeyframeData(id, list);
+            LLKeyframeDataCache::useKeyframeData(id, list);
+            lists.push_back(list);
+        }
+        ensure_equals("nothing parked while in use", LLKeyframeDataCache::getBytes(), (U64)0);
+
+        // Two motions share the first list, it parks with the last release
+        LLKeyframeDataCache::useKeyframeData(ids[0], lists[0]);
+        LLKeyframeDataCache::releaseKeyframeData(ids[0], lists[0]);
+        ensure_equals("still in use", LLKeyframeDataCache::getBytes(), (U64)0);
+        for (U32 i = 0; i < ids.size(); ++i)
+        {
+            LLKeyframeDataCache::releaseKeyframeData(ids[i], lists[i]);
+        }
+        U64 bytes = lists[0]->getAllocatedBytes();
+        ensure_equals("all parked", LLKeyframeDataCache::getBytes(), bytes * ids.size());
+        ensure("kept", LLKeyframeDataCache::getKeyframeData(ids[0]) == lists[0]);
+
+        // Picking one up again takes it out of the running
+        LLKeyframeDataCache::useKeyframeData(ids[0], lists[0]);
+        LLKeyframeDataCache::setLimit(bytes);
+        ensure_equals("trimmed to the newest", LLKeyframeDataCache::getBytes(), bytes);
+        ensure("in use kept", LLKeyframeDataCache::getKeyframeData(ids[0]) == lists[0]);
+        ensure("oldest evicted", !LLKeyframeDataCache::getKeyframeData(ids[1]));
+        ensure("newest kept", LLKeyframeDataCache::getKeyframeData(ids[3]) == lists[3]);
+
+        // Replaced while in use, the old list goes with its last release
+        JointMotionList* replacement = new JointMotionList;
+        LLKeyframeDataCache::addKeyframeData(ids[0], replacement);
+        ensure("replaced", LLKeyframeDataCache::getKeyframeData(ids[0]) == replacement);
+        LLKeyframeDataCache::releaseKeyframeData(ids[0], lists[0]);
+
+        LLKeyframeDataCache::setLimit(0);
+        ensure_equals("disabled cache is empty", LLKeyframeDataCache::getBytes(), (U64)0);
+        LLKeyframeDataCache::clear();
+    }
+}
@@ -0,0 +1,346 @@
+/**
+ * @file   llmotioncontroller_test.cpp
+ * @date   2024-07
+ * @brief  Checks that motion controllers evaluated on a thread pool end up
+ *         with the same poses as serial updateMotions() calls.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include "../llcharacter.h"
+#include "../lljointstate.h"
+#include "../llmotion.h"
+#include "llframetimer.h"
+#include "llthread.h"
+#include "lltimer.h"
+#include "threadpool.h"
+#include "v3dmath.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const S32 NUM_JOINTS = 32;
+
+    const LLUUID SWAY_ID("6b2a1ac5-0c57-4d5e-9d0f-0d1c5e2a7c01");
+    const LLUUID WAVE_ID("6b2a1ac5-0c57-4d5e-9d0f-0d1c5e2a7c02");
+
+    std::atomic<S32> sDeletedMotions{ 0 };
+    // motion instances deleted anywhere but the main thread
+    std::atomic<S32> sDeletedOffMainThread{ 0 };
+
+    // Swings every joint of the character at its own phase, forever
+    class LLSwayMotion : public LLMotion
+    {
+    public:
+        LLSwayMotion(const LLUUID& id) : LLMotion(id) {}
+        ~LLSwayMotion()
+        {
+            ++sDeletedMotions;
+            if (!on_main_thread())
+            {
+                ++sDeletedOffMainThread;
+            }
+        }
+
+        static LLMotion* create(const LLUUID& id) { return new LLSwayMotion(id); }
+
+        BOOL getLoop() override { return TRUE; }
+        F32 getDuration() override { return 0.f; }
+        F32 getEaseInDuration() override { return 0.05f; }
+        F32 getEaseOutDuration() override { return 0.05f; }
+        LLJoint::JointPriority getPriority() override { return LLJoint::MEDIUM_PRIORITY; }
+        LLMotionBlendType getBlendType() override { return NORMAL_BLEND; }
+        F32 getMinPixelArea() override { return 0.f; }
+
+        LLMotionInitStatus onInitialize(LLCharacter* character) override
+        {
+            for (S32 i = 0; i < NUM_JOINTS; ++i)
+            {
+                LLPointer<LLJointState> state = new LLJointState(character->getCharacterJoint(i));
+                state->setUsage(LLJointState::ROT);
+                addJointState(state);
+                mStates.push_back(state);
+            }
+            return STATUS_SUCCESS;
+        }
+
+        BOOL onActivate() override { return TRUE; }
+
+        BOOL onUpdate(F32 time, U8* joint_mask) override
+        {
+            for (size_t i = 0; i < mStates.size(); ++i)
+            {
+                LLQuaternion rot;
+                rot.setAngleAxis(sinf(time * 5.f + (F32)i) * 0.5f, 1.f, 0.f, 0.f);
+                mStates[i]->setRotation(rot);
+            }
+            return TRUE;
+        }
+
+        void onDeactivate() override {}
+
+    protected:
+        std::vector<LLPointer<LLJointState> > mStates;
+    };
+
+    // Plays once over the upper half of the joints on top of the sway.
+    // Restarting it while it eases out deprecates the old instance.
+    class LLWaveMotion : public LLSwayMotion
+    {
+    public:
+        LLWaveMotion(const LLUUID& id) : LLSwayMotion(id) {}
+
+        static LLMotion* create(const LLUUID& id) { return new LLWaveMotion(id); }
+
+        BOOL getLoop() override { return FALSE; }
+        F32 getDuration() override { return 0.1f; }
+        LLJoint::JointPriority getPriority() override { return LLJoint::HIGH_PRIORITY; }
+
+        LLMotionInitStatus onInitialize(LLCharacter* character) override
+        {
+            for (S32 i = NUM_JOINTS / 2; i < NUM_JOINTS; ++i)
+            {
+                LLPointer<LLJointState> state = new LLJointState(character->getCharacterJoint(i));
+                state->setUsage(LLJointState::ROT);
+                addJointState(state);
+                mStates.push_back(state);
+            }
+            return STATUS_SUCCESS;
+        }
+
+        BOOL onUpdate(F32 time, U8* joint_mask) override
+        {
+            for (size_t i = 0; i < mStates.size(); ++i)
+            {
+                LLQuaternion rot;
+                rot.setAngleAxis(time * 4.f + (F32)i * 0.1f, 0.f, 0.f, 1.f);
+                mStates[i]->setRotation(rot);
+            }
+            return TRUE;
+        }
+    };
+
+    // A binary tree of joints, each a little above its parent
+    class LLTestCharacter : public LLCharacter
+    {
+    public:
+        LLTestCharacter()
+        {
+            for (S32 i = 0; i < NUM_JOINTS; ++i)
+            {
+                LLJoint* parent = i ? mJoints[(i - 1) / 2].get() : NULL;
+                mJoints.emplace_back(new LLJoint(stringize("joint", i), parent));
+                mJoints.back()->setJointNum(i);
+                mJoints.back()->setPosition(LLVector3(0.f, i % 2 ? 0.05f : -0.05f, 0.1f));
+            }
+        }
+
+        const char* getAnimationPrefix() override { return "test"; }
+        LLJoint* getRootJoint() override { return mJoints[0].get(); }
+        LLVector3 getCharacterPosition() override { return LLVector3::zero; }
+        LLQuaternion getCharacterRotation() override { return LLQuaternion::DEFAULT; }
+        LLVector3 getCharacterVelocity() override { return LLVector3::zero; }
+        LLVector3 getCharacterAngularVelocity() override { return LLVector3::zero; }
+        void getGround(const LLVector3& inPos, LLVector3& outPos, LLVector3& outNorm) override
+        {
+            outPos = inPos;
+            outNorm = LLVector3::z_axis;
+        }
+        LLJoint* getCharacterJoint(U32 i) override { return i < mJoints.size() ? mJoints[i].get() : NULL; }
+        F32 getTimeDilation() override { return 1.f; }
+        F32 getPixelArea() const override { return 10000.f; }
+        LLPolyMesh* getHeadMesh() override { return NULL; }
+        LLPolyMesh* getUpperBodyMesh() override { return NULL; }
+        LLVector3d getPosGlobalFromAgent(const LLVector3& position) override { return LLVector3d(position); }
+        LLVector3 getPosAgentFromGlobal(const LLVector3d& position) override { return LLVector3(position); }
+        void addDebugText(const std::string& text) override {}
+        const LLUUID& getID() const override { return LLUUID::null; }
+
+        std::vector<std::unique_ptr<LLJoint> > mJoints;
+    };
+}
+
+namespace tut
+{
+    struct LLMotionControllerData
+    {
+        typedef std::vector<std::unique_ptr<LLTestCharacter> > crowd_t;
+
+        LLMotionControllerData()
+        {
+            // the test runner's thread is the main one
+            on_main_thread();
+        }
+
+        crowd_t makeCrowd(size_t count)
+        {
+            crowd_t crowd;
+            for (size_t i = 0; i < count; ++i)
+            {
+                crowd.emplace_back(new LLTestCharacter);
+                crowd.back()->registerMotion(SWAY_ID, LLSwayMotion::create);
+                crowd.back()->registerMotion(WAVE_ID, LLWaveMotion::create);
+                // cover the animation LOD's interpolated updates as well
+                crowd.back()->getMotionController().setUpdatePeriod(1 + (S32)(i % 3));
+            }
+            return crowd;
+        }
+
+        // Starts and stops motions the way the viewer does between frames
+        void script(crowd_t& crowd, S32 frame)
+        {
+            for (std::unique_ptr<LLTestCharacter>& character : crowd)
+            {
+                if (frame == 0)
+                {
+                    character->startMotion(SWAY_ID);
+                    character->startMotion(WAVE_ID);
+                }
+                else if (frame == 3)
+                {
+                    character->stopMotion(WAVE_ID);
+                }
+                else if (frame == 4 || frame == 20)
+                {
+                    character->startMotion(WAVE_ID);
+                }
+            }
+        }
+    };
+
+    typedef test_group<LLMotionControllerData> factory;
+    typedef factory::object object;
+}
+namespace
+{
+    tut::factory tf("LLMotionController");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("controllers evaluated on a thread pool match updateMotions()");
+
+        const size_t num_characters = 16;
+        const S32 num_frames = 40;
+
+        // all timers start on the same frame time
+        LLFrameTimer::updateFrameTime();
+        crowd_t serial = makeCrowd(num_characters);
+        crowd_t threaded = makeCrowd(num_characters);
+
+        LL::WorkStealingThreadPool pool("MotionControllerTest", 4);
+        pool.start();
+
+        // deprecated motions the threaded controllers retired and deleted
+        S32 retired = 0;
+
+        for (S32 frame = 0; frame < num_frames; ++frame)
+        {
+            ms_sleep(10);
+            LLFrameTimer::updateFrameTime();
+            script(serial, frame);
+            script(threaded, frame);
+
+            for (std::unique_ptr<LLTestCharacter>& character : serial)
+            {
+                character->updateMotions(LLCharacter::NORMAL_UPDATE);
+                character->getRootJoint()->updateWorldMatrixChildren();
+            }
+
+            // prepare and finish on this thread, evaluate on the pool, the
+            // way LLVOAvatar::runAnimationJobs() does
+            std::atomic<size_t> done{ 0 };
+            for (std::unique_ptr<LLTestCharacter>& character : threaded)
+            {
+                LLTestCharacter* characterp = character.get();
+                bool evaluate = characterp->prepareMotions(LLCharacter::NORMAL_UPDATE);
+                pool.getQueue().post([characterp, evaluate, &done]()
+                    {
+                        if (evaluate)
+                        {
+                            characterp->evaluateMotions(LLCharacter::NORMAL_UPDATE);
+                        }
+                        characterp->getRootJoint()->updateWorldMatrixChildren();
+                        ++done;
+                    });
+            }
+            while (done < num_characters)
+            {
+                std::this_thread::yield();
+            }
+            S32 deleted = sDeletedMotions;
+            for (std::unique_ptr<LLTestCharacter>& character : threaded)
+            {
+                character->finishMotions();
+            }
+            retired += sDeletedMotions - deleted;
+
+            for (size_t i = 0; i < num_characters; ++i)
+            {
+                LLMotionController& lhs = threaded[i]->getMotionController();
+                LLMotionController& rhs = serial[i]->getMotionController();
+                ensure_equals(stringize("anim time, frame ", frame, " character ", i),
+                              lhs.getAnimTime(), rhs.getAnimTime());
+
+                S32 lhs_counts[5] = { 0 };
+                S32 rhs_counts[5] = { 0 };
+                lhs.incMotionCounts(lhs_counts[0], lhs_counts[1], lhs_counts[2], lhs_counts[3], lhs_counts[4]);
+                rhs.incMotionCounts(rhs_counts[0], rhs_counts[1], rhs_counts[2], rhs_counts[3], rhs_counts[4]);
+                for (S32 c = 0; c < 5; ++c)
+                {
+                    ensure_equals(stringize("motion count ", c, ", frame ", frame, " character ", i),
+                                  lhs_counts[c], rhs_counts[c]);
+                }
+
+                for (S32 j = 0; j < NUM_JOINTS; ++j)
+                {
+                    LLJoint* lhs_joint = threaded[i]->mJoints[j].get();
+                    LLJoint* rhs_joint = serial[i]->mJoints[j].get();
+                    ensure(stringize("rotation, frame ", frame, " character ", i, " joint ", j),
+                           memcmp(lhs_joint->getRotation().mQ, rhs_joint->getRotation().mQ, sizeof(F32) * 4) == 0);
+                    ensure(stringize("world matrix, frame ", frame, " character ", i, " joint ", j),
+                           memcmp(lhs_joint->getWorldMatrix().getF32ptr(), rhs_joint->getWorldMatrix().getF32ptr(),
+                                  sizeof(LLMatrix4a)) == 0);
+                }
+            }
+        }
+        pool.close();
+
+        // the crowd did move, and the restarted waves left deprecated
+        // instances that only finishMotions() deleted
+        ensure("animated", threaded[0]->mJoints[NUM_JOINTS - 1]->getRotation() != LLQuaternion::DEFAULT);
+        ensure("deprecated motions retired", retired > 0);
+        ensure_equals("motions deleted off the main thread", sDeletedOffMainThread.load(), 0);
+    }
+}
@@ -0,0 +1,263 @@
+/**
+ * @file llindexedheap.h
+ * @brief Binary max-heap with O(log n) reprioritization and removal by key.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINDEXEDHEAP_H
+#define LL_LLINDEXEDHEAP_H
+
+#include "llerror.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+// Priority queue of unique keys, highest priority first.  Unlike
+// std::priority_queue (and LLPriQueueMap, which pays for a map node per
+// entry), every key remembers its slot in the heap, so a key can be
+// reprioritized or removed in O(log n) without rebuilding anything.
+// Not thread safe.
+//
+
+template <typename KEY, typename PRIORITY = F32, typename HASH = std::hash<KEY>>
+class LLIndexedHeap
+{
+public:
+    typedef KEY key_type;
+    typedef PRIORITY priority_type;
+
+    bool empty() const                  { return mHeap.empty(); }
+    size_t size() const                 { return mHeap.size(); }
+    bool contains(const KEY& key) const { return mIndex.find(key) != mIndex.end(); }
+
+    void clear()
+    {
+        mHeap.clear();
+        mIndex.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        mHeap.reserve(count);
+        mIndex.reserve(count);
+    }
+
+    // Insert key, or move it to its new place if it is already queued.
+    void set(const KEY& key, PRIORITY priority)
+    {
+        auto result = mIndex.emplace(key, mHeap.size());
+        if (result.second)
+        {
+            mHeap.push_back(Entry{ key, priority });
+            siftUp(mHeap.size() - 1);
+            return;
+        }
+
+        size_t pos = result.first->second;
+        PRIORITY old_priority = mHeap[pos].mPriority;
+        mHeap[pos].mPriority = priority;
+        if (old_priority < priority)
+        {
+            siftUp(pos);
+        }
+        else if (priority < old_priority)
+        {
+            siftDown(pos);
+        }
+    }
+
+    // Only reprioritize, never insert.  Returns false for unknown keys.
+    bool update(const KEY& key, PRIORITY priority)
+    {
+        if (!contains(key))
+        {
+            return false;
+        }
+        set(key, priority);
+        return true;
+    }
+
+    bool getPriority(const KEY& key, PRIORITY& priority) const
+    {
+        auto it = mIndex.find(key);
+        if (it == mIndex.end())
+        {
+            return false;
+        }
+        priority = mHeap[it->second].mPriority;
+        return true;
+    }
+
+    bool erase(const KEY& key)
+    {
+        auto it = mIndex.find(key);
+        if (it == mIndex.end())
+        {
+            return false;
+        }
+        size_t pos = it->second;
+        mIndex.erase(it);
+        removeAt(pos);
+        return true;
+    }
+
+    const KEY& top() const
+    {
+        llassert(!empty());
+        return mHeap.front().mKey;
+    }
+
+    PRIORITY topPriority() const
+    {
+        llassert(!empty());
+        return mHeap.front().mPriority;
+    }
+
+    void pop()
+    {
+        llassert(!empty());
+        mIndex.erase(mHeap.front().mKey);
+        removeAt(0);
+    }
+
+    // Call func(key, priority) for up to count entries, highest priority
+    // first, leaving the heap untouched.  Walks the heap best-first so it
+    // only costs O(count log count) however many keys are queued.
+    template <typename FUNC>
+    void visitTop(size_t count, FUNC&& func) const
+    {
+        if (!count || mHeap.empty())
+        {
+            return;
+        }
+
+        auto less = [this](size_t lhs, size_t rhs)
+            {
+                return mHeap[lhs].mPriority < mHeap[rhs].mPriority;
+            };
+        std::vector<size_t> frontier;
+        frontier.reserve(count * 2 + 1);
+        frontier.push_back(0);
+        while (count-- && !frontier.empty())
+        {
+            std::pop_heap(frontier.begin(), frontier.end(), less);
+            size_t pos = frontier.back();
+            frontier.pop_back();
+            func(mHeap[pos].mKey, mHeap[pos].mPriority);
+
+            for (size_t child = pos * 2 + 1; child <= pos * 2 + 2 && child < mHeap.size(); ++child)
+            {
+                frontier.push_back(child);
+                std::push_heap(frontier.begin(), frontier.end(), less);
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        KEY mKey;
+        PRIORITY mPriority;
+    };
+
+    void place(size_t pos, Entry&& entry)
+    {
+        mIndex[entry.mKey] = pos;
+        mHeap[pos] = std::move(entry);
+    }
+
+    // Fill the hole at pos with the last entry.  The key at pos must
+    // already be gone from mIndex.
+    void removeAt(size_t pos)
+    {
+        size_t last = mHeap.size() - 1;
+        if (pos != last)
+        {
+            PRIORITY removed = mHeap[pos].mPriority;
+            place(pos, std::move(mHeap[last]));
+            mHeap.pop_back();
+            if (removed < mHeap[pos].mPriority)
+            {
+                siftUp(pos);
+            }
+            else
+            {
+                siftDown(pos);
+            }
+        }
+        else
+        {
+            mHeap.pop_back();
+        }
+    }
+
+    void siftUp(size_t pos)
+    {
+        Entry entry = std::move(mHeap[pos]);
+        while (pos > 0)
+        {
+            size_t parent = (pos - 1) / 2;
+            if (!(mHeap[parent].mPriority < entry.mPriority))
+            {
+                break;
+            }
+            place(pos, std::move(mHeap[parent]));
+            pos = parent;
+        }
+        place(pos, std::move(entry));
+    }
+
+    void siftDown(size_t pos)
+    {
+        Entry entry = std::move(mHeap[pos]);
+        size_t count = mHeap.size();
+        while (true)
+        {
+            size_t child = pos * 2 + 1;
+            if (child >= count)
+            {
+                break;
+            }
+            if (child + 1 < count && mHeap[child].mPriority < mHeap[child + 1].mPriority)
+            {
+                ++child;
+            }
+            if (!(entry.mPriority < mHeap[child].mPriority))
+            {
+                break;
+            }
+            place(pos, std::move(mHeap[child]));
+            pos = child;
+        }
+        place(pos, std::move(entry));
+    }
+
+    std::vector<Entry> mHeap;
+    std::unordered_map<KEY, size_t, HASH> mIndex;
+};
+
+#endif // LL_LLINDEXEDHEAP_H
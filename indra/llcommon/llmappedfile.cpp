@@ -0,0 +1,203 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Cross-platform memory mapped file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmappedfile.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+    close();
+}
+
+bool LLMappedFile::open(const std::string& filename, EMode mode, size_t size)
+{
+    close();
+    mMode = mode;
+
+#if LL_WINDOWS
+    const bool writable = (mode == READ_WRITE);
+    // FILE_SHARE_DELETE lets the file be renamed or deleted while mapped.
+    HANDLE file = CreateFileW(ll_convert_string_to_wide(filename).c_str(),
+                              writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    size_t map_size = (writable && size) ? size : (size_t)file_size.QuadPart;
+    if (!map_size)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    DWORD protect = (mode == READ_WRITE) ? PAGE_READWRITE : (mode == COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READONLY);
+    // CreateFileMapping grows the file to the mapping size if needed
+    HANDLE mapping = CreateFileMappingW(file, nullptr, protect,
+                                        (DWORD)((U64)map_size >> 32), (DWORD)(map_size & 0xFFFFFFFF), nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    DWORD access = (mode == READ_WRITE) ? FILE_MAP_WRITE : (mode == COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_READ);
+    void* data = MapViewOfFile(mapping, access, 0, 0, map_size);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mData = (U8*)data;
+    mSize = map_size;
+#else
+    const bool writable = (mode == READ_WRITE);
+    int fd = ::open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat file_status;
+    if (fstat(fd, &file_status) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t map_size = (size_t)file_status.st_size;
+    if (writable && size && size != map_size)
+    {
+        if (ftruncate(fd, (off_t)size) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        map_size = size;
+    }
+
+    if (!map_size)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    int prot = (mode == READ_ONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+    int flags = (mode == READ_WRITE) ? MAP_SHARED : MAP_PRIVATE;
+    void* data = ::mmap(nullptr, map_size, prot, flags, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    mFD = fd;
+    mData = (U8*)data;
+    mSize = map_size;
+#endif
+
+    return true;
+}
+
+void LLMappedFile::close()
+{
+#if LL_WINDOWS
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle)
+    {
+        CloseHandle((HANDLE)mMappingHandle);
+        mMappingHandle = nullptr;
+    }
+    if (mFileHandle)
+    {
+        CloseHandle((HANDLE)mFileHandle);
+        mFileHandle = nullptr;
+    }
+#else
+    if (mData)
+    {
+        ::munmap(mData, mSize);
+    }
+    if (mFD >= 0)
+    {
+        ::close(mFD);
+        mFD = -1;
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+bool LLMappedFile::flush(bool async)
+{
+    if (!mData || mMode != READ_WRITE)
+    {
+        return false;
+    }
+
+#if LL_WINDOWS
+    if (!FlushViewOfFile(mData, 0))
+    {
+        return false;
+    }
+    return async || FlushFileBuffers((HANDLE)mFileHandle);
+#else
+    return ::msync(mData, mSize, async ? MS_ASYNC : MS_SYNC) == 0;
+#endif
+}
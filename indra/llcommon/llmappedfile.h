@@ -0,0 +1,89 @@
+/**
+ * @file llmappedfile.h
+ * @brief Cross-platform memory mapped file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+
+/**
+ * LLMappedFile maps a whole file into the address space of the process.
+ *
+ * READ_ONLY      - the pages can only be read.
+ * COPY_ON_WRITE  - the pages can be written to, but the changes are private
+ *                  to the process and never reach the file.
+ * READ_WRITE     - the pages are shared with the file. The file is created
+ *                  if needed and resized to the requested size.
+ *
+ * Note that on Windows a file cannot be truncated or replaced while it is
+ * mapped; replace mapped files by writing a new file and renaming it, and
+ * be prepared for the rename to fail.
+ */
+class LL_COMMON_API LLMappedFile : private boost::noncopyable
+{
+public:
+    enum EMode
+    {
+        READ_ONLY,
+        COPY_ON_WRITE,
+        READ_WRITE
+    };
+
+    LLMappedFile();
+    ~LLMappedFile();
+
+    /**
+     * Map filename. In READ_WRITE mode, size is the size the file is
+     * created or resized with; 0 maps the file with its current size.
+     * Returns false if the file could not be opened or is empty.
+     */
+    bool open(const std::string& filename, EMode mode, size_t size = 0);
+    void close();
+
+    /**
+     * Write dirty pages of a READ_WRITE mapping back to the file.
+     * With async set, the write is only scheduled.
+     */
+    bool flush(bool async = false);
+
+    bool isOpen() const     { return mData != nullptr; }
+    U8* getData() const     { return mData; }
+    size_t getSize() const  { return mSize; }
+    EMode getMode() const   { return mMode; }
+
+private:
+    U8*     mData = nullptr;
+    size_t  mSize = 0;
+    EMode   mMode = READ_ONLY;
+#if LL_WINDOWS
+    void*   mFileHandle = nullptr;
+    void*   mMappingHandle = nullptr;
+#else
+    int     mFD = -1;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
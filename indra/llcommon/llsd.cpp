@@ -32,9 +32,11 @@
 
 #include "llerror.h"
 #include "llformat.h"
+#include "llmemory.h"
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <atomic>
 #include <limits>
 
 // Defend against a caller forcibly passing a negative number into an unsigned
@@ -99,6 +101,8 @@ class LLSD::Impl
     bool shared() const                         { return (mUseCount > 1) && (mUseCount != STATIC_USAGE_COUNT); }
 
     U32 mUseCount;
+    bool mInArena;
+        ///< storage was carved from a ScopedArena block
 
     const LLSD::map_t& map() const { static const LLSD::map_t empty; return empty; }
     const std::vector<LLSD>& array() const { static const std::vector<LLSD> empty; return empty; }
@@ -110,6 +114,11 @@ class LLSD::Impl
     static void move(Impl*& var, Impl*& impl);
         ///< safely move impl from one object to another
 
+    template<class IMPL, class... ARGS>
+    static IMPL* create(ARGS&&... args);
+    static void destroy(Impl* impl);
+        ///< allocate and free nodes, from the current ScopedArena if any
+
     static       Impl& safe(      Impl*);
     static const Impl& safe(const Impl*);
         ///< since a NULL Impl* is used for undefined, this ensures there is
@@ -183,6 +192,128 @@ class LLSD::Impl
     static U32 sOutstandingCount;
 };
 
+namespace
+{
+    // Header at the start of every ScopedArena block.  mRefs counts the live
+    // nodes carved from the block, plus one while an arena is still carving
+    // from it.  Nodes may be released from any thread; mUsed is only touched
+    // by the thread owning the arena.
+    struct ArenaBlock
+    {
+        std::atomic<U32> mRefs;
+        size_t mUsed;
+    };
+
+    constexpr size_t ARENA_ALIGNMENT = 16;
+    constexpr size_t ARENA_HEADER_SIZE = (sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    thread_local LLSD::ScopedArena* sCurrentArena = nullptr;
+
+    void release_arena_block(ArenaBlock* block)
+    {
+        if (block->mRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            block->~ArenaBlock();
+            ll_aligned_free<LLSD::ScopedArena::BLOCK_SIZE>(block);
+        }
+    }
+}
+
+LLSD::ScopedArena::ScopedArena()
+    : mPrevious(sCurrentArena)
+    , mBlock(nullptr)
+{
+    sCurrentArena = this;
+}
+
+LLSD::ScopedArena::~ScopedArena()
+{
+    llassert(sCurrentArena == this);
+    if (mBlock)
+    {
+        release_arena_block(static_cast<ArenaBlock*>(mBlock));
+    }
+    sCurrentArena = mPrevious;
+}
+
+void* LLSD::ScopedArena::allocate(size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    if (size > BLOCK_SIZE - ARENA_HEADER_SIZE)
+    {
+        return nullptr;
+    }
+
+    ArenaBlock* block = static_cast<ArenaBlock*>(mBlock);
+    if (!block || block->mUsed + size > BLOCK_SIZE)
+    {
+        if (block)
+        {
+            release_arena_block(block);
+            mBlock = nullptr;
+        }
+        void* mem = ll_aligned_malloc<BLOCK_SIZE>(BLOCK_SIZE);
+        if (!mem)
+        {
+            return nullptr;
+        }
+        block = new (mem) ArenaBlock;
+        block->mRefs.store(1, std::memory_order_relaxed);
+        block->mUsed = ARENA_HEADER_SIZE;
+        mBlock = block;
+    }
+
+    void* ptr = reinterpret_cast<char*>(block) + block->mUsed;
+    block->mUsed += size;
+    block->mRefs.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+// static
+void LLSD::ScopedArena::release(void* ptr)
+{
+    // blocks are aligned to their size, so the header is found by masking
+    uintptr_t base = reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(BLOCK_SIZE - 1);
+    release_arena_block(reinterpret_cast<ArenaBlock*>(base));
+}
+
+template<class IMPL, class... ARGS>
+IMPL* LLSD::Impl::create(ARGS&&... args)
+{
+    static_assert(alignof(IMPL) <= ARENA_ALIGNMENT, "LLSD node over-aligned for ScopedArena");
+
+    void* mem = sCurrentArena ? sCurrentArena->allocate(sizeof(IMPL)) : nullptr;
+    if (!mem)
+    {
+        return new IMPL(std::forward<ARGS>(args)...);
+    }
+
+    IMPL* impl;
+    try
+    {
+        impl = new (mem) IMPL(std::forward<ARGS>(args)...);
+    }
+    catch (...)
+    {
+        ScopedArena::release(mem);
+        throw;
+    }
+    impl->mInArena = true;
+    return impl;
+}
+
+// static
+void LLSD::Impl::destroy(Impl* impl)
+{
+    if (!impl->mInArena)
+    {
+        delete impl;
+        return;
+    }
+    impl->~Impl();
+    ScopedArena::release(impl);
+}
+
 #ifdef NAME_UNNAMED_NAMESPACE
 namespace LLSDUnnamedNamespace
 #else
@@ -381,11 +512,9 @@ namespace
 
         DataMap mData;
 
-    protected:
-        ImplMap(DataMap data) : mData(std::move(data)) { }
-
     public:
         ImplMap() = default;
+        ImplMap(DataMap data) : mData(std::move(data)) { }
 
         ImplMap& makeMap(LLSD::Impl*&) override;
 
@@ -424,7 +553,7 @@ namespace
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
         if (shared())
         {
-            ImplMap* i = new ImplMap(mData);
+            ImplMap* i = create<ImplMap>(mData);
             Impl::assign(var, i);
             return *i;
         }
@@ -530,11 +659,9 @@ namespace
 
         DataVector mData;
 
-    protected:
-        ImplArray(DataVector data) : mData(std::move(data)) { }
-
     public:
         ImplArray() = default;
+        ImplArray(DataVector data) : mData(std::move(data)) { }
 
         ImplArray& makeArray(Impl*&) override;
 
@@ -571,7 +698,7 @@ namespace
     {
         if (shared())
         {
-            ImplArray* i = new ImplArray(mData);
+            ImplArray* i = create<ImplArray>(mData);
             Impl::assign(var, i);
             return *i;
         }
@@ -675,6 +802,7 @@ namespace
 
 LLSD::Impl::Impl()
     : mUseCount(0)
+    , mInArena(false)
 {
     ++sAllocationCount;
     ++sOutstandingCount;
@@ -682,6 +810,7 @@ LLSD::Impl::Impl()
 
 LLSD::Impl::Impl(StaticAllocationMarker)
     : mUseCount(0)
+    , mInArena(false)
 {
 }
 
@@ -700,7 +829,7 @@ void LLSD::Impl::reset(Impl*& var, Impl* impl)
         }
         if (var && var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
         {
-            delete var;
+            destroy(var);
         }
         var = impl;
     }
@@ -712,7 +841,7 @@ void LLSD::Impl::move(Impl*& var, Impl*& impl)
 
     if (var && var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
     {
-        delete var; // destroy var if usage falls to 0 and not static
+        destroy(var); // destroy var if usage falls to 0 and not static
     }
     var = impl; // Steal impl to var without incrementing use since this is a move
     impl = nullptr; // null out old-impl pointer
@@ -733,14 +862,14 @@ const LLSD::Impl& LLSD::Impl::safe(const Impl* impl)
 ImplMap& LLSD::Impl::makeMap(Impl*& var)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-    ImplMap* im = new ImplMap;
+    ImplMap* im = create<ImplMap>();
     reset(var, im);
     return *im;
 }
 
 ImplArray& LLSD::Impl::makeArray(Impl*& var)
 {
-    ImplArray* ia = new ImplArray;
+    ImplArray* ia = create<ImplArray>();
     reset(var, ia);
     return *ia;
 }
@@ -758,42 +887,42 @@ void LLSD::Impl::assignUndefined(Impl*& var)
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Boolean v)
 {
-    reset(var, new ImplBoolean(v));
+    reset(var, create<ImplBoolean>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Integer v)
 {
-    reset(var, new ImplInteger(v));
+    reset(var, create<ImplInteger>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Real v)
 {
-    reset(var, new ImplReal(v));
+    reset(var, create<ImplReal>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::String v)
 {
-    reset(var, new ImplString(std::move(v)));
+    reset(var, create<ImplString>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::UUID v)
 {
-    reset(var, new ImplUUID(std::move(v)));
+    reset(var, create<ImplUUID>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Date v)
 {
-    reset(var, new ImplDate(std::move(v)));
+    reset(var, create<ImplDate>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::URI v)
 {
-    reset(var, new ImplURI(std::move(v)));
+    reset(var, create<ImplURI>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Binary v)
 {
-    reset(var, new ImplBinary(std::move(v)));
+    reset(var, create<ImplBinary>(std::move(v)));
 }
 
 
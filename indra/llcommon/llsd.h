@@ -455,6 +455,51 @@ class LL_COMMON_API LLSD final
         friend class LLSD::Impl;
     //@}
 
+public:
+    /** @name Arena Allocation
+        While a ScopedArena is alive, the LLSD nodes created on its thread
+        are carved out of large shared blocks instead of being individually
+        allocated on the heap.  This is meant for documents which are parsed
+        once and then only read, e.g.:
+
+            LLSD::ScopedArena arena;
+            LLSDSerialize::fromBinary(sd, buffer);
+
+        Nodes keep working normally after the arena goes out of scope and may
+        be handed to other threads; a block is released once the last node
+        carved from it is destroyed.  Hence a single long lived node keeps its
+        whole block alive, so do not use an arena for data that is edited
+        piecemeal over a long time.  Only the nodes themselves come from the
+        arena; string, binary and container storage still uses the heap.
+
+        Arenas nest and must be destroyed in reverse order of creation on the
+        thread that created them.
+     */
+    //@{
+        class LL_COMMON_API ScopedArena
+        {
+        public:
+            ScopedArena();
+            ~ScopedArena();
+
+            ScopedArena(const ScopedArena&) = delete;
+            ScopedArena& operator=(const ScopedArena&) = delete;
+
+            /// Size and alignment of the blocks nodes are carved from.
+            static constexpr size_t BLOCK_SIZE = 32 * 1024;
+
+        private:
+            friend class LLSD::Impl;
+
+            /// Returns nullptr if size does not fit in a block.
+            void* allocate(size_t size);
+            static void release(void* ptr);
+
+            ScopedArena* mPrevious;
+            void* mBlock;
+        };
+    //@}
+
 private:
     /** @name Debugging Interface */
     //@{
@@ -1277,6 +1277,338 @@ bool LLSDBinaryParser::parseString(
     return true;
 }
 
+namespace
+{
+    // Cursor based twin of LLSDBinaryParser for documents which are entirely
+    // in memory.  It accepts the same input, but reads straight out of the
+    // buffer instead of going through std::istream one byte at a time, and
+    // since element counts are known up front containers are reserved and
+    // children are parsed directly into place.  The end of the buffer takes
+    // the place of the max_bytes limit.
+    class LLSDBinaryBufferParser
+    {
+    public:
+        LLSDBinaryBufferParser(const char* data, size_t size)
+            : mCur(data), mEnd(data + size)
+        {
+        }
+
+        S32 parse(LLSD& data, S32 max_depth);
+
+    private:
+        size_t left() const { return mEnd - mCur; }
+
+        bool read(void* dest, size_t size)
+        {
+            if (size > left()) return false;
+            memcpy(dest, mCur, size);
+            mCur += size;
+            return true;
+        }
+
+        bool readSize(S32& size)
+        {
+            U32 size_nbo = 0;
+            if (!read(&size_nbo, sizeof(U32))) return false;
+            size = (S32)ntohl(size_nbo);
+            return size >= 0;
+        }
+
+        bool readString(std::string& value);
+        bool readDelimString(std::string& value, char delim);
+        S32 parseMap(LLSD& map, S32 max_depth);
+        S32 parseArray(LLSD& array, S32 max_depth);
+
+        const char* mCur;
+        const char* mEnd;
+    };
+
+    S32 LLSDBinaryBufferParser::parse(LLSD& data, S32 max_depth)
+    {
+        if (!left())
+        {
+            return 0;
+        }
+        if (max_depth == 0)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+
+        S32 parse_count = 1;
+        char c = *mCur++;
+        switch (c)
+        {
+        case '{':
+        {
+            S32 child_count = parseMap(data, max_depth - 1);
+            parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? child_count : parse_count + child_count;
+            break;
+        }
+
+        case '[':
+        {
+            S32 child_count = parseArray(data, max_depth - 1);
+            parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? child_count : parse_count + child_count;
+            break;
+        }
+
+        case '!':
+            data.clear();
+            break;
+
+        case '0':
+            data = false;
+            break;
+
+        case '1':
+            data = true;
+            break;
+
+        case 'i':
+        {
+            U32 value_nbo = 0;
+            if (!read(&value_nbo, sizeof(U32)))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = (S32)ntohl(value_nbo);
+            break;
+        }
+
+        case 'r':
+        {
+            F64 real_nbo = 0.0;
+            if (!read(&real_nbo, sizeof(F64)))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = ll_ntohd(real_nbo);
+            break;
+        }
+
+        case 'u':
+        {
+            LLUUID id;
+            if (!read(id.mData, UUID_BYTES))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = id;
+            break;
+        }
+
+        case '\'':
+        case '"':
+        {
+            std::string value;
+            if (!readDelimString(value, c))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = std::move(value);
+            break;
+        }
+
+        case 's':
+        {
+            std::string value;
+            if (!readString(value))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = std::move(value);
+            break;
+        }
+
+        case 'l':
+        {
+            std::string value;
+            if (!readString(value))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = LLURI(value);
+            break;
+        }
+
+        case 'd':
+        {
+            F64 real = 0.0;
+            if (!read(&real, sizeof(F64)))
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = LLDate(real);
+            break;
+        }
+
+        case 'b':
+        {
+            S32 size = 0;
+            if (!readSize(size) || (size_t)size > left())
+            {
+                parse_count = LLSDParser::PARSE_FAILURE;
+                break;
+            }
+            data = LLSD::Binary(mCur, mCur + size);
+            mCur += size;
+            break;
+        }
+
+        default:
+            parse_count = LLSDParser::PARSE_FAILURE;
+            LL_INFOS() << "Unrecognized character while parsing: int(" << int(c)
+                << ")" << LL_ENDL;
+            break;
+        }
+        if (LLSDParser::PARSE_FAILURE == parse_count)
+        {
+            data.clear();
+        }
+        return parse_count;
+    }
+
+    S32 LLSDBinaryBufferParser::parseMap(LLSD& map, S32 max_depth)
+    {
+        map = LLSD::emptyMap();
+        S32 size = 0;
+        if (!readSize(size))
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+
+        // every entry takes at least a key tag and a value tag, so a corrupt
+        // count cannot make us reserve more than the buffer could hold
+        LLSD::map_t& values = map.asMap();
+        values.reserve(std::min((size_t)size, left() / 2));
+
+        S32 parse_count = 0;
+        S32 count = 0;
+        std::string name;
+        while (left() && *mCur != '}' && count < size)
+        {
+            char c = *mCur++;
+            name.clear();
+            switch (c)
+            {
+            case 'k':
+                if (!readString(name))
+                {
+                    return LLSDParser::PARSE_FAILURE;
+                }
+                break;
+            case '\'':
+            case '"':
+                if (!readDelimString(name, c))
+                {
+                    return LLSDParser::PARSE_FAILURE;
+                }
+                break;
+            }
+
+            // Like LLSD::insert(), the first value of a duplicated key wins.
+            auto inserted = values.try_emplace(std::move(name));
+            LLSD discard;
+            S32 child_count = parse(inserted.second ? inserted.first->second : discard, max_depth);
+            if (child_count <= 0)
+            {
+                // There must be a value for every key.
+                return LLSDParser::PARSE_FAILURE;
+            }
+            parse_count += child_count;
+            ++count;
+        }
+        if (!left() || *mCur++ != '}' || count < size)
+        {
+            // Make sure it is correctly terminated and we parsed as many
+            // as were said to be there.
+            return LLSDParser::PARSE_FAILURE;
+        }
+        return parse_count;
+    }
+
+    S32 LLSDBinaryBufferParser::parseArray(LLSD& array, S32 max_depth)
+    {
+        array = LLSD::emptyArray();
+        S32 size = 0;
+        if (!readSize(size))
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+
+        LLSD::array_t& values = array.asArray();
+        values.reserve(std::min((size_t)size, left()));
+
+        S32 parse_count = 0;
+        S32 count = 0;
+        while (left() && *mCur != ']' && count < size)
+        {
+            values.emplace_back();
+            S32 child_count = parse(values.back(), max_depth);
+            if (child_count <= 0)
+            {
+                return LLSDParser::PARSE_FAILURE;
+            }
+            parse_count += child_count;
+            ++count;
+        }
+        if (!left() || *mCur++ != ']' || count < size)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        return parse_count;
+    }
+
+    bool LLSDBinaryBufferParser::readString(std::string& value)
+    {
+        S32 size = 0;
+        if (!readSize(size) || (size_t)size > left())
+        {
+            return false;
+        }
+        value.assign(mCur, size);
+        mCur += size;
+        return true;
+    }
+
+    bool LLSDBinaryBufferParser::readDelimString(std::string& value, char delim)
+    {
+        const char* end = static_cast<const char*>(memchr(mCur, delim, left()));
+        if (end && !memchr(mCur, '\\', end - mCur))
+        {
+            value.assign(mCur, end);
+            mCur = end + 1;
+            return true;
+        }
+
+        // Escaped strings are rare enough to leave decoding them to the
+        // stream code.
+        boost::iostreams::stream<boost::iostreams::array_source> istr(mCur, left());
+        llssize count = deserialize_string_delim(istr, value, delim);
+        if (LLSDParser::PARSE_FAILURE == count)
+        {
+            return false;
+        }
+        mCur += count;
+        return true;
+    }
+}
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, std::string_view buffer, S32 max_depth)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    LLSDBinaryBufferParser parser(buffer.data(), buffer.size());
+    return parser.parse(sd, max_depth);
+}
+
 
 /**
  * LLSDFormatter
@@ -2342,9 +2674,7 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
     {
         char* result_ptr = strip_deprecated_header((char*)result, cur_size);
 
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+        if (!LLSDSerialize::fromBinary(data, std::string_view(result_ptr, cur_size), UNZIP_LLSD_MAX_DEPTH))
         {
             free(result);
             return ZR_PARSE_ERROR;
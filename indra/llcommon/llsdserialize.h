@@ -847,6 +847,11 @@ class LL_COMMON_API LLSDSerialize
         (void)p->parse(str, sd, max_bytes, max_depth);
         return sd;
     }
+    // Buffer based parser, several times faster than the stream based
+    // fromBinary() but only usable when the whole document, without any
+    // header, is in memory.  Returns the number of parsed LLSD objects or
+    // LLSDParser::PARSE_FAILURE.
+    static S32 fromBinary(LLSD& sd, std::string_view buffer, S32 max_depth = -1);
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
@@ -0,0 +1,169 @@
+/**
+ * @file   llindexedheap_test.cpp
+ * @date   2024-06
+ * @brief  Test for llindexedheap.h.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llindexedheap.h"
+// STL headers
+#include <map>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+#include "llrand.h"
+#include "stringize.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llindexedheap_data
+    {
+        typedef LLIndexedHeap<S32, F32> heap_t;
+
+        // pop everything, checking the order and the priorities
+        std::vector<S32> drain(heap_t& heap)
+        {
+            std::vector<S32> keys;
+            F32 last = 0.f;
+            while (!heap.empty())
+            {
+                F32 priority = heap.topPriority();
+                ensure(stringize("descending at ", keys.size()), keys.empty() || priority <= last);
+                last = priority;
+                keys.push_back(heap.top());
+                heap.pop();
+            }
+            return keys;
+        }
+    };
+    typedef test_group<llindexedheap_data> llindexedheap_group;
+    typedef llindexedheap_group::object object;
+    llindexedheap_group llindexedheapgrp("llindexedheap");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("set, pop and reprioritize");
+        heap_t heap;
+        ensure("starts empty", heap.empty());
+        heap.set(1, 10.f);
+        heap.set(2, 30.f);
+        heap.set(3, 20.f);
+        ensure_equals("size", heap.size(), (size_t)3);
+        ensure_equals("top", heap.top(), 2);
+
+        heap.set(1, 40.f);          // raise
+        ensure_equals("raised to top", heap.top(), 1);
+        heap.set(1, 5.f);           // lower
+        ensure_equals("lowered away", heap.top(), 2);
+        ensure_equals("no duplicates", heap.size(), (size_t)3);
+
+        ensure("update known", heap.update(3, 50.f));
+        ensure("update unknown", !heap.update(4, 60.f));
+        ensure("unknown not inserted", !heap.contains(4));
+
+        F32 priority = 0.f;
+        ensure("getPriority", heap.getPriority(3, priority));
+        ensure_equals("priority", priority, 50.f);
+
+        std::vector<S32> expected{ 3, 2, 1 };
+        ensure("order", drain(heap) == expected);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("erase from the middle keeps the heap valid");
+        heap_t heap;
+        for (S32 i = 0; i < 100; ++i)
+        {
+            heap.set(i, (F32)((i * 37) % 100));
+        }
+        for (S32 i = 0; i < 100; i += 3)
+        {
+            ensure(stringize("erase ", i), heap.erase(i));
+        }
+        ensure("erase twice", !heap.erase(0));
+        ensure_equals("size", heap.size(), (size_t)66);
+
+        std::vector<S32> keys = drain(heap);
+        ensure_equals("drained", keys.size(), (size_t)66);
+        for (S32 key : keys)
+        {
+            ensure(stringize("erased key ", key, " came back"), key % 3 != 0);
+        }
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("random updates agree with a reference map");
+        heap_t heap;
+        std::map<S32, F32> reference;
+        for (S32 step = 0; step < 5000; ++step)
+        {
+            S32 key = ll_rand(200);
+            S32 op = ll_rand(4);
+            if (op == 0)
+            {
+                heap.erase(key);
+                reference.erase(key);
+            }
+            else
+            {
+                F32 priority = (F32)ll_rand(1000);
+                heap.set(key, priority);
+                reference[key] = priority;
+            }
+        }
+
+        ensure_equals("size", heap.size(), reference.size());
+        F32 best = -1.f;
+        for (const auto& pair : reference)
+        {
+            best = llmax(best, pair.second);
+        }
+        ensure_equals("top priority", heap.topPriority(), best);
+        ensure_equals("top key's priority", reference[heap.top()], best);
+
+        std::vector<S32> keys = drain(heap);
+        ensure_equals("drained", keys.size(), reference.size());
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("visitTop walks the best entries without popping");
+        heap_t heap;
+        for (S32 i = 0; i < 1000; ++i)
+        {
+            heap.set(i, (F32)((i * 7919) % 1000));
+        }
+
+        std::vector<F32> seen;
+        heap.visitTop(10, [&seen](S32 key, F32 priority) { seen.push_back(priority); });
+        ensure_equals("visited", seen.size(), (size_t)10);
+        for (size_t i = 0; i < seen.size(); ++i)
+        {
+            ensure_equals(stringize("rank ", i), seen[i], (F32)(999 - i));
+        }
+        ensure_equals("untouched", heap.size(), (size_t)1000);
+
+        seen.clear();
+        heap_t small;
+        small.set(1, 1.f);
+        small.visitTop(5, [&seen](S32 key, F32 priority) { seen.push_back(priority); });
+        ensure_equals("fewer than asked", seen.size(), (size_t)1);
+    }
+} // namespace tut
@@ -0,0 +1,150 @@
+/**
+ * @file llsdbinaryparse_test.cpp
+ * @date 2024-06
+ * @brief Compares the stream and buffer based binary LLSD parsers.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llsd.h"
+#include "../llsdserialize.h"
+#include "../llsdutil.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include <functional>
+
+namespace tut
+{
+    struct LLSDBinaryParseFixture
+    {
+        // Roughly the shape of an inventory fetch reply: many small maps
+        // with ids, names, numbers and dates.
+        static LLSD makeFolder(S32 items)
+        {
+            LLSD folder;
+            folder["folder_id"] = LLUUID::generateNewID();
+            folder["owner_id"] = LLUUID::generateNewID();
+            folder["version"] = 42;
+            folder["descendents"] = items;
+            LLSD& list = folder["items"];
+            for (S32 i = 0; i < items; ++i)
+            {
+                LLSD item;
+                item["item_id"] = LLUUID::generateNewID();
+                item["parent_id"] = folder["folder_id"];
+                item["asset_id"] = LLUUID::generateNewID();
+                item["name"] = stringize("Inventory item number ", i);
+                item["desc"] = "(No Description)";
+                item["type"] = i % 24;
+                item["inv_type"] = i % 20;
+                item["flags"] = i * 13;
+                item["created_at"] = LLDate((F64)(1500000000 + i));
+                LLSD& permissions = item["permissions"];
+                permissions["base_mask"] = 0x7fffffff;
+                permissions["owner_mask"] = 0x7fffffff;
+                permissions["group_mask"] = 0;
+                permissions["everyone_mask"] = 0;
+                permissions["next_owner_mask"] = 0x82000;
+                permissions["creator_id"] = LLUUID::generateNewID();
+                LLSD& sale = item["sale_info"];
+                sale["sale_price"] = 10;
+                sale["sale_type"] = "not";
+                list.append(item);
+            }
+            return folder;
+        }
+
+        LLSDBinaryParseFixture()
+        {
+            LLSD folders;
+            for (S32 i = 0; i < 50; ++i)
+            {
+                folders.append(makeFolder(200));
+            }
+            mDocument["folders"] = folders;
+
+            std::ostringstream str;
+            LLSDSerialize::toBinary(mDocument, str);
+            mBuffer = str.str();
+        }
+
+        void check(const std::string& name, const std::function<void(LLSD&)>& parse)
+        {
+            LLSD parsed;
+            parse(parsed);
+            ensure(name + " result", llsd_equals(parsed, mDocument));
+        }
+
+        LLSD mDocument;
+        std::string mBuffer;
+    };
+    typedef test_group<LLSDBinaryParseFixture> LLSDBinaryParse_factory;
+    typedef LLSDBinaryParse_factory::object LLSDBinaryParse_t;
+    LLSDBinaryParse_factory tf("LLSD binary parse");
+
+    template<> template<>
+    void LLSDBinaryParse_t::test<1>()
+    {
+        set_test_name("stream parser, buffer parser and buffer parser with arena agree");
+
+        check("stream", [this](LLSD& parsed)
+            {
+                boost::iostreams::stream<boost::iostreams::array_source> istr(mBuffer.data(), mBuffer.size());
+                LLSDSerialize::fromBinary(parsed, istr, mBuffer.size());
+            });
+
+        check("buffer", [this](LLSD& parsed)
+            {
+                LLSDSerialize::fromBinary(parsed, mBuffer);
+            });
+
+        check("buffer + arena", [this](LLSD& parsed)
+            {
+                LLSD::ScopedArena arena;
+                LLSDSerialize::fromBinary(parsed, mBuffer);
+            });
+    }
+
+    template<> template<>
+    void LLSDBinaryParse_t::test<2>()
+    {
+        set_test_name("arena documents outlive their arena and free cleanly");
+
+        LLSD parsed;
+        {
+            LLSD::ScopedArena arena;
+            ensure("parse", LLSDSerialize::fromBinary(parsed, mBuffer) > 0);
+        }
+        // copy-on-write edits after the arena is gone go back to the heap
+        parsed["folders"][0]["version"] = 43;
+        LLSD kept = parsed["folders"][1];
+        parsed.clear();
+        ensure("kept subtree", llsd_equals(kept, mDocument["folders"][1]));
+    }
+}
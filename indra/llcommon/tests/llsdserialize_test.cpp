@@ -602,6 +602,65 @@ namespace tut
     };
 |*==========================================================================*/
 
+    template<> template<>
+    void TestLLSDSerializeObject::test<11>()
+    {
+        setFormatterParser(new LLSDBinaryFormatter(), new LLSDBinaryParser());
+        mParser = [](std::istream& istr, LLSD& data, llssize)
+        {
+            std::string buffer{ std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>() };
+            return LLSDSerialize::fromBinary(data, buffer) > 0;
+        };
+        doRoundTripTests("binary buffer serialization");
+    }
+
+    template<> template<>
+    void TestLLSDSerializeObject::test<12>()
+    {
+        setFormatterParser(new LLSDBinaryFormatter(), new LLSDBinaryParser());
+        mParser = [](std::istream& istr, LLSD& data, llssize)
+        {
+            std::string buffer{ std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>() };
+            LLSD::ScopedArena arena;
+            return LLSDSerialize::fromBinary(data, buffer) > 0;
+        };
+        doRoundTripTests("binary buffer serialization into an arena");
+    }
+
+    template<> template<>
+    void TestLLSDSerializeObject::test<13>()
+    {
+        set_test_name("binary buffer parser rejects truncated input");
+
+        LLSD sd;
+        sd["name"] = "some object";
+        sd["id"] = LLUUID::generateNewID();
+        sd["list"].append(1.5);
+        sd["list"].append(LLSD::Binary(10, 'x'));
+        sd["list"].append("done");
+        std::ostringstream str;
+        LLSDSerialize::toBinary(sd, str);
+        const std::string buffer = str.str();
+
+        LLSD parsed;
+        ensure("complete", LLSDSerialize::fromBinary(parsed, buffer) > 0);
+        ensure("same as stream parser", llsd_equals(parsed, sd));
+        for (size_t size = 1; size < buffer.size(); ++size)
+        {
+            ensure_equals(stringize("truncated to ", size),
+                          LLSDSerialize::fromBinary(parsed, std::string_view(buffer.data(), size)),
+                          LLSDParser::PARSE_FAILURE);
+            ensure(stringize("cleared at ", size), parsed.isUndefined());
+        }
+
+        std::istringstream escaped("{" + std::string("\0\0\0\1", 4) + "'it\\'s''a\\x41\\tb'}");
+        LLSD expected;
+        ensure("stream parser", LLSDSerialize::fromBinary(expected, escaped, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure("buffer parser", LLSDSerialize::fromBinary(parsed, escaped.str()) > 0);
+        ensure_equals("escaped key and value", parsed["it's"].asString(), "aA\tb");
+        ensure("escapes match", llsd_equals(parsed, expected));
+    }
+
     /**
      * @class TestLLSDParsing
      * @brief Base class for of a parse tester.
@@ -0,0 +1,197 @@
+/**
+ * @file   workstealingqueue_test.cpp
+ * @date   2024-06
+ * @brief  Test for WorkStealingQueue, plus a contention benchmark against
+ *         WorkQueue.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "workqueue.h"
+// STL headers
+// std headers
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+#include "stringize.h"
+
+using namespace LL;
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct workstealingqueue_data
+    {
+        // run WorkQueueBase::runUntilClose() on that many threads
+        void startWorkers(WorkQueueBase& queue, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                mThreads.emplace_back([&queue]() { queue.runUntilClose(); });
+            }
+        }
+
+        void joinWorkers()
+        {
+            for (auto& thread : mThreads)
+            {
+                thread.join();
+            }
+            mThreads.clear();
+        }
+
+        // Post tiny work items from several producer threads and return how
+        // long the workers took to run them all, in milliseconds.
+        F64 stress(WorkQueueBase& queue, size_t workers, size_t producers, size_t items)
+        {
+            std::atomic<size_t> done{ 0 };
+            auto start = std::chrono::steady_clock::now();
+            startWorkers(queue, workers);
+
+            std::vector<std::thread> posters;
+            for (size_t p = 0; p < producers; ++p)
+            {
+                posters.emplace_back([&queue, &done, items, producers]()
+                    {
+                        for (size_t i = 0; i < items / producers; ++i)
+                        {
+                            queue.post([&done]() { ++done; });
+                        }
+                    });
+            }
+            for (auto& poster : posters)
+            {
+                poster.join();
+            }
+            queue.close();
+            joinWorkers();
+
+            ensure_equals("every item ran", done.load(), (items / producers) * producers);
+            return std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::vector<std::thread> mThreads;
+    };
+    typedef test_group<workstealingqueue_data> workstealingqueue_group;
+    typedef workstealingqueue_group::object object;
+    workstealingqueue_group workstealingqueuegrp("workstealingqueue");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("post, run and drain on close");
+        WorkStealingQueue queue("stealing1");
+        ensure("findable", WorkStealingQueue::getInstance("stealing1").get() == &queue);
+
+        std::atomic<int> sum{ 0 };
+        for (int i = 1; i <= 100; ++i)
+        {
+            ensure("post", queue.post([&sum, i]() { sum += i; }));
+        }
+        ensure_equals("queued before workers start", queue.size(), (size_t)100);
+
+        startWorkers(queue, 4);
+        for (int i = 101; i <= 1000; ++i)
+        {
+            queue.post([&sum, i]() { sum += i; });
+        }
+        queue.close();
+        ensure("no posting once closed", !queue.post([]() {}));
+        joinWorkers();
+
+        ensure_equals("every item ran once", sum.load(), 500500);
+        ensure("drained", queue.done());
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("batches and posts from workers are spread by stealing");
+        WorkStealingQueue queue("stealing2", 1024 * 1024);
+        std::atomic<size_t> ran{ 0 };
+
+        // Each root item fans out into children posted from the worker
+        // thread, which land on that worker's own deque: the other workers
+        // only get them by stealing.
+        std::vector<WorkQueueBase::Work> batch;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            batch.emplace_back([&queue, &ran]()
+                {
+                    for (size_t child = 0; child < 2000; ++child)
+                    {
+                        queue.post([&ran]()
+                            {
+                                std::this_thread::sleep_for(std::chrono::microseconds(1));
+                                ++ran;
+                            });
+                    }
+                    ++ran;
+                });
+        }
+        startWorkers(queue, 4);
+        ensure("batch", queue.postBatch(std::move(batch)));
+
+        while (ran < 8 * 2001)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        queue.close();
+        joinWorkers();
+
+        WorkStealingQueue::Stats stats = queue.getStats();
+        ensure_equals("posted", stats.mPosted, (U64)(8 * 2001));
+        ensure_equals("depth", stats.mDepth, (size_t)0);
+        ensure("idle workers stole", stats.mSteals > 0);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("tryPost respects capacity");
+        WorkStealingQueue queue("stealing3", 4);
+        for (int i = 0; i < 4; ++i)
+        {
+            ensure("room left", queue.tryPost([]() {}));
+        }
+        ensure("full", !queue.tryPost([]() {}));
+        ensure("runOne", queue.runOne());
+        ensure("room again", queue.tryPost([]() {}));
+        queue.close();
+        ensure("closed", !queue.tryPost([]() {}));
+        ensure("still draining", !queue.runPending());
+        ensure("drained", queue.done());
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("contention benchmark: WorkQueue vs WorkStealingQueue");
+        const size_t items = 200000;
+        const size_t workers = 8;
+        const size_t producers = 2;
+
+        WorkQueue shared("shared", 1024 * 1024);
+        F64 shared_time = stress(shared, workers, producers, items);
+
+        WorkStealingQueue stealing("stealing4", 1024 * 1024);
+        F64 stealing_time = stress(stealing, workers, producers, items);
+
+        WorkStealingQueue::Stats stats = stealing.getStats();
+        LL_INFOS() << items << " tiny items, " << workers << " workers, " << producers << " producers: "
+                   << "WorkQueue " << shared_time << " ms, WorkStealingQueue " << stealing_time
+                   << " ms (" << stats.mSteals << " stolen in " << stats.mStealAttempts << " attempts)"
+                   << LL_ENDL;
+    }
+} // namespace tut
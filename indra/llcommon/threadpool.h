@@ -136,6 +136,10 @@ namespace LL
     /// ThreadPool is shorthand for using the simpler WorkQueue
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
 
+    /// WorkStealingThreadPool gives each worker thread its own deque, for
+    /// pools busy enough that a single queue lock becomes contended
+    using WorkStealingThreadPool = ThreadPoolUsing<WorkStealingQueue>;
+
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_H) */
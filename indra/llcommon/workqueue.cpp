@@ -21,7 +21,10 @@
 #include LLCOROS_MUTEX_HEADER
 #include "llerror.h"
 #include "llexception.h"
+#include "lltrace.h"
 #include "stringize.h"
+#include <deque>
+#include <mutex>
 
 using Mutex = LLCoros::Mutex;
 using Lock  = LLCoros::LockType;
@@ -243,3 +246,384 @@ bool LL::WorkSchedule::tryPop_(Work& work)
 {
     return mQueue.tryPop(work);
 }
+
+/*****************************************************************************
+*   WorkStealingQueue
+*****************************************************************************/
+namespace
+{
+    LLTrace::SampleStatHandle<> sWorkStealingDepth("workstealingdepth",
+                                                   "Work items waiting in all WorkStealingQueues");
+    LLTrace::CountStatHandle<> sWorkStealingSteals("workstealingsteals",
+                                                   "Work items taken from another worker's deque");
+
+    // most items a thief takes from one victim at a time
+    constexpr size_t MAX_STEAL = 32;
+
+    // unique id for every WorkStealingQueue, so that a stale entry in a
+    // thread's worker slots can never match a new queue at the same address
+    std::atomic<U64> sNextQueueId{ 0 };
+
+    // (queue id, worker slot) for each WorkStealingQueue this thread consumes
+    thread_local std::vector<std::pair<U64, size_t>> sWorkerSlots;
+}
+
+// Each deque sits on its own cache line so workers don't false-share.
+struct alignas(64) LL::WorkStealingQueue::Worker
+{
+    std::mutex mMutex;
+    std::deque<Work> mWork;
+    // mirrors mWork.size() so thieves can skip empty deques without locking
+    std::atomic<size_t> mCount{ 0 };
+};
+
+LL::WorkStealingQueue::WorkStealingQueue(const std::string& name, size_t capacity):
+    super(name),
+    mWorkers(new Worker[MAX_WORKERS + 1]),
+    mQueueId(++sNextQueueId),
+    mCapacity(capacity)
+{
+}
+
+LL::WorkStealingQueue::~WorkStealingQueue()
+{
+    close();
+}
+
+void LL::WorkStealingQueue::close()
+{
+    mClosed = true;
+    LLCoros::LockType lock(mSleepMutex);
+    mWorkCondition.notify_all();
+    mSpaceCondition.notify_all();
+}
+
+size_t LL::WorkStealingQueue::size()
+{
+    return mSize;
+}
+
+bool LL::WorkStealingQueue::isClosed()
+{
+    return mClosed;
+}
+
+bool LL::WorkStealingQueue::done()
+{
+    return mClosed && !mSize;
+}
+
+bool LL::WorkStealingQueue::post(const Work& callable)
+{
+    if (mClosed || (mSize >= mCapacity && !waitForSpace()))
+    {
+        return false;
+    }
+    Worker* worker = getWorker();
+    if (!push(worker ? worker : nextTarget(), callable))
+    {
+        return false;
+    }
+    wakeWorkers(1);
+    return true;
+}
+
+bool LL::WorkStealingQueue::tryPost(const Work& callable)
+{
+    if (mClosed || mSize >= mCapacity)
+    {
+        return false;
+    }
+    Worker* worker = getWorker();
+    if (!push(worker ? worker : nextTarget(), callable))
+    {
+        return false;
+    }
+    wakeWorkers(1);
+    return true;
+}
+
+bool LL::WorkStealingQueue::postBatch(std::vector<Work>&& batch)
+{
+    if (mClosed || (mSize >= mCapacity && !waitForSpace()))
+    {
+        return false;
+    }
+    const size_t count = batch.size();
+    if (!count)
+    {
+        return true;
+    }
+
+    // Count the whole batch in before checking mClosed again: see push().
+    mSize += count;
+    if (mClosed)
+    {
+        mSize -= count;
+        return false;
+    }
+    mPosted += count;
+
+    auto append = [](Worker* worker, std::vector<Work>::iterator begin, std::vector<Work>::iterator end)
+    {
+        std::lock_guard<std::mutex> lock(worker->mMutex);
+        worker->mWork.insert(worker->mWork.end(), std::make_move_iterator(begin), std::make_move_iterator(end));
+        worker->mCount = worker->mWork.size();
+    };
+
+    Worker* self = getWorker();
+    const size_t workers = std::min(mWorkerCount.load(), MAX_WORKERS);
+    if (self || !workers)
+    {
+        append(self ? self : &mWorkers[0], batch.begin(), batch.end());
+    }
+    else
+    {
+        // hand every worker an equal slice, starting where post() left off
+        const size_t slice = (count + workers - 1) / workers;
+        size_t target = mNextTarget.fetch_add(workers);
+        for (size_t begin = 0; begin < count; begin += slice, ++target)
+        {
+            size_t end = std::min(begin + slice, count);
+            append(&mWorkers[1 + target % workers], batch.begin() + begin, batch.begin() + end);
+        }
+    }
+    batch.clear();
+
+    wakeWorkers(count);
+    return true;
+}
+
+LL::WorkStealingQueue::Stats LL::WorkStealingQueue::getStats() const
+{
+    Stats stats;
+    stats.mDepth = mSize;
+    stats.mPosted = mPosted;
+    stats.mSteals = mSteals;
+    stats.mStealAttempts = mStealAttempts;
+    return stats;
+}
+
+void LL::WorkStealingQueue::setTraceStats(LLTrace::SampleStatHandle<F64>* depth,
+                                          LLTrace::CountStatHandle<F64>* steals)
+{
+    mTraceDepth = depth;
+    mTraceSteals = steals;
+}
+
+//static
+void LL::WorkStealingQueue::sampleStats()
+{
+    size_t depth = 0;
+    U64 steals = 0;
+    // instance_snapshot would hand us WorkQueueBase references
+    for (const auto& pair : WorkStealingQueue::snapshot())
+    {
+        WorkStealingQueue& queue = *pair.second;
+        size_t queue_depth = queue.mSize;
+        U64 queue_steals = queue.mSteals;
+        U64 new_steals = queue_steals - queue.mReportedSteals;
+        queue.mReportedSteals = queue_steals;
+
+        if (queue.mTraceDepth)
+        {
+            LLTrace::sample(*queue.mTraceDepth, (F64)queue_depth);
+        }
+        if (queue.mTraceSteals && new_steals)
+        {
+            LLTrace::add(*queue.mTraceSteals, (F64)new_steals);
+        }
+        depth += queue_depth;
+        steals += new_steals;
+    }
+    LLTrace::sample(sWorkStealingDepth, (F64)depth);
+    if (steals)
+    {
+        LLTrace::add(sWorkStealingSteals, (F64)steals);
+    }
+}
+
+LL::WorkStealingQueue::Worker* LL::WorkStealingQueue::getWorker()
+{
+    for (const auto& slot : sWorkerSlots)
+    {
+        if (slot.first == mQueueId)
+        {
+            return &mWorkers[slot.second];
+        }
+    }
+    return nullptr;
+}
+
+LL::WorkStealingQueue::Worker* LL::WorkStealingQueue::nextTarget()
+{
+    const size_t workers = std::min(mWorkerCount.load(), MAX_WORKERS);
+    if (!workers)
+    {
+        return &mWorkers[0];
+    }
+    return &mWorkers[1 + mNextTarget++ % workers];
+}
+
+bool LL::WorkStealingQueue::push(Worker* worker, const Work& work)
+{
+    // Count the item in before checking mClosed again. A consumer only
+    // gives up once it sees the queue both closed and empty, so either it
+    // sees this item or we see the close and back out.
+    ++mSize;
+    if (mClosed)
+    {
+        --mSize;
+        return false;
+    }
+    ++mPosted;
+
+    std::lock_guard<std::mutex> lock(worker->mMutex);
+    worker->mWork.push_back(work);
+    worker->mCount = worker->mWork.size();
+    return true;
+}
+
+void LL::WorkStealingQueue::wakeWorkers(size_t count)
+{
+    // Sleeping workers bump mSleepers under mSleepMutex before checking
+    // mSize, so if we see no sleepers, any worker about to sleep will see
+    // our item.
+    if (!mSleepers)
+    {
+        return;
+    }
+    LLCoros::LockType lock(mSleepMutex);
+    if (count > 1)
+    {
+        mWorkCondition.notify_all();
+    }
+    else
+    {
+        mWorkCondition.notify_one();
+    }
+}
+
+bool LL::WorkStealingQueue::waitForSpace()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    LLCoros::LockType lock(mSleepMutex);
+    ++mBlockedProducers;
+    mSpaceCondition.wait(lock, [this]() { return mSize < mCapacity || mClosed; });
+    --mBlockedProducers;
+    return !mClosed;
+}
+
+bool LL::WorkStealingQueue::steal(Worker* thief, Work& work)
+{
+    const size_t workers = std::min(mWorkerCount.load(), MAX_WORKERS);
+    if (workers < 2)
+    {
+        // nobody else to steal from
+        return false;
+    }
+    ++mStealAttempts;
+
+    const size_t start = thief - &mWorkers[0];
+    std::vector<Work> loot;
+    for (size_t i = 1; i <= workers; ++i)
+    {
+        Worker* victim = &mWorkers[1 + (start + i) % workers];
+        if (victim == thief || !victim->mCount)
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(victim->mMutex);
+            if (victim->mWork.empty())
+            {
+                continue;
+            }
+            // take the oldest half, so they don't wait behind the victim's
+            // current item
+            size_t take = std::min((victim->mWork.size() + 1) / 2, MAX_STEAL);
+            work = std::move(victim->mWork.front());
+            victim->mWork.pop_front();
+            for (size_t n = 1; n < take; ++n)
+            {
+                loot.push_back(std::move(victim->mWork.front()));
+                victim->mWork.pop_front();
+            }
+            victim->mCount = victim->mWork.size();
+        }
+        mSteals += loot.size() + 1;
+
+        if (!loot.empty())
+        {
+            std::lock_guard<std::mutex> lock(thief->mMutex);
+            thief->mWork.insert(thief->mWork.end(), std::make_move_iterator(loot.begin()), std::make_move_iterator(loot.end()));
+            thief->mCount = thief->mWork.size();
+        }
+        return true;
+    }
+    return false;
+}
+
+LL::WorkStealingQueue::Work LL::WorkStealingQueue::pop_()
+{
+    Work work;
+    for (;;)
+    {
+        if (tryPop_(work))
+        {
+            return work;
+        }
+
+        LLCoros::LockType lock(mSleepMutex);
+        ++mSleepers;
+        mWorkCondition.wait(lock, [this]() { return mSize || mClosed; });
+        --mSleepers;
+        if (mClosed && !mSize)
+        {
+            LLTHROW(Closed());
+        }
+    }
+}
+
+bool LL::WorkStealingQueue::tryPop_(Work& work)
+{
+    Worker* self = getWorker();
+    if (!self)
+    {
+        // first time this thread consumes from us: give it a deque
+        size_t slot = 1 + mWorkerCount++ % MAX_WORKERS;
+        sWorkerSlots.emplace_back(mQueueId, slot);
+        self = &mWorkers[slot];
+    }
+
+    auto popFront = [](Worker* worker, Work& work)
+    {
+        if (!worker->mCount)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(worker->mMutex);
+        if (worker->mWork.empty())
+        {
+            return false;
+        }
+        work = std::move(worker->mWork.front());
+        worker->mWork.pop_front();
+        worker->mCount = worker->mWork.size();
+        return true;
+    };
+
+    if (!popFront(self, work) && !popFront(&mWorkers[0], work) && !steal(self, work))
+    {
+        return false;
+    }
+
+    --mSize;
+    if (mBlockedProducers)
+    {
+        LLCoros::LockType lock(mSleepMutex);
+        mSpaceCondition.notify_all();
+    }
+    return true;
+}
@@ -17,10 +17,21 @@
 #include "llinstancetracker.h"
 #include "llinstancetrackersubclass.h"
 #include "threadsafeschedule.h"
+#include LLCOROS_MUTEX_HEADER
+#include LLCOROS_CONDVAR_HEADER
+#include <atomic>
 #include <chrono>
 #include <exception>                // std::current_exception
 #include <functional>               // std::function
+#include <memory>
 #include <string>
+#include <vector>
+
+namespace LLTrace
+{
+    template <typename T> class SampleStatHandle;
+    template <typename T> class CountStatHandle;
+}
 
 namespace LL
 {
@@ -354,6 +365,127 @@ namespace LL
         bool tryPop_(Work&) override;
     };
 
+/*****************************************************************************
+*   WorkStealingQueue: per-worker deques with work stealing
+*****************************************************************************/
+    /**
+     * WorkStealingQueue is a drop-in alternative to WorkQueue for busy
+     * ThreadPools (see WorkStealingThreadPool). Instead of one queue behind
+     * one lock, each worker thread gets its own deque. Work posted by a worker
+     * lands on that worker's deque; work posted from other threads is spread
+     * round-robin over the workers. A worker whose deque runs dry steals half
+     * of another worker's deque.
+     *
+     * Unlike WorkQueue, items are only FIFO per deque: two items posted by
+     * different threads, or spread over different workers, may run in any
+     * order. Capacity is a soft limit: post() waits while the queue is at
+     * capacity, but concurrent producers can briefly overshoot it.
+     */
+    class WorkStealingQueue: public LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>
+    {
+    private:
+        using super = LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>;
+
+    public:
+        /// worker threads beyond this many share the deques of the others
+        static constexpr size_t MAX_WORKERS = 32;
+
+        /**
+         * You may omit the WorkStealingQueue name, in which case a unique
+         * name is synthesized; for practical purposes that makes it anonymous.
+         */
+        WorkStealingQueue(const std::string& name = std::string(), size_t capacity=1024);
+        ~WorkStealingQueue() override;
+
+        void close() override;
+        size_t size() override;
+        bool isClosed() override;
+        bool done() override;
+
+        /*---------------------- fire and forget API -----------------------*/
+
+        /**
+         * post work, unless the queue is closed before we can post
+         */
+        bool post(const Work&) override;
+
+        /**
+         * post work, unless the queue is full
+         */
+        bool tryPost(const Work&) override;
+
+        /**
+         * post a batch of work, unless the queue is closed. The batch is split
+         * over the worker deques taking each deque's lock only once, and
+         * waiting workers are woken once for the whole batch.
+         */
+        bool postBatch(std::vector<Work>&& batch);
+
+        /*----------------------------- metrics ----------------------------*/
+
+        struct Stats
+        {
+            size_t mDepth{ 0 };     ///< items currently queued
+            U64 mPosted{ 0 };       ///< items posted so far
+            U64 mSteals{ 0 };       ///< items taken from another worker's deque
+            U64 mStealAttempts{ 0 };///< times a worker with an empty deque went stealing
+        };
+        Stats getStats() const;
+
+        /**
+         * LLTrace stats have to be declared statically, so a queue owner that
+         * wants per-pool metrics declares its own and hands them over here.
+         * sampleStats() then records this queue's depth and steals into them.
+         */
+        void setTraceStats(LLTrace::SampleStatHandle<F64>* depth,
+                           LLTrace::CountStatHandle<F64>* steals);
+
+        /**
+         * Record the metrics of every WorkStealingQueue into LLTrace: the
+         * totals over all queues, plus the per-queue stats set with
+         * setTraceStats(). Call once per frame from the main thread.
+         */
+        static void sampleStats();
+
+    private:
+        struct Worker;
+
+        Worker* getWorker();
+        Worker* nextTarget();
+        bool push(Worker* worker, const Work& work);
+        void wakeWorkers(size_t count);
+        bool waitForSpace();
+        bool steal(Worker* thief, Work& work);
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        // mWorkers[0] takes posts made before any worker showed up;
+        // registered workers use the others
+        std::unique_ptr<Worker[]> mWorkers;
+        std::atomic<size_t> mWorkerCount{ 0 };
+        std::atomic<size_t> mNextTarget{ 0 };
+        const U64 mQueueId;
+
+        const size_t mCapacity;
+        std::atomic<size_t> mSize{ 0 };
+        std::atomic<bool> mClosed{ false };
+
+        // idle workers and blocked producers wait here
+        LLCoros::Mutex mSleepMutex;
+        LLCoros::ConditionVariable mWorkCondition;
+        LLCoros::ConditionVariable mSpaceCondition;
+        std::atomic<size_t> mSleepers{ 0 };
+        std::atomic<size_t> mBlockedProducers{ 0 };
+
+        std::atomic<U64> mPosted{ 0 };
+        std::atomic<U64> mSteals{ 0 };
+        std::atomic<U64> mStealAttempts{ 0 };
+        U64 mReportedSteals{ 0 };
+        LLTrace::SampleStatHandle<F64>* mTraceDepth{ nullptr };
+        LLTrace::CountStatHandle<F64>* mTraceSteals{ nullptr };
+    };
+
     /**
      * BackJack is, in effect, a hand-rolled lambda, binding a WorkSchedule, a
      * CALLABLE that returns bool, a TimePoint and an interval at which to
@@ -30,6 +30,7 @@
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
+#include "httpstats.h"
 
 #include "llhttpconstants.h"
 
@@ -409,6 +410,21 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
         }
     }
 
+    if (handle)
+    {
+        // Per-class transfer stats, gathered before the handle is recycled
+        long http_version(0L);
+        curl_off_t bytes_down(0);
+        double total_time(0.0);
+        curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version);
+        curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &bytes_down);
+        curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &total_time);
+        HTTPStats::instance().recordClassRequest(op->mReqPolicy,
+                                                 http_version >= CURL_HTTP_VERSION_2_0,
+                                                 U64(llmax(bytes_down, curl_off_t(0))),
+                                                 total_time);
+    }
+
     if (multi_handle && handle)
     {
         // Detach from multi and recycle handle
@@ -487,7 +503,27 @@ void HttpLibcurl::policyUpdated(int policy_class)
         policy.stallPolicy(policy_class, false);
         mDirtyPolicy[policy_class] = false;
 
-        if (options.mPipelining > 1)
+        if (options.useHttp2())
+        {
+            // Multiplex requests as HTTP/2 streams.  Connections are
+            // capped per host so requests queue up as streams on the
+            // open connections instead of opening more of them.
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_PIPELINING,
+                                     CURLPIPE_MULTIPLEX);
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_MAX_HOST_CONNECTIONS,
+                                     long(options.mPerHostConnectionLimit));
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                                     long(options.mConnectionLimit));
+#if LIBCURL_VERSION_NUM >= 0x074300 // 7.67.0
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_MAX_CONCURRENT_STREAMS,
+                                     long(options.mHttp2Streams));
+#endif
+        }
+        else if (options.mPipelining > 1)
         {
             // We'll try to do pipelining on this multihandle
             check_curl_multi_setopt(multi_handle,
@@ -562,6 +562,15 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 
     check_curl_easy_setopt(mCurlHandle, CURLOPT_NOBODY, nobody);
 
+    if (cpolicy.useHttp2())
+    {
+        // Ask for HTTP/2 over TLS (1.1 otherwise) and wait for a
+        // connection that can take another stream rather than racing
+        // to open a new one.
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+    }
+
     // The Linksys WRT54G V5 router has an issue with frequent
     // DNS lookups from LAN machines.  If they happen too often,
     // like for every HTTP request, the router gets annoyed after
@@ -752,6 +761,13 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
         // xfer_timeout *= cpolicy.mPipelining;
         xfer_timeout *= 2L;
     }
+    else if (cpolicy.useHttp2())
+    {
+        // Multiplexed streams share one connection's bandwidth so
+        // they see the same delay as pipelined requests, just without
+        // the head-of-line blocking.
+        xfer_timeout *= 2L;
+    }
     // *DEBUG:  Enable following override for timeout handling and "[curl:bugs] #1420" tests
     //if (cpolicy.mPipelining)
     //{
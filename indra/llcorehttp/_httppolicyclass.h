@@ -59,11 +59,17 @@ class HttpPolicyClass
     HttpStatus set(HttpRequest::EPolicyOption opt, long value);
     HttpStatus get(HttpRequest::EPolicyOption opt, long * value) const;
 
+    bool useHttp2() const                   { return mHttp2Streams > 0L; }
+
+    // Most requests the class should have in flight at once
+    long getActiveLimit() const;
+
 public:
     long                        mConnectionLimit;
     long                        mPerHostConnectionLimit;
     long                        mPipelining;
     long                        mThrottleRate;
+    long                        mHttp2Streams;
 };  // end class HttpPolicyClass
 
 }  // end namespace LLCore
@@ -63,6 +63,7 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
     {   true,       true,       true,       false,      false   },      // PO_TRACE
     {   true,       true,       false,      true,       false   },      // PO_ENABLE_PIPELINING
     {   true,       true,       false,      true,       false   },      // PO_THROTTLE_RATE
+    {   true,       true,       false,      true,       false   },      // PO_HTTP2_STREAMS
     {   false,      false,      true,       false,      true    },      // PO_SSL_VERIFY_CALLBACK
     {   false,      false,      true,       false,      false   }       // PO_USER_AGENT
 };
@@ -225,6 +225,20 @@ class HttpRequest
         /// Per-class only
         PO_THROTTLE_RATE,
 
+        /// Switches the class to HTTP/2 multiplexing when positive
+        /// and gives the number of concurrent streams libcurl may
+        /// open on each connection.  Requests prefer waiting for an
+        /// existing connection over opening a new one and servers
+        /// that won't negotiate HTTP/2 over TLS silently fall back
+        /// to HTTP/1.1.  PO_PER_HOST_CONNECTION_LIMIT then counts
+        /// connections rather than requests, and the in-flight
+        /// request limit becomes that times the stream count.  This
+        /// takes precedence over PO_PIPELINING_DEPTH.  A value of
+        /// zero, the default, keeps plain HTTP/1.1 behavior.
+        ///
+        /// Per-class only
+        PO_HTTP2_STREAMS,
+
         /// Controls the callback function used to control SSL CTX
         /// certificate verification.
         ///
@@ -41,6 +41,9 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+
+    LLMutexLock lock(&mClassMutex);
+    mClassStats.clear();
 }
 
 
@@ -57,6 +60,27 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordClassRequest(S32 policy_class, bool http2, U64 bytes, F64 seconds)
+{
+    LLMutexLock lock(&mClassMutex);
+    ClassStats& stats(mClassStats[policy_class]);
+    ++stats.mRequests;
+    if (http2)
+    {
+        ++stats.mHttp2Requests;
+    }
+    stats.mBytesDown += bytes;
+    stats.mTotalSeconds += seconds;
+    stats.mMaxSeconds = llmax(stats.mMaxSeconds, seconds);
+}
+
+HTTPStats::ClassStats HTTPStats::getClassStats(S32 policy_class)
+{
+    LLMutexLock lock(&mClassMutex);
+    std::map<S32, ClassStats>::const_iterator it(mClassStats.find(policy_class));
+    return it != mClassStats.end() ? it->second : ClassStats();
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -97,6 +121,20 @@ void HTTPStats::dumpStats()
         out << (*it).first << " " << (*it).second << std::endl;
     }
 
+    out << std::endl;
+    out << "Policy Classes:" << std::endl << "Class Requests HTTP/2 Recv Mean(ms) Max(ms)" << std::endl;
+    {
+        LLMutexLock lock(&mClassMutex);
+        for (const auto& entry : mClassStats)
+        {
+            const ClassStats& stats(entry.second);
+            out << entry.first << " " << stats.mRequests << " " << stats.mHttp2Requests
+                << " " << byte_count_converter(F32(stats.mBytesDown))
+                << " " << stats.getMeanSeconds() * 1000.0
+                << " " << stats.mMaxSeconds * 1000.0 << std::endl;
+        }
+    }
+
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
 
@@ -31,6 +31,7 @@
 #include "lltrace.h"
 #include "llstatsaccumulator.h"
 #include "llsingleton.h"
+#include "llmutex.h"
 #include "llsd.h"
 
 namespace LLCore
@@ -59,6 +60,24 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        /// Totals for the completed requests of one policy class.
+        struct ClassStats
+        {
+            U64     mRequests = 0;
+            U64     mHttp2Requests = 0;     // negotiated HTTP/2 or better
+            U64     mBytesDown = 0;
+            F64     mTotalSeconds = 0.0;    // summed libcurl total times
+            F64     mMaxSeconds = 0.0;
+
+            F64     getMeanSeconds() const  { return mRequests ? mTotalSeconds / mRequests : 0.0; }
+        };
+
+        /// Called from the worker thread as each request completes.
+        void    recordClassRequest(S32 policy_class, bool http2, U64 bytes, F64 seconds);
+
+        /// Safe from any thread.
+        ClassStats getClassStats(S32 policy_class);
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +86,9 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        LLMutex            mClassMutex;
+        std::map<S32, ClassStats> mClassStats;
     };
 
 
@@ -34,9 +34,11 @@
 #include "httpoptions.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
+#include "httpstats.h"
 
 #include <curl/curl.h>
 #include <boost/regex.hpp>
+#include <chrono>
 #include <sstream>
 
 #include "llcorehttp_test.h"
@@ -3012,6 +3014,181 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+// Counts completions without judging the status so the same
+// handler can run against servers other than the test peer.
+class RangeCountHandler : public LLCore::HttpHandler
+{
+public:
+    virtual void onCompleted(HttpHandle, HttpResponse * response)
+        {
+            ++mCompleted;
+            if (! response || ! response->getStatus())
+            {
+                ++mFailed;
+            }
+        }
+
+    int mCompleted = 0;
+    int mFailed = 0;
+};
+
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+    ScopedCurlInit ready;
+
+    set_test_name("HttpRequest many small range GETs, HTTP/1.1 vs HTTP/2 policy class");
+
+    // The test peer only speaks cleartext HTTP/1.1, so against it the
+    // HTTP/2 class negotiates down and this checks that the multiplexing
+    // policy is harmless there.  Point LL_TEST_HTTP2_URL at an HTTPS
+    // server that does HTTP/2 and byte ranges and compare the logged
+    // batch times to see the actual gain.
+    const char * h2_env(getenv("LL_TEST_HTTP2_URL"));
+    const bool external(h2_env && *h2_env);
+    const std::string url(external ? std::string(h2_env) : get_base_url() + "/range/");
+    const int request_count(200);
+    const size_t range_length(1024);
+
+    RangeCountHandler handler;
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+    TestHandler2 stop_handler(this, "handler");
+    LLCore::HttpHandler::ptr_t stop_handlerp(&stop_handler, NoOpDeletor);
+    mHandlerCalls = 0;
+
+    HttpRequest * req = NULL;
+    HttpOptions::ptr_t opts;
+
+    try
+    {
+        // Get singletons created
+        HttpRequest::createService();
+
+        // Same connection budget for both, HTTP/2 multiplexes it
+        HttpRequest::policy_t h1_class(HttpRequest::createPolicyClass());
+        HttpRequest::policy_t h2_class(HttpRequest::createPolicyClass());
+        ensure("HTTP/1.1 class created", h1_class != HttpRequest::INVALID_POLICY_ID);
+        ensure("HTTP/2 class created", h2_class != HttpRequest::INVALID_POLICY_ID);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT, h1_class, 4, NULL);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, h1_class, 4, NULL);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT, h2_class, 4, NULL);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, h2_class, 4, NULL);
+        HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, h2_class, 32, NULL));
+        ensure("HTTP/2 streams accepted per-class", bool(status));
+        status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, HttpRequest::GLOBAL_POLICY_ID, 32, NULL);
+        ensure("HTTP/2 streams refused globally", ! status);
+
+        // Start threading early so that thread memory is invariant
+        // over the test.
+        HttpRequest::startThread();
+
+        // create a new ref counted object with an implicit reference
+        req = new HttpRequest();
+
+        opts = HttpOptions::ptr_t(new HttpOptions());
+        opts->setRetries(0);
+        opts->setSSLVerifyPeer(false);
+        opts->setSSLVerifyHost(false);
+
+        // Issue the batch and pump until it drains, returning milliseconds
+        auto run_batch = [&](HttpRequest::policy_t policy_class) -> F64
+            {
+                handler.mCompleted = 0;
+                handler.mFailed = 0;
+                LLCore::HTTPStats::ClassStats before(LLCore::HTTPStats::instance().getClassStats(policy_class));
+
+                auto start = std::chrono::steady_clock::now();
+                for (int i(0); i < request_count; ++i)
+                {
+                    HttpHandle handle = req->requestGetByteRange(policy_class,
+                                                                 url,
+                                                                 i * range_length,
+                                                                 range_length,
+                                                                 opts,
+                                                                 HttpHeaders::ptr_t(),
+                                                                 handlerp);
+                    ensure("Valid handle returned for range request", handle != LLCORE_HTTP_HANDLE_INVALID);
+                }
+
+                int count(0);
+                int limit(LOOP_COUNT_LONG);
+                while (count++ < limit && handler.mCompleted < request_count)
+                {
+                    req->update(0);
+                    usleep(LOOP_SLEEP_INTERVAL / 10);
+                }
+                const F64 elapsed(std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - start).count());
+                ensure("Range requests executed in reasonable time", count < limit);
+                ensure_equals("Every range request completed", handler.mCompleted, request_count);
+                if (! external)
+                {
+                    ensure_equals("No range request failed", handler.mFailed, 0);
+                }
+
+                LLCore::HTTPStats::ClassStats after(LLCore::HTTPStats::instance().getClassStats(policy_class));
+                ensure_equals("Class stats counted every request",
+                              after.mRequests - before.mRequests, U64(request_count));
+                if (! external)
+                {
+                    ensure_equals("Class stats counted the range bytes",
+                                  after.mBytesDown - before.mBytesDown, U64(request_count * range_length));
+                    ensure_equals("Cleartext peer stays on HTTP/1.1",
+                                  after.mHttp2Requests - before.mHttp2Requests, U64(0));
+                }
+                return elapsed;
+            };
+
+        const F64 h1_time(run_batch(h1_class));
+        const F64 h2_time(run_batch(h2_class));
+        LL_INFOS("CoreHttp") << request_count << " x " << range_length << " byte ranges from " << url
+                             << ": HTTP/1.1 class " << h1_time << " ms, HTTP/2 class " << h2_time << " ms" << LL_ENDL;
+
+        // Okay, request a shutdown of the servicing thread
+        mStatus = HttpStatus();
+        HttpHandle handle = req->requestStopThread(stop_handlerp);
+        ensure("Valid handle returned for stop request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+        // Run the notification pump again
+        int count(0);
+        int limit(LOOP_COUNT_LONG);
+        while (count++ < limit && mHandlerCalls < 1)
+        {
+            req->update(1000000);
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Stop request executed in reasonable time", count < limit);
+        ensure("Stop handler invocation", mHandlerCalls == 1);
+
+        // See that we actually shutdown the thread
+        count = 0;
+        limit = LOOP_COUNT_SHORT;
+        while (count++ < limit && ! HttpService::isStopped())
+        {
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Thread actually stopped running", HttpService::isStopped());
+
+        // release options
+        opts.reset();
+
+        // release the request object
+        delete req;
+        req = NULL;
+
+        // Shut down service
+        HttpRequest::destroyService();
+    }
+    catch (...)
+    {
+        stop_thread(req);
+        opts.reset();
+        delete req;
+        HttpRequest::destroyService();
+        throw;
+    }
+}
+
+
 }  // end namespace tut
 
 namespace
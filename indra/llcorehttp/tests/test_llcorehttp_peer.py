@@ -30,6 +30,7 @@
 """
 
 import os
+import re
 import sys
 import time
 import select
@@ -46,6 +47,9 @@
 
 from testrunner import freeport, run, debug, VERBOSE
 
+# Body served from '/range/' URLs, 256KB of a repeating byte pattern
+RANGE_BODY = bytes(range(256)) * 1024
+
 class TestHTTPRequestHandler(BaseHTTPRequestHandler):
     """This subclass of BaseHTTPRequestHandler is to receive and echo
     LLSD-flavored messages sent by the C++ LLHTTPClient.
@@ -76,6 +80,8 @@ class TestHTTPRequestHandler(BaseHTTPRequestHandler):
     -- '/503/4/'            "Retry-After: (*#*(@*(@(")"
     -- '/503/5/'            "Retry-After: aklsjflajfaklsfaklfasfklasdfklasdgahsdhgasdiogaioshdgo"
     -- '/503/6/'            "Retry-After: 1 2 3 4 5 6 7 8 9 10"
+    - '/range/'         256KB body honoring 'Range: bytes=first-last'
+                        with 206 responses, for small range request tests
 
     Some combinations make no sense, there's no effort to protect
     you from that.
@@ -219,6 +225,28 @@ def answer(self, data, withdata=True):
             self.end_headers()
             if body:
                 self.wfile.write(body.encode('utf-8'))
+        elif "/range/" in self.path:
+            # Fixed-content resource for byte range tests.  Answers a
+            # 'bytes=first-last' Range header with a 206 and the slice,
+            # anything else with the whole body.
+            body = RANGE_BODY
+            match = re.match(r"bytes=(\d+)-(\d*)$", self.headers.get("Range", ""))
+            if match:
+                first = int(match.group(1))
+                last = int(match.group(2)) if match.group(2) else len(body) - 1
+                last = min(last, len(body) - 1)
+                self.send_response(206)
+                self.send_header("Content-Range", "bytes %d-%d/%d" % (first, last, len(body)))
+                body = body[first:last + 1]
+            else:
+                self.send_response(200)
+            if "/reflect/" in self.path:
+                self.reflect_headers()
+            self.send_header("Content-type", "application/octet-stream")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            if withdata:
+                self.wfile.write(body)
         elif "fail" not in self.path:
             data = data.copy()          # we're going to modify
             # Ensure there's a "reply" key in data, even if there wasn't before
@@ -39,6 +39,7 @@
 #include <chrono>
 
 #include "lldiskcache.h"
+#include "lldiskpack.h"
 
 const std::string DISK_CACHE_DIR_NAME = "cache";
 
@@ -46,18 +47,31 @@ LLDiskCache::LLDiskCache()
 {
 }
 
-void LLDiskCache::init(ELLPath location, const uintmax_t max_size_bytes, const bool enable_cache_debug_info, const bool cache_version_mismatch)
+LLDiskCache::~LLDiskCache()
+{
+}
+
+void LLDiskCache::init(ELLPath location, const uintmax_t max_size_bytes, const bool enable_cache_debug_info, const bool cache_version_mismatch, const bool use_pack_store)
 {
     mMaxSizeBytes = max_size_bytes;
     mEnableCacheDebugInfo = enable_cache_debug_info;
     mCacheDir = gDirUtilp->getExpandedFilename(location, DISK_CACHE_DIR_NAME);
+    mPackStore.reset();
 
-    if (cache_version_mismatch)
+    // Switching between the per-file layout and the pack store leaves the
+    // other layout's files behind where nothing would ever purge them.
+    const bool has_pack_store = LLDiskPackStore::exists(mCacheDir);
+    if (cache_version_mismatch || (use_pack_store != has_pack_store))
     {
         clearCache(location, false);
     }
 
     createCache();
+
+    if (use_pack_store)
+    {
+        mPackStore = std::make_unique<LLDiskPackStore>(mCacheDir, mMaxSizeBytes, mReadOnly);
+    }
 }
 
 
@@ -103,6 +117,13 @@ void LLDiskCache::purge()
 {
     if (mReadOnly) return;
 
+    if (mPackStore)
+    {
+        // The pack store does its own locking and never scans the directory
+        mPackStore->purge();
+        return;
+    }
+
     if (mEnableCacheDebugInfo)
     {
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
@@ -337,7 +358,8 @@ void LLDiskCache::updateFileAccessTime(const boost::filesystem::path& file_path)
 
 const std::string LLDiskCache::getCacheInfo()
 {
-    uintmax_t cache_used_mb = dirFileSize(mCacheDir) / (1024U * 1024U);
+    uintmax_t cache_used_bytes = mPackStore ? mPackStore->getDiskBytes() : dirFileSize(mCacheDir);
+    uintmax_t cache_used_mb = cache_used_bytes / (1024U * 1024U);
 
     uintmax_t max_in_mb = mMaxSizeBytes / (1024U * 1024U);
     F64 percent_used = ((F64)cache_used_mb / (F64)max_in_mb) * 100.0;
@@ -351,6 +373,11 @@ void LLDiskCache::clearCache(ELLPath location, bool recreate_cache)
     {
         std::string disk_cache_dir = gDirUtilp->getExpandedFilename(location, DISK_CACHE_DIR_NAME);
 
+        if (mPackStore)
+        {
+            mPackStore->clear();
+        }
+
         const char* subdirs = "0123456789abcdef";
         std::string delem = gDirUtilp->getDirDelimiter();
         std::string mask = "*";
@@ -36,6 +36,9 @@
  *    the same sized directory of files, writing the last updated
  *    time to each took less than 600ms indicating that this
  *    important part of the mechanism has almost no overhead.
+ * 6/ Optionally, the assets can be kept in a handful of large pack
+ *    files with an in-memory index instead (see lldiskpack.h). That
+ *    avoids the directory scan in purge() for very large caches.
  *
  * $LicenseInfo:firstyear=2009&license=viewerlgpl$
  * Second Life Viewer Source Code
@@ -68,6 +71,8 @@
 
 #include "boost/unordered/unordered_flat_set.hpp"
 
+class LLDiskPackStore;
+
 class LLDiskCache final :
     public LLSimpleton<LLDiskCache>
 {
@@ -80,7 +85,7 @@ class LLDiskCache final :
          * the class via a call in LLAppViewer.
          */
         LLDiskCache();
-        virtual ~LLDiskCache() = default;
+        virtual ~LLDiskCache();
 public:
         void init(
             /**
@@ -101,7 +106,12 @@ class LLDiskCache final :
             /**
              * Cache version mismatch purge
              */
-            const bool cache_version_mismatch);
+            const bool cache_version_mismatch,
+            /**
+             * Store the assets in a few large pack files with a persisted
+             * index (see lldiskpack.h) instead of one file per asset
+             */
+            const bool use_pack_store = false);
 
         /**
          * Construct a filename and path to it based on the file meta data
@@ -149,6 +159,13 @@ class LLDiskCache final :
 
         void setReadonly(bool read_only) { mReadOnly = read_only; }
 
+        /**
+         * The pack store backend, or nullptr when every asset lives in
+         * its own file. LLFileSystem routes all of its I/O through it
+         * when it is enabled.
+         */
+        LLDiskPackStore* getPackStore() const { return mPackStore.get(); }
+
     private:
         /**
          * Utility function to gather the total size the files in a given
@@ -202,6 +219,8 @@ class LLDiskCache final :
         bool mEnableCacheDebugInfo = false;
 
         bool mReadOnly = false;
+
+        std::unique_ptr<LLDiskPackStore> mPackStore;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
@@ -0,0 +1,787 @@
+/**
+ * @file lldiskpack.cpp
+ * @brief Pack-file backend for the disk cache.
+ *
+ * See lldiskpack.h for a description of how the pack store works.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskpack.h"
+
+#include "lldir.h"
+
+#include <chrono>
+
+namespace
+{
+    const char PACK_INDEX_NAME[] = "diskpack.idx";
+    const char PACK_SEGMENT_EXT[] = ".sl_pack";
+    const char PACK_INDEX_MAGIC[4] = { 'L', 'L', 'P', 'K' };
+    const U32 PACK_INDEX_VERSION = 1;
+
+    const U32 MIN_SEGMENT_SIZE = 16 * 1024 * 1024;
+    const U32 MAX_SEGMENT_SIZE = 256 * 1024 * 1024;
+    // The cache is split over at least this many segments so that evicting
+    // one of them only drops a small fraction of the cached assets.
+    const uintmax_t TARGET_SEGMENT_COUNT = 16;
+
+    // Records that may still grow (appends, mesh headers that are filled in
+    // later) get some slack so that they do not move on every write.
+    const U32 GROWABLE_RECORD_ALIGN = 4096;
+    const U32 RECORD_ALIGN = 16;
+
+    const U32 COPY_CHUNK_SIZE = 64 * 1024;
+
+    U32 align_up(U32 value, U32 align)
+    {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    U32 record_capacity(U32 size, bool growable)
+    {
+        if (growable)
+        {
+            return align_up(llmax(size + size / 2, GROWABLE_RECORD_ALIGN), GROWABLE_RECORD_ALIGN);
+        }
+        return align_up(llmax(size, 1U), RECORD_ALIGN);
+    }
+
+    // Little helpers to (de)serialize the index without any padding concerns.
+    template<typename T>
+    void put(std::vector<U8>& out, const T& value)
+    {
+        const U8* p = reinterpret_cast<const U8*>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    template<typename T>
+    bool get(const std::vector<U8>& in, size_t& pos, T& value)
+    {
+        if (pos + sizeof(T) > in.size())
+        {
+            return false;
+        }
+        memcpy(&value, in.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+}
+
+LLDiskPackStore::Segment::~Segment()
+{
+    if (mFile)
+    {
+        LLFile::close(mFile);
+        mFile = nullptr;
+    }
+}
+
+LLDiskPackStore::LLDiskPackStore(const std::string& cache_dir, uintmax_t max_size_bytes, bool read_only) :
+    mCacheDir(cache_dir),
+    mMaxSizeBytes(max_size_bytes),
+    mSegmentSize((U32)llclamp(max_size_bytes / TARGET_SEGMENT_COUNT, (uintmax_t)MIN_SEGMENT_SIZE, (uintmax_t)MAX_SEGMENT_SIZE)),
+    mReadOnly(read_only)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!loadIndex())
+    {
+        clearLocked();
+    }
+
+    LL_INFOS("DiskCache") << "Pack store opened with " << mIndex.size() << " entries in "
+                          << mSegments.size() << " segments (" << mLiveBytes << " bytes)" << LL_ENDL;
+}
+
+LLDiskPackStore::~LLDiskPackStore()
+{
+    saveIndex();
+}
+
+// static
+bool LLDiskPackStore::exists(const std::string& cache_dir)
+{
+    return LLFile::isfile(cache_dir + gDirUtilp->getDirDelimiter() + PACK_INDEX_NAME);
+}
+
+// static
+void LLDiskPackStore::removeFiles(const std::string& cache_dir)
+{
+    gDirUtilp->deleteFilesInDir(cache_dir, std::string("*") + PACK_SEGMENT_EXT);
+    LLFile::remove(cache_dir + gDirUtilp->getDirDelimiter() + PACK_INDEX_NAME, ENOENT);
+}
+
+std::string LLDiskPackStore::getSegmentPath(U32 segment_id) const
+{
+    return llformat("%s%sdiskpack_%08x%s", mCacheDir.c_str(), gDirUtilp->getDirDelimiter().c_str(), segment_id, PACK_SEGMENT_EXT);
+}
+
+std::string LLDiskPackStore::getIndexPath() const
+{
+    return mCacheDir + gDirUtilp->getDirDelimiter() + PACK_INDEX_NAME;
+}
+
+bool LLDiskPackStore::exists(const LLUUID& id, LLAssetType::EType type) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIndex.find(Key{ id, type }) != mIndex.end();
+}
+
+S32 LLDiskPackStore::getSize(const LLUUID& id, LLAssetType::EType type) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    index_t::const_iterator it = mIndex.find(Key{ id, type });
+    return it != mIndex.end() ? (S32)it->second.mSize : 0;
+}
+
+void LLDiskPackStore::touch(const LLUUID& id, LLAssetType::EType type)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    index_t::iterator it = mIndex.find(Key{ id, type });
+    if (it != mIndex.end())
+    {
+        it->second.mReferenced = true;
+    }
+}
+
+S32 LLDiskPackStore::read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes)
+{
+    if (offset < 0 || bytes <= 0)
+    {
+        return 0;
+    }
+
+    Entry entry;
+    std::shared_ptr<Segment> segment;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        index_t::iterator it = mIndex.find(Key{ id, type });
+        if (it == mIndex.end())
+        {
+            return 0;
+        }
+        it->second.mReferenced = true;
+        entry = it->second;
+
+        segment_map_t::iterator seg_it = mSegments.find(entry.mSegment);
+        if (seg_it == mSegments.end())
+        {
+            return 0;
+        }
+        segment = seg_it->second;
+    }
+
+    // Records are never overwritten by another asset until their segment
+    // is evicted, so the actual read can happen without the store lock.
+    if ((U32)offset >= entry.mSize)
+    {
+        return 0;
+    }
+
+    U32 to_read = llmin((U32)bytes, entry.mSize - (U32)offset);
+    if (!readAt(*segment, entry.mOffset + offset, buffer, to_read))
+    {
+        return 0;
+    }
+    return (S32)to_read;
+}
+
+bool LLDiskPackStore::write(const LLUUID& id, LLAssetType::EType type, S32 offset,
+                            const U8* buffer, S32 bytes, bool truncate, S32& new_pos)
+{
+    if (mReadOnly || bytes < 0)
+    {
+        return false;
+    }
+
+    // Writes are rare compared to reads and may have to move a record, so
+    // they keep the store locked for their whole duration.
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const Key key{ id, type };
+    index_t::iterator it = mIndex.find(key);
+    Entry* current = (it != mIndex.end()) ? &it->second : nullptr;
+
+    U32 pos = 0;
+    if (!truncate && current)
+    {
+        pos = (offset < 0) ? current->mSize : llmin((U32)offset, current->mSize);
+    }
+    const U32 end_pos = pos + (U32)bytes;
+
+    // Fits into the space already reserved for this record
+    if (!truncate && current && end_pos <= current->mCapacity)
+    {
+        segment_map_t::iterator seg_it = mSegments.find(current->mSegment);
+        if (seg_it == mSegments.end() || !writeAt(*seg_it->second, current->mOffset + pos, buffer, (U32)bytes))
+        {
+            return false;
+        }
+
+        if (end_pos > current->mSize)
+        {
+            const U32 delta = end_pos - current->mSize;
+            seg_it->second->mLiveBytes += delta;
+            mLiveBytes += delta;
+            current->mSize = end_pos;
+        }
+        mIndexDirty = true;
+        new_pos = (S32)end_pos;
+        return true;
+    }
+
+    // New asset, truncating write or the record outgrew its capacity:
+    // append a new record to the active segment.
+    const U32 capacity = record_capacity(end_pos, !truncate);
+    U32 record_offset = 0;
+    std::shared_ptr<Segment> segment = allocate(capacity, record_offset);
+    if (!segment)
+    {
+        return false;
+    }
+
+    if (current && pos > 0)
+    {
+        segment_map_t::iterator old_it = mSegments.find(current->mSegment);
+        if (old_it == mSegments.end() ||
+            !copyRecord(*old_it->second, current->mOffset, *segment, record_offset, pos))
+        {
+            return false;
+        }
+    }
+
+    if (bytes > 0 && !writeAt(*segment, record_offset + pos, buffer, (U32)bytes))
+    {
+        return false;
+    }
+
+    Entry entry;
+    entry.mSegment = segment->mID;
+    entry.mOffset = record_offset;
+    entry.mSize = end_pos;
+    entry.mCapacity = capacity;
+    if (current)
+    {
+        entry.mReferenced = current->mReferenced;
+        releaseEntry(*current);
+        *current = entry;
+    }
+    else
+    {
+        mIndex.emplace(key, entry);
+    }
+    segment->mLiveBytes += end_pos;
+    mLiveBytes += end_pos;
+    mIndexDirty = true;
+
+    new_pos = (S32)end_pos;
+    return true;
+}
+
+bool LLDiskPackStore::remove(const LLUUID& id, LLAssetType::EType type)
+{
+    if (mReadOnly)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    index_t::iterator it = mIndex.find(Key{ id, type });
+    if (it == mIndex.end())
+    {
+        return false;
+    }
+
+    releaseEntry(it->second);
+    mIndex.erase(it);
+    mIndexDirty = true;
+    return true;
+}
+
+bool LLDiskPackStore::rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                             const LLUUID& new_id, LLAssetType::EType new_type)
+{
+    if (mReadOnly)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    index_t::iterator it = mIndex.find(Key{ old_id, old_type });
+    if (it == mIndex.end())
+    {
+        return false;
+    }
+
+    const Entry entry = it->second;
+    mIndex.erase(it);
+
+    const Key new_key{ new_id, new_type };
+    index_t::iterator new_it = mIndex.find(new_key);
+    if (new_it != mIndex.end())
+    {
+        releaseEntry(new_it->second);
+        new_it->second = entry;
+    }
+    else
+    {
+        mIndex.emplace(new_key, entry);
+    }
+    mIndexDirty = true;
+    return true;
+}
+
+void LLDiskPackStore::purge()
+{
+    if (mReadOnly)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_ptr<Segment>> dropped;
+    size_t evicted = 0;
+    size_t relocated = 0;
+
+    // Never evict the active segment; it is the last one in the map.
+    while (getDiskBytesLocked() > mMaxSizeBytes && mSegments.size() > 1)
+    {
+        std::shared_ptr<Segment> oldest = mSegments.begin()->second;
+
+        std::vector<Key> victims;
+        for (const auto& pair : mIndex)
+        {
+            if (pair.second.mSegment == oldest->mID)
+            {
+                victims.push_back(pair.first);
+            }
+        }
+
+        // Second chance: entries read since they were written are copied
+        // forward into the active segment. Bound the amount of copying so
+        // a segment full of hot entries cannot stall the purge.
+        U32 relocate_budget = mSegmentSize / 4;
+        for (const Key& key : victims)
+        {
+            Entry& entry = mIndex[key];
+            if (entry.mReferenced && entry.mSize <= relocate_budget)
+            {
+                const U32 capacity = record_capacity(entry.mSize, false);
+                U32 record_offset = 0;
+                std::shared_ptr<Segment> segment = allocate(capacity, record_offset);
+                if (segment && segment != oldest &&
+                    copyRecord(*oldest, entry.mOffset, *segment, record_offset, entry.mSize))
+                {
+                    releaseEntry(entry);
+                    entry.mSegment = segment->mID;
+                    entry.mOffset = record_offset;
+                    entry.mCapacity = capacity;
+                    entry.mReferenced = false;
+                    segment->mLiveBytes += entry.mSize;
+                    mLiveBytes += entry.mSize;
+                    relocate_budget -= entry.mSize;
+                    ++relocated;
+                    continue;
+                }
+            }
+
+            releaseEntry(entry);
+            mIndex.erase(key);
+            ++evicted;
+        }
+
+        mSegments.erase(oldest->mID);
+        dropped.push_back(oldest);
+        mIndexDirty = true;
+    }
+
+    // Make sure the persisted index no longer references the segments
+    // before their files go away.
+    saveIndexLocked();
+
+    for (const std::shared_ptr<Segment>& segment : dropped)
+    {
+        {
+            std::lock_guard<std::mutex> io_lock(segment->mIOMutex);
+            if (segment->mFile)
+            {
+                LLFile::close(segment->mFile);
+                segment->mFile = nullptr;
+            }
+        }
+        LLFile::remove(getSegmentPath(segment->mID), ENOENT);
+    }
+
+    if (!dropped.empty())
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        LL_INFOS("DiskCache") << "Pack store purge dropped " << dropped.size() << " segments, evicted "
+                              << evicted << " entries and kept " << relocated << " in "
+                              << execute_time << " ms" << LL_ENDL;
+    }
+}
+
+void LLDiskPackStore::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    clearLocked();
+}
+
+void LLDiskPackStore::clearLocked()
+{
+    for (auto& pair : mSegments)
+    {
+        std::lock_guard<std::mutex> io_lock(pair.second->mIOMutex);
+        if (pair.second->mFile)
+        {
+            LLFile::close(pair.second->mFile);
+            pair.second->mFile = nullptr;
+        }
+    }
+    mSegments.clear();
+    mIndex.clear();
+    mLiveBytes = 0;
+    mNextSegmentID = 1;
+    mIndexDirty = false;
+
+    if (!mReadOnly)
+    {
+        removeFiles(mCacheDir);
+    }
+}
+
+bool LLDiskPackStore::saveIndex()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return saveIndexLocked();
+}
+
+bool LLDiskPackStore::saveIndexLocked()
+{
+    if (mReadOnly || !mIndexDirty)
+    {
+        return true;
+    }
+
+    // Flush the segments first so the index never points at data that
+    // only exists in a stdio buffer.
+    for (auto& pair : mSegments)
+    {
+        std::lock_guard<std::mutex> io_lock(pair.second->mIOMutex);
+        if (pair.second->mFile)
+        {
+            fflush(pair.second->mFile);
+        }
+    }
+
+    std::vector<U8> out;
+    out.reserve(20 + mSegments.size() * 8 + mIndex.size() * 37);
+    out.insert(out.end(), std::begin(PACK_INDEX_MAGIC), std::end(PACK_INDEX_MAGIC));
+    put(out, PACK_INDEX_VERSION);
+    put(out, mNextSegmentID);
+    put(out, (U32)mSegments.size());
+    put(out, (U32)mIndex.size());
+
+    for (const auto& pair : mSegments)
+    {
+        put(out, pair.second->mID);
+        put(out, pair.second->mSize);
+    }
+
+    for (const auto& pair : mIndex)
+    {
+        out.insert(out.end(), pair.first.mID.mData, pair.first.mID.mData + UUID_BYTES);
+        put(out, (S32)pair.first.mType);
+        put(out, pair.second.mSegment);
+        put(out, pair.second.mOffset);
+        put(out, pair.second.mSize);
+        put(out, pair.second.mCapacity);
+        put(out, (U8)pair.second.mReferenced);
+    }
+
+    // Write to a temporary file and swap it in so that a crash while
+    // saving never leaves a truncated index behind.
+    const std::string index_path = getIndexPath();
+    const std::string temp_path = index_path + ".tmp";
+    LLFILE* file = LLFile::fopen(temp_path, "wb");
+    if (!file)
+    {
+        LL_WARNS("DiskCache") << "Unable to write pack store index " << temp_path << LL_ENDL;
+        return false;
+    }
+    const bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    LLFile::close(file);
+    if (!written)
+    {
+        LL_WARNS("DiskCache") << "Unable to write pack store index " << temp_path << LL_ENDL;
+        LLFile::remove(temp_path, ENOENT);
+        return false;
+    }
+
+    LLFile::remove(index_path, ENOENT);
+    if (LLFile::rename(temp_path, index_path) != 0)
+    {
+        return false;
+    }
+
+    mIndexDirty = false;
+    return true;
+}
+
+bool LLDiskPackStore::loadIndex()
+{
+    const std::string index_path = getIndexPath();
+    LLFILE* file = LLFile::fopen(index_path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<U8> in;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long file_size = ftell(file);
+        if (file_size > 0 && fseek(file, 0, SEEK_SET) == 0)
+        {
+            in.resize(file_size);
+            if (fread(in.data(), 1, in.size(), file) != in.size())
+            {
+                in.clear();
+            }
+        }
+    }
+    LLFile::close(file);
+
+    size_t pos = 0;
+    char magic[4];
+    U32 version = 0;
+    U32 next_segment_id = 0;
+    U32 segment_count = 0;
+    U32 entry_count = 0;
+    if (!get(in, pos, magic) || memcmp(magic, PACK_INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !get(in, pos, version) || version != PACK_INDEX_VERSION ||
+        !get(in, pos, next_segment_id) ||
+        !get(in, pos, segment_count) ||
+        !get(in, pos, entry_count))
+    {
+        LL_WARNS("DiskCache") << "Invalid pack store index, discarding pack store" << LL_ENDL;
+        return false;
+    }
+
+    for (U32 i = 0; i < segment_count; ++i)
+    {
+        U32 segment_id = 0;
+        U32 segment_size = 0;
+        if (!get(in, pos, segment_id) || !get(in, pos, segment_size) || segment_id >= next_segment_id)
+        {
+            LL_WARNS("DiskCache") << "Invalid pack store index, discarding pack store" << LL_ENDL;
+            return false;
+        }
+
+        std::shared_ptr<Segment> segment = openSegment(segment_id, false);
+        if (!segment)
+        {
+            LL_WARNS("DiskCache") << "Missing pack store segment " << segment_id << ", discarding pack store" << LL_ENDL;
+            return false;
+        }
+        segment->mSize = segment_size;
+        mSegments.emplace(segment_id, segment);
+    }
+
+    mIndex.reserve(entry_count);
+    for (U32 i = 0; i < entry_count; ++i)
+    {
+        Key key;
+        S32 type = 0;
+        Entry entry;
+        U8 referenced = 0;
+        if (pos + UUID_BYTES > in.size())
+        {
+            return false;
+        }
+        memcpy(key.mID.mData, in.data() + pos, UUID_BYTES);
+        pos += UUID_BYTES;
+        if (!get(in, pos, type) ||
+            !get(in, pos, entry.mSegment) ||
+            !get(in, pos, entry.mOffset) ||
+            !get(in, pos, entry.mSize) ||
+            !get(in, pos, entry.mCapacity) ||
+            !get(in, pos, referenced))
+        {
+            LL_WARNS("DiskCache") << "Truncated pack store index, discarding pack store" << LL_ENDL;
+            return false;
+        }
+        key.mType = (LLAssetType::EType)type;
+        entry.mReferenced = referenced != 0;
+
+        segment_map_t::iterator seg_it = mSegments.find(entry.mSegment);
+        if (seg_it == mSegments.end() || entry.mSize > entry.mCapacity ||
+            (uintmax_t)entry.mOffset + entry.mCapacity > seg_it->second->mSize)
+        {
+            // Stale entry; skip it rather than throwing the whole store away
+            continue;
+        }
+
+        seg_it->second->mLiveBytes += entry.mSize;
+        mLiveBytes += entry.mSize;
+        mIndex[key] = entry;
+    }
+
+    mNextSegmentID = next_segment_id;
+    mIndexDirty = false;
+    return true;
+}
+
+std::shared_ptr<LLDiskPackStore::Segment> LLDiskPackStore::openSegment(U32 segment_id, bool create)
+{
+    const std::string path = getSegmentPath(segment_id);
+    const char* mode = create ? "w+b" : (mReadOnly ? "rb" : "r+b");
+    LLFILE* file = LLFile::fopen(path, mode);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+    segment->mID = segment_id;
+    segment->mFile = file;
+    return segment;
+}
+
+std::shared_ptr<LLDiskPackStore::Segment> LLDiskPackStore::getActiveSegment(U32 bytes)
+{
+    if (!mSegments.empty())
+    {
+        std::shared_ptr<Segment>& last = mSegments.rbegin()->second;
+        // An empty segment always takes the record, even if it is bigger
+        // than the nominal segment size.
+        if (last->mSize == 0 || (uintmax_t)last->mSize + bytes <= mSegmentSize)
+        {
+            return last;
+        }
+    }
+
+    const U32 segment_id = mNextSegmentID++;
+    std::shared_ptr<Segment> segment = openSegment(segment_id, true);
+    if (!segment)
+    {
+        LL_WARNS("DiskCache") << "Unable to create pack store segment " << getSegmentPath(segment_id) << LL_ENDL;
+        return nullptr;
+    }
+    mSegments.emplace(segment_id, segment);
+    mIndexDirty = true;
+    return segment;
+}
+
+std::shared_ptr<LLDiskPackStore::Segment> LLDiskPackStore::allocate(U32 capacity, U32& offset)
+{
+    std::shared_ptr<Segment> segment = getActiveSegment(capacity);
+    if (segment)
+    {
+        offset = segment->mSize;
+        segment->mSize += capacity;
+    }
+    return segment;
+}
+
+bool LLDiskPackStore::copyRecord(Segment& from, U32 from_offset, Segment& to, U32 to_offset, U32 size)
+{
+    std::vector<U8> buffer(llmin(size, COPY_CHUNK_SIZE));
+    U32 copied = 0;
+    while (copied < size)
+    {
+        const U32 chunk = llmin(size - copied, COPY_CHUNK_SIZE);
+        if (!readAt(from, from_offset + copied, buffer.data(), chunk) ||
+            !writeAt(to, to_offset + copied, buffer.data(), chunk))
+        {
+            return false;
+        }
+        copied += chunk;
+    }
+    return true;
+}
+
+void LLDiskPackStore::releaseEntry(const Entry& entry)
+{
+    segment_map_t::iterator seg_it = mSegments.find(entry.mSegment);
+    if (seg_it != mSegments.end())
+    {
+        seg_it->second->mLiveBytes -= entry.mSize;
+    }
+    mLiveBytes -= entry.mSize;
+}
+
+// static
+bool LLDiskPackStore::readAt(Segment& segment, U32 offset, U8* buffer, U32 bytes)
+{
+    std::lock_guard<std::mutex> io_lock(segment.mIOMutex);
+    if (!segment.mFile || fseek(segment.mFile, (long)offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    return fread(buffer, 1, bytes, segment.mFile) == bytes;
+}
+
+// static
+bool LLDiskPackStore::writeAt(Segment& segment, U32 offset, const U8* buffer, U32 bytes)
+{
+    std::lock_guard<std::mutex> io_lock(segment.mIOMutex);
+    if (!segment.mFile || fseek(segment.mFile, (long)offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    return fwrite(buffer, 1, bytes, segment.mFile) == bytes;
+}
+
+uintmax_t LLDiskPackStore::getLiveBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLiveBytes;
+}
+
+uintmax_t LLDiskPackStore::getDiskBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getDiskBytesLocked();
+}
+
+uintmax_t LLDiskPackStore::getDiskBytesLocked() const
+{
+    uintmax_t total = 0;
+    for (const auto& pair : mSegments)
+    {
+        total += pair.second->mSize;
+    }
+    return total;
+}
+
+size_t LLDiskPackStore::getEntryCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIndex.size();
+}
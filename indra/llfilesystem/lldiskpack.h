@@ -0,0 +1,248 @@
+/**
+ * @file lldiskpack.h
+ * @brief Pack-file backend for the disk cache.
+ *
+ * @Description:
+ * The default disk cache stores every asset in its own file and
+ * has to walk and stat the whole cache directory to find the least
+ * recently used files when it purges. With hundreds of thousands of
+ * entries that is slow and puts a lot of pressure on the filesystem.
+ *
+ * LLDiskPackStore keeps assets in a small number of large segment
+ * files instead:
+ * 1/ Segments are append-only. New assets, and assets that outgrow
+ *    the space reserved for them, are appended to the active segment.
+ *    Writes that fit inside an existing record (e.g. mesh LODs that
+ *    are filled in after the header was cached) are done in place.
+ * 2/ An in-memory hash index maps (asset id, asset type) to the
+ *    segment, offset, size and reserved capacity of its record.
+ * 3/ The index is persisted next to the segments on shutdown and
+ *    at every purge so a warm start never needs to scan anything.
+ *    When the index is missing or invalid, the segments are dropped.
+ * 4/ Eviction works on whole segments in FIFO order with a CLOCK
+ *    style second chance: records that have been read since they
+ *    were written are copied forward into the active segment, the
+ *    rest are dropped along with the oldest segment file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDISKPACK_H
+#define LL_LLDISKPACK_H
+
+#include "llassettype.h"
+#include "lluuid.h"
+
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+class LLDiskPackStore
+{
+public:
+    /**
+     * Open (or create) the pack store that lives in cache_dir. The
+     * directory must already exist. A read only store never writes
+     * segments or the index and is used by secondary viewer instances.
+     */
+    LLDiskPackStore(const std::string& cache_dir, uintmax_t max_size_bytes, bool read_only);
+
+    /**
+     * Saves the index so the next session can reuse the segments.
+     */
+    ~LLDiskPackStore();
+
+    LLDiskPackStore(const LLDiskPackStore&) = delete;
+    LLDiskPackStore& operator=(const LLDiskPackStore&) = delete;
+
+    /**
+     * True if a pack store index exists in cache_dir. Used to detect a
+     * switch between the pack store and the per-file cache layout.
+     */
+    static bool exists(const std::string& cache_dir);
+
+    /**
+     * Remove every file that belongs to a pack store in cache_dir.
+     */
+    static void removeFiles(const std::string& cache_dir);
+
+    bool exists(const LLUUID& id, LLAssetType::EType type) const;
+
+    /**
+     * Size of the stored asset in bytes, or 0 when it is not cached.
+     */
+    S32 getSize(const LLUUID& id, LLAssetType::EType type) const;
+
+    /**
+     * Mark an entry as recently used so that it survives the next
+     * eviction of its segment. This is the pack store equivalent of
+     * LLDiskCache::updateFileAccessTime().
+     */
+    void touch(const LLUUID& id, LLAssetType::EType type);
+
+    /**
+     * Read up to bytes bytes starting at offset into buffer. Returns
+     * the number of bytes read, 0 on failure or at the end of the asset.
+     */
+    S32 read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes);
+
+    /**
+     * Write bytes bytes at offset. An offset of -1 appends to the end of
+     * the asset. When truncate is set, the asset is replaced entirely by
+     * the new data (the equivalent of opening the file with "wb").
+     * On success, new_pos receives the position after the written data.
+     */
+    bool write(const LLUUID& id, LLAssetType::EType type, S32 offset,
+               const U8* buffer, S32 bytes, bool truncate, S32& new_pos);
+
+    bool remove(const LLUUID& id, LLAssetType::EType type);
+
+    /**
+     * Move an entry to a new key, replacing any entry already stored there.
+     * This never touches the segment data.
+     */
+    bool rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                const LLUUID& new_id, LLAssetType::EType new_type);
+
+    /**
+     * Evict whole segments, oldest first, until the space used on disk
+     * is no bigger than the maximum size, then checkpoint the index.
+     * Called by LLPurgeDiskCacheThread.
+     */
+    void purge();
+
+    /**
+     * Drop all entries and delete the segment and index files.
+     */
+    void clear();
+
+    /**
+     * Write the index to disk if it changed since the last save.
+     */
+    bool saveIndex();
+
+    /**
+     * Bytes of asset data referenced by the index.
+     */
+    uintmax_t getLiveBytes() const;
+
+    /**
+     * Bytes used by the segment files on disk, including dead records.
+     */
+    uintmax_t getDiskBytes() const;
+
+    size_t getEntryCount() const;
+
+private:
+    struct Key
+    {
+        LLUUID              mID;
+        LLAssetType::EType  mType;
+
+        bool operator==(const Key& rhs) const
+        {
+            return mType == rhs.mType && mID == rhs.mID;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            size_t seed = hash_value(key.mID);
+            boost::hash_combine(seed, (S32)key.mType);
+            return seed;
+        }
+    };
+
+    struct Entry
+    {
+        U32     mSegment = 0;
+        U32     mOffset = 0;
+        U32     mSize = 0;
+        U32     mCapacity = 0;
+        bool    mReferenced = false;
+    };
+
+    struct Segment
+    {
+        ~Segment();
+
+        U32         mID = 0;
+        LLFILE*     mFile = nullptr;
+        // Append cursor, may be past the physical end of the file
+        // when the last record has not been filled completely yet.
+        U32         mSize = 0;
+        uintmax_t   mLiveBytes = 0;
+        // Serializes seek + read/write on mFile. Readers only hold a
+        // reference to the segment, not the store lock, while reading.
+        std::mutex  mIOMutex;
+    };
+
+    typedef boost::unordered_flat_map<Key, Entry, KeyHash> index_t;
+    typedef std::map<U32, std::shared_ptr<Segment>> segment_map_t;
+
+    std::string getSegmentPath(U32 segment_id) const;
+    std::string getIndexPath() const;
+
+    bool loadIndex();
+    bool saveIndexLocked();
+    void clearLocked();
+
+    std::shared_ptr<Segment> openSegment(U32 segment_id, bool create);
+    std::shared_ptr<Segment> getActiveSegment(U32 bytes);
+
+    /**
+     * Reserve capacity bytes at the end of the active segment.
+     * Returns the segment or nullptr on failure.
+     */
+    std::shared_ptr<Segment> allocate(U32 capacity, U32& offset);
+
+    /**
+     * Copy size bytes from one record to another. Both segments are
+     * expected to be open, the store lock must be held.
+     */
+    bool copyRecord(Segment& from, U32 from_offset, Segment& to, U32 to_offset, U32 size);
+
+    void releaseEntry(const Entry& entry);
+    uintmax_t getDiskBytesLocked() const;
+
+    static bool readAt(Segment& segment, U32 offset, U8* buffer, U32 bytes);
+    static bool writeAt(Segment& segment, U32 offset, const U8* buffer, U32 bytes);
+
+private:
+    const std::string   mCacheDir;
+    const uintmax_t     mMaxSizeBytes;
+    const U32           mSegmentSize;
+    const bool          mReadOnly;
+
+    mutable std::mutex  mMutex;
+    index_t             mIndex;
+    segment_map_t       mSegments;
+    U32                 mNextSegmentID = 1;
+    uintmax_t           mLiveBytes = 0;
+    bool                mIndexDirty = false;
+};
+
+#endif // LL_LLDISKPACK_H
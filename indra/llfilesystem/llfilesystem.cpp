@@ -33,6 +33,7 @@
 #include "llfilesystem.h"
 #include "llfasttimer.h"
 #include "lldiskcache.h"
+#include "lldiskpack.h"
 
 const S32 LLFileSystem::READ        = 0x00000001;
 const S32 LLFileSystem::WRITE       = 0x00000002;
@@ -54,6 +55,12 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
     if (mode == LLFileSystem::READ)
     {
+        if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+        {
+            pack->touch(mFileID, mFileType);
+            return;
+        }
+
         // update the last access time for the file if it exists - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
@@ -74,6 +81,11 @@ LLFileSystem::~LLFileSystem()
 // static
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        return pack->exists(file_id, file_type);
+    }
+
     const boost::filesystem::path filename = LLDiskCache::getInstance()->metaDataToFilepath(file_id, file_type);
     boost::system::error_code ec;
     return boost::filesystem::exists(filename, ec) && !ec.failed();
@@ -82,6 +94,12 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
 // static
 bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error /*= 0*/)
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        pack->remove(file_id, file_type);
+        return true;
+    }
+
     const boost::filesystem::path filename = LLDiskCache::getInstance()->metaDataToFilepath(file_id, file_type);
 
     LLFile::remove(filename, suppress_error);
@@ -100,6 +118,11 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 // static
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        return pack->getSize(file_id, file_type);
+    }
+
     const boost::filesystem::path filename = LLDiskCache::getInstance()->metaDataToFilepath(file_id, file_type);
     boost::system::error_code ec;
     S32 file_size = boost::filesystem::file_size(filename, ec);
@@ -114,6 +137,13 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
 {
     BOOL success = FALSE;
 
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        mBytesRead = pack->read(mFileID, mFileType, mPosition, buffer, bytes);
+        mPosition += mBytesRead;
+        return mBytesRead ? TRUE : FALSE;
+    }
+
     LLFILE* file = LLFile::fopen(mFilePath, TEXT("rb"));
     if (file)
     {
@@ -150,6 +180,16 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 {
     BOOL success = FALSE;
 
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        // Same semantics as the fopen() modes used below: APPEND writes at
+        // the end, READ_WRITE at the current position and WRITE replaces
+        // the whole asset.
+        S32 offset = (mMode == APPEND) ? -1 : mPosition;
+        bool truncate = (mMode != APPEND) && (mMode != READ_WRITE);
+        return pack->write(mFileID, mFileType, offset, buffer, bytes, truncate, mPosition) ? TRUE : FALSE;
+    }
+
     if (mMode == APPEND)
     {
         LLFILE* ofs = LLFile::fopen(mFilePath, TEXT("a+b"));
@@ -239,6 +279,11 @@ S32 LLFileSystem::tell() const
 
 S32 LLFileSystem::getSize()
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        return pack->getSize(mFileID, mFileType);
+    }
+
     boost::system::error_code ec;
     S32 file_size = boost::filesystem::file_size(mFilePath, ec);
     if(ec.failed())
@@ -256,6 +301,18 @@ S32 LLFileSystem::getMaxSize()
 
 BOOL LLFileSystem::rename(const LLUUID& new_id, const LLAssetType::EType new_type)
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        if (!pack->rename(mFileID, mFileType, new_id, new_type))
+        {
+            LL_WARNS() << "Failed to rename " << mFileID << " to " << new_id << " in the pack store" << LL_ENDL;
+        }
+        mFileID = new_id;
+        mFileType = new_type;
+        mFilePath = LLDiskCache::getInstance()->metaDataToFilepath(new_id, new_type);
+        return TRUE;
+    }
+
     const boost::filesystem::path new_filename = LLDiskCache::getInstance()->metaDataToFilepath(new_id, new_type);
 
     // Rename needs the new file to not exist.
@@ -286,6 +343,12 @@ BOOL LLFileSystem::rename(const LLUUID& new_id, const LLAssetType::EType new_typ
 
 BOOL LLFileSystem::remove()
 {
+    if (LLDiskPackStore* pack = LLDiskCache::getInstance()->getPackStore())
+    {
+        pack->remove(mFileID, mFileType);
+        return TRUE;
+    }
+
     boost::system::error_code ec;
     boost::filesystem::remove(mFilePath, ec);
     return TRUE;
@@ -0,0 +1,168 @@
+/**
+ * @file lldiskpack_test.cpp
+ * @date 2024-05
+ * @brief LLDiskPackStore test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldiskpack.h"
+#include "../lldir.h"
+
+#include "lltut.h"
+
+namespace tut
+{
+    struct LLDiskPackFixture
+    {
+        LLDiskPackFixture()
+        {
+            std::string base = LLFile::tmpdir() + std::string("LLDiskPack");
+            for (int counter = 0; ; ++counter)
+            {
+                mDir = base + std::to_string(counter);
+                if (!LLFile::isdir(mDir) && !LLFile::isfile(mDir))
+                {
+                    break;
+                }
+            }
+            LLFile::mkdir(mDir);
+        }
+
+        ~LLDiskPackFixture()
+        {
+            LLDiskPackStore::removeFiles(mDir);
+            LLFile::rmdir(mDir);
+        }
+
+        std::vector<U8> makeData(size_t size, U8 seed)
+        {
+            std::vector<U8> data(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                data[i] = (U8)(seed + i * 7);
+            }
+            return data;
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<LLDiskPackFixture> LLDiskPackTest_factory;
+    typedef LLDiskPackTest_factory::object LLDiskPackTest_t;
+    LLDiskPackTest_factory tf("LLDiskPackStore");
+
+    template<> template<>
+    void LLDiskPackTest_t::test<1>()
+    {
+        set_test_name("write, append, patch and read back");
+
+        LLDiskPackStore store(mDir, 64 * 1024 * 1024, false);
+        LLUUID id;
+        id.generate();
+
+        std::vector<U8> head = makeData(1000, 1);
+        std::vector<U8> tail = makeData(10000, 2);
+        S32 pos = 0;
+        ensure("truncating write", store.write(id, LLAssetType::AT_MESH, 0, head.data(), (S32)head.size(), true, pos));
+        ensure_equals("position after write", pos, 1000);
+        ensure("append", store.write(id, LLAssetType::AT_MESH, -1, tail.data(), (S32)tail.size(), false, pos));
+        ensure_equals("position after append", pos, 11000);
+        ensure_equals("size", store.getSize(id, LLAssetType::AT_MESH), 11000);
+        ensure("type is part of the key", !store.exists(id, LLAssetType::AT_SOUND));
+
+        std::vector<U8> patch = makeData(16, 3);
+        ensure("patch in place", store.write(id, LLAssetType::AT_MESH, 500, patch.data(), (S32)patch.size(), false, pos));
+        ensure_equals("patch keeps the size", store.getSize(id, LLAssetType::AT_MESH), 11000);
+
+        std::vector<U8> expected = head;
+        expected.insert(expected.end(), tail.begin(), tail.end());
+        std::copy(patch.begin(), patch.end(), expected.begin() + 500);
+
+        std::vector<U8> buffer(expected.size() + 10);
+        ensure_equals("read everything", store.read(id, LLAssetType::AT_MESH, 0, buffer.data(), (S32)buffer.size()), 11000);
+        buffer.resize(expected.size());
+        ensure("data matches", buffer == expected);
+        ensure_equals("read past the end", store.read(id, LLAssetType::AT_MESH, 11000, buffer.data(), 10), 0);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<2>()
+    {
+        set_test_name("rename, remove and reload");
+
+        LLUUID id1, id2;
+        id1.generate();
+        id2.generate();
+        std::vector<U8> data = makeData(5000, 4);
+        {
+            LLDiskPackStore store(mDir, 64 * 1024 * 1024, false);
+            S32 pos = 0;
+            ensure("write", store.write(id1, LLAssetType::AT_ANIMATION, 0, data.data(), (S32)data.size(), true, pos));
+            ensure("rename", store.rename(id1, LLAssetType::AT_ANIMATION, id2, LLAssetType::AT_ANIMATION));
+            ensure("old key gone", !store.exists(id1, LLAssetType::AT_ANIMATION));
+            ensure("new key present", store.exists(id2, LLAssetType::AT_ANIMATION));
+            ensure("write second", store.write(id1, LLAssetType::AT_SOUND, 0, data.data(), (S32)data.size(), true, pos));
+            ensure("remove", store.remove(id1, LLAssetType::AT_SOUND));
+            ensure_equals("live bytes", store.getLiveBytes(), (uintmax_t)5000);
+        }
+
+        ensure("index persisted", LLDiskPackStore::exists(mDir));
+
+        LLDiskPackStore store(mDir, 64 * 1024 * 1024, false);
+        ensure_equals("entries after reload", store.getEntryCount(), (size_t)1);
+        std::vector<U8> buffer(data.size());
+        ensure_equals("read after reload", store.read(id2, LLAssetType::AT_ANIMATION, 0, buffer.data(), (S32)buffer.size()), 5000);
+        ensure("data after reload", buffer == data);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<3>()
+    {
+        set_test_name("purge drops the oldest segments and keeps referenced entries");
+
+        const uintmax_t max_size = 16 * 1024 * 1024;
+        LLDiskPackStore store(mDir, max_size, false);
+        std::vector<U8> data = makeData(1024 * 1024, 5);
+        std::vector<LLUUID> ids(40);
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+            S32 pos = 0;
+            ensure("write", store.write(id, LLAssetType::AT_SOUND, 0, data.data(), (S32)data.size(), true, pos));
+        }
+        ensure("over budget", store.getDiskBytes() > max_size);
+
+        store.touch(ids[0], LLAssetType::AT_SOUND);
+        store.purge();
+
+        ensure("under budget", store.getDiskBytes() <= max_size);
+        ensure("referenced entry survives", store.exists(ids[0], LLAssetType::AT_SOUND));
+        ensure("old entry evicted", !store.exists(ids[1], LLAssetType::AT_SOUND));
+        ensure("newest entry kept", store.exists(ids.back(), LLAssetType::AT_SOUND));
+
+        std::vector<U8> buffer(data.size());
+        ensure_equals("read relocated entry", store.read(ids[0], LLAssetType::AT_SOUND, 0, buffer.data(), (S32)buffer.size()), (S32)data.size());
+        ensure("relocated data", buffer == data);
+    }
+}
@@ -0,0 +1,249 @@
+/**
+ * @file llimagedecodecache.cpp
+ * @brief Keeps recent decode results so a texture is not decoded again.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagedecodecache.h"
+
+namespace
+{
+    // Size of a level the way the decoders round it, never below a pixel
+    S32 level_size(S32 full, S32 discard)
+    {
+        return llmax((full + (1 << discard) - 1) >> discard, 1);
+    }
+
+    // A copy of src at width x height, or null when src can't be scaled.
+    // Halves one level at a time so bilinear scaling doesn't alias.
+    LLPointer<LLImageRaw> copy_at(LLImageRaw* src, S32 width, S32 height)
+    {
+        if (!src)
+        {
+            return NULL;
+        }
+        LLPointer<LLImageRaw> result;
+        while (src->getWidth() > width * 2 && src->getHeight() > height * 2)
+        {
+            result = src->scaled(level_size(src->getWidth(), 1), level_size(src->getHeight(), 1));
+            if (result.isNull() || result->isBufferInvalid())
+            {
+                return NULL;
+            }
+            src = result;
+        }
+        result = src->scaled(width, height);
+        if (result.notNull() && result->isBufferInvalid())
+        {
+            result = NULL;
+        }
+        return result;
+    }
+}
+
+LLImageDecodeCache::LLImageDecodeCache()
+:   mBytes(0),
+    mMaxBytes(0)
+{
+}
+
+LLImageDecodeCache::~LLImageDecodeCache()
+{
+    clear();
+}
+
+bool LLImageDecodeCache::find(const LLUUID& id, S32 discard, S32 data_size, S32 width, S32 height, bool needs_aux,
+                              LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (id.isNull() || discard < 0 || discard > MAX_DISCARD_LEVEL || width <= 0 || height <= 0)
+    {
+        return false;
+    }
+
+    LLPointer<LLImageRaw> kept_raw;
+    LLPointer<LLImageRaw> kept_aux;
+    {
+        LLMutexLock lock(&mMutex);
+        entry_map_t::iterator it = mEntries.find(id);
+        if (it == mEntries.end())
+        {
+            return false;
+        }
+
+        Entry& entry = it->second;
+        if (entry.mDiscard > discard || entry.mDataSize < data_size || (needs_aux && entry.mAux.isNull()))
+        {
+            return false;
+        }
+
+        // Kept images are never modified, they can be read unlocked
+        kept_raw = entry.mRaw;
+        kept_aux = entry.mAux;
+        mUsed.splice(mUsed.begin(), mUsed, entry.mUsed);
+    }
+
+    // The kept copy is at least as sharp, bring it down to the level asked for
+    S32 level_width = level_size(width, discard);
+    S32 level_height = level_size(height, discard);
+    LLPointer<LLImageRaw> new_raw = copy_at(kept_raw, level_width, level_height);
+    LLPointer<LLImageRaw> new_aux;
+    if (needs_aux)
+    {
+        new_aux = copy_at(kept_aux, level_width, level_height);
+    }
+
+    if (new_raw.isNull() || (needs_aux && new_aux.isNull()))
+    {
+        return false;
+    }
+    raw = new_raw;
+    aux = new_aux;
+    return true;
+}
+
+void LLImageDecodeCache::insert(const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw, LLImageRaw* aux)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (id.isNull() || discard < 0 || !raw || raw->isBufferInvalid())
+    {
+        return;
+    }
+
+    U64 bytes = (U64)raw->getDataSize() + (aux ? (U64)aux->getDataSize() : 0);
+    {
+        LLMutexLock lock(&mMutex);
+        if (bytes > mMaxBytes)
+        {
+            return;
+        }
+
+        entry_map_t::iterator it = mEntries.find(id);
+        if (it != mEntries.end())
+        {
+            const Entry& old = it->second;
+            bool better = discard < old.mDiscard ||
+                          (discard == old.mDiscard && (data_size > old.mDataSize || (aux && old.mAux.isNull())));
+            if (!better)
+            {
+                mUsed.splice(mUsed.begin(), mUsed, old.mUsed);
+                return;
+            }
+        }
+    }
+
+    // Copy outside the lock, the caller keeps using its own images
+    LLPointer<LLImageRaw> raw_copy = copy_at(raw, raw->getWidth(), raw->getHeight());
+    LLPointer<LLImageRaw> aux_copy;
+    if (aux)
+    {
+        aux_copy = copy_at(aux, aux->getWidth(), aux->getHeight());
+    }
+    if (raw_copy.isNull())
+    {
+        return;
+    }
+
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator it = mEntries.find(id);
+    if (it != mEntries.end())
+    {
+        // Another thread may have put in something better meanwhile
+        const Entry& old = it->second;
+        if (old.mDiscard < discard || (old.mDiscard == discard && old.mDataSize > data_size))
+        {
+            return;
+        }
+        forget(it);
+    }
+
+    Entry& entry = mEntries[id];
+    entry.mRaw = raw_copy;
+    entry.mAux = aux_copy;
+    entry.mDiscard = discard;
+    entry.mDataSize = data_size;
+    entry.mBytes = bytes;
+    mUsed.push_front(id);
+    entry.mUsed = mUsed.begin();
+    mBytes += bytes;
+
+    trim();
+}
+
+void LLImageDecodeCache::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator it = mEntries.find(id);
+    if (it != mEntries.end())
+    {
+        forget(it);
+    }
+}
+
+void LLImageDecodeCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+    mEntries.clear();
+    mUsed.clear();
+    mBytes = 0;
+}
+
+void LLImageDecodeCache::setMaxBytes(U64 bytes)
+{
+    LLMutexLock lock(&mMutex);
+    mMaxBytes = bytes;
+    trim();
+}
+
+U64 LLImageDecodeCache::getMaxBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mMaxBytes;
+}
+
+U64 LLImageDecodeCache::getBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mBytes;
+}
+
+// Called with mMutex held
+void LLImageDecodeCache::forget(entry_map_t::iterator entry)
+{
+    mBytes -= entry->second.mBytes;
+    mUsed.erase(entry->second.mUsed);
+    mEntries.erase(entry);
+}
+
+// Called with mMutex held
+void LLImageDecodeCache::trim()
+{
+    while (mBytes > mMaxBytes && !mUsed.empty())
+    {
+        entry_map_t::iterator it = mEntries.find(mUsed.back());
+        llassert(it != mEntries.end());
+        forget(it);
+    }
+}
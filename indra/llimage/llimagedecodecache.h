@@ -0,0 +1,100 @@
+/**
+ * @file llimagedecodecache.h
+ * @brief Keeps recent decode results so a texture is not decoded again.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEDECODECACHE_H
+#define LL_LLIMAGEDECODECACHE_H
+
+#include "llimage.h"
+#include "llmutex.h"
+#include "llpointer.h"
+#include "lluuid.h"
+
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include <list>
+
+//
+// A texture is decoded again every time its discard level comes back
+// down, after the viewer scaled it away under memory pressure or it left
+// the view for a while.  LLImageDecodeCache keeps a private copy of the
+// best decode of each recently seen texture.  A later request that the
+// copy can answer, because it is at the same or a finer level and came
+// from at least as many bytes of the codestream, gets a copy scaled to
+// the requested level instead of a decode.
+//
+// Entries are evicted least recently used first once the cache is over
+// its byte limit.  Safe to use from any thread.
+//
+class LLImageDecodeCache
+{
+public:
+    LLImageDecodeCache();
+    ~LLImageDecodeCache();
+
+    LLImageDecodeCache(const LLImageDecodeCache&) = delete;
+    LLImageDecodeCache& operator=(const LLImageDecodeCache&) = delete;
+
+    // Fill raw (and aux when needs_aux) with id decoded at discard from
+    // data_size bytes, if a kept decode is at least that good.  width and
+    // height are the full resolution dimensions.
+    bool find(const LLUUID& id, S32 discard, S32 data_size, S32 width, S32 height, bool needs_aux,
+              LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux);
+
+    // Keep a copy of a decode of id, unless a better one is already kept.
+    // aux may be null.
+    void insert(const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw, LLImageRaw* aux);
+
+    void remove(const LLUUID& id);
+    void clear();
+
+    // Bytes of decoded data kept, zero keeps none
+    void setMaxBytes(U64 bytes);
+    U64 getMaxBytes() const;
+    U64 getBytes() const;
+
+private:
+    struct Entry
+    {
+        LLPointer<LLImageRaw>       mRaw;
+        LLPointer<LLImageRaw>       mAux;
+        S32                         mDiscard;
+        S32                         mDataSize;
+        U64                         mBytes;
+        std::list<LLUUID>::iterator mUsed;
+    };
+    typedef boost::unordered_flat_map<LLUUID, Entry> entry_map_t;
+
+    void forget(entry_map_t::iterator entry);
+    void trim();
+
+    mutable LLMutex mMutex;
+    entry_map_t mEntries;
+    std::list<LLUUID> mUsed;    // most recently used first
+    U64 mBytes;
+    U64 mMaxBytes;
+};
+
+#endif // LL_LLIMAGEDECODECACHE_H
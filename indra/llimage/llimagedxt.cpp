@@ -26,6 +26,7 @@
 #include "linden_common.h"
 
 #include "llimagedxt.h"
+#include "llmath.h"
 #include "llmemory.h"
 
 //static
@@ -404,6 +405,80 @@ bool LLImageDXT::encode(const LLImageRaw* raw_image, F32 time)
     return encodeDXT(raw_image, time, false);
 }
 
+bool LLImageDXT::encodeCompressed(const LLImageRaw* raw_image)
+{
+    llassert_always(raw_image);
+    resetLastError();
+
+    S32 ncomponents = raw_image->getComponents();
+    if (ncomponents != 3)
+    {
+        setLastError("LLImageDXT can only block compress RGB images");
+        return false;
+    }
+    EFileFormat format = FORMAT_DXR1;
+
+    S32 width = raw_image->getWidth();
+    S32 height = raw_image->getHeight();
+    if (width < 1 || height < 1 || (width & (width - 1)) || (height & (height - 1)))
+    {
+        setLastError("LLImageDXT can only block compress power of two images");
+        return false;
+    }
+
+    setSize(width, height, ncomponents);
+    mHeaderSize = sizeof(dxtfile_header_t);
+    mFileFormat = format;
+
+    S32 nmips = calcNumMips(width, height);
+    S32 w = width;
+    S32 h = height;
+
+    S32 totbytes = mHeaderSize;
+    for (S32 mip=0; mip<nmips; mip++)
+    {
+        totbytes += formatBytes(format,w,h);
+        w >>= 1;
+        h >>= 1;
+    }
+
+    U8* data = allocateData(totbytes);
+    if (!data)
+    {
+        setLastError("LLImageDXT out of memory");
+        return false;
+    }
+
+    dxtfile_header_t* header = (dxtfile_header_t*)data;
+    memset(header, 0, mHeaderSize);
+    header->fourcc = 0x20534444;
+    header->pixel_fmt.fourcc = getFourCC(format);
+    header->num_mips = nmips;
+    header->maxwidth = width;
+    header->maxheight = height;
+
+    // Each mip is box filtered from the uncompressed level above it
+    const U8* src = raw_image->getData();
+    std::vector<U8> cur_mip, next_mip;
+    w = width, h = height;
+    for (S32 mip=0; mip<nmips; mip++)
+    {
+        compressMip(src, data + getMipOffset(mip), w, h);
+        if (mip + 1 < nmips)
+        {
+            next_mip.resize((size_t)(w >> 1) * (h >> 1) * ncomponents);
+            generateMip(src, next_mip.data(), w >> 1, h >> 1, ncomponents);
+            cur_mip.swap(next_mip);
+            src = cur_mip.data();
+        }
+        w >>= 1;
+        h >>= 1;
+    }
+
+    setDiscardLevel(0);
+    return true;
+}
+
 // virtual
 bool LLImageDXT::convertToDXR()
 {
@@ -505,3 +580,186 @@ void LLImageDXT::extractMip(const U8 *indata, U8* mipdata, int width, int height
 }
 
 //============================================================================
+
+namespace
+{
+    inline U16 pack565(const F32* color)
+    {
+        S32 r = llclamp(ll_round(color[0] * (31.f / 255.f)), 0, 31);
+        S32 g = llclamp(ll_round(color[1] * (63.f / 255.f)), 0, 63);
+        S32 b = llclamp(ll_round(color[2] * (31.f / 255.f)), 0, 31);
+        return (U16)((r << 11) | (g << 5) | b);
+    }
+
+    // Expand the way decoders do
+    inline void unpack565(U16 packed, S32* color)
+    {
+        S32 r = (packed >> 11) & 31;
+        S32 g = (packed >> 5) & 63;
+        S32 b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    inline void storeLE(U8* dst, U64 value, S32 bytes)
+    {
+        for (S32 i = 0; i < bytes; ++i)
+        {
+            dst[i] = (U8)(value >> (8 * i));
+        }
+    }
+}
+
+//static
+void LLImageDXT::compressBlockBC1(const U8* rgba, U8* block)
+{
+    // Fit a line through the colors (principal axis of their covariance)
+    // and put the endpoints at the extreme projections onto it
+    F32 mean[3] = { 0.f, 0.f, 0.f };
+    for (S32 i = 0; i < 16; ++i)
+    {
+        for (S32 c = 0; c < 3; ++c)
+        {
+            mean[c] += rgba[i * 4 + c];
+        }
+    }
+    for (S32 c = 0; c < 3; ++c)
+    {
+        mean[c] *= 1.f / 16.f;
+    }
+
+    F32 cov[3][3] = { { 0.f } };
+    for (S32 i = 0; i < 16; ++i)
+    {
+        F32 d[3];
+        for (S32 c = 0; c < 3; ++c)
+        {
+            d[c] = rgba[i * 4 + c] - mean[c];
+        }
+        for (S32 r = 0; r < 3; ++r)
+        {
+            for (S32 c = 0; c < 3; ++c)
+            {
+                cov[r][c] += d[r] * d[c];
+            }
+        }
+    }
+
+    F32 axis[3] = { 1.f, 1.f, 1.f };
+    for (S32 iter = 0; iter < 8; ++iter)
+    {
+        F32 next[3];
+        F32 scale = 0.f;
+        for (S32 r = 0; r < 3; ++r)
+        {
+            next[r] = cov[r][0] * axis[0] + cov[r][1] * axis[1] + cov[r][2] * axis[2];
+            scale = llmax(scale, fabsf(next[r]));
+        }
+        if (scale < 1e-6f)
+        {
+            break;
+        }
+        for (S32 r = 0; r < 3; ++r)
+        {
+            axis[r] = next[r] / scale;
+        }
+    }
+    F32 axis_len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+    F32 min_t = 0.f;
+    F32 max_t = 0.f;
+    for (S32 i = 0; i < 16; ++i)
+    {
+        F32 t = 0.f;
+        for (S32 c = 0; c < 3; ++c)
+        {
+            t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+        }
+        t /= axis_len2;
+        min_t = llmin(min_t, t);
+        max_t = llmax(max_t, t);
+    }
+
+    F32 hi[3];
+    F32 lo[3];
+    for (S32 c = 0; c < 3; ++c)
+    {
+        hi[c] = mean[c] + max_t * axis[c];
+        lo[c] = mean[c] + min_t * axis[c];
+    }
+    U16 c0 = pack565(hi);
+    U16 c1 = pack565(lo);
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    // c0 > c1 selects the four color mode, equal endpoints need no indices
+    U32 indices = 0;
+    if (c0 != c1)
+    {
+        S32 palette[4][3];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (S32 c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (S32 i = 0; i < 16; ++i)
+        {
+            S32 best = 0;
+            S32 best_dist = S32_MAX;
+            for (S32 p = 0; p < 4; ++p)
+            {
+                S32 dist = 0;
+                for (S32 c = 0; c < 3; ++c)
+                {
+                    S32 d = rgba[i * 4 + c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < best_dist)
+                {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices |= (U32)best << (2 * i);
+        }
+    }
+
+    storeLE(block, c0, 2);
+    storeLE(block + 2, c1, 2);
+    storeLE(block + 4, indices, 4);
+}
+
+//static
+void LLImageDXT::compressMip(const U8* indata, U8* mipdata, S32 width, S32 height)
+{
+    // Mips smaller than a block repeat their edge pixels to fill it
+    U8 rgba[16 * 4];
+    for (S32 by = 0; by < height; by += 4)
+    {
+        for (S32 bx = 0; bx < width; bx += 4)
+        {
+            for (S32 y = 0; y < 4; ++y)
+            {
+                const U8* row = indata + (size_t)llmin(by + y, height - 1) * width * 3;
+                for (S32 x = 0; x < 4; ++x)
+                {
+                    const U8* pixel = row + llmin(bx + x, width - 1) * 3;
+                    U8* out = rgba + (y * 4 + x) * 4;
+                    out[0] = pixel[0];
+                    out[1] = pixel[1];
+                    out[2] = pixel[2];
+                    out[3] = 255;
+                }
+            }
+
+            compressBlockBC1(rgba, mipdata);
+            mipdata += 8;
+        }
+    }
+}
@@ -117,6 +117,10 @@ class LLImageDXT final : public LLImageFormatted
 
     bool convertToDXR(); // convert from DXT to DXR
 
+    // Block compress an RGB raw_image and a box filtered mip chain below
+    // it to BC1 (DXR1)
+    bool encodeCompressed(const LLImageRaw* raw_image);
+
     static void checkMinWidthHeight(EFileFormat format, S32& width, S32& height);
     static S32 formatBits(EFileFormat format);
     static S32 formatBytes(EFileFormat format, S32 width, S32 height);
@@ -129,9 +133,14 @@ class LLImageDXT final : public LLImageFormatted
     static void calcDiscardWidthHeight(S32 discard_level, EFileFormat format, S32& width, S32& height);
     static S32 calcNumMips(S32 width, S32 height);
 
+    // Encode the colors of one 4x4 block of RGBA pixels, row by row, into
+    // an 8 byte BC1 block
+    static void compressBlockBC1(const U8* rgba, U8* block);
+
 private:
     static void extractMip(const U8 *indata, U8* mipdata, int width, int height,
                            int mip_width, int mip_height, EFileFormat format);
+    static void compressMip(const U8* indata, U8* mipdata, S32 width, S32 height);
 
 private:
     EFileFormat mFileFormat;
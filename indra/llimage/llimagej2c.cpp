@@ -42,6 +42,9 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+U32 LLImageJ2C::sDecodeThreads = 1;
+U32 LLImageJ2C::sDecodePixelsPerThread = LLImageJ2C::DEFAULT_DECODE_PIXELS_PER_THREAD;
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -56,6 +59,7 @@ LLImageJ2C::LLImageJ2C() :  LLImageFormatted(IMG_CODEC_J2C),
                             mRawDiscardLevel(-1),
                             mRate(DEFAULT_COMPRESSION_RATE),
                             mReversible(false),
+                            mLastDecodeThreads(1),
                             mAreaUsedForDataSizeCalcs(0)
 {
     mImpl.reset(fallbackCreateLLImageJ2CImpl());
@@ -168,6 +172,7 @@ bool LLImageJ2C::decodeChannels(LLImageRaw *raw_imagep, F32 decode_time, S32 fir
         // Update the raw discard level
         updateRawDiscardLevel();
         mDecoding = true;
+        mLastDecodeThreads = 1;
         res = mImpl->decodeImpl(*this, *raw_imagep, decode_time, first_channel, max_channel_count);
     }
 
@@ -201,6 +206,11 @@ bool LLImageJ2C::decodeChannels(LLImageRaw *raw_imagep, F32 decode_time, S32 fir
         {
             // The whole data stream is finally decompressed when res is returned as true
             tester->updateDecompressionStats(this->getDataSize(), raw_imagep->getDataSize()) ;
+            if (raw_imagep->getDataSize() > 0)
+            {
+                tester->updateImageDecompressionStats(raw_imagep->getWidth() * raw_imagep->getHeight(),
+                                                      mLastDecodeThreads, elapsed.getElapsedTimeF32());
+            }
         }
     }
 
@@ -342,6 +352,22 @@ void LLImageJ2C::setReversible(const bool reversible)
     mReversible = reversible;
 }
 
+//static
+void LLImageJ2C::setDecodeThreads(U32 max_threads, U32 pixels_per_thread)
+{
+    sDecodeThreads = llmax(max_threads, 1U);
+    sDecodePixelsPerThread = llmax(pixels_per_thread, 1U);
+}
+
+//static
+U32 LLImageJ2C::calcDecodeThreads(S32 width, S32 height)
+{
+    // Small images are not worth waking more threads for, large ones get
+    // one more thread per sDecodePixelsPerThread up to the limit
+    U64 pixels = (U64)llmax(width, 0) * (U64)llmax(height, 0);
+    return (U32)llclamp(pixels / sDecodePixelsPerThread, (U64)1, (U64)sDecodeThreads);
+}
+
 
 bool LLImageJ2C::loadAndValidate(const std::string &filename)
 {
@@ -449,6 +475,11 @@ LLImageCompressionTester::LLImageCompressionTester() : LLMetricPerformanceTester
     addMetric("Volume Out Decompression (kB)");
     addMetric("Decompression Ratio (x:1)");
     addMetric("Perf Decompression (kB/s)");
+    addMetric("Images Decompressed");
+    addMetric("Perf Image Decompression (Mpixels/s)");
+    addMetric("Max Image Decompression Time (s)");
+    addMetric("Parallel Images Decompressed");
+    addMetric("Perf Parallel Image Decompression (Mpixels/s)");
 
     addMetric("Time Compression (s)");
     addMetric("Volume In Compression (kB)");
@@ -468,6 +499,14 @@ LLImageCompressionTester::LLImageCompressionTester() : LLMetricPerformanceTester
     mTotalTimeDecompression = 0.0f;
     mTotalTimeCompression = 0.0f;
     mRunTimeDecompression = 0.0f;
+
+    mTotalImagesDecompression = 0;
+    mTotalPixelsDecompression = 0;
+    mTotalImageTimeDecompression = 0.0f;
+    mMaxImageTimeDecompression = 0.0f;
+    mParallelImagesDecompression = 0;
+    mParallelPixelsDecompression = 0;
+    mParallelImageTimeDecompression = 0.0f;
 }
 
 LLImageCompressionTester::~LLImageCompressionTester()
@@ -508,11 +547,27 @@ void LLImageCompressionTester::outputTestRecord(LLSD *sd)
         compressionRate = totalkBInCompression / totalkBOutCompression;
     }
 
+    F32 imageDecompressionPerf = 0.0f;
+    F32 parallelDecompressionPerf = 0.0f;
+    if (!is_approx_zero(mTotalImageTimeDecompression))
+    {
+        imageDecompressionPerf = (F32)mTotalPixelsDecompression / 1000000.f / mTotalImageTimeDecompression;
+    }
+    if (!is_approx_zero(mParallelImageTimeDecompression))
+    {
+        parallelDecompressionPerf = (F32)mParallelPixelsDecompression / 1000000.f / mParallelImageTimeDecompression;
+    }
+
     (*sd)[currentLabel]["Time Decompression (s)"]       = (LLSD::Real)mTotalTimeDecompression;
     (*sd)[currentLabel]["Volume In Decompression (kB)"] = (LLSD::Real)totalkBInDecompression;
     (*sd)[currentLabel]["Volume Out Decompression (kB)"]= (LLSD::Real)totalkBOutDecompression;
     (*sd)[currentLabel]["Decompression Ratio (x:1)"]    = (LLSD::Real)decompressionRate;
     (*sd)[currentLabel]["Perf Decompression (kB/s)"]    = (LLSD::Real)decompressionPerf;
+    (*sd)[currentLabel]["Images Decompressed"]          = (LLSD::Integer)mTotalImagesDecompression;
+    (*sd)[currentLabel]["Perf Image Decompression (Mpixels/s)"] = (LLSD::Real)imageDecompressionPerf;
+    (*sd)[currentLabel]["Max Image Decompression Time (s)"]     = (LLSD::Real)mMaxImageTimeDecompression;
+    (*sd)[currentLabel]["Parallel Images Decompressed"] = (LLSD::Integer)mParallelImagesDecompression;
+    (*sd)[currentLabel]["Perf Parallel Image Decompression (Mpixels/s)"] = (LLSD::Real)parallelDecompressionPerf;
 
     (*sd)[currentLabel]["Time Compression (s)"]         = (LLSD::Real)mTotalTimeCompression;
     (*sd)[currentLabel]["Volume In Compression (kB)"]   = (LLSD::Real)totalkBInCompression;
@@ -545,6 +600,20 @@ void LLImageCompressionTester::updateDecompressionStats(const F32 deltaTime)
     mTotalTimeDecompression += deltaTime;
 }
 
+void LLImageCompressionTester::updateImageDecompressionStats(const S32 pixels, const U32 threads, const F32 deltaTime)
+{
+    mTotalImagesDecompression++;
+    mTotalPixelsDecompression += pixels;
+    mTotalImageTimeDecompression += deltaTime;
+    mMaxImageTimeDecompression = llmax(mMaxImageTimeDecompression, deltaTime);
+    if (threads > 1)
+    {
+        mParallelImagesDecompression++;
+        mParallelPixelsDecompression += pixels;
+        mParallelImageTimeDecompression += deltaTime;
+    }
+}
+
 void LLImageCompressionTester::updateDecompressionStats(const S32 bytesIn, const S32 bytesOut)
 {
     mTotalBytesInDecompression += bytesIn;
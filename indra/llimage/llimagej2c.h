@@ -78,6 +78,16 @@ class LLImageJ2C final : public LLImageFormatted
 
     static std::string getEngineInfo();
 
+    // Let the codec split one image over up to max_threads threads, about
+    // one per pixels_per_thread output pixels.  1 decodes serially.
+    static void setDecodeThreads(U32 max_threads, U32 pixels_per_thread = DEFAULT_DECODE_PIXELS_PER_THREAD);
+    static U32 calcDecodeThreads(S32 width, S32 height);
+
+    // Threads the last decode ran on, for stats
+    U32 getLastDecodeThreads() const { return mLastDecodeThreads; }
+
+    static const U32 DEFAULT_DECODE_PIXELS_PER_THREAD = 256 * 256 * 4;
+
 protected:
     friend class LLImageJ2CImpl;
     friend class LLImageJ2COJ;
@@ -94,11 +104,15 @@ class LLImageJ2C final : public LLImageFormatted
     S8  mRawDiscardLevel;
     F32 mRate;
     bool mReversible;
+    U32 mLastDecodeThreads;
     std::unique_ptr<LLImageJ2CImpl> mImpl;
     std::string mLastError;
 
     // Image compression/decompression tester
     static LLImageCompressionTester* sTesterp;
+
+    static U32 sDecodeThreads;
+    static U32 sDecodePixelsPerThread;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -146,6 +160,7 @@ class LLImageCompressionTester final : public LLMetricPerformanceTesterBasic
         void updateDecompressionStats(const S32 bytesIn, const S32 bytesOut) ;
         void updateCompressionStats(const F32 deltaTime) ;
         void updateCompressionStats(const S32 bytesIn, const S32 bytesOut) ;
+        void updateImageDecompressionStats(const S32 pixels, const U32 threads, const F32 deltaTime) ;
 
     protected:
         /*virtual*/ void outputTestRecord(LLSD* sd);
@@ -167,6 +182,16 @@ class LLImageCompressionTester final : public LLMetricPerformanceTesterBasic
         F32 mTotalTimeDecompression;        // Total time spent in computing decompression
         F32 mTotalTimeCompression;          // Total time spent in computing compression
         F32 mRunTimeDecompression;          // Time in this run (we output every 5 sec in decompress)
+        //
+        // Per image
+        //
+        U32 mTotalImagesDecompression;      // Images decoded to completion
+        U64 mTotalPixelsDecompression;      // Pixels they produced
+        F32 mTotalImageTimeDecompression;   // Time spent on them
+        F32 mMaxImageTimeDecompression;     // Slowest single image
+        U32 mParallelImagesDecompression;   // Same, for images decoded on several threads
+        U64 mParallelPixelsDecompression;
+        F32 mParallelImageTimeDecompression;
     };
 
 #endif
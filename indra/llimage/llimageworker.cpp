@@ -28,6 +28,7 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "lltrace.h"
 #include "threadpool.h"
 
 /*--------------------------------------------------------------------------*/
@@ -38,7 +39,9 @@ class ImageRequest
                  S32 discard,
                  BOOL needs_aux,
                  const LLPointer<LLImageDecodeThread::Responder>& responder,
-                 U32 request_id);
+                 U32 request_id,
+                 const LLUUID& id,
+                 LLImageDecodeCache* cache);
     virtual ~ImageRequest();
 
     /*virtual*/ bool processRequest();
@@ -52,6 +55,8 @@ class ImageRequest
     S32 mDiscardLevel;
     U32 mRequestId;
     BOOL mNeedsAux;
+    LLUUID mID;
+    LLImageDecodeCache* mCache;
     // output
     LLPointer<LLImageRaw> mDecodedImageRaw;
     LLPointer<LLImageRaw> mDecodedImageAux;
@@ -64,11 +69,17 @@ class ImageRequest
 
 //----------------------------------------------------------------------------
 
+static LLTrace::SampleStatHandle<> sDecodeQueueDepth("imagedecodequeuedepth", "Image decodes waiting in the ImageDecode pool");
+static LLTrace::CountStatHandle<> sDecodeSteals("imagedecodesteals", "Image decodes stolen by an idle ImageDecode worker");
+static LLTrace::CountStatHandle<> sDecodeCacheHits("imagedecodecachehits", "Image decodes answered from the decode cache");
+static LLTrace::CountStatHandle<> sDecodeCacheMisses("imagedecodecachemisses", "Image decodes the decode cache could not answer");
+
 // MAIN THREAD
 LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
     : mDecodeCount(0)
 {
-    mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
+    mThreadPool.reset(new LL::WorkStealingThreadPool("ImageDecode", 8));
+    mThreadPool->getQueue().setTraceStats(&sDecodeQueueDepth, &sDecodeSteals);
     mThreadPool->start();
 }
 
@@ -93,14 +104,17 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     const LLPointer<LLImageFormatted>& image,
     S32 discard,
     BOOL needs_aux,
-    const LLPointer<LLImageDecodeThread::Responder>& responder)
+    const LLPointer<LLImageDecodeThread::Responder>& responder,
+    const LLUUID& id)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
     U32 decode_id = ++mDecodeCount;
+    // With the decode cache off, requests neither look in it nor copy into it
+    LLImageDecodeCache* cache = mDecodeCache.getMaxBytes() > 0 ? &mDecodeCache : NULL;
     // Instantiate the ImageRequest right in the lambda, why not?
     bool posted = mThreadPool->getQueue().post(
-        [req = ImageRequest(image, discard, needs_aux, responder, decode_id)]
+        [req = ImageRequest(image, discard, needs_aux, responder, decode_id, id, cache)]
         () mutable
         {
             auto done = req.processRequest();
@@ -130,10 +144,14 @@ ImageRequest::ImageRequest(const LLPointer<LLImageFormatted>& image,
                            S32 discard,
                            BOOL needs_aux,
                            const LLPointer<LLImageDecodeThread::Responder>& responder,
-                           U32 request_id)
+                           U32 request_id,
+                           const LLUUID& id,
+                           LLImageDecodeCache* cache)
     : mFormattedImage(image),
       mDiscardLevel(discard),
       mNeedsAux(needs_aux),
+      mID(id),
+      mCache(cache),
       mDecodedRaw(FALSE),
       mDecodedAux(FALSE),
       mResponder(responder),
@@ -179,6 +197,21 @@ bool ImageRequest::processRequest()
             {
                 mFormattedImage->setDiscardLevel(mDiscardLevel);
             }
+            if (mCache && mID.notNull())
+            {
+                if (mCache->find(mID, mFormattedImage->getDiscardLevel(), mFormattedImage->getDataSize(),
+                                 mFormattedImage->getWidth(), mFormattedImage->getHeight(), mNeedsAux,
+                                 mDecodedImageRaw, mDecodedImageAux))
+                {
+                    // An earlier decode at this level or a finer one already
+                    // had these bytes, skip the decoder
+                    LLTrace::add(sDecodeCacheHits, 1);
+                    mDecodedRaw = TRUE;
+                    mDecodedAux = mNeedsAux;
+                    return true;
+                }
+                LLTrace::add(sDecodeCacheMisses, 1);
+            }
             mDecodedImageRaw = new LLImageRaw(mFormattedImage->getWidth(),
                                               mFormattedImage->getHeight(),
                                               mFormattedImage->getComponents());
@@ -206,6 +239,12 @@ bool ImageRequest::processRequest()
         mErrorString = LLImage::getLastThreadError();
     }
 
+    if (done && mCache && mDecodedRaw && (!mNeedsAux || mDecodedAux))
+    {
+        mCache->insert(mID, mFormattedImage->getDiscardLevel(), mFormattedImage->getDataSize(),
+                       mDecodedImageRaw, mNeedsAux ? mDecodedImageAux.get() : NULL);
+    }
+
     return done;
 }
 
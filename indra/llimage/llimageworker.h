@@ -28,6 +28,7 @@
 #define LL_LLIMAGEWORKER_H
 
 #include "llimage.h"
+#include "llimagedecodecache.h"
 #include "llpointer.h"
 #include "threadpool_fwd.h"
 
@@ -48,19 +49,26 @@ class LLImageDecodeThread
 
     // meant to resemble LLQueuedThread::handle_t
     typedef U32 handle_t;
+    // While the decode cache is enabled, decodes of a non-null id are
+    // answered from and kept in it when it can serve them
     handle_t decodeImage(const LLPointer<LLImageFormatted>& image,
                          S32 discard, BOOL needs_aux,
-                         const LLPointer<Responder>& responder);
+                         const LLPointer<Responder>& responder,
+                         const LLUUID& id = LLUUID::null);
     size_t getPending();
     size_t update(F32 max_time_ms);
     S32 getTotalDecodeCount() { return mDecodeCount; }
     void shutdown();
 
+    LLImageDecodeCache& getDecodeCache() { return mDecodeCache; }
+
 private:
+    // Declared ahead of the pool so it outlives requests still running
+    LLImageDecodeCache mDecodeCache;
     // As of SL-17483, LLImageDecodeThread is no longer itself an
     // LLQueuedThread - instead this is the API by which we submit work to the
     // "ImageDecode" ThreadPool.
-    std::unique_ptr<LL::ThreadPool> mThreadPool;
+    std::unique_ptr<LL::WorkStealingThreadPool> mThreadPool;
     LLAtomicU32 mDecodeCount;
 };
 
@@ -0,0 +1,233 @@
+/**
+ * @file llimagedxt_test.cpp
+ * @brief Tests for LLImageDXT's BC1 block compression
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+// Class to test
+#include "../llimagedxt.h"
+#include "../llimage.h"
+// Tut header
+#include "../test/lltut.h"
+#include "stringize.h"
+
+namespace
+{
+    U16 loadU16(const U8* src)
+    {
+        return (U16)(src[0] | (src[1] << 8));
+    }
+
+    U32 loadU32(const U8* src)
+    {
+        return (U32)src[0] | ((U32)src[1] << 8) | ((U32)src[2] << 16) | ((U32)src[3] << 24);
+    }
+
+    // Decode an 8 byte BC1 block to 16 RGB pixels the way the hardware does
+    void decodeBlockBC1(const U8* block, S32 rgb[16][3])
+    {
+        U16 c0 = loadU16(block);
+        U16 c1 = loadU16(block + 2);
+        U32 indices = loadU32(block + 4);
+
+        S32 palette[4][3];
+        for (S32 p = 0; p < 2; ++p)
+        {
+            U16 packed = p ? c1 : c0;
+            S32 r = (packed >> 11) & 31;
+            S32 g = (packed >> 5) & 63;
+            S32 b = packed & 31;
+            palette[p][0] = (r << 3) | (r >> 2);
+            palette[p][1] = (g << 2) | (g >> 4);
+            palette[p][2] = (b << 3) | (b >> 2);
+        }
+        for (S32 c = 0; c < 3; ++c)
+        {
+            if (c0 > c1)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+
+        for (S32 i = 0; i < 16; ++i)
+        {
+            S32 index = (indices >> (2 * i)) & 3;
+            for (S32 c = 0; c < 3; ++c)
+            {
+                rgb[i][c] = palette[index][c];
+            }
+        }
+    }
+
+    void setPixel(U8* rgba, S32 i, U8 r, U8 g, U8 b)
+    {
+        rgba[i * 4 + 0] = r;
+        rgba[i * 4 + 1] = g;
+        rgba[i * 4 + 2] = b;
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+namespace tut
+{
+    struct imagedxt_test
+    {
+        U8 mRGBA[16 * 4];
+        U8 mBlock[8];
+
+        imagedxt_test()
+        {
+            memset(mRGBA, 0, sizeof(mRGBA));
+            memset(mBlock, 0xCD, sizeof(mBlock));
+        }
+
+        void compress()
+        {
+            LLImageDXT::compressBlockBC1(mRGBA, mBlock);
+        }
+    };
+
+    typedef test_group<imagedxt_test> imagedxt_t;
+    typedef imagedxt_t::object imagedxt_object_t;
+    tut::imagedxt_t tut_imagedxt("LLImageDXT");
+
+    template<> template<>
+    void imagedxt_object_t::test<1>()
+    {
+        set_test_name("a single color block has equal endpoints and no indices");
+
+        for (S32 i = 0; i < 16; ++i)
+        {
+            setPixel(mRGBA, i, 255, 0, 0);
+        }
+        compress();
+
+        ensure_equals("c0", loadU16(mBlock), (U16)0xF800);
+        ensure_equals("c1", loadU16(mBlock + 2), (U16)0xF800);
+        ensure_equals("indices", loadU32(mBlock + 4), (U32)0);
+    }
+
+    template<> template<>
+    void imagedxt_object_t::test<2>()
+    {
+        set_test_name("a two color block picks its colors as endpoints");
+
+        // Top half white, bottom half black
+        for (S32 i = 0; i < 16; ++i)
+        {
+            U8 value = i < 8 ? 255 : 0;
+            setPixel(mRGBA, i, value, value, value);
+        }
+        compress();
+
+        ensure_equals("c0", loadU16(mBlock), (U16)0xFFFF);
+        ensure_equals("c1", loadU16(mBlock + 2), (U16)0x0000);
+        // white is endpoint 0, black endpoint 1
+        ensure_equals("indices", loadU32(mBlock + 4), (U32)0x55550000);
+    }
+
+    template<> template<>
+    void imagedxt_object_t::test<3>()
+    {
+        set_test_name("a gray ramp lands on the interpolated colors");
+
+        // Every row runs 255, 170, 85, 0
+        const U8 ramp[4] = { 255, 170, 85, 0 };
+        for (S32 i = 0; i < 16; ++i)
+        {
+            U8 value = ramp[i % 4];
+            setPixel(mRGBA, i, value, value, value);
+        }
+        compress();
+
+        ensure_equals("c0", loadU16(mBlock), (U16)0xFFFF);
+        ensure_equals("c1", loadU16(mBlock + 2), (U16)0x0000);
+        // endpoint 0, 2/3 of the way to endpoint 1 is index 2, 1/3 is index 3
+        ensure_equals("indices", loadU32(mBlock + 4), (U32)0x78787878);
+
+        S32 rgb[16][3];
+        decodeBlockBC1(mBlock, rgb);
+        for (S32 i = 0; i < 16; ++i)
+        {
+            for (S32 c = 0; c < 3; ++c)
+            {
+                ensure_equals(stringize("pixel ", i, " channel ", c), rgb[i][c], (S32)ramp[i % 4]);
+            }
+        }
+    }
+
+    template<> template<>
+    void imagedxt_object_t::test<4>()
+    {
+        set_test_name("encodeCompressed() round trips an RGB image");
+
+        // One flat color per 4x4 block, each exactly representable in 565
+        const U8 colors[4][3] = { { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 132, 130, 132 } };
+        LLPointer<LLImageRaw> raw = new LLImageRaw(8, 8, 3);
+        U8* pixels = raw->getData();
+        for (S32 y = 0; y < 8; ++y)
+        {
+            for (S32 x = 0; x < 8; ++x)
+            {
+                const U8* color = colors[(y / 4) * 2 + x / 4];
+                memcpy(pixels + (y * 8 + x) * 3, color, 3);
+            }
+        }
+
+        LLPointer<LLImageDXT> image = new LLImageDXT();
+        ensure("encoded", image->encodeCompressed(raw));
+        ensure_equals("format", (S32)image->getFileFormat(), (S32)LLImageDXT::FORMAT_DXR1);
+        ensure_equals("width", image->getWidth(), 8);
+        ensure_equals("height", image->getHeight(), 8);
+        ensure_equals("components", (S32)image->getComponents(), 3);
+
+        // The full size level is the last one, after the smaller mips
+        const U8* mip = image->getData() + image->getMipOffset(0);
+        ensure_equals("full size level ends the data", image->getMipOffset(0) + 4 * 8, image->getDataSize());
+        for (S32 block = 0; block < 4; ++block)
+        {
+            S32 rgb[16][3];
+            decodeBlockBC1(mip + block * 8, rgb);
+            for (S32 i = 0; i < 16; ++i)
+            {
+                for (S32 c = 0; c < 3; ++c)
+                {
+                    ensure_equals(stringize("block ", block, " pixel ", i, " channel ", c),
+                                  rgb[i][c], (S32)colors[block][c]);
+                }
+            }
+        }
+
+        // Alpha is not block compressed
+        LLPointer<LLImageRaw> rgba = new LLImageRaw(8, 8, 4);
+        LLPointer<LLImageDXT> rejected = new LLImageDXT();
+        ensure("RGBA rejected", !rejected->encodeCompressed(rgba));
+    }
+}
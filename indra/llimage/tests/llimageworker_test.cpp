@@ -70,6 +70,13 @@ const U8* LLImageBase::getData() const { return NULL; }
 U8* LLImageBase::getData() { return NULL; }
 const std::string& LLImage::getLastThreadError() { static std::string msg; return msg; }
 
+LLImageDecodeCache::LLImageDecodeCache() : mBytes(0), mMaxBytes(0) { }
+LLImageDecodeCache::~LLImageDecodeCache() { }
+bool LLImageDecodeCache::find(const LLUUID& id, S32 discard, S32 data_size, S32 width, S32 height, bool needs_aux,
+                              LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux) { return false; }
+void LLImageDecodeCache::insert(const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw, LLImageRaw* aux) { }
+U64 LLImageDecodeCache::getMaxBytes() const { return 0; }
+
 // End Stubbing
 // -------------------------------------------------------------------------------------------
 
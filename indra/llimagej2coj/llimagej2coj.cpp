@@ -216,14 +216,21 @@ int ceildivpow2(int a, int b)
 }
 
 LLImageJ2COJ::LLImageJ2COJ()
-    : LLImageJ2CImpl()
+    : LLImageJ2CImpl(),
+    mHasRegion(false)
 {
+    memset(mRegion, 0, sizeof(mRegion));
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
 {
-    // No specific implementation for this method in the OpenJpeg case
-    return false;
+    // The discard level is picked up from base, only the region is ours to keep
+    mHasRegion = region && region[2] > region[0] && region[3] > region[1];
+    if (mHasRegion)
+    {
+        memcpy(mRegion, region, sizeof(mRegion));
+    }
+    return true;
 }
 
 bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size, int precincts_size, int levels)
@@ -235,6 +242,10 @@ bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int block
 
 bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
 {
+    // A region from initDecode() applies to this decode only
+    const bool has_region = mHasRegion;
+    mHasRegion = false;
+
     /* Extract metadata */
     /* ---------------- */
     U8* c_data = base.getData();
@@ -319,6 +330,22 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
     //opj_decoder_set_strict_mode(opj_decoder_p, OPJ_FALSE);
 
+    // Big images are split over several threads inside OpenJPEG.  That has
+    // to be set before the header is read, so size it from the metadata.
+    U32 threads = 1;
+    if (opj_has_thread_support())
+    {
+        S32 width = has_region ? mRegion[2] - mRegion[0] : base.getWidth();
+        S32 height = has_region ? mRegion[3] - mRegion[1] : base.getHeight();
+        U32 reduce = llmin((U32)parameters.cp_reduce, (U32)MAX_DISCARD_LEVEL);
+        threads = LLImageJ2C::calcDecodeThreads(width >> reduce, height >> reduce);
+        if (threads > 1 && !opj_codec_set_threads(opj_decoder_p, threads))
+        {
+            threads = 1;
+        }
+    }
+    base.mLastDecodeThreads = threads;
+
     /* open a byte stream */
     LLJp2StreamReader streamReader(&base);
     opj_stream_t* opj_stream_p = opj_stream_default_create(OPJ_STREAM_READ);
@@ -329,9 +356,18 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     opj_stream_set_user_data_length(opj_stream_p, base.getDataSize());
 
     /* decode the stream and fill the image structure */
-    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image) &&
-                    opj_decode(opj_decoder_p, opj_stream_p, image) &&
-                    opj_end_decompress(opj_decoder_p, opj_stream_p);
+    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image);
+
+    // Code blocks outside the region are skipped, as are the resolution
+    // levels cp_reduce drops
+    if (success && has_region)
+    {
+        success = opj_set_decode_area(opj_decoder_p, image, mRegion[0], mRegion[1], mRegion[2], mRegion[3]);
+    }
+
+    success = success &&
+                opj_decode(opj_decoder_p, opj_stream_p, image) &&
+                opj_end_decompress(opj_decoder_p, opj_stream_p);
 
     /* close the byte stream */
     opj_stream_destroy(opj_stream_p);
@@ -386,6 +422,13 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     S32 f=image->comps[0].factor;
     S32 width = ceildivpow2(image->x1 - image->x0, f);
     S32 height = ceildivpow2(image->y1 - image->y0, f);
+    if (has_region)
+    {
+        // A region need not start on a multiple of 2^f, the component
+        // knows its own size
+        width = image->comps[0].w;
+        height = image->comps[0].h;
+    }
     raw_image.resize(width, height, channels);
     U8 *rawp = raw_image.getData();
     if (!rawp)
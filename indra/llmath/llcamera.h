@@ -141,6 +141,8 @@ class LLCamera
     LLVector3 mAgentFrustum[AGENT_FRUSTRUM_NUM];  //8 corners of 6-plane frustum
     F32 mFrustumCornerDist;     //distance to corner of frustum against far clip plane
     LLPlane& getAgentPlane(U32 idx) { return mAgentPlanes[idx]; }
+    U8 getPlaneMask(U32 idx) const { return mPlaneMask[idx]; } // PLANE_MASK_NONE if the plane is ignored
+    U32 getPlaneCount() const { return mPlaneCount; }
 
 public:
     LLCamera();
@@ -0,0 +1,251 @@
+/**
+ * @file llflatoctree.cpp
+ * @brief Linearized mirror of an LLOctreeNode tree for culling.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llflatoctree.h"
+
+#include "llmemory.h"
+
+LLFlatOctreeBase::Frustum::Frustum(LLCamera& camera, U32 flags)
+:   mPlaneCount(0),
+    mSphere(flags & TEST_SPHERE)
+{
+    // Same planes LLCamera::AABBInFrustum() and AABBInFrustumNoFarClip()
+    // look at.  Taking |n| against the half size picks the corner the
+    // plane mask would have picked.
+    U32 max_planes = llmin(camera.getPlaneCount(), (U32) LLCamera::AGENT_PLANE_USER_CLIP_NUM);
+    for (U32 i = 0; i < max_planes; i++)
+    {
+        if (camera.getPlaneMask(i) >= LLCamera::PLANE_MASK_NUM ||
+            (i == LLCamera::AGENT_PLANE_FAR && !(flags & TEST_FAR_PLANE)))
+        {
+            continue;
+        }
+
+        const LLPlane& plane = camera.getAgentPlane(i);
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            mNormal[mPlaneCount][axis].splat(plane[axis]);
+            mAbsNormal[mPlaneCount][axis].splat(fabsf(plane[axis]));
+        }
+        mDistance[mPlaneCount].splat(-plane[3]);
+        ++mPlaneCount;
+    }
+
+    const LLVector3& origin = camera.getOrigin();
+    for (U32 axis = 0; axis < 3; ++axis)
+    {
+        mOrigin[axis].splat(origin.mV[axis]);
+    }
+    mRadiusSquared.splat(camera.mFrustumCornerDist * camera.mFrustumCornerDist);
+}
+
+LLFlatOctreeBase::LLFlatOctreeBase()
+:   mBlocks(nullptr),
+    mBlockCount(0),
+    mBlockCapacity(0)
+{
+}
+
+LLFlatOctreeBase::~LLFlatOctreeBase()
+{
+    ll_aligned_free_16(mBlocks);
+}
+
+void LLFlatOctreeBase::clearSlots()
+{
+    mParent.clear();
+    mFirstChild.clear();
+    mChildCount.clear();
+    mBlockCount = 0;
+}
+
+U32 LLFlatOctreeBase::allocFamily(U32 parent, U32 count)
+{
+    llassert(count > 0 && count <= 8);
+
+    U32 first = (U32) mParent.size();
+    U32 blocks = (count + 3) / 4;
+    if (mBlockCount + blocks > mBlockCapacity)
+    {
+        U32 capacity = llmax(mBlockCapacity * 2, mBlockCount + blocks);
+        mBlocks = (LLVector4a*) ll_aligned_realloc_16(mBlocks,
+                                                      capacity * BLOCK_VECTORS * sizeof(LLVector4a),
+                                                      mBlockCapacity * BLOCK_VECTORS * sizeof(LLVector4a));
+        mBlockCapacity = capacity;
+    }
+    for (U32 i = 0; i < blocks * BLOCK_VECTORS; ++i)
+    {
+        mBlocks[mBlockCount * BLOCK_VECTORS + i].clear();
+    }
+    mBlockCount += blocks;
+
+    // Padding slots are leaves with no parent
+    mParent.resize(first + blocks * 4, NO_NODE);
+    mFirstChild.resize(first + blocks * 4, NO_NODE);
+    mChildCount.resize(first + blocks * 4, 0);
+    for (U32 i = 0; i < count; ++i)
+    {
+        mParent[first + i] = parent;
+    }
+
+    if (parent != NO_NODE)
+    {
+        mFirstChild[parent] = first;
+        mChildCount[parent] = (U8) count;
+    }
+
+    return first;
+}
+
+void LLFlatOctreeBase::setBounds(U32 index, const LLVector4a* bounds, const LLVector4a* extents)
+{
+    LLVector4a* block = mBlocks + (index / 4) * BLOCK_VECTORS;
+    U32 lane = index % 4;
+    for (U32 axis = 0; axis < 3; ++axis)
+    {
+        block[CENTER_X + axis].getF32ptr()[lane] = bounds[0][axis];
+        block[SIZE_X + axis].getF32ptr()[lane] = bounds[1][axis];
+        block[MIN_X + axis].getF32ptr()[lane] = extents[0][axis];
+        block[MAX_X + axis].getF32ptr()[lane] = extents[1][axis];
+    }
+}
+
+void LLFlatOctreeBase::getBounds(U32 index, LLVector4a* bounds, LLVector4a* extents) const
+{
+    const LLVector4a* block = mBlocks + (index / 4) * BLOCK_VECTORS;
+    U32 lane = index % 4;
+    bounds[0].set(block[CENTER_X][lane], block[CENTER_Y][lane], block[CENTER_Z][lane]);
+    bounds[1].set(block[SIZE_X][lane], block[SIZE_Y][lane], block[SIZE_Z][lane]);
+    extents[0].set(block[MIN_X][lane], block[MIN_Y][lane], block[MIN_Z][lane]);
+    extents[1].set(block[MAX_X][lane], block[MAX_Y][lane], block[MAX_Z][lane]);
+}
+
+void LLFlatOctreeBase::test(const Frustum& frustum, U32 first, U32 count, U8* results) const
+{
+    llassert(first + count <= getSlotCount());
+
+    U8 block_results[4];
+    U32 end = first + count;
+    for (U32 block = first / 4; block * 4 < end; ++block)
+    {
+        testBlock(frustum, block, block_results);
+        for (U32 lane = 0; lane < 4; ++lane)
+        {
+            U32 index = block * 4 + lane;
+            if (index >= first && index < end)
+            {
+                results[index - first] = block_results[lane];
+            }
+        }
+    }
+}
+
+void LLFlatOctreeBase::testBlock(const Frustum& frustum, U32 block, U8* results) const
+{
+    const LLVector4a* v = mBlocks + block * BLOCK_VECTORS;
+
+    // A box is out when its nearest corner is outside any plane, and only
+    // partly in when its farthest corner is outside one
+    U32 outside = 0;
+    U32 partial = 0;
+    LLVector4a dist, tmp, reach, lo, hi;
+    for (U32 i = 0; i < frustum.mPlaneCount; ++i)
+    {
+        dist.setMul(frustum.mNormal[i][0], v[CENTER_X]);
+        tmp.setMul(frustum.mNormal[i][1], v[CENTER_Y]);
+        dist.add(tmp);
+        tmp.setMul(frustum.mNormal[i][2], v[CENTER_Z]);
+        dist.add(tmp);
+
+        reach.setMul(frustum.mAbsNormal[i][0], v[SIZE_X]);
+        tmp.setMul(frustum.mAbsNormal[i][1], v[SIZE_Y]);
+        reach.add(tmp);
+        tmp.setMul(frustum.mAbsNormal[i][2], v[SIZE_Z]);
+        reach.add(tmp);
+
+        lo.setSub(dist, reach);
+        hi.setAdd(dist, reach);
+        outside |= lo.greaterThan(frustum.mDistance[i]).getGatheredBits();
+        partial |= hi.greaterThan(frustum.mDistance[i]).getGatheredBits();
+    }
+
+    // AABBSphereIntersect(): in when both corners are within the radius,
+    // out when the closest point of the box is beyond it
+    U32 sphere_inside = 0xf;
+    U32 sphere_outside = 0;
+    if (frustum.mSphere)
+    {
+        LLVector4a near_dist, min_dist, max_dist, zero;
+        zero.clear();
+        near_dist.clear();
+        min_dist.clear();
+        max_dist.clear();
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            lo.setSub(v[MIN_X + axis], frustum.mOrigin[axis]);
+            hi.setSub(v[MAX_X + axis], frustum.mOrigin[axis]);
+
+            tmp.setMul(lo, lo);
+            min_dist.add(tmp);
+            tmp.setMul(hi, hi);
+            max_dist.add(tmp);
+
+            // at most one of lo > 0 (origin below the box) and hi < 0
+            // (origin above it) holds
+            LLVector4a gap;
+            gap.setMax(lo, zero);
+            tmp.setSub(zero, hi);
+            tmp.setMax(tmp, zero);
+            gap.add(tmp);
+            gap.mul(gap);
+            near_dist.add(gap);
+        }
+        sphere_inside = min_dist.lessThan(frustum.mRadiusSquared).getGatheredBits() &
+                        max_dist.lessThan(frustum.mRadiusSquared).getGatheredBits();
+        sphere_outside = near_dist.greaterThan(frustum.mRadiusSquared).getGatheredBits();
+    }
+
+    for (U32 lane = 0; lane < 4; ++lane)
+    {
+        U32 bit = 1 << lane;
+        U8 res = 0;
+        if (!(outside & bit) && !(sphere_outside & bit))
+        {
+            res = ((partial & bit) || !(sphere_inside & bit)) ? 1 : 2;
+        }
+        results[lane] = res;
+    }
+}
+
+U64 LLFlatOctreeBase::getAllocatedBytes() const
+{
+    return mParent.capacity() * sizeof(U32) +
+           mFirstChild.capacity() * sizeof(U32) +
+           mChildCount.capacity() * sizeof(U8) +
+           (U64) mBlockCapacity * BLOCK_VECTORS * sizeof(LLVector4a);
+}
@@ -0,0 +1,220 @@
+/**
+ * @file llflatoctree.h
+ * @brief Linearized mirror of an LLOctreeNode tree for culling.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFLATOCTREE_H
+#define LL_LLFLATOCTREE_H
+
+#include "llcamera.h"
+#include "lloctree.h"
+#include "llvector4a.h"
+
+#include <vector>
+
+//
+// LLOctreeNode trees are walked by chasing a pointer per node and per
+// child.  LLFlatOctree keeps a copy of the tree's shape in flat arrays:
+// slots are handed out breadth first, the children of a node always sit
+// next to each other starting on a multiple of 4, and their bounding
+// boxes are stored four to a block, one LLVector4a per coordinate.  A
+// whole family is then classified against a frustum with a handful of
+// SIMD operations instead of one LLCamera::AABBInFrustum() per child.
+//
+// The mirror is a snapshot: rebuild it after the tree changes shape,
+// refit a node with setBounds() when only its box moved.
+//
+
+class LLFlatOctreeBase
+{
+public:
+    enum
+    {
+        TEST_FAR_PLANE = 0x1,   // clip against the far plane, like LLCamera::AABBInFrustum()
+        TEST_SPHERE    = 0x2,   // also clip the extents against the camera's corner distance
+    };
+
+    static constexpr U32 NO_NODE = 0xFFFFFFFF;
+
+    // Frustum planes splatted across the four lanes of a block
+    class Frustum
+    {
+    public:
+        Frustum(LLCamera& camera, U32 flags);
+
+    private:
+        friend class LLFlatOctreeBase;
+
+        LLVector4a mNormal[LLCamera::AGENT_PLANE_USER_CLIP_NUM][3];
+        LLVector4a mAbsNormal[LLCamera::AGENT_PLANE_USER_CLIP_NUM][3];
+        LLVector4a mDistance[LLCamera::AGENT_PLANE_USER_CLIP_NUM];
+        U32 mPlaneCount;
+        LLVector4a mOrigin[3];
+        LLVector4a mRadiusSquared;
+        bool mSphere;
+    };
+
+    LLFlatOctreeBase();
+    ~LLFlatOctreeBase();
+
+    LLFlatOctreeBase(const LLFlatOctreeBase&) = delete;
+    LLFlatOctreeBase& operator=(const LLFlatOctreeBase&) = delete;
+
+    // Slots in use, padding included
+    U32 getSlotCount() const                { return (U32) mParent.size(); }
+    U32 getParent(U32 index) const          { return mParent[index]; }
+    U32 getFirstChild(U32 index) const      { return mFirstChild[index]; }
+    U32 getChildCount(U32 index) const      { return mChildCount[index]; }
+
+    // bounds is center and half size, extents is min and max, the way
+    // LLViewerOctreeGroup keeps them
+    void setBounds(U32 index, const LLVector4a* bounds, const LLVector4a* extents);
+    void getBounds(U32 index, LLVector4a* bounds, LLVector4a* extents) const;
+
+    // Classify slots [first, first + count) the way LLCamera's AABB tests
+    // do: 0 outside, 1 partly inside, 2 fully inside.  results must have
+    // room for count entries.
+    void test(const Frustum& frustum, U32 first, U32 count, U8* results) const;
+
+    // Bytes held by the arrays
+    U64 getAllocatedBytes() const;
+
+protected:
+    void clearSlots();
+
+    // Reserve a 4-aligned run of count slots for parent's children and
+    // return the first one
+    U32 allocFamily(U32 parent, U32 count);
+
+private:
+    enum
+    {
+        CENTER_X, CENTER_Y, CENTER_Z,
+        SIZE_X, SIZE_Y, SIZE_Z,
+        MIN_X, MIN_Y, MIN_Z,
+        MAX_X, MAX_Y, MAX_Z,
+        BLOCK_VECTORS
+    };
+
+    void testBlock(const Frustum& frustum, U32 block, U8* results) const;
+
+    std::vector<U32> mParent;
+    std::vector<U32> mFirstChild;
+    std::vector<U8> mChildCount;
+
+    LLVector4a* mBlocks;    // BLOCK_VECTORS per four slots
+    U32 mBlockCount;
+    U32 mBlockCapacity;
+};
+
+template <class T, typename T_PTR>
+class LLFlatOctree : public LLFlatOctreeBase
+{
+public:
+    typedef LLOctreeNode<T, T_PTR> oct_node;
+
+    // Lay out the tree under root from scratch.  Bounds are not filled in,
+    // the caller decides what box a node has (see setBounds()).
+    void build(const oct_node* root)
+    {
+        clearSlots();
+        mNodes.clear();
+
+        allocFamily(NO_NODE, 1);
+        mNodes.resize(getSlotCount(), nullptr);
+        mNodes[0] = root;
+
+        for (U32 i = 0; i < mNodes.size(); ++i)
+        {
+            const oct_node* node = mNodes[i];
+            U32 count = node ? node->getChildCount() : 0;
+            if (count)
+            {
+                U32 first = allocFamily(i, count);
+                mNodes.resize(getSlotCount(), nullptr);
+                for (U32 c = 0; c < count; ++c)
+                {
+                    mNodes[first + c] = node->getChild(c);
+                }
+            }
+        }
+    }
+
+    // nullptr for padding slots
+    const oct_node* getNode(U32 index) const    { return mNodes[index]; }
+
+    // Walk the nodes at least partly inside frustum, parents before their
+    // children and children in octree order, calling visit(node, index, res)
+    // for each.  Below a node that is fully inside nothing is tested again
+    // and res stays 2.
+    template <typename VISITOR>
+    void cull(const Frustum& frustum, VISITOR&& visit) const
+    {
+        if (mNodes.empty())
+        {
+            return;
+        }
+
+        thread_local std::vector<U8> results;
+        thread_local std::vector<std::pair<U32, U8> > stack;
+        results.resize(mNodes.size());
+        stack.clear();
+
+        test(frustum, 0, 1, &results[0]);
+        stack.emplace_back(0, results[0]);
+        while (!stack.empty())
+        {
+            U32 index = stack.back().first;
+            U8 res = stack.back().second;
+            stack.pop_back();
+            if (!res)
+            {
+                continue;
+            }
+
+            visit(mNodes[index], index, (S32) res);
+
+            U32 first = getFirstChild(index);
+            U32 count = getChildCount(index);
+            if (count && res != 2)
+            {
+                test(frustum, first, count, &results[first]);
+            }
+            for (U32 c = count; c-- > 0; )
+            {
+                stack.emplace_back(first + c, res == 2 ? 2 : results[first + c]);
+            }
+        }
+    }
+
+    U64 getAllocatedBytes() const
+    {
+        return LLFlatOctreeBase::getAllocatedBytes() + mNodes.capacity() * sizeof(const oct_node*);
+    }
+
+private:
+    std::vector<const oct_node*> mNodes;
+};
+
+#endif // LL_LLFLATOCTREE_H
@@ -96,6 +96,148 @@ const S32 SCULPT_MIN_AREA_DETAIL = 1;
 
 BOOL gDebugGL = FALSE; // See settings.xml "RenderDebugGL"
 
+// Batched kernels for the hot volume generation loops.  Each one keeps
+// the operation order of the LLVector4a code it replaces so the output
+// is bit-identical; the AVX builds (USE_AVX/USE_AVX2) just run two
+// vectors through every instruction.
+namespace
+{
+    // dst[i] = mat.rotate(src[i]) + offset
+    void transform_points(const LLMatrix4a& mat, const LLVector4a& offset,
+                          const LLVector4a* src, LLVector4a* dst, S32 count)
+    {
+        S32 i = 0;
+#if defined(__AVX__)
+        const __m256 col0 = _mm256_broadcast_ps((const __m128*) mat.mMatrix[0].getF32ptr());
+        const __m256 col1 = _mm256_broadcast_ps((const __m128*) mat.mMatrix[1].getF32ptr());
+        const __m256 col2 = _mm256_broadcast_ps((const __m128*) mat.mMatrix[2].getF32ptr());
+        const __m256 offs = _mm256_broadcast_ps((const __m128*) offset.getF32ptr());
+        for (; i + 2 <= count; i += 2)
+        {
+            __m256 v = _mm256_loadu_ps(src[i].getF32ptr());
+            __m256 x = _mm256_mul_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), col0);
+            __m256 y = _mm256_mul_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), col1);
+            __m256 z = _mm256_mul_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), col2);
+            __m256 res = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), offs);
+            _mm256_storeu_ps(dst[i].getF32ptr(), res);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            LLVector4a tmp;
+            mat.rotate(src[i], tmp);
+            dst[i].setAdd(tmp, offset);
+        }
+    }
+
+#if defined(__AVX__)
+    // Two lanes of LLVector4a::setCross3
+    inline __m256 cross3_x2(__m256 a, __m256 b)
+    {
+        __m256 a_yzx = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m256 b_zxy = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+        __m256 a_zxy = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+        __m256 b_yzx = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        return _mm256_sub_ps(_mm256_mul_ps(a_yzx, b_zxy), _mm256_mul_ps(a_zxy, b_yzx));
+    }
+
+    inline __m256 load_pair(const LLVector4a& lo, const LLVector4a& hi)
+    {
+        return _mm256_set_m128(hi, lo);
+    }
+#endif
+
+    // Unnormalized face normal of every triangle in idx
+    void calc_triangle_normals(const LLVector4a* pos, const U16* idx, LLVector4a* output, U32 count)
+    {
+        U32 i = 0;
+#if defined(__AVX__)
+        for (; i + 2 <= count; i += 2, idx += 6)
+        {
+            __m256 p0 = load_pair(pos[idx[0]], pos[idx[3]]);
+            __m256 p1 = load_pair(pos[idx[1]], pos[idx[4]]);
+            __m256 p2 = load_pair(pos[idx[2]], pos[idx[5]]);
+            __m256 a = _mm256_sub_ps(p0, p1);
+            __m256 b = _mm256_sub_ps(p0, p2);
+            _mm256_storeu_ps(output[i].getF32ptr(), cross3_x2(a, b));
+        }
+#endif
+        for (; i < count; ++i, idx += 3)
+        {
+            LLVector4a a, b;
+            a.setSub(pos[idx[0]], pos[idx[1]]);
+            b.setSub(pos[idx[0]], pos[idx[2]]);
+            output[i].setCross3(a, b);
+        }
+    }
+
+    // Per-triangle half of LLCalculateTangentArray.  The edge math runs
+    // on whole vectors, and with AVX sdir and tdir share one register:
+    // [d1 | d2] * [t2 | s1] - [d2 | d1] * [t1 | s2] = [sdir | tdir] / r
+    void accumulate_tangents(const LLVector4a* vertex, const LLVector2* texcoord,
+                             U32 triangleCount, const U16* index_array,
+                             LLVector4a* tan1, LLVector4a* tan2)
+    {
+        for (U32 a = 0; a < triangleCount; a++)
+        {
+            U32 i1 = *index_array++;
+            U32 i2 = *index_array++;
+            U32 i3 = *index_array++;
+
+            const LLVector2& w1 = texcoord[i1];
+            const LLVector2& w2 = texcoord[i2];
+            const LLVector2& w3 = texcoord[i3];
+
+            F32 s1 = w2.mV[0] - w1.mV[0];
+            F32 s2 = w3.mV[0] - w1.mV[0];
+            F32 t1 = w2.mV[1] - w1.mV[1];
+            F32 t2 = w3.mV[1] - w1.mV[1];
+
+            F32 rd = s1*t2-s2*t1;
+
+            F32 r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd)
+                                            : ((rd > 0.0f) ? 1024.f : -1024.f); //some made up large ratio for division by zero
+
+            llassert(llfinite(r));
+            llassert(!llisnan(r));
+
+            LLVector4a d1, d2;
+            d1.setSub(vertex[i2], vertex[i1]);
+            d2.setSub(vertex[i3], vertex[i1]);
+
+            LLVector4a sdir, tdir;
+#if defined(__AVX__)
+            __m256 lhs = _mm256_mul_ps(load_pair(d1, d2), _mm256_setr_m128(_mm_set1_ps(t2), _mm_set1_ps(s1)));
+            __m256 rhs = _mm256_mul_ps(load_pair(d2, d1), _mm256_setr_m128(_mm_set1_ps(t1), _mm_set1_ps(s2)));
+            __m256 dirs = _mm256_mul_ps(_mm256_sub_ps(lhs, rhs), _mm256_set1_ps(r));
+            sdir = _mm256_castps256_ps128(dirs);
+            tdir = _mm256_extractf128_ps(dirs, 1);
+#else
+            LLVector4a lhs(d1), rhs(d2);
+            lhs.mul(t2);
+            rhs.mul(t1);
+            sdir.setSub(lhs, rhs);
+            sdir.mul(r);
+
+            lhs = d2;
+            rhs = d1;
+            lhs.mul(s1);
+            rhs.mul(s2);
+            tdir.setSub(lhs, rhs);
+            tdir.mul(r);
+#endif
+
+            tan1[i1].add(sdir);
+            tan1[i2].add(sdir);
+            tan1[i3].add(sdir);
+
+            tan2[i1].add(tdir);
+            tan2[i2].add(tdir);
+            tan2[i3].add(tdir);
+        }
+    }
+}
+
 BOOL check_same_clock_dir( const LLVector3& pt1, const LLVector3& pt2, const LLVector3& pt3, const LLVector3& norm)
 {
     LLVector3 test = (pt2-pt1)%(pt3-pt2);
@@ -1965,6 +2107,7 @@ void LLPathParams::copyParams(const LLPathParams &params)
 }
 
 S32 LLVolume::sNumMeshPoints = 0;
+bool LLVolume::sVectorized = true;
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
     : mParams(params)
@@ -2003,6 +2146,16 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
     }
 }
 
+U64 LLVolume::getAllocatedBytes() const
+{
+    U64 bytes = sizeof(LLVolume) + mMesh.size() * sizeof(LLVector4a);
+    for (const LLVolumeFace& face : mVolumeFaces)
+    {
+        bytes += face.getAllocatedBytes();
+    }
+    return bytes;
+}
+
 void LLVolume::resizePath(S32 length)
 {
     mPathp->resizePath(length);
@@ -2133,6 +2286,13 @@ BOOL LLVolume::generate()
                 offset.clear();
             }
 
+            if (sVectorized)
+            {
+                transform_points(rot_mat, offset, profile, dst, sizeT);
+                dst += sizeT;
+                continue;
+            }
+
             LLVector4a tmp;
 
             // Run along the profile.
@@ -6026,60 +6186,41 @@ BOOL LLVolumeFace::createCap(LLVolume* volume, BOOL partial_build)
 
     const LLVector4a* p = profile.mArray;
 
-    if (mTypeMask & TOP_MASK)
-    {
-        min_uv.set((*p)[0]+0.5f,
-                    (*p)[1]+0.5f);
-
-        max_uv = min_uv;
-
-        while(src < end)
-        {
-            tc->mV[0] = (*p)[0]+0.5f;
-            tc->mV[1] = (*p)[1]+0.5f;
+    // Texture coordinates are the profile's x/y shifted into 0..1,
+    // mirrored in v for the underside.
+    const LLVector4a uv_scale(1.f, (mTypeMask & TOP_MASK) ? 1.f : -1.f, 0.f, 0.f);
+    const LLVector4a uv_bias(0.5f, 0.5f, 0.f, 0.f);
 
-            llassert(src->isFinite3()); // MAINT-5660; don't know why this happens, does not affect Release builds
-            update_min_max(min,max,*src);
-            update_min_max(min_uv, max_uv, *tc);
+    LLVector4a uv;
+    uv.setMul(*p, uv_scale);
+    uv.add(uv_bias);
 
-            *pos = *src;
+    LLVector4a uv_min = uv;
+    LLVector4a uv_max = uv;
 
-            llassert(pos->isFinite3());
-
-            ++p;
-            ++tc;
-            ++src;
-            ++pos;
-        }
-        }
-        else
-        {
-
-        min_uv.set((*p)[0]+0.5f,
-                   0.5f - (*p)[1]);
-        max_uv = min_uv;
-
-        while(src < end)
-        {
-            // Mirror for underside.
-            tc->mV[0] = (*p)[0]+0.5f;
-            tc->mV[1] = 0.5f - (*p)[1];
+    while(src < end)
+    {
+        uv.setMul(*p, uv_scale);
+        uv.add(uv_bias);
+        _mm_storel_pi((__m64*) tc->mV, uv);
 
-            llassert(src->isFinite3());
-            update_min_max(min,max,*src);
-            update_min_max(min_uv, max_uv, *tc);
+        llassert(src->isFinite3()); // MAINT-5660; don't know why this happens, does not affect Release builds
+        update_min_max(min,max,*src);
+        update_min_max(uv_min, uv_max, uv);
 
-            *pos = *src;
+        *pos = *src;
 
-            llassert(pos->isFinite3());
+        llassert(pos->isFinite3());
 
-            ++p;
-            ++tc;
-            ++src;
-            ++pos;
-        }
+        ++p;
+        ++tc;
+        ++src;
+        ++pos;
     }
 
+    min_uv.set(uv_min[0], uv_min[1]);
+    max_uv.set(uv_max[0], uv_max[1]);
+
     LL_CHECK_MEMORY
 
     mCenter->setAdd(min, max);
@@ -6511,6 +6652,30 @@ void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, con
     mNumVertices++;
 }
 
+U64 LLVolumeFace::getAllocatedBytes() const
+{
+    U64 bytes = sizeof(LLVector4a) * 3; // extents and center
+    if (mPositions)
+    {
+        U64 tc_size = ((mNumAllocatedVertices * sizeof(LLVector2)) + 0xF) & ~0xF;
+        bytes += sizeof(LLVector4a) * 2 * mNumAllocatedVertices + tc_size;
+    }
+    if (mTangents)
+    {
+        bytes += sizeof(LLVector4a) * mNumVertices;
+    }
+    if (mWeights)
+    {
+        bytes += sizeof(LLVector4a) * mNumVertices;
+    }
+    if (mIndices)
+    {
+        bytes += ((mNumIndices * sizeof(U16)) + 0xF) & ~0xF;
+    }
+    bytes += mEdge.capacity() * sizeof(S32);
+    return bytes;
+}
+
 void LLVolumeFace::allocateTangents(S32 num_verts)
 {
     ll_aligned_free_16(mTangents);
@@ -6888,6 +7053,12 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 
     U16* idx = mIndices;
 
+    if (LLVolume::sVectorized)
+    {
+        calc_triangle_normals(pos, idx, output, count);
+        output = end_output;
+    }
+
     while (output < end_output)
     {
         LLVector4a b,v1,v2;
@@ -7128,6 +7299,12 @@ void LLCalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LL
         tan1[i].clear();
     }
 
+    if (LLVolume::sVectorized)
+    {
+        accumulate_tangents(vertex, texcoord, triangleCount, index_array, tan1, tan2);
+        triangleCount = 0;
+    }
+
     for (U32 a = 0; a < triangleCount; a++)
     {
         U32 i1 = *index_array++;
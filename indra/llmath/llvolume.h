@@ -890,6 +890,9 @@ class LLVolumeFace
 
     void getVertexData(U16 indx, LLVolumeFace::VertexData& cv);
 
+    // Approximate heap footprint of the face's vertex and index data
+    U64 getAllocatedBytes() const;
+
     class VertexMapData : public LLVolumeFace::VertexData
     {
     public:
@@ -1019,6 +1022,7 @@ class LLVolume : public LLRefCount
     U8 getPathType() const                                  { return mParams.getPathParams().getCurveType(); }
     S32 getNumFaces() const;
     S32 getNumVolumeFaces() const                           { return mVolumeFaces.size(); }
+    U64 getAllocatedBytes() const;                          // faces plus generated mesh points
     F32 getDetail() const                                   { return mDetail; }
     F32 getSurfaceArea() const                              { return mSurfaceArea; }
     const LLVolumeParams& getParams() const                 { return mParams; }
@@ -1070,6 +1074,7 @@ class LLVolume : public LLRefCount
 
     BOOL isFaceMaskValid(LLFaceID face_mask);
     static S32 sNumMeshPoints;
+    static bool sVectorized; // batched SIMD generation and tangent loops, false for the reference loops
 
     friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
     friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);      // HACK to bypass Windoze confusion over
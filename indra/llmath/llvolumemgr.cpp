@@ -27,6 +27,7 @@
 
 #include "llvolumemgr.h"
 #include "llvolume.h"
+#include "lltrace.h"
 
 
 const F32 BASE_THRESHOLD = 0.03f;
@@ -41,6 +42,113 @@ F32 LLVolumeLODGroup::mDetailThresholds[NUM_LODS] = {BASE_THRESHOLD,
 F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 
 
+static LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > sVolumeCacheHitRate("volume_cache_hits");
+static LLTrace::SampleStatHandle<F64Megabytes> sVolumeCacheSize("volume_cache_size");
+
+//============================================================================
+
+LLVolumeCache::LLVolumeCache()
+:   mLimit(0),
+    mBytes(0),
+    mHits(0),
+    mMisses(0)
+{
+}
+
+void LLVolumeCache::setLimit(U64 bytes)
+{
+    mLimit = bytes;
+    trim();
+}
+
+void LLVolumeCache::put(S32 lod, LLVolume* volume)
+{
+    if (!mLimit || !volume || volume->isUnique())
+    {
+        return;
+    }
+
+    // Only keep geometry that is complete.  A sculpt that never got its
+    // texture or a mesh that never loaded would just be stale here.
+    U8 sculpt_type = volume->getParams().getSculptType() & LL_SCULPT_TYPE_MASK;
+    if (sculpt_type == LL_SCULPT_TYPE_MESH)
+    {
+        if (!volume->isMeshAssetLoaded())
+        {
+            return;
+        }
+    }
+    else if (sculpt_type != LL_SCULPT_TYPE_NONE && volume->getSculptLevel() == -2)
+    {
+        return;
+    }
+
+    key_t key(&volume->getParams(), lod);
+    auto found = mIndex.find(key);
+    if (found != mIndex.end())
+    {
+        // Same shape already parked, keep the newer one
+        mBytes -= found->second->mBytes;
+        mEntries.erase(found->second);
+        mIndex.erase(found);
+    }
+
+    U64 bytes = volume->getAllocatedBytes();
+    if (bytes > mLimit)
+    {
+        return;
+    }
+
+    mEntries.push_front(Entry{ lod, volume, bytes });
+    mIndex.emplace(key, mEntries.begin());
+    mBytes += bytes;
+    trim();
+}
+
+LLPointer<LLVolume> LLVolumeCache::take(const LLVolumeParams& params, S32 lod)
+{
+    LLPointer<LLVolume> volume;
+    auto found = mIndex.find(key_t(&params, lod));
+    if (found != mIndex.end())
+    {
+        volume = found->second->mVolume;
+        mBytes -= found->second->mBytes;
+        mEntries.erase(found->second);
+        mIndex.erase(found);
+        ++mHits;
+    }
+    else
+    {
+        ++mMisses;
+    }
+
+    if (mLimit)
+    {
+        record(sVolumeCacheHitRate, LLUnits::Ratio::fromValue(volume.notNull() ? 1 : 0));
+        sample(sVolumeCacheSize, F64Bytes((F64)mBytes));
+    }
+    return volume;
+}
+
+void LLVolumeCache::clear()
+{
+    mIndex.clear();
+    mEntries.clear();
+    mBytes = 0;
+}
+
+void LLVolumeCache::trim()
+{
+    while (mBytes > mLimit && !mEntries.empty())
+    {
+        const Entry& oldest = mEntries.back();
+        mIndex.erase(key_t(&oldest.mVolume->getParams(), oldest.mLOD));
+        mBytes -= oldest.mBytes;
+        mEntries.pop_back();
+    }
+    sample(sVolumeCacheSize, F64Bytes((F64)mBytes));
+}
+
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
@@ -78,6 +186,7 @@ BOOL LLVolumeMgr::cleanup()
         delete volgroupp;
     }
     mVolumeLODGroups.clear();
+    mCache.clear();
     if (mDataMutex)
     {
         mDataMutex->unlock();
@@ -105,6 +214,14 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
     {
         volgroupp = iter->second;
     }
+    if (!volgroupp->hasLOD(lod) && mCache.getLimit())
+    {
+        LLPointer<LLVolume> cached = mCache.take(volume_params, lod);
+        if (cached.notNull())
+        {
+            volgroupp->setLOD(lod, cached);
+        }
+    }
     if (mDataMutex)
     {
         mDataMutex->unlock();
@@ -162,6 +279,7 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
         if (volgroupp->getNumRefs() == 0)
         {
             mVolumeLODGroups.erase(params);
+            volgroupp->retireLODs(mCache);
             delete volgroupp;
         }
     }
@@ -218,6 +336,18 @@ void LLVolumeMgr::useMutex()
     }
 }
 
+void LLVolumeMgr::setCacheLimit(U64 bytes)
+{
+    LLMutexLock lock(mDataMutex);
+    mCache.setLimit(bytes);
+}
+
+U64 LLVolumeMgr::getCacheBytes() const
+{
+    LLMutexLock lock(mDataMutex);
+    return mCache.getBytes();
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
     s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -301,6 +431,27 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 lod)
     return mVolumeLODs[lod];
 }
 
+void LLVolumeLODGroup::setLOD(const S32 lod, LLVolume* volumep)
+{
+    llassert(lod >=0 && lod < NUM_LODS);
+    llassert(mVolumeLODs[lod].isNull());
+    mVolumeLODs[lod] = volumep;
+}
+
+// Hand every generated LOD to the cache once nothing references the group
+void LLVolumeLODGroup::retireLODs(LLVolumeCache& cache)
+{
+    llassert(mRefs == 0);
+    for (S32 i = 0; i < NUM_LODS; i++)
+    {
+        if (mVolumeLODs[i].notNull())
+        {
+            cache.put(i, mVolumeLODs[i]);
+            mVolumeLODs[i] = NULL;
+        }
+    }
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
     llassert_always(mRefs > 0);
@@ -27,6 +27,7 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <list>
 #include <map>
 
 #include "llvolume.h"
@@ -35,6 +36,7 @@
 
 class LLVolumeParams;
 class LLVolumeLODGroup;
+class LLVolumeCache;
 
 class LLVolumeLODGroup
 {
@@ -57,6 +59,9 @@ class LLVolumeLODGroup
 
     LLVolume* refLOD(const S32 detail);
     BOOL derefLOD(LLVolume *volumep);
+    bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+    void setLOD(const S32 detail, LLVolume* volumep);
+    void retireLODs(LLVolumeCache& cache);
     S32 getNumRefs() const { return mRefs; }
 
     const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
@@ -75,6 +80,66 @@ class LLVolumeLODGroup
     S32     mAccessCount[NUM_LODS];
 };
 
+// Bounded LRU of generated volumes that nothing references any more,
+// keyed by params and LOD.  LLVolumeMgr parks a volume here when its
+// last user goes away and hands the same LLVolume back to the next
+// refVolume() for that shape, so LOD flips and region crossings don't
+// regenerate identical geometry.  Volumes are shared, never copied.
+// Not thread safe on its own; LLVolumeMgr calls it under its mutex.
+class LLVolumeCache
+{
+    LOG_CLASS(LLVolumeCache);
+
+public:
+    LLVolumeCache();
+
+    // Zero disables the cache and drops whatever it holds.
+    void setLimit(U64 bytes);
+    U64 getLimit() const                        { return mLimit; }
+    U64 getBytes() const                        { return mBytes; }
+    size_t size() const                         { return mEntries.size(); }
+    U64 getHits() const                         { return mHits; }
+    U64 getMisses() const                       { return mMisses; }
+
+    // Keep a volume nothing references any more.  Partially loaded
+    // sculpts and meshes are not worth keeping and are refused.
+    void put(S32 lod, LLVolume* volume);
+
+    // Remove and return the cached volume for params and lod, if any.
+    LLPointer<LLVolume> take(const LLVolumeParams& params, S32 lod);
+
+    void clear();
+
+private:
+    void trim();
+
+    struct Entry
+    {
+        S32                 mLOD;
+        LLPointer<LLVolume> mVolume;
+        U64                 mBytes;
+    };
+    typedef std::list<Entry> entry_list_t; // most recently parked first
+
+    typedef std::pair<const LLVolumeParams*, S32> key_t;
+    struct KeyLess
+    {
+        bool operator()(const key_t& lhs, const key_t& rhs) const
+        {
+            if (*lhs.first < *rhs.first) return true;
+            if (*rhs.first < *lhs.first) return false;
+            return lhs.second < rhs.second;
+        }
+    };
+
+    entry_list_t mEntries;
+    std::map<key_t, entry_list_t::iterator, KeyLess> mIndex; // keys point into the cached volumes' params
+    U64 mLimit;
+    U64 mBytes;
+    U64 mHits;
+    U64 mMisses;
+};
+
 class LLVolumeMgr
 {
 public:
@@ -95,6 +160,10 @@ class LLVolumeMgr
     // manually call this for mutex magic
     void useMutex();
 
+    // Byte budget for volumes kept after their last unref, 0 to disable
+    void setCacheLimit(U64 bytes);
+    U64 getCacheBytes() const;
+
     friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -105,6 +174,7 @@ class LLVolumeMgr
 protected:
     typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
     volume_lod_group_map_t mVolumeLODGroups;
+    LLVolumeCache mCache;
 
     LLMutex* mDataMutex;
 };
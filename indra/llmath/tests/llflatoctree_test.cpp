@@ -0,0 +1,355 @@
+/**
+ * @file   llflatoctree_test.cpp
+ * @date   2024-06
+ * @brief  Checks LLFlatOctree against the pointer octree it mirrors.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include "../llflatoctree.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace tut
+{
+    struct LLFlatOctreeData
+    {
+        class alignas(16) Element
+        {
+            LL_ALIGN_NEW
+        public:
+            Element(const LLVector3& position, F32 radius)
+            :   mRadius(radius),
+                mBinIndex(-1)
+            {
+                mPosition.load3(position.mV);
+            }
+
+            const LLVector4a& getPositionGroup() const  { return mPosition; }
+            const F32& getBinRadius() const             { return mRadius; }
+            S32 getBinIndex() const                     { return mBinIndex; }
+            void setBinIndex(S32 index) const           { mBinIndex = index; }
+
+            LLVector4a mPosition;
+            F32 mRadius;
+            mutable S32 mBinIndex;
+        };
+
+        typedef LLOctreeRoot<Element, Element*> tree_t;
+        typedef LLOctreeNode<Element, Element*> node_t;
+        typedef LLFlatOctree<Element, Element*> flat_t;
+
+        LLFlatOctreeData()
+        {
+            // viewer defaults
+            gOctreeMaxCapacity = 128;
+            gOctreeMinSize = 0.01f;
+        }
+
+        ~LLFlatOctreeData()
+        {
+            mTree.reset();
+        }
+
+        // Deterministic so failures reproduce
+        F32 frand(F32 max)
+        {
+            mSeed = mSeed * 1664525 + 1013904223;
+            return (F32)(mSeed >> 8) / (F32)(1 << 24) * max;
+        }
+
+        // Scene dumps ("Dump Octree Scene" in the Develop menu) hold one
+        // "partition x y z radius" line per drawable.  Without one, scatter
+        // a few regions' worth of mostly small objects with the odd big one.
+        void loadScene(const char* path)
+        {
+            mElements.clear();
+            if (path)
+            {
+                std::ifstream in(path);
+                std::string line;
+                while (std::getline(in, line))
+                {
+                    std::istringstream fields(line);
+                    U32 partition;
+                    LLVector3 position;
+                    F32 radius;
+                    if (fields >> partition >> position.mV[VX] >> position.mV[VY] >> position.mV[VZ] >> radius)
+                    {
+                        mElements.emplace_back(new Element(position, llmax(radius, 0.01f)));
+                    }
+                }
+            }
+
+            if (mElements.empty())
+            {
+                for (U32 i = 0; i < 40000; ++i)
+                {
+                    LLVector3 position(frand(768.f), frand(768.f), 20.f + frand(60.f));
+                    F32 radius = (i % 100) ? 0.1f + frand(4.f) : 10.f + frand(40.f);
+                    mElements.emplace_back(new Element(position, radius));
+                }
+            }
+
+            mTree.reset(new tree_t(LLVector4a(384.f, 384.f, 384.f), LLVector4a(512.f, 512.f, 512.f), nullptr));
+            for (auto& element : mElements)
+            {
+                mTree->insert(element.get());
+            }
+        }
+
+        // Node boxes straight from the octree
+        static void nodeBounds(const node_t* node, LLVector4a* bounds, LLVector4a* extents)
+        {
+            bounds[0] = node->getCenter();
+            bounds[1] = node->getSize();
+            extents[0].setSub(bounds[0], bounds[1]);
+            extents[1].setAdd(bounds[0], bounds[1]);
+        }
+
+        void buildFlat(flat_t& flat)
+        {
+            flat.build(mTree.get());
+            LLVector4a bounds[2], extents[2];
+            for (U32 i = 0; i < flat.getSlotCount(); ++i)
+            {
+                if (flat.getNode(i))
+                {
+                    nodeBounds(flat.getNode(i), bounds, extents);
+                    flat.setBounds(i, bounds, extents);
+                }
+            }
+        }
+
+        void setCamera(LLCamera& camera, const LLVector3& origin, const LLVector3& target)
+        {
+            camera.lookAt(origin, target);
+
+            // Corners the way LLViewerCamera unprojects them: near then
+            // far, each left-bottom, right-bottom, right-top, left-top
+            LLVector3 frust[LLCamera::AGENT_FRUSTRUM_NUM];
+            F32 tan_half = tanf(camera.getView() * 0.5f);
+            for (U32 i = 0; i < 2; ++i)
+            {
+                F32 dist = i ? camera.getFar() : camera.getNear();
+                LLVector3 center = origin + camera.getAtAxis() * dist;
+                LLVector3 left = camera.getLeftAxis() * (dist * tan_half * camera.getAspect());
+                LLVector3 up = camera.getUpAxis() * (dist * tan_half);
+                frust[i * 4 + 0] = center + left - up;
+                frust[i * 4 + 1] = center - left - up;
+                frust[i * 4 + 2] = center - left + up;
+                frust[i * 4 + 3] = center + left + up;
+            }
+            camera.calcAgentFrustumPlanes(frust);
+        }
+
+        // AABBSphereIntersect() lives in newview, this is the same test
+        static S32 sphereTest(const LLVector4a* extents, const LLVector3& origin, F32 radius)
+        {
+            F32 r2 = radius * radius;
+            LLVector3 min(extents[0].getF32ptr());
+            LLVector3 max(extents[1].getF32ptr());
+            if ((min - origin).magVecSquared() < r2 && (max - origin).magVecSquared() < r2)
+            {
+                return 2;
+            }
+            F32 d = 0.f;
+            for (U32 i = 0; i < 3; ++i)
+            {
+                F32 t = 0.f;
+                if (origin.mV[i] < min.mV[i])
+                {
+                    t = min.mV[i] - origin.mV[i];
+                }
+                else if (origin.mV[i] > max.mV[i])
+                {
+                    t = origin.mV[i] - max.mV[i];
+                }
+                d += t * t;
+            }
+            return d > r2 ? 0 : 1;
+        }
+
+        // What LLFlatOctree::cull() does, one LLCamera call per node
+        void cullPointer(LLCamera& camera, U32 flags, const node_t* node, S32 parent_res, std::vector<const node_t*>& visited)
+        {
+            S32 res = parent_res;
+            if (res != 2)
+            {
+                LLVector4a bounds[2], extents[2];
+                nodeBounds(node, bounds, extents);
+                res = (flags & LLFlatOctreeBase::TEST_FAR_PLANE) ? camera.AABBInFrustum(bounds[0], bounds[1])
+                                                                 : camera.AABBInFrustumNoFarClip(bounds[0], bounds[1]);
+                if (res && (flags & LLFlatOctreeBase::TEST_SPHERE))
+                {
+                    res = llmin(res, sphereTest(extents, camera.getOrigin(), camera.mFrustumCornerDist));
+                }
+            }
+            if (!res)
+            {
+                return;
+            }
+
+            visited.push_back(node);
+            for (U32 i = 0; i < node->getChildCount(); ++i)
+            {
+                cullPointer(camera, flags, node->getChild(i), res, visited);
+            }
+        }
+
+        std::vector<const node_t*> cullFlat(LLCamera& camera, U32 flags, const flat_t& flat)
+        {
+            std::vector<const node_t*> visited;
+            flat.cull(LLFlatOctreeBase::Frustum(camera, flags),
+                      [&visited](const node_t* node, U32 index, S32 res) { visited.push_back(node); });
+            return visited;
+        }
+
+        void checkViews(flat_t& flat, const std::string& what)
+        {
+            const U32 flag_sets[] = { 0, LLFlatOctreeBase::TEST_FAR_PLANE, LLFlatOctreeBase::TEST_SPHERE };
+            U32 visible = 0;
+            for (U32 view = 0; view < 16; ++view)
+            {
+                LLCamera camera(1.f, 1.5f, 1024, 0.5f, 64.f + view * 16.f);
+                setCamera(camera, LLVector3(frand(768.f), frand(768.f), 30.f + frand(40.f)),
+                          LLVector3(frand(768.f), frand(768.f), frand(60.f)));
+                for (U32 flags : flag_sets)
+                {
+                    std::vector<const node_t*> expected;
+                    cullPointer(camera, flags, mTree.get(), 0, expected);
+                    std::vector<const node_t*> actual = cullFlat(camera, flags, flat);
+                    ensure_equals(stringize(what, " view ", view, " flags ", flags, " node count"),
+                                  actual.size(), expected.size());
+                    ensure(stringize(what, " view ", view, " flags ", flags, " order"), actual == expected);
+                    visible += (U32) expected.size();
+                }
+            }
+            ensure(what + " saw something", visible > 0);
+        }
+
+        U32 mSeed = 12345;
+        std::vector<std::unique_ptr<Element> > mElements;
+        std::unique_ptr<tree_t> mTree;
+    };
+
+    typedef test_group<LLFlatOctreeData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llflatoctree_test_factory("LLFlatOctree");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("layout mirrors the octree");
+
+        loadScene(nullptr);
+        flat_t flat;
+        buildFlat(flat);
+
+        U32 nodes = 0;
+        for (U32 i = 0; i < flat.getSlotCount(); ++i)
+        {
+            const node_t* node = flat.getNode(i);
+            if (!node)
+            {
+                ensure_equals(stringize("padding slot ", i, " has children"), flat.getChildCount(i), 0U);
+                continue;
+            }
+            ++nodes;
+
+            ensure_equals(stringize("slot ", i, " child count"), flat.getChildCount(i), node->getChildCount());
+            if (node->getChildCount())
+            {
+                U32 first = flat.getFirstChild(i);
+                ensure_equals(stringize("slot ", i, " family alignment"), first % 4, 0U);
+                ensure(stringize("slot ", i, " parent first"), first > i);
+                for (U32 c = 0; c < node->getChildCount(); ++c)
+                {
+                    ensure(stringize("slot ", i, " child ", c), flat.getNode(first + c) == node->getChild(c));
+                    ensure_equals(stringize("slot ", i, " child ", c, " parent"), flat.getParent(first + c), i);
+                }
+            }
+
+            LLVector4a bounds[2], extents[2];
+            flat.getBounds(i, bounds, extents);
+            ensure(stringize("slot ", i, " center"), bounds[0].equals3(node->getCenter()));
+            ensure(stringize("slot ", i, " size"), bounds[1].equals3(node->getSize()));
+        }
+        ensure("more than a root", nodes > 1);
+        ensure_equals("root parent", flat.getParent(0), LLFlatOctreeBase::NO_NODE);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("culling matches the pointer walk");
+
+        // Point LL_FLAT_OCTREE_SCENE at a scene dump to check a real region
+        loadScene(getenv("LL_FLAT_OCTREE_SCENE"));
+        flat_t flat;
+        buildFlat(flat);
+        checkViews(flat, "built");
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("refitting moved boxes keeps culling in step");
+
+        loadScene(nullptr);
+        flat_t flat;
+        buildFlat(flat);
+
+        // Slide every leaf a little, the way rebound() would after objects
+        // moved, and refit only those slots
+        LLVector4a bounds[2], extents[2];
+        for (U32 i = 0; i < flat.getSlotCount(); ++i)
+        {
+            node_t* node = const_cast<node_t*>(flat.getNode(i));
+            if (node && node->isLeaf())
+            {
+                LLVector4a center = node->getCenter();
+                center.add(LLVector4a(frand(2.f) - 1.f, frand(2.f) - 1.f, 0.f));
+                node->setCenter(center);
+                nodeBounds(node, bounds, extents);
+                flat.setBounds(i, bounds, extents);
+            }
+        }
+        checkViews(flat, "refit");
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * @file   llvolume_test.cpp
+ * @date   2024-06
+ * @brief  Checks the vectorized LLVolume generation paths against the
+ *         reference loops and exercises the LLVolumeMgr geometry cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include "../llvolume.h"
+#include "../llvolumemgr.h"
+
+#include <vector>
+
+namespace tut
+{
+    struct LLVolumeData
+    {
+        LLVolumeData()
+        {
+            // The placer's default shapes
+            add(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 1.f, 1.f, 0.f);        // cube
+            add(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 0.f, 1.f, -0.5f);      // prism
+            add(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 0.f, 0.f, 0.f);        // pyramid
+            add(LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_LINE, 0.f, 0.f, 0.f);      // tetrahedron
+            add(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_LINE, 1.f, 1.f, 0.f);        // cylinder
+            add(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_LINE, 0.f, 0.f, 0.f);        // cone
+            add(LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE, 1.f, 1.f, 0.f); // sphere
+            add(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE, 1.f, 0.25f, 0.f);    // torus
+            add(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE, 1.f, 0.25f, 0.f);    // tube
+            add(LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_CIRCLE, 1.f, 0.25f, 0.f);  // ring
+
+            // Hollow, cut and twisted variants for the cap and wrap paths
+            LLVolumeParams params = makeParams(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 1.f, 1.f, 0.f);
+            params.setHollow(0.5f);
+            params.setBeginAndEndS(0.125f, 0.875f);
+            params.setTwistEnd(0.5f);
+            mShapes.push_back(params);
+
+            params = makeParams(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE, 1.f, 0.25f, 0.f);
+            params.setHollow(0.3f);
+            params.setBeginAndEndT(0.f, 0.75f);
+            mShapes.push_back(params);
+        }
+
+        static LLVolumeParams makeParams(U8 profile, U8 path, F32 ratio_x, F32 ratio_y, F32 shear_x)
+        {
+            LLVolumeParams params;
+            params.setType(profile, path);
+            params.setBeginAndEndS(0.f, 1.f);
+            params.setBeginAndEndT(0.f, 1.f);
+            params.setRatio(ratio_x, ratio_y);
+            params.setShear(shear_x, 0.f);
+            return params;
+        }
+
+        void add(U8 profile, U8 path, F32 ratio_x, F32 ratio_y, F32 shear_x)
+        {
+            mShapes.push_back(makeParams(profile, path, ratio_x, ratio_y, shear_x));
+        }
+
+        // Every shape at every LOD, with tangents like the renderer asks for
+        std::vector<LLPointer<LLVolume> > generateAll(bool vectorized)
+        {
+            LLVolume::sVectorized = vectorized;
+            std::vector<LLPointer<LLVolume> > volumes;
+            for (const LLVolumeParams& params : mShapes)
+            {
+                for (S32 lod = 0; lod < LLVolumeLODGroup::NUM_LODS; ++lod)
+                {
+                    LLPointer<LLVolume> volume = new LLVolume(params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+                    for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+                    {
+                        volume->getVolumeFace(i).createTangents();
+                    }
+                    volumes.push_back(volume);
+                }
+            }
+            LLVolume::sVectorized = true;
+            return volumes;
+        }
+
+        void ensureClose(const std::string& what, const LLVector4a& lhs, const LLVector4a& rhs, S32 lanes)
+        {
+            for (S32 i = 0; i < lanes; ++i)
+            {
+                ensure(stringize(what, " lane ", i, ": ", lhs[i], " vs ", rhs[i]),
+                       fabsf(lhs[i] - rhs[i]) <= 1e-5f * llmax(1.f, fabsf(rhs[i])));
+            }
+        }
+
+        std::vector<LLVolumeParams> mShapes;
+    };
+
+    typedef test_group<LLVolumeData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llvolume_test_factory("LLVolume");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("vectorized generation matches the reference loops");
+
+        std::vector<LLPointer<LLVolume> > reference = generateAll(false);
+        std::vector<LLPointer<LLVolume> > vectorized = generateAll(true);
+        ensure_equals("volume count", vectorized.size(), reference.size());
+
+        U32 inexact = 0;
+        for (size_t v = 0; v < reference.size(); ++v)
+        {
+            ensure_equals(stringize("volume ", v, " faces"),
+                          vectorized[v]->getNumVolumeFaces(), reference[v]->getNumVolumeFaces());
+            for (S32 f = 0; f < reference[v]->getNumVolumeFaces(); ++f)
+            {
+                const LLVolumeFace& ref = reference[v]->getVolumeFace(f);
+                const LLVolumeFace& vec = vectorized[v]->getVolumeFace(f);
+                const std::string where(stringize("volume ", v, " face ", f));
+                ensure_equals(where + " vertices", vec.mNumVertices, ref.mNumVertices);
+                ensure_equals(where + " indices", vec.mNumIndices, ref.mNumIndices);
+
+                for (S32 i = 0; i < ref.mNumVertices; ++i)
+                {
+                    ensureClose(stringize(where, " position ", i), vec.mPositions[i], ref.mPositions[i], 3);
+                    ensureClose(stringize(where, " normal ", i), vec.mNormals[i], ref.mNormals[i], 3);
+                    ensureClose(stringize(where, " tangent ", i), vec.mTangents[i], ref.mTangents[i], 4);
+                    ensure(stringize(where, " texcoord ", i), vec.mTexCoords[i] == ref.mTexCoords[i]);
+
+                    if (!vec.mPositions[i].equals3(ref.mPositions[i], 0.f) ||
+                        !vec.mNormals[i].equals3(ref.mNormals[i], 0.f) ||
+                        !vec.mTangents[i].equals4(ref.mTangents[i], 0.f))
+                    {
+                        ++inexact;
+                    }
+                }
+            }
+        }
+        LL_INFOS() << reference.size() << " volumes compared, " << inexact
+                   << " vertices not bit-identical" << LL_ENDL;
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("released volumes are reused from the cache and evicted by size");
+
+        LLVolumeMgr manager;
+        manager.setCacheLimit(64 * 1024 * 1024);
+
+        // Same shape twice in a row hands back the very same geometry
+        LLVolume* first = manager.refVolume(mShapes[0], 3);
+        U64 bytes = first->getAllocatedBytes();
+        ensure("accounted", bytes > sizeof(LLVolume));
+        manager.unrefVolume(first);
+        ensure_equals("parked", manager.getCacheBytes(), bytes);
+
+        LLVolume* second = manager.refVolume(mShapes[0], 3);
+        ensure("shared, not regenerated", second == first);
+        ensure_equals("taken out while in use", manager.getCacheBytes(), (U64)0);
+
+        // A different LOD of the same shape is a miss
+        LLVolume* other_lod = manager.refVolume(mShapes[0], 1);
+        ensure("distinct lod", other_lod != second);
+        manager.unrefVolume(other_lod);
+        manager.unrefVolume(second);
+
+        // Park every shape at the top LOD, then squeeze the budget down to
+        // the most recent few and make sure the oldest go first
+        for (const LLVolumeParams& params : mShapes)
+        {
+            manager.unrefVolume(manager.refVolume(params, 3));
+        }
+        LLVolume* newest = manager.refVolume(mShapes.back(), 3);
+        U64 newest_bytes = newest->getAllocatedBytes();
+        manager.unrefVolume(newest);
+
+        manager.setCacheLimit(newest_bytes);
+        ensure_equals("trimmed to the newest", manager.getCacheBytes(), newest_bytes);
+        ensure("newest kept", manager.refVolume(mShapes.back(), 3) == newest);
+        ensure_equals("everything older evicted", manager.getCacheBytes(), (U64)0);
+        manager.unrefVolume(newest);
+
+        manager.setCacheLimit(0);
+        ensure_equals("disabled cache is empty", manager.getCacheBytes(), (U64)0);
+    }
+}
@@ -183,6 +183,8 @@ class LLDataPackerBinaryBuffer final : public LLDataPacker
                 void        reset()             { mCurBufferp = mBufferp; mWriteEnabled = (mCurBufferp != NULL); }
                 void        shift(S32 offset)   { reset(); mCurBufferp += offset;}
                 void        freeBuffer()        { delete [] mBufferp; mBufferp = mCurBufferp = NULL; mBufferSize = 0; mWriteEnabled = FALSE; }
+                // Forget a buffer the packer does not own (e.g. memory mapped data) without deleting it
+                void        releaseBuffer()     { mBufferp = mCurBufferp = NULL; mBufferSize = 0; mWriteEnabled = FALSE; }
                 void        assignBuffer(U8 *bufferp, S32 size)
                 {
                     if(mBufferp && mBufferp != bufferp)
@@ -1450,7 +1450,10 @@ void LLGLManager::initExtensions()
     mHasTransformFeedback = mGLVersion >= 3.99f;
     mHasDebugOutput = mGLVersion >= 4.29f;
     mHasTextureSwizzle = mGLVersion >= 3.29f;
+    mHasBufferStorage = mGLVersion >= 4.39f;
+    mHasMultiDrawIndirect = mGLVersion >= 4.29f;
     mHasTextureFilterAnisotropic = mGLVersion >= 4.59f || ExtensionExists("GL_EXT_texture_filter_anisotropic", gGLHExts.mSysExts);
+    mHasTextureCompressionS3TC = ExtensionExists("GL_EXT_texture_compression_s3tc", gGLHExts.mSysExts);
 
     // Misc
     glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, (GLint*) &mGLMaxVertexRange);
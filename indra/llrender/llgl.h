@@ -97,12 +97,15 @@ class LLGLManager
     bool mHasTextureSwizzle = false;
     bool mHasGPUShader4  = false;
     bool mHasAdaptiveVSync = false;
+    bool mHasBufferStorage = false;
+    bool mHasMultiDrawIndirect = false;
 
     // Vendor-specific extensions
     bool mHasAMDAssociations = false;
     bool mHasNVXMemInfo = false;
     bool mHasATIMemInfo = false;
     bool mHasTextureFilterAnisotropic = false;
+    bool mHasTextureCompressionS3TC = false;
 
     BOOL mIsAMD;
     BOOL mIsNVIDIA;
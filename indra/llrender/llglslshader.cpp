@@ -993,6 +993,15 @@ BOOL LLGLSLShader::mapUniforms(const vector<LLStaticHashedString>* uniforms)
             glUniformBlockBinding(mProgramObject, UBOBlockIndex, BLOCKBINDING);
         }
     }
+
+    if (mFeatures.hasObjectSkinning)
+    {
+        GLuint UBOBlockIndex = glGetUniformBlockIndex(mProgramObject, "MatrixPalette");
+        if (UBOBlockIndex != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(mProgramObject, UBOBlockIndex, MATRIX_PALETTE_BINDING);
+        }
+    }
     unbind();
 
     LL_DEBUGS("ShaderUniform") << "Total Uniform Size: " << mTotalUniformSize << LL_ENDL;
@@ -153,6 +153,8 @@ class LLGLSLShader
 
     static GLuint sCurBoundShader;
     static LLGLSLShader* sCurBoundShaderPtr;
+    // uniform buffer binding of the MatrixPalette block of skinned shaders
+    static constexpr GLuint MATRIX_PALETTE_BINDING = 2;
     static S32 sIndexedTextureChannels;
 
     static void initProfile();
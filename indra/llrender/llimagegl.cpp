@@ -42,6 +42,8 @@
 #include "llwindow.h"
 #include "llframetimer.h"
 
+#include <deque>
+
 extern LL_COMMON_API bool on_main_thread();
 
 #if !LL_IMAGEGL_THREAD_CHECK
@@ -137,6 +139,286 @@ std::set<LLImageGL*> LLImageGL::sImageList;
 bool LLImageGLThread::sEnabledTextures = false;
 bool LLImageGLThread::sEnabledMedia = false;
 
+U32 LLImageGL::sStagingBufferSize = 0;
+
+//----------------------------------------------------------------------------
+// Staging ring for pixel uploads
+//
+// Pixels handed to glTexImage2D come from client memory, which the driver
+// has to copy before the call returns.  LLStagingRing keeps a persistently
+// mapped pixel unpack buffer instead: pixels are copied into it in order,
+// the texture is filled from a buffer offset and the transfer happens
+// asynchronously.  Space goes out around the ring in batches, each batch
+// is fenced when it is complete and its space comes back once the fence
+// has signalled.  If the space ahead is still in flight the upload falls
+// back to client memory rather than waiting on the GPU.
+//
+// Mappings belong to a context, so every uploading thread has its own ring.
+class LLStagingRing
+{
+public:
+    LLStagingRing(U32 size)
+    :   mSize(size)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+        constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &mName);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mName);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, mSize, nullptr, map_flags);
+        mMapped = (U8*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mSize, map_flags);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        stop_glerror();
+    }
+
+    ~LLStagingRing()
+    {
+        for (const Batch& batch : mBatches)
+        {
+            glDeleteSync(batch.mSync);
+        }
+        if (mMapped)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mName);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &mName);
+    }
+
+    bool isMapped() const { return mMapped != nullptr; }
+    GLuint getName() const { return mName; }
+
+    // Copy bytes of data into the ring and return its offset, or -1 when
+    // the free space ahead is too small right now
+    S64 stage(const void* data, U32 bytes)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+        reclaim();
+
+        // keep every upload on a cache line
+        U32 span = (bytes + 63) & ~63U;
+        if (!mMapped || span > mSize - mUsed)
+        {
+            return -1;
+        }
+        if (mUsed == 0)
+        {
+            mHead = mTail = 0;
+        }
+
+        if (mHead >= mTail && mSize - mHead < span)
+        {
+            // not enough room before the end, skip to the start
+            U32 skip = mSize - mHead;
+            if (mTail < span)
+            {
+                return -1;
+            }
+            mHead = 0;
+            mUsed += skip;
+            mPending += skip;
+        }
+        else if (mHead < mTail && mTail - mHead < span)
+        {
+            return -1;
+        }
+
+        S64 offset = mHead;
+        memcpy(mMapped + offset, data, bytes);
+        mHead = (mHead + span) % mSize;
+        mUsed += span;
+        mPending += span;
+        return offset;
+    }
+
+    // Close the current batch, its space is reused once the GPU is done
+    // reading it
+    void fence()
+    {
+        if (mPending)
+        {
+            mBatches.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mPending });
+            mPending = 0;
+        }
+    }
+
+private:
+    void reclaim()
+    {
+        while (!mBatches.empty())
+        {
+            const Batch& batch = mBatches.front();
+            GLenum status = glClientWaitSync(batch.mSync, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                break;
+            }
+            glDeleteSync(batch.mSync);
+            mTail = (mTail + batch.mBytes) % mSize;
+            mUsed -= batch.mBytes;
+            mBatches.pop_front();
+        }
+    }
+
+    struct Batch
+    {
+        GLsync mSync;
+        U32 mBytes;
+    };
+
+    GLuint mName = 0;
+    U8* mMapped = nullptr;
+    U32 mSize;
+    U32 mHead = 0;      // next byte handed out
+    U32 mTail = 0;      // first byte still in flight
+    U32 mUsed = 0;      // bytes in flight or waiting for a fence
+    U32 mPending = 0;   // bytes since the last fence
+    std::deque<Batch> mBatches;
+};
+
+// The ring of the calling thread's context.  Not cleaned up at exit, the
+// context is gone by then.
+static thread_local LLStagingRing* sStagingRing = nullptr;
+static thread_local bool sStagingFailed = false;
+
+static LLStagingRing* get_staging_ring()
+{
+    if (!sStagingRing && !sStagingFailed)
+    {
+        if (LLImageGL::sStagingBufferSize == 0 || !gGLManager.mHasBufferStorage)
+        {
+            return nullptr;
+        }
+        sStagingRing = new LLStagingRing(LLImageGL::sStagingBufferSize);
+        if (!sStagingRing->isMapped())
+        {
+            LL_WARNS() << "Could not map a texture staging buffer, uploading from client memory" << LL_ENDL;
+            delete sStagingRing;
+            sStagingRing = nullptr;
+            sStagingFailed = true;
+        }
+    }
+    return sStagingRing;
+}
+
+// Bytes of a tightly packed width x height upload, or 0 for pixel types
+// that are not staged
+static U32 staging_bytes(U32 pixformat, U32 pixtype, S32 width, S32 height)
+{
+    if (pixtype != GL_UNSIGNED_BYTE && pixtype != GL_UNSIGNED_INT_8_8_8_8_REV)
+    {
+        return 0;
+    }
+    return (U32) (width * height * LLImageGL::dataFormatComponents(pixformat));
+}
+
+// Stage bytes of pixels on the current thread's ring.  On success the ring
+// is bound as the unpack buffer and pixels becomes an offset into it.
+static bool stage_pixels(const void*& pixels, U32 bytes)
+{
+    if (!pixels || bytes == 0)
+    {
+        return false;
+    }
+    LLStagingRing* ring = get_staging_ring();
+    S64 offset = ring ? ring->stage(pixels, bytes) : -1;
+    if (offset < 0)
+    {
+        return false;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->getName());
+    pixels = (const void*) (uintptr_t) offset;
+    return true;
+}
+
+static void unstage_pixels(bool staged)
+{
+    if (staged)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+}
+
+static void fence_staging()
+{
+    if (sStagingRing)
+    {
+        sStagingRing->fence();
+    }
+}
+
+//static
+void LLImageGL::cleanupStaging()
+{
+    delete sStagingRing;
+    sStagingRing = nullptr;
+    sStagingFailed = false;
+}
+
+//----------------------------------------------------------------------------
+// Texture names created on the image thread, waiting for their uploads
+// to complete before the main thread switches to them
+
+struct LLPendingTexName
+{
+    LLPointer<LLImageGL> mImage;
+    LLGLuint mTexName;
+    GLsync mSync;
+};
+
+static LLMutex sPendingTexNamesMutex;
+static std::deque<LLPendingTexName> sPendingTexNames;
+
+//static
+void LLImageGL::updateUploads()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    llassert(on_main_thread());
+
+    // whatever the main thread staged this frame is one batch
+    fence_staging();
+
+    std::vector<LLPendingTexName> ready;
+    {
+        LLMutexLock lock(&sPendingTexNamesMutex);
+        while (!sPendingTexNames.empty())
+        {
+            // fences from one context signal in order, stop at the first busy one
+            const LLPendingTexName& pending = sPendingTexNames.front();
+            if (glClientWaitSync(pending.mSync, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                break;
+            }
+            ready.push_back(pending);
+            sPendingTexNames.pop_front();
+        }
+    }
+
+    for (LLPendingTexName& pending : ready)
+    {
+        glDeleteSync(pending.mSync);
+        pending.mImage->syncTexName(pending.mTexName);
+    }
+}
+
+//static
+void LLImageGL::finishUploads()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    std::deque<LLPendingTexName> pending_names;
+    {
+        LLMutexLock lock(&sPendingTexNamesMutex);
+        pending_names.swap(sPendingTexNames);
+    }
+
+    for (LLPendingTexName& pending : pending_names)
+    {
+        glClientWaitSync(pending.mSync, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(pending.mSync);
+        pending.mImage->syncTexName(pending.mTexName);
+    }
+}
+
 //****************************************************************************************************
 //The below for texture auditing use only
 //****************************************************************************************************
@@ -263,6 +545,8 @@ void LLImageGL::cleanupClass()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     LLImageGLThread::deleteSingleton();
+    finishUploads();
+    cleanupStaging();
 }
 
 
@@ -363,6 +647,9 @@ void LLImageGL::updateStats(F32 current_time)
 //static
 void LLImageGL::destroyGL(BOOL save_state)
 {
+    finishUploads();
+    cleanupStaging();
+
     for (S32 stage = 0; stage < gGLManager.mNumTextureImageUnits; stage++)
     {
         gGL.getTexUnit(stage)->unbind(LLTexUnit::TT_TEXTURE);
@@ -578,9 +865,6 @@ void LLImageGL::init(BOOL usemipmaps)
 #endif
 
     mCategory = -1;
-
-    // Sometimes we have to post work for the main thread.
-    mMainQueue = LL::WorkQueue::getInstance("mainloop");
 }
 
 void LLImageGL::cleanup()
@@ -798,7 +1082,10 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
                 if (is_compressed)
                 {
                     S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
-                    glCompressedTexImage2D(mTarget, gl_level, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
+                    const void* src = data_in;
+                    const bool staged = stage_pixels(src, (U32) tex_size);
+                    glCompressedTexImage2D(mTarget, gl_level, mFormatPrimary, w, h, 0, tex_size, src);
+                    unstage_pixels(staged);
                     stop_glerror();
                 }
                 else
@@ -992,7 +1279,10 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
         if (is_compressed)
         {
             S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
-            glCompressedTexImage2D(mTarget, 0, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
+            const void* src = data_in;
+            const bool staged = stage_pixels(src, (U32) tex_size);
+            glCompressedTexImage2D(mTarget, 0, mFormatPrimary, w, h, 0, tex_size, src);
+            unstage_pixels(staged);
             stop_glerror();
         }
         else
@@ -1020,6 +1310,8 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
         }
     }
     stop_glerror();
+    // all levels of this image are one batch on the staging ring
+    fence_staging();
     mGLTextureCreated = true;
     return TRUE;
 }
@@ -1250,7 +1542,14 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
         if (!res) LL_ERRS() << "LLImageGL::setSubImage(): bindTexture failed" << LL_ENDL;
         stop_glerror();
 
-        const bool use_sub_image = should_stagger_image_set(isCompressed());
+        // rows are staged with their stride, GL_UNPACK_ROW_LENGTH still applies
+        const void* src = sub_datap;
+        const bool staged = !isCompressed() && stage_pixels(src, staging_bytes(mFormatPrimary, mFormatType, data_width, height - 1) +
+                                                                 staging_bytes(mFormatPrimary, mFormatType, width, 1));
+        sub_datap = (const U8*) src;
+
+        // staged rows come from the ring in one call, see setManualImage()
+        const bool use_sub_image = !staged && should_stagger_image_set(isCompressed());
         if (!use_sub_image)
         {
             // *TODO: Why does this work here, in setSubImage, but not in
@@ -1263,6 +1562,8 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
         {
             sub_image_lines(mTarget, 0, x_pos, y_pos, width, height, mFormatPrimary, mFormatType, sub_datap, data_width);
         }
+        unstage_pixels(staged);
+        fence_staging();
         gGL.getTexUnit(0)->disable();
         stop_glerror();
 
@@ -1518,7 +1819,11 @@ void LLImageGL::setManualImage(U32 target, S32 miplevel, S32 intformat, S32 widt
         LL_PROFILE_ZONE_NUM(height);
 
         free_cur_tex_image();
-        const bool use_sub_image = should_stagger_image_set(compress);
+        // pixels becomes an offset into the staging ring if it had room.  A
+        // staged image goes up in one call: the ring is bound, so a separate
+        // nullptr allocation would copy from offset 0.
+        const bool staged = stage_pixels(pixels, staging_bytes(pixformat, pixtype, width, height));
+        const bool use_sub_image = !staged && should_stagger_image_set(compress);
         if (!use_sub_image)
         {
             LL_PROFILE_ZONE_NAMED("glTexImage2D alloc + copy");
@@ -1539,6 +1844,7 @@ void LLImageGL::setManualImage(U32 target, S32 miplevel, S32 intformat, S32 widt
                 sub_image_lines(target, miplevel, 0, 0, width, height, pixformat, pixtype, src, width);
             }
         }
+        unstage_pixels(staged);
         alloc_tex_image(width, height, pixformat, 1);
     }
     stop_glerror();
@@ -1682,6 +1988,32 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S
     return createGLTexture(discard_level, rawdata, FALSE, usename, defer_copy, tex_name);
 }
 
+BOOL LLImageGL::createGLTextureCompressed(S32 discard_level, S32 width, S32 height, S32 ncomponents, LLGLenum format,
+                                          const U8* data, S32 category)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    checkActiveThread();
+
+    if (gGLManager.mIsDisabled || !gGLManager.mHasTextureCompressionS3TC)
+    {
+        return FALSE;
+    }
+
+    llassert(gGLManager.mInited);
+    llassert(data);
+    stop_glerror();
+
+    setSize(width, height, ncomponents, discard_level);
+    setExplicitFormat(format, format);
+    setCategory(category);
+
+    BOOL res = createGLTexture(discard_level, data, TRUE);
+
+    // The next raw upload picks its format from its component count again
+    mHasExplicitFormat = FALSE;
+    return res;
+}
+
 BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_hasmips, S32 usename, bool defer_copy, LLGLuint* tex_name)
 // Call with void data, vmem is allocated but unitialized
 {
@@ -1802,50 +2134,18 @@ void LLImageGL::syncToMainThread(LLGLuint new_tex_name)
     llassert(!on_main_thread());
 
     {
-        LL_PROFILE_ZONE_NAMED("cglt - sync");
-        if (gGLManager.mIsNVIDIA)
-        {
-            // wait for texture upload to finish before notifying main thread
-            // upload is complete
-            auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-            glFlush();
-            glClientWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
-            glDeleteSync(sync);
-        }
-        else
-        {
-            // post a sync to the main thread (will execute before tex name swap lambda below)
-            // glFlush calls here are partly superstitious and partly backed by observation
-            // on AMD hardware
-            glFlush();
-            auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-            glFlush();
-            LL::WorkQueue::postMaybe(
-                mMainQueue,
-                [=]()
-                {
-                    LL_PROFILE_ZONE_NAMED("cglt - wait sync");
-                    {
-                        LL_PROFILE_ZONE_NAMED("glWaitSync");
-                        glWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
-                    }
-                    {
-                        LL_PROFILE_ZONE_NAMED("glDeleteSync");
-                        glDeleteSync(sync);
-                    }
-                });
-        }
-    }
+        LL_PROFILE_ZONE_NAMED("cglt - fence");
+        // the main thread switches to new_tex_name once this fence has
+        // signalled, see updateUploads().  Nothing waits here.
+        // glFlush calls here are partly superstitious and partly backed by
+        // observation on AMD hardware
+        glFlush();
+        GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
 
-    ref();
-    LL::WorkQueue::postMaybe(
-        mMainQueue,
-        [=]()
-        {
-            LL_PROFILE_ZONE_NAMED("cglt - delete callback");
-            syncTexName(new_tex_name);
-            unref();
-        });
+        LLMutexLock lock(&sPendingTexNamesMutex);
+        sPendingTexNames.push_back({ this, new_tex_name, sync });
+    }
 
     LL_PROFILER_GPU_COLLECT;
 }
@@ -2621,6 +2921,7 @@ void LLImageGLThread::run()
     gGL.init(false);
     LL_PROFILER_GPU_CONTEXT;
     LL::ThreadPool::run();
+    LLImageGL::cleanupStaging();
     gGL.shutdown();
     mWindow->destroySharedContext(mContext);
 }
@@ -75,6 +75,13 @@ class LLImageGL : public LLRefCount
     // needs to be called every frame
     static void updateStats(F32 current_time);
 
+    // Main thread, every frame: switch textures uploaded on the image
+    // thread to their new names once the GPU is done with the upload
+    static void updateUploads();
+
+    // Release the calling thread's staging ring
+    static void cleanupStaging();
+
     // Save off / restore GL textures
     static void destroyGL(BOOL save_state = TRUE);
     static void restoreGL();
@@ -116,6 +123,10 @@ class LLImageGL : public LLRefCount
     BOOL createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename = 0, BOOL to_create = TRUE,
         S32 category = sMaxCategories-1, bool defer_copy = false, LLGLuint* tex_name = nullptr);
     BOOL createGLTexture(S32 discard_level, const U8* data, BOOL data_hasmips = FALSE, S32 usename = 0, bool defer_copy = false, LLGLuint* tex_name = nullptr);
+    // Upload a block compressed mip chain (S3TC format, smallest mips stored
+    // before data, see LLImageDXT) for a width x height image at discard_level
+    BOOL createGLTextureCompressed(S32 discard_level, S32 width, S32 height, S32 ncomponents, LLGLenum format,
+        const U8* data, S32 category = sMaxCategories-1);
     void setImage(const LLImageRaw* imageraw);
     BOOL setImage(const U8* data_in, BOOL data_hasmips = FALSE, S32 usename = 0);
     // *TODO: This function may not work if the textures is compressed (i.e.
@@ -125,8 +136,8 @@ class LLImageGL : public LLRefCount
     BOOL setSubImage(const U8* datap, S32 data_width, S32 data_height, S32 x_pos, S32 y_pos, S32 width, S32 height, BOOL force_fast_update = FALSE, LLGLuint use_name = 0);
     BOOL setSubImageFromFrameBuffer(S32 fb_x, S32 fb_y, S32 x_pos, S32 y_pos, S32 width, S32 height);
 
-    // wait for gl commands to finish on current thread and push
-    // a lambda to main thread to swap mNewTexName and mTexName
+    // fence gl commands on current thread and have the main thread swap
+    // new_tex_name into mTexName once the fence has signalled
     void syncToMainThread(LLGLuint new_tex_name);
 
     // Read back a raw image for this discard level, if it exists
@@ -220,7 +231,6 @@ class LLImageGL : public LLRefCount
     bool isCompressed();
 
     LLPointer<LLImageRaw> mSaveData; // used for destroyGL/restoreGL
-    LL::WorkQueue::weak_t mMainQueue;
     U8* mPickMask;  //downsampled bitmap approximation of alpha channel.  NULL if no alpha channel
     U16 mPickMaskWidth;
     U16 mPickMaskHeight;
@@ -283,6 +293,7 @@ class LLImageGL : public LLRefCount
     static LLImageGL* sDefaultGLTexture ;
     static BOOL sAutomatedTest;
     static bool sCompressTextures;          //use GL texture compression
+    static U32 sStagingBufferSize;          // bytes of upload staging ring per thread, 0 uploads from client memory
 #if DEBUG_MISS
     BOOL mMissed; // Missed on last bind?
     BOOL getMissed() const { return mMissed; };
@@ -295,6 +306,8 @@ class LLImageGL : public LLRefCount
     static void cleanupClass() ;
 
 private:
+    static void finishUploads();
+
     static S32 sMaxCategories;
     static BOOL sSkipAnalyzeAlpha;
 
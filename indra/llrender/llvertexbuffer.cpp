@@ -37,6 +37,9 @@
 #include "llglslshader.h"
 #include "llmemory.h"
 
+#include <deque>
+#include <memory>
+
 //Next Highest Power Of Two
 //helper function, returns first number > v that is a power of 2, or v if v is already a power of 2
 U32 nhpo2(U32 v)
@@ -524,10 +527,650 @@ class LLVBOPool
 
 static LLVBOPool* sVBOPool = nullptr;
 
+// Small buffers are carved out of large shared GL buffers instead of getting
+// a GL buffer each.  Every arena is split into pages, a page is handed to one
+// size class and cut into equal slots.  Size classes run four to a power of
+// two, so a slot is never more than a quarter larger than what was asked for.
+// A freed slot may still be read by draws in flight, so it is only put back
+// on its free list once a fence placed after the free has signaled.
+class LLVBOArena
+{
+public:
+    typedef std::chrono::steady_clock::time_point Time;
+
+    static constexpr U32 ARENA_SIZE = 16 * 1024 * 1024;
+    static constexpr U32 PAGE_SIZE = 1024 * 1024;
+    static constexpr U32 PAGE_COUNT = ARENA_SIZE / PAGE_SIZE;
+    static constexpr U32 MIN_SLOT_SHIFT = 8;    // 256 bytes
+    static constexpr U32 MAX_SLOT_SHIFT = 18;   // 256 KB
+    static constexpr U32 CLASS_STEPS = 4;
+    static constexpr U32 CLASS_COUNT = (MAX_SLOT_SHIFT - MIN_SLOT_SHIFT) * CLASS_STEPS + 1;
+    static constexpr U32 MAX_SLOT_SIZE = 1 << MAX_SLOT_SHIFT;
+
+    // fence the pending frees early if nobody calls fence() for a while
+    static constexpr U32 MAX_PENDING = 4096;
+
+    struct Page
+    {
+        U32 mSizeClass = 0;
+        U32 mLive = 0;      // slots handed out
+        U32 mRetired = 0;   // slots freed while the GPU may still read them
+        bool mInUse = false;
+        Time mIdleSince;
+    };
+
+    struct Arena
+    {
+        GLuint mGLName = 0;
+        U8* mShadow = nullptr;      // client side copy, what LLVertexBuffer maps
+        U8* mPersistent = nullptr;  // persistently mapped GL storage, or null
+        U32 mPagesInUse = 0;
+        Page mPages[PAGE_COUNT];
+    };
+
+    struct Slot
+    {
+        Arena* mArena;
+        U32 mOffset;
+    };
+
+    struct Heap
+    {
+        GLenum mTarget;
+        std::vector<std::unique_ptr<Arena>> mArenas;
+        std::vector<Slot> mFree[CLASS_COUNT];
+    };
+
+    struct Retired
+    {
+        GLsync mFence;
+        std::vector<std::pair<Heap*, Slot>> mSlots;
+    };
+
+    LLVBOArena(bool persistent)
+        : mPersistent(persistent)
+    {
+        mHeaps[0].mTarget = GL_ARRAY_BUFFER;
+        mHeaps[1].mTarget = GL_ELEMENT_ARRAY_BUFFER;
+    }
+
+    ~LLVBOArena()
+    {
+        clear();
+    }
+
+    static U32 getSizeClass(U32 size)
+    {
+        if (size <= (1U << MIN_SLOT_SHIFT))
+        {
+            return 0;
+        }
+
+        // 2^shift < size <= 2^(shift+1)
+        U32 shift = MIN_SLOT_SHIFT;
+        while ((2U << shift) < size)
+        {
+            ++shift;
+        }
+
+        U32 step = 1 << (shift - 2);
+        U32 k = (size - (1 << shift) + step - 1) / step;
+        return (shift - MIN_SLOT_SHIFT) * CLASS_STEPS + k;
+    }
+
+    static U32 getClassSize(U32 size_class)
+    {
+        if (size_class == 0)
+        {
+            return 1 << MIN_SLOT_SHIFT;
+        }
+
+        U32 shift = MIN_SLOT_SHIFT + (size_class - 1) / CLASS_STEPS;
+        U32 k = (size_class - 1) % CLASS_STEPS + 1;
+        return (1 << shift) + k * (1 << (shift - 2));
+    }
+
+    void allocate(GLenum type, U32 size, GLuint& name, U32& offset, U8*& data, U8*& persistent)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        llassert(size <= MAX_SLOT_SIZE);
+        llassert(name == 0);
+        llassert(data == nullptr);
+
+        Heap& heap = getHeap(type);
+        U32 size_class = getSizeClass(size);
+        std::vector<Slot>& free_slots = heap.mFree[size_class];
+        if (free_slots.empty())
+        {
+            poll();
+        }
+        if (free_slots.empty())
+        {
+            addPage(heap, size_class);
+        }
+
+        Slot slot = free_slots.back();
+        free_slots.pop_back();
+
+        Arena* arena = slot.mArena;
+        arena->mPages[slot.mOffset / PAGE_SIZE].mLive++;
+
+        mRequestedBytes += size;
+        mSlotBytes += getClassSize(size_class);
+        mSlotCount++;
+
+        name = arena->mGLName;
+        offset = slot.mOffset;
+        data = arena->mShadow ? arena->mShadow + slot.mOffset : nullptr;
+        persistent = arena->mPersistent ? arena->mPersistent + slot.mOffset : nullptr;
+    }
+
+    void free(GLenum type, U32 size, GLuint name, U32 offset)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        Heap& heap = getHeap(type);
+        Arena* arena = nullptr;
+        for (auto& candidate : heap.mArenas)
+        {
+            if (candidate->mGLName == name)
+            {
+                arena = candidate.get();
+                break;
+            }
+        }
+
+        llassert(arena);
+        if (!arena)
+        {
+            return;
+        }
+
+        Page& page = arena->mPages[offset / PAGE_SIZE];
+        llassert(page.mInUse && page.mLive > 0);
+        llassert(getSizeClass(size) == page.mSizeClass);
+        page.mLive--;
+        page.mRetired++;
+
+        U32 slot_size = getClassSize(page.mSizeClass);
+        llassert(mRequestedBytes >= size && mSlotBytes >= slot_size);
+        mRequestedBytes -= size;
+        mSlotBytes -= slot_size;
+        mRetiredBytes += slot_size;
+        mSlotCount--;
+
+        mPending.push_back({ &heap, { arena, offset } });
+        if (mPending.size() >= MAX_PENDING)
+        {
+            fence();
+        }
+    }
+
+    // Fence everything freed since the last call
+    void fence()
+    {
+        if (!mPending.empty())
+        {
+            Retired batch;
+            batch.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            batch.mSlots.swap(mPending);
+            mRetired.push_back(std::move(batch));
+        }
+    }
+
+    // Put the slots of every batch the GPU is done with back on their free lists
+    void poll()
+    {
+        while (!mRetired.empty())
+        {
+            Retired& batch = mRetired.front();
+            if (batch.mFence)
+            {
+                if (glClientWaitSync(batch.mFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                {
+                    break;
+                }
+                glDeleteSync(batch.mFence);
+            }
+
+            Time now = std::chrono::steady_clock::now();
+            for (auto& retired : batch.mSlots)
+            {
+                const Slot& slot = retired.second;
+                Page& page = slot.mArena->mPages[slot.mOffset / PAGE_SIZE];
+                llassert(page.mRetired > 0);
+                page.mRetired--;
+                if (page.mLive == 0 && page.mRetired == 0)
+                {
+                    page.mIdleSince = now;
+                }
+
+                U32 slot_size = getClassSize(page.mSizeClass);
+                llassert(mRetiredBytes >= slot_size);
+                mRetiredBytes -= slot_size;
+                retired.first->mFree[page.mSizeClass].push_back(slot);
+            }
+            mRetired.pop_front();
+        }
+    }
+
+    // Give pages that have been empty for a while back to their arena, and
+    // arenas with no pages left back to GL
+    void trim()
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+
+        using namespace std::chrono_literals;
+        Time cutoff = std::chrono::steady_clock::now() - 5s;
+
+        auto reclaimable = [cutoff](const Page& page)
+            {
+                return page.mInUse && page.mLive == 0 && page.mRetired == 0 && page.mIdleSince < cutoff;
+            };
+
+        std::vector<GLuint> names_to_free;
+        for (Heap& heap : mHeaps)
+        {
+            for (std::vector<Slot>& free_slots : heap.mFree)
+            {
+                free_slots.erase(std::remove_if(free_slots.begin(), free_slots.end(),
+                    [&reclaimable](const Slot& slot)
+                    {
+                        return reclaimable(slot.mArena->mPages[slot.mOffset / PAGE_SIZE]);
+                    }),
+                    free_slots.end());
+            }
+
+            for (auto iter = heap.mArenas.begin(); iter != heap.mArenas.end(); )
+            {
+                Arena* arena = iter->get();
+                for (Page& page : arena->mPages)
+                {
+                    if (reclaimable(page))
+                    {
+                        page.mInUse = false;
+                        arena->mPagesInUse--;
+                        mPageBytes -= PAGE_SIZE;
+                    }
+                }
+
+                if (arena->mPagesInUse == 0)
+                {
+                    names_to_free.push_back(arena->mGLName);
+                    destroyArena(arena);
+                    iter = heap.mArenas.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+
+        if (!names_to_free.empty())
+        {
+            glDeleteBuffers(names_to_free.size(), names_to_free.data());
+        }
+    }
+
+    void clear()
+    {
+        for (Retired& batch : mRetired)
+        {
+            if (batch.mFence)
+            {
+                glDeleteSync(batch.mFence);
+            }
+        }
+        mRetired.clear();
+        mPending.clear();
+
+        std::vector<GLuint> names_to_free;
+        for (Heap& heap : mHeaps)
+        {
+            for (auto& arena : heap.mArenas)
+            {
+                names_to_free.push_back(arena->mGLName);
+                destroyArena(arena.get());
+            }
+            heap.mArenas.clear();
+
+            for (std::vector<Slot>& free_slots : heap.mFree)
+            {
+                free_slots.clear();
+            }
+        }
+
+        if (!names_to_free.empty())
+        {
+            glDeleteBuffers(names_to_free.size(), names_to_free.data());
+        }
+
+        mArenaBytes = 0;
+        mPageBytes = 0;
+        mSlotBytes = 0;
+        mRequestedBytes = 0;
+        mRetiredBytes = 0;
+        mSlotCount = 0;
+    }
+
+    void getStats(LLVertexBuffer::PoolStats& stats) const
+    {
+        stats.mArenaBytes = mArenaBytes;
+        stats.mPageBytes = mPageBytes;
+        stats.mSlotBytes = mSlotBytes;
+        stats.mRequestedBytes = mRequestedBytes;
+        stats.mRetiredBytes = mRetiredBytes;
+        stats.mArenaCount = (U32) (mHeaps[0].mArenas.size() + mHeaps[1].mArenas.size());
+        stats.mSlotCount = mSlotCount;
+    }
+
+    U64 getVramBytesUsed() const
+    {
+        return mArenaBytes;
+    }
+
+private:
+    Heap& getHeap(GLenum type)
+    {
+        llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
+        return type == GL_ELEMENT_ARRAY_BUFFER ? mHeaps[1] : mHeaps[0];
+    }
+
+    void addPage(Heap& heap, U32 size_class)
+    {
+        Arena* arena = nullptr;
+        for (auto& candidate : heap.mArenas)
+        {
+            if (candidate->mPagesInUse < PAGE_COUNT)
+            {
+                arena = candidate.get();
+                break;
+            }
+        }
+
+        if (!arena)
+        {
+            heap.mArenas.emplace_back(createArena(heap.mTarget));
+            arena = heap.mArenas.back().get();
+        }
+
+        U32 page_index = 0;
+        while (arena->mPages[page_index].mInUse)
+        {
+            ++page_index;
+        }
+
+        Page& page = arena->mPages[page_index];
+        page.mInUse = true;
+        page.mSizeClass = size_class;
+        page.mLive = 0;
+        page.mRetired = 0;
+        page.mIdleSince = std::chrono::steady_clock::now();
+        arena->mPagesInUse++;
+        mPageBytes += PAGE_SIZE;
+
+        // pushed high to low so the page fills from its start
+        U32 slot_size = getClassSize(size_class);
+        std::vector<Slot>& free_slots = heap.mFree[size_class];
+        for (U32 i = PAGE_SIZE / slot_size; i-- > 0; )
+        {
+            free_slots.push_back({ arena, page_index * PAGE_SIZE + i * slot_size });
+        }
+    }
+
+    Arena* createArena(GLenum target)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vbo arena alloc");
+        LL_PROFILE_GPU_ZONE("vbo arena alloc");
+
+        Arena* arena = new Arena();
+        arena->mGLName = gen_buffer();
+        glBindBuffer(target, arena->mGLName);
+        if (target == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            LLVertexBuffer::sGLRenderIndices = arena->mGLName;
+        }
+        else
+        {
+            LLVertexBuffer::sGLRenderBuffer = arena->mGLName;
+        }
+
+        if (mPersistent)
+        {
+            constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, ARENA_SIZE, nullptr, map_flags | GL_DYNAMIC_STORAGE_BIT);
+            arena->mPersistent = (U8*) glMapBufferRange(target, 0, ARENA_SIZE, map_flags);
+        }
+        else if (gGLManager.mHasBufferStorage)
+        {
+            glBufferStorage(target, ARENA_SIZE, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        }
+        else
+        {
+            glBufferData(target, ARENA_SIZE, nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        arena->mShadow = (U8*) ll_aligned_malloc_16(ARENA_SIZE);
+        mArenaBytes += ARENA_SIZE;
+        return arena;
+    }
+
+    // caller deletes the GL name
+    void destroyArena(Arena* arena)
+    {
+        if (LLVertexBuffer::sGLRenderBuffer == arena->mGLName)
+        {
+            LLVertexBuffer::sGLRenderBuffer = 0;
+        }
+        if (LLVertexBuffer::sGLRenderIndices == arena->mGLName)
+        {
+            LLVertexBuffer::sGLRenderIndices = 0;
+        }
+
+        ll_aligned_free_16(arena->mShadow);
+        arena->mShadow = nullptr;
+        llassert(mArenaBytes >= ARENA_SIZE);
+        mArenaBytes -= ARENA_SIZE;
+    }
+
+    bool mPersistent;
+    Heap mHeaps[2];     // vertices, indices
+
+    std::vector<std::pair<Heap*, Slot>> mPending;
+    std::deque<Retired> mRetired;
+
+    U64 mArenaBytes = 0;
+    U64 mPageBytes = 0;
+    U64 mSlotBytes = 0;
+    U64 mRequestedBytes = 0;
+    U64 mRetiredBytes = 0;
+    U32 mSlotCount = 0;
+};
+
+static LLVBOArena* sVBOArena = nullptr;
+
+// GL buffer and offset the vertex attributes were last pointed at.  This is
+// not the same as what is bound to GL_ARRAY_BUFFER, binding a buffer to
+// upload to it leaves the attribute pointers alone.
+static U32 sAttribBuffer = 0;
+static U32 sAttribOffset = 0;
+
+// Whether a buffer of this many bytes lives in an arena
+static bool use_arena(U32 size)
+{
+    return sVBOArena && size <= LLVBOArena::MAX_SLOT_SIZE;
+}
+
+// Layout glMultiDrawElementsIndirect reads its commands in
+struct DrawElementsIndirectCommand
+{
+    U32 mCount;
+    U32 mInstanceCount;
+    U32 mFirstIndex;
+    S32 mBaseVertex;
+    U32 mBaseInstance;
+};
+
+// Draws waiting for LLVertexBuffer::flushDraws(), all from buffers sharing
+// sDrawSource's arenas
+static std::vector<DrawElementsIndirectCommand> sDrawCommands;
+static LLPointer<LLVertexBuffer> sDrawSource;
+static U32 sIndirectBuffer = 0;
+
+static U32 sQueuedDraws = 0;
+static U32 sDrawCalls = 0;
+static U32 sLastQueuedDraws = 0;
+static U32 sLastDrawCalls = 0;
+
 //static
 U64 LLVertexBuffer::getBytesAllocated()
 {
-    return sVBOPool ? sVBOPool->getVramBytesUsed() : 0;
+    return (sVBOPool ? sVBOPool->getVramBytesUsed() : 0) +
+           (sVBOArena ? sVBOArena->getVramBytesUsed() : 0);
+}
+
+//static
+void LLVertexBuffer::getPoolStats(PoolStats& stats)
+{
+    stats = PoolStats();
+    if (sVBOArena)
+    {
+        sVBOArena->getStats(stats);
+    }
+    stats.mPoolBytes = sVBOPool ? sVBOPool->getVramBytesUsed() : 0;
+}
+
+//static
+void LLVertexBuffer::updateClass()
+{
+    if (sVBOArena)
+    {
+        sVBOArena->fence();
+        sVBOArena->poll();
+
+        static U32 frames = 0;
+        if (++frames >= 64)
+        {
+            frames = 0;
+            sVBOArena->trim();
+        }
+    }
+
+    sLastQueuedDraws = sQueuedDraws;
+    sLastDrawCalls = sDrawCalls;
+    sQueuedDraws = 0;
+    sDrawCalls = 0;
+}
+
+//static
+void LLVertexBuffer::getDrawStats(U32& queued_draws, U32& draw_calls)
+{
+    queued_draws = sLastQueuedDraws;
+    draw_calls = sLastDrawCalls;
+}
+
+//static
+bool LLVertexBuffer::canQueueDraws()
+{
+    return sMultiDrawIndirect && sVBOArena && gGLManager.mHasMultiDrawIndirect &&
+           LLGLSLShader::sCurBoundShaderPtr &&
+           LLGLSLShader::sCurBoundShaderPtr->mAttributeMask == MAP_VERTEX;
+}
+
+bool LLVertexBuffer::canMergeDraws(const LLVertexBuffer* other) const
+{
+    // Positions are the first attribute of a buffer and every arena slot
+    // starts on a whole position, so draws from one arena can share a single
+    // attribute pointer and differ only in their base vertex
+    return other &&
+           use_arena(mSize) && use_arena(mIndicesSize) &&
+           use_arena(other->mSize) && use_arena(other->mIndicesSize) &&
+           mGLBuffer == other->mGLBuffer &&
+           mGLIndices == other->mGLIndices &&
+           mIndicesType == other->mIndicesType;
+}
+
+void LLVertexBuffer::queueDraw(U32 start, U32 end, U32 count, U32 indices_offset)
+{
+    llassert(validateRange(start, end, count, indices_offset));
+    llassert(mMappedVertexRegions.empty());
+    llassert(mMappedIndexRegions.empty());
+    llassert(canQueueDraws());
+
+    ++sQueuedDraws;
+
+    if (!canMergeDraws(this))
+    { // has a GL buffer of its own
+        flushDraws();
+        setBuffer();
+        drawRange(LLRender::TRIANGLES, start, end, count, indices_offset);
+        ++sDrawCalls;
+        return;
+    }
+
+    if (!sDrawCommands.empty() && !canMergeDraws(sDrawSource))
+    {
+        flushDraws();
+    }
+    sDrawSource = this;
+
+    llassert(mOffsets[TYPE_VERTEX] == 0);
+    llassert(mBufferOffset % sTypeSize[TYPE_VERTEX] == 0);
+
+    DrawElementsIndirectCommand cmd;
+    cmd.mCount = count;
+    cmd.mInstanceCount = 1;
+    cmd.mFirstIndex = mIndicesOffset / mIndicesStride + indices_offset;
+    cmd.mBaseVertex = (S32) (mBufferOffset / sTypeSize[TYPE_VERTEX]);
+    cmd.mBaseInstance = 0;
+    sDrawCommands.push_back(cmd);
+
+    // the GPU may be reading the buffer from here on
+    mPersistentData = nullptr;
+    mPersistentIndexData = nullptr;
+}
+
+//static
+void LLVertexBuffer::flushDraws()
+{
+    if (sDrawCommands.empty())
+    {
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+
+    const LLVertexBuffer* source = sDrawSource.get();
+    if (sGLRenderBuffer != source->mGLBuffer)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, source->mGLBuffer);
+        sGLRenderBuffer = source->mGLBuffer;
+    }
+    glVertexAttribPointer(TYPE_VERTEX, 3, GL_FLOAT, GL_FALSE, sTypeSize[TYPE_VERTEX], nullptr);
+    // only the position pointer is set up, make the next setBuffer() redo them all
+    sAttribBuffer = 0;
+
+    if (sGLRenderIndices != source->mGLIndices)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, source->mGLIndices);
+        sGLRenderIndices = source->mGLIndices;
+    }
+
+    if (!sIndirectBuffer)
+    {
+        glGenBuffers(1, &sIndirectBuffer);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sIndirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sDrawCommands.size() * sizeof(DrawElementsIndirectCommand),
+                 sDrawCommands.data(), GL_STREAM_DRAW);
+
+    gGL.syncMatrices();
+    glMultiDrawElementsIndirect(GL_TRIANGLES, source->mIndicesType, nullptr, (GLsizei) sDrawCommands.size(), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    ++sDrawCalls;
+    sDrawCommands.clear();
+    sDrawSource = nullptr;
 }
 
 //============================================================================
@@ -535,6 +1178,8 @@ U64 LLVertexBuffer::getBytesAllocated()
 //static
 U32 LLVertexBuffer::sGLRenderBuffer = 0;
 U32 LLVertexBuffer::sGLRenderIndices = 0;
+U32 LLVertexBuffer::sBufferMode = LLVertexBuffer::BUFFER_ARENA;
+bool LLVertexBuffer::sMultiDrawIndirect = true;
 U32 LLVertexBuffer::sLastMask = 0;
 U32 LLVertexBuffer::sVertexCount = 0;
 GLuint LLVertexBuffer::sDummyVAO = 0;
@@ -740,7 +1385,10 @@ bool LLVertexBuffer::validateRange(U32 start, U32 end, U32 count, U32 indices_of
 
 #ifdef LL_PROFILER_ENABLE_RENDER_DOC
 void LLVertexBuffer::setLabel(const char* label) {
-    LL_LABEL_OBJECT_GL(GL_BUFFER, mGLBuffer, strlen(label), label);
+    if (!use_arena(mSize))
+    { // arenas are shared, don't label them after one of their buffers
+        LL_LABEL_OBJECT_GL(GL_BUFFER, mGLBuffer, strlen(label), label);
+    }
 }
 #endif
 
@@ -751,7 +1399,11 @@ void LLVertexBuffer::drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indi
     llassert(mGLIndices == sGLRenderIndices);
     gGL.syncMatrices();
     glDrawRangeElements(sGLMode[mode], start, end, count, mIndicesType,
-        (GLvoid*) (indices_offset * (size_t) mIndicesStride));
+        (GLvoid*) (mIndicesOffset + indices_offset * (size_t) mIndicesStride));
+
+    // the GPU may be reading the buffer from here on
+    mPersistentData = nullptr;
+    mPersistentIndexData = nullptr;
 }
 
 void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
@@ -768,6 +1420,8 @@ void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
 
     gGL.syncMatrices();
     glDrawArrays(sGLMode[mode], first, count);
+
+    mPersistentData = nullptr;
 }
 
 //static
@@ -794,6 +1448,13 @@ void LLVertexBuffer::initClass(LLWindow* window)
     llassert(sVBOPool == nullptr);
     sVBOPool = new LLVBOPool();
 
+    llassert(sVBOArena == nullptr);
+    if (sBufferMode != BUFFER_PER_VBO)
+    {
+        bool persistent = sBufferMode == BUFFER_ARENA_PERSISTENT && gGLManager.mHasBufferStorage;
+        sVBOArena = new LLVBOArena(persistent);
+    }
+
 #if ENABLE_GL_WORK_QUEUE
     sQueue = new GLWorkQueue();
 
@@ -813,6 +1474,7 @@ void LLVertexBuffer::unbind()
 
     sGLRenderBuffer = 0;
     sGLRenderIndices = 0;
+    sAttribBuffer = 0;
 }
 
 //static
@@ -820,9 +1482,20 @@ void LLVertexBuffer::cleanupClass()
 {
     unbind();
 
+    sDrawCommands.clear();
+    sDrawSource = nullptr;
+    if (sIndirectBuffer)
+    {
+        glDeleteBuffers(1, &sIndirectBuffer);
+        sIndirectBuffer = 0;
+    }
+
     delete sVBOPool;
     sVBOPool = nullptr;
 
+    delete sVBOArena;
+    sVBOArena = nullptr;
+
     if (sDummyVAO != 0)
     {
 #ifdef GL_ARB_vertex_array_object
@@ -929,7 +1602,14 @@ void LLVertexBuffer::genBuffer(U32 size)
         llassert(mMappedData == nullptr);
 
         mSize = size;
-        sVBOPool->allocate(GL_ARRAY_BUFFER, mSize, mGLBuffer, mMappedData);
+        if (use_arena(mSize))
+        {
+            sVBOArena->allocate(GL_ARRAY_BUFFER, mSize, mGLBuffer, mBufferOffset, mMappedData, mPersistentData);
+        }
+        else
+        {
+            sVBOPool->allocate(GL_ARRAY_BUFFER, mSize, mGLBuffer, mMappedData);
+        }
     }
 }
 
@@ -944,7 +1624,14 @@ void LLVertexBuffer::genIndices(U32 size)
         llassert(mGLIndices == 0);
         llassert(mMappedIndexData == nullptr);
         mIndicesSize = size;
-        sVBOPool->allocate(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mMappedIndexData);
+        if (use_arena(mIndicesSize))
+        {
+            sVBOArena->allocate(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mIndicesOffset, mMappedIndexData, mPersistentIndexData);
+        }
+        else
+        {
+            sVBOPool->allocate(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mMappedIndexData);
+        }
     }
 }
 
@@ -1000,14 +1687,25 @@ void LLVertexBuffer::destroyGLBuffer()
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         //llassert(sVBOPool);
-        if (sVBOPool)
+        if (use_arena(mSize))
+        {
+            sVBOArena->free(GL_ARRAY_BUFFER, mSize, mGLBuffer, mBufferOffset);
+        }
+        else if (sVBOPool)
         {
             sVBOPool->free(GL_ARRAY_BUFFER, mSize, mGLBuffer, mMappedData);
         }
 
+        if (sAttribBuffer == mGLBuffer && sAttribOffset == mBufferOffset)
+        { // the next buffer given this storage must set up its own attributes
+            sAttribBuffer = 0;
+        }
+
         mSize = 0;
         mGLBuffer = 0;
+        mBufferOffset = 0;
         mMappedData = nullptr;
+        mPersistentData = nullptr;
     }
 }
 
@@ -1017,14 +1715,20 @@ void LLVertexBuffer::destroyGLIndices()
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         //llassert(sVBOPool);
-        if (sVBOPool)
+        if (use_arena(mIndicesSize))
+        {
+            sVBOArena->free(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mIndicesOffset);
+        }
+        else if (sVBOPool)
         {
             sVBOPool->free(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mMappedIndexData);
         }
 
         mIndicesSize = 0;
         mGLIndices = 0;
+        mIndicesOffset = 0;
         mMappedIndexData = nullptr;
+        mPersistentIndexData = nullptr;
     }
 }
 
@@ -1179,9 +1883,16 @@ U8* LLVertexBuffer::mapIndexBuffer(U32 index, S32 count)
 //  start -- first byte to copy
 //  end -- last byte to copy (NOT last byte + 1)
 //  data -- mMappedData or mMappedIndexData
-static void flush_vbo(GLenum target, U32 start, U32 end, void* data)
+//  offset -- where the buffer starts in its GL buffer
+//  persistent -- persistently mapped storage of the buffer, written directly when not null
+static void flush_vbo(GLenum target, U32 start, U32 end, void* data, U32 offset, U8* persistent)
 {
-    if (end != 0)
+    if (end != 0 && persistent)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("persistent copy");
+        memcpy(persistent + start, data, end - start + 1);
+    }
+    else if (end != 0)
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("glBufferSubData");
         LL_PROFILE_ZONE_NUM(start);
@@ -1196,7 +1907,7 @@ static void flush_vbo(GLenum target, U32 start, U32 end, void* data)
             //LL_PROFILE_GPU_ZONE("glBufferSubData");
             U32 tend = llmin(i + block_size, end);
             U32 size = tend - i + 1;
-            glBufferSubData(target, i, size, (U8*) data + (i-start));
+            glBufferSubData(target, offset + i, size, (U8*) data + (i-start));
         }
     }
 }
@@ -1234,13 +1945,13 @@ void LLVertexBuffer::unmapBuffer()
             }
             else
             {
-                flush_vbo(GL_ARRAY_BUFFER, start, end, (U8*)mMappedData + start);
+                flush_vbo(GL_ARRAY_BUFFER, start, end, (U8*)mMappedData + start, mBufferOffset, mPersistentData);
                 start = region.mStart;
                 end = region.mEnd;
             }
         }
 
-        flush_vbo(GL_ARRAY_BUFFER, start, end, (U8*)mMappedData + start);
+        flush_vbo(GL_ARRAY_BUFFER, start, end, (U8*)mMappedData + start, mBufferOffset, mPersistentData);
 
         mMappedVertexRegions.clear();
     }
@@ -1268,13 +1979,13 @@ void LLVertexBuffer::unmapBuffer()
             }
             else
             {
-                flush_vbo(GL_ELEMENT_ARRAY_BUFFER, start, end, (U8*)mMappedIndexData + start);
+                flush_vbo(GL_ELEMENT_ARRAY_BUFFER, start, end, (U8*)mMappedIndexData + start, mIndicesOffset, mPersistentIndexData);
                 start = region.mStart;
                 end = region.mEnd;
             }
         }
 
-        flush_vbo(GL_ELEMENT_ARRAY_BUFFER, start, end, (U8*)mMappedIndexData + start);
+        flush_vbo(GL_ELEMENT_ARRAY_BUFFER, start, end, (U8*)mMappedIndexData + start, mIndicesOffset, mPersistentIndexData);
 
         mMappedIndexRegions.clear();
     }
@@ -1416,7 +2127,12 @@ void LLVertexBuffer::setBuffer()
     {
         glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
         sGLRenderBuffer = mGLBuffer;
+    }
 
+    if (sAttribBuffer != mGLBuffer || sAttribOffset != mBufferOffset)
+    { // buffers sharing an arena differ only in where their attributes start
+        sAttribBuffer = mGLBuffer;
+        sAttribOffset = mBufferOffset;
         setupVertexBuffer();
     }
     else if (sLastMask != data_mask)
@@ -1436,7 +2152,7 @@ void LLVertexBuffer::setBuffer()
 // virtual (default)
 void LLVertexBuffer::setupVertexBuffer()
 {
-    U8* base = nullptr;
+    U8* base = (U8*) (size_t) mBufferOffset;
 
     U32 data_mask = LLGLSLShader::sCurBoundShaderPtr->mAttributeMask;
 
@@ -1530,43 +2246,43 @@ void LLVertexBuffer::setupVertexBuffer()
 void LLVertexBuffer::setPositionData(const LLVector4a* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, 0, sizeof(LLVector4a) * getNumVerts()-1, (U8*) data);
+    flush_vbo(GL_ARRAY_BUFFER, 0, sizeof(LLVector4a) * getNumVerts()-1, (U8*) data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setTexCoordData(const LLVector2* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_TEXCOORD0], mOffsets[TYPE_TEXCOORD0] + sTypeSize[TYPE_TEXCOORD0] * getNumVerts() - 1, (U8*)data);
+    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_TEXCOORD0], mOffsets[TYPE_TEXCOORD0] + sTypeSize[TYPE_TEXCOORD0] * getNumVerts() - 1, (U8*)data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setColorData(const LLColor4U* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_COLOR], mOffsets[TYPE_COLOR] + sTypeSize[TYPE_COLOR] * getNumVerts() - 1, (U8*) data);
+    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_COLOR], mOffsets[TYPE_COLOR] + sTypeSize[TYPE_COLOR] * getNumVerts() - 1, (U8*) data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setNormalData(const LLVector4a* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_NORMAL], mOffsets[TYPE_NORMAL] + sTypeSize[TYPE_NORMAL] * getNumVerts() - 1, (U8*) data);
+    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_NORMAL], mOffsets[TYPE_NORMAL] + sTypeSize[TYPE_NORMAL] * getNumVerts() - 1, (U8*) data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setTangentData(const LLVector4a* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_TANGENT], mOffsets[TYPE_TANGENT] + sTypeSize[TYPE_TANGENT] * getNumVerts() - 1, (U8*) data);
+    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_TANGENT], mOffsets[TYPE_TANGENT] + sTypeSize[TYPE_TANGENT] * getNumVerts() - 1, (U8*) data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setWeight4Data(const LLVector4a* data)
 {
     llassert(sGLRenderBuffer == mGLBuffer);
-    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_WEIGHT4], mOffsets[TYPE_WEIGHT4] + sTypeSize[TYPE_WEIGHT4] * getNumVerts() - 1, (U8*) data);
+    flush_vbo(GL_ARRAY_BUFFER, mOffsets[TYPE_WEIGHT4], mOffsets[TYPE_WEIGHT4] + sTypeSize[TYPE_WEIGHT4] * getNumVerts() - 1, (U8*) data, mBufferOffset, mPersistentData);
 }
 
 void LLVertexBuffer::setIndexData(const U16* data)
 {
     llassert(sGLRenderIndices == mGLIndices);
-    flush_vbo(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(U16) * getNumIndices() - 1, (U8*) data);
+    flush_vbo(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(U16) * getNumIndices() - 1, (U8*) data, mIndicesOffset, mPersistentIndexData);
 }
 
 void LLVertexBuffer::setIndexData(const U32* data)
@@ -1578,6 +2294,6 @@ void LLVertexBuffer::setIndexData(const U32* data)
         mIndicesStride = 4;
         mNumIndices /= 2;
     }
-    flush_vbo(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(U32) * getNumIndices() - 1, (U8*)data);
+    flush_vbo(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(U32) * getNumIndices() - 1, (U8*)data, mIndicesOffset, mPersistentIndexData);
 }
 
@@ -73,8 +73,30 @@ class LLVertexBuffer final : public LLRefCount
         return *this;
     }
 
+    // How buffers get their GL storage, set before initClass()
+    enum
+    {
+        BUFFER_PER_VBO = 0,         // a GL buffer each, recycled by size
+        BUFFER_ARENA,               // small buffers suballocated from large shared GL buffers
+        BUFFER_ARENA_PERSISTENT,    // same, written through a persistent mapping on GL 4.4
+    };
+
+    // Where the GL storage for vertex buffers went
+    struct PoolStats
+    {
+        U64 mPoolBytes = 0;         // GL buffers of their own, in use or recycled
+        U64 mArenaBytes = 0;        // shared GL buffers
+        U64 mPageBytes = 0;         // arena pages handed to a size class
+        U64 mSlotBytes = 0;         // slots in use, rounded up to their size class
+        U64 mRequestedBytes = 0;    // what the buffers in those slots asked for
+        U64 mRetiredBytes = 0;      // freed slots waiting for the GPU to let go of them
+        U32 mArenaCount = 0;
+        U32 mSlotCount = 0;
+    };
+
     static void initClass(LLWindow* window);
     static void cleanupClass();
+    static void updateClass(); // once per frame, recycles storage the GPU is done with
     static void setupClientArrays(U32 data_mask);
     static void drawArrays(U32 mode, const std::vector<LLVector3>& pos);
     static void drawElements(U32 mode, const LLVector4a* pos, const LLVector2* tc, U32 num_indices, const U16* indicesp);
@@ -215,6 +237,22 @@ class LLVertexBuffer final : public LLRefCount
     void drawArrays(U32 mode, U32 offset, U32 count) const;
     void drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const;
 
+    // Position-only triangle draws of buffers that share arena storage can be
+    // queued and sent to GL together as one glMultiDrawElementsIndirect.
+    // Queued draws go out with the GL state and matrices current at
+    // flushDraws(), so flush before changing anything they depend on.
+    //
+    // true if indirect draws are available and the bound shader reads
+    // nothing but positions
+    static bool canQueueDraws();
+    // like setBuffer() then drawRange(TRIANGLES, ...), but may be deferred
+    // until the next flushDraws()
+    void queueDraw(U32 start, U32 end, U32 count, U32 indices_offset);
+    // submit queued draws
+    static void flushDraws();
+    // whether queued draws of this buffer and other can share a GL call
+    bool canMergeDraws(const LLVertexBuffer* other) const;
+
     //for debugging, validate data in given range is valid
     bool validateRange(U32 start, U32 end, U32 count, U32 offset) const;
 
@@ -226,6 +264,8 @@ class LLVertexBuffer final : public LLRefCount
 protected:
     U32     mGLBuffer = 0;      // GL VBO handle
     U32     mGLIndices = 0;     // GL IBO handle
+    U32     mBufferOffset = 0;  // byte offset of this buffer's vertices in mGLBuffer
+    U32     mIndicesOffset = 0; // byte offset of this buffer's indices in mGLIndices
     U32     mNumVerts = 0;      // Number of vertices allocated
     U32     mNumIndices = 0;    // Number of indices allocated
     U32     mIndicesType = GL_UNSIGNED_SHORT; // type of indices in index buffer
@@ -235,6 +275,11 @@ class LLVertexBuffer final : public LLRefCount
     U8* mMappedData = nullptr;  // pointer to currently mapped data (NULL if unmapped)
     U8* mMappedIndexData = nullptr; // pointer to currently mapped indices (NULL if unmapped)
 
+    // persistently mapped GL storage, written directly instead of through
+    // glBufferSubData while nothing has drawn from it (cleared by the first draw)
+    mutable U8* mPersistentData = nullptr;
+    mutable U8* mPersistentIndexData = nullptr;
+
     U32     mTypeMask = 0;      // bitmask of present vertex attributes
 
     U32     mSize = 0;          // size in bytes of mMappedData
@@ -261,6 +306,11 @@ class LLVertexBuffer final : public LLRefCount
 public:
 
     static U64 getBytesAllocated();
+    static void getPoolStats(PoolStats& stats);
+    // draws queued and GL calls they went out in over the last frame
+    static void getDrawStats(U32& queued_draws, U32& draw_calls);
+    static U32 sBufferMode;
+    static bool sMultiDrawIndirect;
     static const U32 sTypeSize[TYPE_MAX];
     static const U32 sGLMode[LLRender::NUM_MODES];
     static U32 sGLRenderBuffer;
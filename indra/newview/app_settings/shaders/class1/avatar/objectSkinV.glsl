@@ -24,7 +24,10 @@
 
 in vec4 weight4;
 
-uniform mat3x4 matrixPalette[MAX_JOINTS_PER_MESH_OBJECT];
+layout(std140) uniform MatrixPalette
+{
+    mat3x4 matrixPalette[MAX_JOINTS_PER_MESH_OBJECT];
+};
 
 mat4 getObjectSkinnedTransform()
 {
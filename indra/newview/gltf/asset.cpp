@@ -30,6 +30,7 @@
 #include "llvolumeoctree.h"
 #include "../llviewershadermgr.h"
 #include "../llviewercontrol.h"
+#include "../llskinningutil.h"
 
 #include "glh/glh_linear.h"
 
@@ -658,9 +659,8 @@ void Skin::uploadMatrixPalette(Asset& asset, Node& node)
         mp[idx + 11] = m[14];
     }
 
-    LLGLSLShader::sCurBoundShaderPtr->uniformMatrix3x4fv(LLViewerShaderMgr::AVATAR_MATRIX,
-        mJoints.size(),
-        FALSE,
-        (GLfloat*)glmp.data());
+    // rebuilt for every draw, nothing to reuse
+    LLSkinningUtil::PaletteSlot slot;
+    LLSkinningUtil::bindMatrixPalette(glmp.data(), llmin((U32) mJoints.size(), LLSkinningUtil::getMaxJointCount()), slot);
 }
 
@@ -468,6 +468,35 @@ void LLAppCoreHttp::refreshSettings(bool initial)
             }
         }
 
+        // HTTP/2 multiplexing for the CDN-backed classes that would
+        // otherwise pipeline.  Takes precedence over pipelining in
+        // llcorehttp and falls back to HTTP/1.1 on servers without it.
+        if (initial && init_data[i].mPipelined)
+        {
+            const U32 http2_streams(gSavedSettings.getU32("AlchemyHttp2Streams"));
+            if (http2_streams)
+            {
+                LLCore::HttpHandle handle;
+                handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAMS,
+                                                   mHttpClasses[app_policy].mPolicy,
+                                                   long(http2_streams),
+                                                   LLCore::HttpHandler::ptr_t());
+                if (LLCORE_HTTP_HANDLE_INVALID == handle)
+                {
+                    status = mRequest->getStatus();
+                    LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+                                     << " HTTP/2 streams.  Reason:  " << status.toString()
+                                     << LL_ENDL;
+                }
+                else
+                {
+                    LL_INFOS("Init") << "HTTP/2 multiplexing " << init_data[i].mUsage
+                                     << " with " << http2_streams << " streams per connection"
+                                     << LL_ENDL;
+                }
+            }
+        }
+
         // Get target connection concurrency value
         U32 setting(init_data[i].mDefault);
         if (! init_data[i].mKey.empty() && gSavedSettings.controlExists(init_data[i].mKey))
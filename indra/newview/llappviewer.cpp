@@ -554,6 +554,8 @@ static void settings_to_globals()
     LLRender::sNsightDebugSupport = gSavedSettings.getBOOL("RenderNsightDebugSupport");
     LLRender::sAnisotropicFilteringLevel = static_cast<F32>(gSavedSettings.getU32("RenderAnisotropicLevel"));
     LLImageGL::sCompressTextures        = gSavedSettings.getBOOL("RenderCompressTextures");
+    LLImageGL::sStagingBufferSize       = llmin(gSavedSettings.getU32("AlchemyTextureStagingSize"), 1024U) << 20;
+    LLVertexBuffer::sBufferMode         = gSavedSettings.getU32("AlchemyVertexBufferArena");
     LLVOVolume::sLODFactor              = llclamp(gSavedSettings.getF32("RenderVolumeLODFactor"), 0.01f, MAX_LOD_FACTOR);
     LLVOVolume::sDistanceFactor         = 1.f-LLVOVolume::sLODFactor * 0.1f;
     LLVolumeImplFlexible::sUpdateFactor = gSavedSettings.getF32("RenderFlexTimeFactor");
@@ -2167,6 +2169,17 @@ bool LLAppViewer::initThreads()
     threadCounts["ImageDecode"] = image_decode_count;
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
+    // Large textures are also split over several threads inside the decoder.
+    // Every ImageDecode worker may be doing that at once, so keep the total
+    // within the core count.
+    U32 per_image_decode_count = gSavedSettings.getU32("AlchemyImageDecodeThreadsPerImage");
+    if (per_image_decode_count == 0)
+    {
+        per_image_decode_count = 4;
+    }
+    per_image_decode_count = llclamp((U32)(cores / image_decode_count), 1U, per_image_decode_count);
+    LLImageJ2C::setDecodeThreads(per_image_decode_count);
+
     // Image decoding
     LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
     LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
@@ -2882,7 +2895,10 @@ bool LLAppViewer::initConfiguration()
     //LLVolumeMgr::initClass();
     LLVolumeMgr* volume_manager = new LLVolumeMgr();
     volume_manager->useMutex(); // LLApp and LLMutex magic must be manually enabled
+    volume_manager->setCacheLimit((U64)gSavedSettings.getU32("AlchemyVolumeCacheSize") * 1024 * 1024);
     LLPrimitive::setVolumeManager(volume_manager);
+    LLKeyframeDataCache::setLimit((U64)gSavedSettings.getU32("AlchemyAnimationCacheSize") * 1024 * 1024);
+    LLKeyframeDataCache::setDiskCacheEnabled(gSavedSettings.getBOOL("AlchemyAnimationDiskCache"));
 
     // Note: this is where we used to initialize gFeatureManagerp.
 
@@ -4067,7 +4083,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
     // Viewer object cache version, change if object update
     // format changes. JC
-    const U32 INDRA_OBJECT_CACHE_VERSION = 17;
+    const U32 INDRA_OBJECT_CACHE_VERSION = 18;
 
     return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -4160,7 +4176,8 @@ bool LLAppViewer::initCache()
         const uintmax_t disk_cache_bytes = disk_cache_mb * 1024ull * 1024ull;
 
         const bool enable_cache_debug_info = gSavedSettings.getBOOL("EnableDiskCacheDebugInfo");
-        LLDiskCache::getInstance()->init(LL_PATH_CACHE, disk_cache_bytes, enable_cache_debug_info, disk_cache_mismatch);
+        const bool use_pack_store = gSavedSettings.getBOOL("AlchemyDiskCachePackStore");
+        LLDiskCache::getInstance()->init(LL_PATH_CACHE, disk_cache_bytes, enable_cache_debug_info, disk_cache_mismatch, use_pack_store);
 
         if (!read_only)
         {
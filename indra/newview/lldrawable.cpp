@@ -1469,12 +1469,20 @@ class LLOctreeMarkNotCulled: public OctreeTraveler
 };
 
 void LLSpatialBridge::setVisible(LLCamera& camera_in, std::vector<LLDrawable*>* results, BOOL for_select)
+{
+    if (isCullable())
+    {
+        cullTree(camera_in, results, for_select);
+    }
+}
+
+bool LLSpatialBridge::isCullable()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
 
     if (!gPipeline.hasRenderType(mDrawableType))
     {
-        return;
+        return false;
     }
 
 
@@ -1503,7 +1511,7 @@ void LLSpatialBridge::setVisible(LLCamera& camera_in, std::vector<LLDrawable*>*
                 }
                 else
                 {
-                    return;
+                    return false;
                 }
             }
 
@@ -1512,11 +1520,17 @@ void LLSpatialBridge::setVisible(LLCamera& camera_in, std::vector<LLDrawable*>*
                 impostor ||
                 !loaded)
             {
-                return;
+                return false;
             }
         }
     }
 
+    return true;
+}
+
+void LLSpatialBridge::cullTree(LLCamera& camera_in, std::vector<LLDrawable*>* results, BOOL for_select)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWABLE
 
     LLSpatialGroup* group = (LLSpatialGroup*) mOctree->getListener(0);
     group->rebound();
@@ -450,6 +450,7 @@ void LLRenderPass::pushBatches(U32 type, bool texture, bool batch_textures)
 void LLRenderPass::pushUntexturedBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    bool queue = LLVertexBuffer::canQueueDraws();
     auto* begin = gPipeline.beginRenderMap(type);
     auto* end = gPipeline.endRenderMap(type);
     for (LLCullResult::drawinfo_iterator i = begin; i != end; )
@@ -457,8 +458,16 @@ void LLRenderPass::pushUntexturedBatches(U32 type)
         LLDrawInfo* pparams = *i;
         LLCullResult::increment_iterator(i, end);
 
-        pushUntexturedBatch(*pparams);
+        if (queue)
+        {
+            queueUntexturedBatch(*pparams);
+        }
+        else
+        {
+            pushUntexturedBatch(*pparams);
+        }
     }
+    LLVertexBuffer::flushDraws();
 }
 
 void LLRenderPass::pushRiggedBatches(U32 type, bool texture, bool batch_textures)
@@ -658,6 +667,23 @@ void LLRenderPass::pushUntexturedBatch(LLDrawInfo& params)
     params.mVertexBuffer->drawRange(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset);
 }
 
+// static
+void LLRenderPass::queueUntexturedBatch(LLDrawInfo& params)
+{
+    if (!params.mCount)
+    {
+        return;
+    }
+
+    if (params.mModelMatrix != gGLLastMatrix)
+    { // queued draws go out under the matrix current when they are flushed
+        LLVertexBuffer::flushDraws();
+        applyModelMatrix(params);
+    }
+
+    params.mVertexBuffer->queueDraw(params.mStart, params.mEnd, params.mCount, params.mOffset);
+}
+
 // static
 bool LLRenderPass::uploadMatrixPalette(LLDrawInfo& params)
 {
@@ -681,10 +707,7 @@ bool LLRenderPass::uploadMatrixPalette(LLVOAvatar* avatar, LLMeshSkinInfo* skinI
         return false;
     }
 
-    LLGLSLShader::sCurBoundShaderPtr->uniformMatrix3x4fv(LLViewerShaderMgr::AVATAR_MATRIX,
-        count,
-        FALSE,
-        (GLfloat*)&(mpc.mGLMp[0]));
+    LLSkinningUtil::bindMatrixPalette(mpc.mGLMp.data(), count, mpc.mPaletteSlot);
 
     return true;
 }
@@ -718,7 +741,7 @@ void LLRenderPass::pushGLTFBatches(U32 type, bool textured)
     }
     else
     {
-        pushRiggedGLTFBatches(type);
+        pushUntexturedGLTFBatches(type);
     }
 }
 
@@ -740,6 +763,9 @@ void LLRenderPass::pushGLTFBatches(U32 type)
 void LLRenderPass::pushUntexturedGLTFBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    bool queue = LLVertexBuffer::canQueueDraws();
+    // held across runs of queued double sided draws
+    std::unique_ptr<LLGLDisable> no_cull;
     auto* begin = gPipeline.beginRenderMap(type);
     auto* end = gPipeline.endRenderMap(type);
     for (LLCullResult::drawinfo_iterator i = begin; i != end; )
@@ -748,8 +774,22 @@ void LLRenderPass::pushUntexturedGLTFBatches(U32 type)
         LLDrawInfo& params = **i;
         LLCullResult::increment_iterator(i, end);
 
-        pushUntexturedGLTFBatch(params);
+        if (queue)
+        {
+            bool double_sided = params.mGLTFMaterial->mDoubleSided;
+            if (double_sided != (no_cull != nullptr))
+            {
+                LLVertexBuffer::flushDraws();
+                no_cull.reset(double_sided ? new LLGLDisable(GL_CULL_FACE) : nullptr);
+            }
+            queueUntexturedBatch(params);
+        }
+        else
+        {
+            pushUntexturedGLTFBatch(params);
+        }
     }
+    LLVertexBuffer::flushDraws();
 }
 
 // static
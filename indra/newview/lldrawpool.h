@@ -383,6 +383,9 @@ class LLRenderPass : public LLDrawPool
     void pushRiggedMaskBatches(U32 type, bool texture = true, bool batch_textures = false);
     void pushBatch(LLDrawInfo& params, bool texture, bool batch_textures = false);
     void pushUntexturedBatch(LLDrawInfo& params);
+    // like pushUntexturedBatch, but may be merged with the draws around it
+    // (see LLVertexBuffer::queueDraw), only while LLVertexBuffer::canQueueDraws()
+    static void queueUntexturedBatch(LLDrawInfo& params);
     void pushBumpBatch(LLDrawInfo& params, bool texture, bool batch_textures = false);
     static bool uploadMatrixPalette(LLDrawInfo& params);
     static bool uploadMatrixPalette(LLVOAvatar* avatar, LLMeshSkinInfo* skinInfo);
@@ -249,19 +249,11 @@ void LLDrawPoolMaterials::renderDeferred(S32 pass)
         {
             if (params.mAvatar != lastAvatar)
             {
-                const LLVOAvatar::MatrixPaletteCache& mpc = params.mAvatar->updateSkinInfoMatrixPalette(params.mSkinInfo);
-                U32 count = mpc.mMatrixPalette.size();
-
-                if (count == 0)
+                if (!uploadMatrixPalette(params))
                 {
                     //skin info not loaded yet, don't render
                     return;
                 }
-
-                mShader->uniformMatrix3x4fv(LLViewerShaderMgr::AVATAR_MATRIX,
-                    count,
-                    FALSE,
-                    (GLfloat*)&(mpc.mGLMp[0]));
             }
         }
 
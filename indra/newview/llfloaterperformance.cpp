@@ -505,6 +505,12 @@ void LLFloaterPerformance::populateNearbyList()
     mNearbyList->sortByColumnIndex(1, FALSE);
     mNearbyList->setScrollPos(prev_pos);
     mNearbyList->selectByID(prev_selected_id);
+
+    const LLVOAvatar::AnimationLODStats& anim_stats = LLVOAvatar::getAnimationLODStats();
+    LLTextBox* anim_text = mNearbyPanel->getChild<LLTextBox>("animation_lod_text");
+    anim_text->setTextArg("[AVATARS]", llformat("%d", anim_stats.mAvatars));
+    anim_text->setTextArg("[REDUCED]", llformat("%d", anim_stats.mReducedRate));
+    anim_text->setTextArg("[JOINTS]", llformat("%d", anim_stats.mReducedJoints));
 }
 
 void LLFloaterPerformance::setFPSText()
@@ -46,6 +46,7 @@
 #include "llsdserialize.h"
 #include "llthread.h"
 #include "llfilesystem.h"
+#include "threadpool.h"
 #include "llviewercontrol.h"
 #include "llviewerinventory.h"
 #include "llviewermenufile.h"
@@ -149,9 +150,12 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                               decodeLOD() invoked
+//                                 job posted to mDecodePool
+//                                                             lodReceived() invoked
+//                                                               unpack data into LLVolume
+//                                                               append LoadedMesh to mLoadedQ
+//                                                               write data to cache
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -222,9 +226,9 @@
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
-//     sCacheBytesWritten              "
-//     sCacheReads                     "
-//     sCacheWrites                    "
+//     sCacheBytesWritten              Repo::mMutex    rw.any.Repo::mMutex, ro.main.none [1]
+//     sCacheReads                     none            rw.repo.none, ro.main.none [1]
+//     sCacheWrites                    Repo::mMutex    rw.any.Repo::mMutex, ro.main.none [1]
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -248,15 +252,17 @@
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
 //     mSkinReqQ                mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinUnavailableQ        mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinUnavailableQ        mMutex        rw.any.mMutex, ro.repo.none [5]
+//     mSkinInfoQ               mMutex        rw.any.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinRefetchQ            mMutex        rw.any.mMutex
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], rw.any.mMutex, ro.main.none [5], rw.main.mMutex
+//     mLoadedQ                 mMutex        rw.any.mMutex, ro.main.none [5], rw.main.mMutex
+//     mLODRefetchQ             mMutex        rw.any.mMutex
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -841,6 +847,13 @@ LLMeshRepoThread::LLMeshRepoThread()
     mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
     mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1);
     mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+    U32 decode_threads = gSavedSettings.getU32("AlchemyMeshDecodeThreads");
+    if (decode_threads > 0)
+    {
+        mDecodePool.reset(new LL::ThreadPool("MeshDecode", decode_threads));
+        mDecodePool->start();
+    }
 }
 
 
@@ -851,6 +864,13 @@ LLMeshRepoThread::~LLMeshRepoThread()
                        << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
                        << LL_ENDL;
 
+    // decode jobs push into our queues under mMutex, finish them first
+    if (mDecodePool)
+    {
+        mDecodePool->close();
+        mDecodePool.reset();
+    }
+
     mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
@@ -906,6 +926,34 @@ void LLMeshRepoThread::run()
         }
         sRequestWaterLevel = mHttpRequestSet.size();            // Stats data update
 
+        if (mDecodePool)
+        {
+            // cached data the decode pool rejected goes to the simulator
+            std::deque<LODRequest> lod_refetch;
+            std::deque<UUIDBasedRequest> skin_refetch;
+            {
+                LLMutexLock lock(mMutex);
+                lod_refetch.swap(mLODRefetchQ);
+                skin_refetch.swap(mSkinRefetchQ);
+            }
+            for (const LODRequest& req : lod_refetch)
+            {
+                if (!fetchMeshLOD(req.mMeshParams, req.mLOD, true, false))
+                {
+                    LLMutexLock lock(mMutex);
+                    mUnavailableQ.push_back(req);
+                }
+            }
+            for (const UUIDBasedRequest& req : skin_refetch)
+            {
+                if (!fetchMeshSkinInfo(req.mId, true, false))
+                {
+                    LLMutexLock lock(mMutex);
+                    mSkinUnavailableQ.push_back(req);
+                }
+            }
+        }
+
         // NOTE: order of queue processing intentionally favors LOD requests over header requests
         // Todo: we are processing mLODReqQ, mHeaderReqQ, mSkinRequests, mDecompositionRequests and mPhysicsShapeRequests
         // in relatively similar manners, remake code to simplify/unify the process,
@@ -1318,41 +1366,148 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
 }
 
 bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn)
+{
+    mesh_buffer_t buffer = readFromFilesystem(mesh_id, info);
+    //attempt to parse
+    return buffer && fn(mesh_id, buffer->data(), info.mSize) == MESH_OK;
+}
+
+LLMeshRepoThread::mesh_buffer_t LLMeshRepoThread::readFromFilesystem(const LLUUID& mesh_id, const MeshHeaderInfo& info)
 {
     //check cache for mesh skin info
     LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
     if (file.getSize() >= info.mOffset + info.mSize)
     {
-        auto buffer = std::make_unique<U8[]>(info.mSize);
-        if (!buffer)
+        mesh_buffer_t buffer;
+        try
+        {
+            buffer = std::make_shared<std::vector<U8>>(info.mSize);
+        }
+        catch (const std::bad_alloc&)
         {
             LL_WARNS_ONCE(LOG_MESH) << "Failed to allocate memory for mesh data load, size: " << info.mSize << LL_ENDL;
-            return false;
+            return nullptr;
         }
         LLMeshRepository::sCacheBytesRead += info.mSize;
         ++LLMeshRepository::sCacheReads;
         file.seek(info.mOffset);
-        file.read(buffer.get(), info.mSize);
+        file.read(buffer->data(), info.mSize);
 
         //make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
         bool zero = true;
         for (S32 i = 0; i < llmin(info.mSize, S32(1024)) && zero; ++i)
         {
-            zero = buffer[i] > 0 ? false : true;
+            zero = (*buffer)[i] > 0 ? false : true;
         }
 
         if (!zero)
-        { //attempt to parse
-            if (fn(mesh_id, buffer.get(), info.mSize) == MESH_OK)
-            {
-                return true;
-            }
+        {
+            return buffer;
         }
     }
-    return false;
+    return nullptr;
 }
 
-bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
+namespace
+{
+    // good fetch from sim, write to cache
+    void write_mesh_cache(LLMutex* mutex, const LLUUID& mesh_id, const U8* data, S32 offset, S32 size)
+    {
+        // <FS:Ansariel> Fix asset caching
+        //LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+        LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+        if (file.getSize() >= offset+size)
+        {
+            file.seek(offset);
+            file.write(data, size);
+            LLMutexLock lock(mutex);
+            LLMeshRepository::sCacheBytesWritten += size;
+            ++LLMeshRepository::sCacheWrites;
+        }
+    }
+
+    // Run the decode job on the pool, or right here if there is no pool.
+    // Jobs queued at shutdown are dropped.
+    void post_mesh_decode(LL::ThreadPool* pool, const std::function<void()>& job)
+    {
+        if (!pool)
+        {
+            job();
+            return;
+        }
+
+        pool->getQueue().post([job]()
+            {
+                if (!LLApp::isExiting())
+                {
+                    job();
+                }
+            });
+    }
+}
+
+void LLMeshRepoThread::decodeLOD(const LLVolumeParams& mesh_params, S32 lod, const mesh_buffer_t& buffer, S32 cache_offset, S32 cache_size)
+{
+    post_mesh_decode(mDecodePool.get(), [this, mesh_params, lod, buffer, cache_offset, cache_size]()
+        {
+            // completions land in mLoadedQ, which notifyLoadedMeshes() hands
+            // to the main thread a frame's worth at a time
+            EMeshProcessingResult result = lodReceived(mesh_params, lod, buffer->data(), (S32)buffer->size());
+            if (result == MESH_OK)
+            {
+                if (cache_offset >= 0)
+                {
+                    write_mesh_cache(mMutex, mesh_params.getSculptID(), buffer->data(), cache_offset, cache_size);
+                }
+            }
+            else if (cache_offset < 0)
+            {
+                LLMutexLock lock(mMutex);
+                mLODRefetchQ.emplace_back(mesh_params, lod);
+            }
+            else
+            {
+                LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_params.getSculptID()
+                                   << ", Reason: " << result
+                                   << " LOD: " << lod
+                                   << " Data size: " << buffer->size()
+                                   << " Not retrying."
+                                   << LL_ENDL;
+                LLMutexLock lock(mMutex);
+                mUnavailableQ.emplace_back(mesh_params, lod);
+            }
+        });
+}
+
+void LLMeshRepoThread::decodeSkinInfo(const LLUUID& mesh_id, const mesh_buffer_t& buffer, S32 cache_offset, S32 cache_size)
+{
+    post_mesh_decode(mDecodePool.get(), [this, mesh_id, buffer, cache_offset, cache_size]()
+        {
+            if (skinInfoReceived(mesh_id, buffer->data(), (S32)buffer->size()) == MESH_OK)
+            {
+                if (cache_offset >= 0)
+                {
+                    write_mesh_cache(mMutex, mesh_id, buffer->data(), cache_offset, cache_size);
+                }
+            }
+            else if (cache_offset < 0)
+            {
+                LLMutexLock lock(mMutex);
+                mSkinRefetchQ.emplace_back(mesh_id);
+            }
+            else
+            {
+                LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+                                   << ", Unknown reason.  Not retrying."
+                                   << LL_ENDL;
+                LLMutexLock lock(mMutex);
+                mSkinUnavailableQ.emplace_back(mesh_id);
+            }
+        });
+}
+
+bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry, bool use_cache)
 {
     MeshHeaderInfo info;
     {
@@ -1383,7 +1538,15 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
     if (info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
         //check cache for mesh skin info
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::skinInfoReceived, this, _1, _2, _3)))
+        if (use_cache && mDecodePool)
+        {
+            if (mesh_buffer_t buffer = readFromFilesystem(mesh_id, info))
+            {
+                decodeSkinInfo(mesh_id, buffer, -1, 0);
+                return true;
+            }
+        }
+        else if (use_cache && loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::skinInfoReceived, this, _1, _2, _3)))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1656,7 +1819,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool use_cache)
 {
     const LLUUID& mesh_id = mesh_params.getSculptID();
     MeshHeaderInfo info;
@@ -1687,7 +1850,15 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
     if(info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::lodReceived, this, mesh_params, lod, _2, _3 )))
+        if (use_cache && mDecodePool)
+        {
+            if (mesh_buffer_t buffer = readFromFilesystem(mesh_id, info))
+            {
+                decodeLOD(mesh_params, lod, buffer, -1, 0);
+                return true;
+            }
+        }
+        else if (use_cache && loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::lodReceived, this, mesh_params, lod, _2, _3 )))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -3235,36 +3406,9 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
     if ((!MESH_LOD_PROCESS_FAILED)
         && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
-        if (result == MESH_OK)
-        {
-            // good fetch from sim, write to cache
-            // <FS:Ansariel> Fix asset caching
-            //LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::WRITE);
-            LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-            S32 offset = mOffset;
-            S32 size = mRequestedBytes;
-
-            if (file.getSize() >= offset+size)
-            {
-                file.seek(offset);
-                file.write(data, size);
-                LLMeshRepository::sCacheBytesWritten += size;
-                ++LLMeshRepository::sCacheWrites;
-            }
-        }
-        else
-        {
-            LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mMeshParams.getSculptID()
-                               << ", Reason: " << result
-                               << " LOD: " << mLOD
-                               << " Data size: " << data_size
-                               << " Not retrying."
-                               << LL_ENDL;
-            LLMutexLock lock(gMeshRepo.mThread->mMutex);
-            gMeshRepo.mThread->mUnavailableQ.emplace_back(mMeshParams, mLOD);
-        }
+        // the body buffer goes away with this handler, the decode job gets a copy
+        auto buffer = std::make_shared<std::vector<U8>>(data, data + data_size);
+        gMeshRepo.mThread->decodeLOD(mMeshParams, mLOD, buffer, mOffset, mRequestedBytes);
     }
     else
     {
@@ -3300,24 +3444,10 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
                                         U8 * data, S32 data_size)
 {
     if ((!MESH_SKIN_INFO_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size) == MESH_OK)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        // good fetch from sim, write to cache
-        // <FS:Ansariel> Fix asset caching
-        //LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-        LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-        S32 offset = mOffset;
-        S32 size = mRequestedBytes;
-
-        if (file.getSize() >= offset+size)
-        {
-            LLMeshRepository::sCacheBytesWritten += size;
-            ++LLMeshRepository::sCacheWrites;
-            file.seek(offset);
-            file.write(data, size);
-        }
+        auto buffer = std::make_shared<std::vector<U8>>(data, data + data_size);
+        gMeshRepo.mThread->decodeSkinInfo(mMeshID, buffer, mOffset, mRequestedBytes);
     }
     else
     {
@@ -40,6 +40,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool_fwd.h"
 
 #include "boost/unordered/unordered_map.hpp"
 #include "boost/unordered/unordered_flat_map.hpp"
@@ -392,6 +393,11 @@ class LLMeshRepoThread final : public LLThread
     // list of completed Physics info requests shared with decomp..
     std::deque<std::unique_ptr<LLModel::Decomposition>> mPhysicsQ;
 
+    // LODs and skin info whose cached copy failed to decode on mDecodePool,
+    // to be fetched from the simulator again by the repo thread
+    std::deque<LODRequest> mLODRefetchQ;
+    std::deque<UUIDBasedRequest> mSkinRefetchQ;
+
     // End
 
     //map of pending header requests and currently desired LODs
@@ -416,6 +422,11 @@ class LLMeshRepoThread final : public LLThread
     int mLegacyGetMeshVersion;
     std::string mGetMeshCapability;
 
+    // LOD and skin info decoding runs here so that the repo thread only
+    // deals with I/O.  Null when AlchemyMeshDecodeThreads is 0, in which
+    // case the repo thread decodes as before.
+    std::unique_ptr<LL::ThreadPool> mDecodePool;
+
     LLMeshRepoThread();
     ~LLMeshRepoThread();
 
@@ -425,7 +436,7 @@ class LLMeshRepoThread final : public LLThread
     void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
     bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-    bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+    bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool use_cache = true);
     EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
     EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
     EMeshProcessingResult skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -436,6 +447,15 @@ class LLMeshRepoThread final : public LLThread
     bool hasHeader(const LLUUID& mesh_id);
 
     bool loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn);
+    typedef std::shared_ptr<std::vector<U8>> mesh_buffer_t;
+    mesh_buffer_t readFromFilesystem(const LLUUID& mesh_id, const MeshHeaderInfo& info);
+
+    // Decode on mDecodePool, or right away without one.  Data fetched from
+    // the simulator is written to the cache at cache_offset once it decoded
+    // and marked unavailable if it didn't; pass a negative cache_offset for
+    // data read from the cache, which gets fetched again when it fails.
+    void decodeLOD(const LLVolumeParams& mesh_params, S32 lod, const mesh_buffer_t& buffer, S32 cache_offset, S32 cache_size);
+    void decodeSkinInfo(const LLUUID& mesh_id, const mesh_buffer_t& buffer, S32 cache_offset, S32 cache_size);
 
     void notifyLoadedMeshes(); // Only call from main thread.
     S32 getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
@@ -446,7 +466,7 @@ class LLMeshRepoThread final : public LLThread
 
     //send request for skin info, returns true if header info exists
     //  (should hold onto mesh_id and try again later if header info does not exist)
-    bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true);
+    bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true, bool use_cache = true);
 
     //send request for decomposition, returns true if header info exists
     //  (should hold onto mesh_id and try again later if header info does not exist)
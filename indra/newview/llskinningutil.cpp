@@ -33,6 +33,8 @@
 #include "llmeshrepository.h"
 #include "llvolume.h"
 #include "llrigginginfo.h"
+#include "llglslshader.h"
+#include "llglheaders.h"
 
 #define DEBUG_SKINNING  LL_DEBUG
 
@@ -356,3 +358,101 @@ void LLSkinningUtil::updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *a
 
     }
 }
+
+namespace
+{
+    // Uniform buffer the palettes are streamed into.  Slots are handed out
+    // front to back; when the buffer fills up it is orphaned and every slot
+    // handed out so far goes stale with the old generation.
+    constexpr U32 PALETTE_BUFFER_SIZE = 4 * 1024 * 1024;
+    constexpr U32 PALETTE_MATRIX_SIZE = 12 * sizeof(F32);
+
+    U32 sPaletteBuffer = 0;
+    U32 sPaletteGeneration = 1;
+    U32 sPaletteHead = 0;
+    U32 sPaletteSlotSize = 0;
+    U32 sBoundOffset = U32_MAX;
+
+    LLSkinningUtil::PaletteStats sPaletteStats;
+    LLSkinningUtil::PaletteStats sLastPaletteStats;
+}
+
+void LLSkinningUtil::bindMatrixPalette(const F32* palette, U32 count, PaletteSlot& slot)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    llassert(count <= getMaxJointCount());
+
+    if (!sPaletteBuffer)
+    {
+        // every slot covers the whole block the shaders declare
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = llmax(alignment, 16);
+        sPaletteSlotSize = (getMaxJointCount() * PALETTE_MATRIX_SIZE + alignment - 1) / alignment * alignment;
+
+        glGenBuffers(1, &sPaletteBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, sPaletteBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, PALETTE_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+        sPaletteHead = 0;
+    }
+
+    ++sPaletteStats.mBinds;
+
+    if (slot.mGeneration != sPaletteGeneration)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, sPaletteBuffer);
+        if (sPaletteHead + sPaletteSlotSize > PALETTE_BUFFER_SIZE)
+        {
+            glBufferData(GL_UNIFORM_BUFFER, PALETTE_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+            sPaletteHead = 0;
+            sBoundOffset = U32_MAX;
+            if (++sPaletteGeneration == 0)
+            {
+                sPaletteGeneration = 1;
+            }
+        }
+
+        slot.mGeneration = sPaletteGeneration;
+        slot.mOffset = sPaletteHead;
+        sPaletteHead += sPaletteSlotSize;
+
+        glBufferSubData(GL_UNIFORM_BUFFER, slot.mOffset, count * PALETTE_MATRIX_SIZE, palette);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        ++sPaletteStats.mUploads;
+        sPaletteStats.mUploadBytes += count * PALETTE_MATRIX_SIZE;
+    }
+
+    if (slot.mOffset != sBoundOffset)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, LLGLSLShader::MATRIX_PALETTE_BINDING, sPaletteBuffer,
+                          slot.mOffset, getMaxJointCount() * PALETTE_MATRIX_SIZE);
+        sBoundOffset = slot.mOffset;
+    }
+}
+
+void LLSkinningUtil::updateMatrixPalettes()
+{
+    sLastPaletteStats = sPaletteStats;
+    sPaletteStats = PaletteStats();
+}
+
+void LLSkinningUtil::cleanupMatrixPalettes()
+{
+    if (sPaletteBuffer)
+    {
+        glDeleteBuffers(1, &sPaletteBuffer);
+        sPaletteBuffer = 0;
+    }
+    // whatever slots are still around refer to the deleted buffer
+    if (++sPaletteGeneration == 0)
+    {
+        sPaletteGeneration = 1;
+    }
+    sBoundOffset = U32_MAX;
+}
+
+const LLSkinningUtil::PaletteStats& LLSkinningUtil::getMatrixPaletteStats()
+{
+    return sLastPaletteStats;
+}
@@ -57,6 +57,33 @@ namespace LLSkinningUtil
 
     void updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, LLVolumeFace& vol_face);
 
+    // Matrix palettes reach the MatrixPalette uniform block of the skinning
+    // shaders through one uniform buffer shared by all rigged draws.  A
+    // palette is written to it the first time a draw needs it, after that
+    // any shader in any pass gets it with a glBindBufferRange.
+    struct PaletteSlot
+    {
+        U32 mGeneration = 0;    // buffer generation mOffset refers to, 0 for none
+        U32 mOffset = 0;        // byte offset of the palette in the buffer
+    };
+
+    struct PaletteStats
+    {
+        U32 mBinds = 0;         // palettes bound for a draw
+        U32 mUploads = 0;       // of those, written to the buffer
+        U64 mUploadBytes = 0;
+    };
+
+    // Bind count matrices laid out for glUniformMatrix3x4fv for the next
+    // rigged draws.  Writes them unless slot already holds them; reset slot
+    // whenever the palette changes.
+    void bindMatrixPalette(const F32* palette, U32 count, PaletteSlot& slot);
+    // Once per frame, rolls the stats over
+    void updateMatrixPalettes();
+    void cleanupMatrixPalettes();
+    // Counts for the last frame
+    const PaletteStats& getMatrixPaletteStats();
+
     inline void scrubSkinWeights(LLVector4a* weights, U32 num_vertices, const LLMeshSkinInfo* skin)
     {
         const S32 max_joints = skin->mJointNames.size();
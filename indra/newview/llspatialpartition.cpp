@@ -816,6 +816,7 @@ void LLSpatialGroup::handleDestruction(const TreeNode* node)
     mBufferMap.clear();
     sZombieGroups++;
     mOctreeNode = NULL;
+    getSpatialPartition()->dirtyFlatOctree();
 }
 
 void LLSpatialGroup::handleChildAddition(const OctreeNode* parent, OctreeNode* child)
@@ -832,10 +833,17 @@ void LLSpatialGroup::handleChildAddition(const OctreeNode* parent, OctreeNode* c
     }
 
     unbound();
+    getSpatialPartition()->dirtyFlatOctree();
 
     assert_states_valid(this);
 }
 
+void LLSpatialGroup::handleChildRemoval(const OctreeNode* parent, const OctreeNode* child)
+{
+    LLOcclusionCullingGroup::handleChildRemoval(parent, child);
+    getSpatialPartition()->dirtyFlatOctree();
+}
+
 //virtual
 void LLSpatialGroup::rebound()
 {
@@ -843,6 +851,7 @@ void LLSpatialGroup::rebound()
         return;
 
     super::rebound();
+    getSpatialPartition()->refitFlatOctree(this);
 
     if (mSpatialPartition->mDrawableType == LLPipeline::RENDER_TYPE_CONTROL_AV)
     {
@@ -913,8 +922,10 @@ void LLSpatialGroup::destroyGLState(bool keep_occlusion)
 
 //==============================================
 
+U32 LLSpatialPartition::sFlatOctreeMask = 0;
+
 LLSpatialPartition::LLSpatialPartition(U32 data_mask, BOOL render_by_group, LLViewerRegion* regionp)
-: mRenderByGroup(render_by_group), mBridge(NULL)
+: mRenderByGroup(render_by_group), mBridge(NULL), mFlatOctreeDirty(true)
 {
     mRegionp = regionp;
     mPartitionType = LLViewerRegion::PARTITION_NONE;
@@ -1036,6 +1047,67 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 { //shift octree node bounding boxes by offset
     LLSpatialShift shifter(offset);
     shifter.traverse(mOctree);
+    dirtyFlatOctree();
+}
+
+void LLSpatialPartition::refitFlatOctree(LLSpatialGroup* group)
+{
+    if (mFlatOctree && !mFlatOctreeDirty && group->mFlatIndex != LLFlatOctreeBase::NO_NODE)
+    {
+        mFlatOctree->setBounds(group->mFlatIndex, group->mBounds, group->mExtents);
+    }
+}
+
+void LLSpatialPartition::updateFlatOctree()
+{
+    if (!mFlatOctree)
+    {
+        mFlatOctree = std::make_unique<FlatOctree>();
+        mFlatOctreeDirty = true;
+    }
+
+    if (!mFlatOctreeDirty)
+    {   // rebound() has refit whatever moved
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+    mFlatOctree->build(mOctree);
+    for (U32 i = 0; i < mFlatOctree->getSlotCount(); ++i)
+    {
+        const OctreeNode* node = mFlatOctree->getNode(i);
+        if (node)
+        {
+            LLSpatialGroup* group = (LLSpatialGroup*) node->getListener(0);
+            group->mFlatIndex = i;
+            mFlatOctree->setBounds(i, group->mBounds, group->mExtents);
+        }
+    }
+    mFlatOctreeDirty = false;
+}
+
+void LLSpatialPartition::dumpScene(std::ostream& out)
+{
+    class LLOctreeDumpScene : public OctreeTraveler
+    {
+    public:
+        LLOctreeDumpScene(std::ostream& out, U32 partition) : mOut(out), mPartition(partition) {}
+
+        void visit(const OctreeNode* branch)
+        {
+            for (OctreeNode::const_element_iter i = branch->getDataBegin(); i != branch->getDataEnd(); ++i)
+            {
+                const LLVector4a& pos = (*i)->getPositionGroup();
+                mOut << mPartition << " " << pos[0] << " " << pos[1] << " " << pos[2] << " " << (*i)->getBinRadius() << "\n";
+            }
+        }
+
+        std::ostream& mOut;
+        U32 mPartition;
+    };
+
+    LLOctreeDumpScene dumper(out, mPartitionType);
+    dumper.traverse(mOctree);
 }
 
 class LLOctreeCull : public LLViewerOctreeCull
@@ -1043,6 +1115,13 @@ class LLOctreeCull : public LLViewerOctreeCull
 public:
     LLOctreeCull(LLCamera* camera) : LLViewerOctreeCull(camera) {}
 
+    // Pick the traversal up at node as if its parent had left res behind
+    void traverseFrom(const OctreeNode* node, S32 res)
+    {
+        mRes = res;
+        traverse(node);
+    }
+
     virtual bool earlyFail(LLViewerOctreeGroup* base_group)
     {
         if (LLPipeline::sReflectionRender)
@@ -1051,6 +1130,10 @@ class LLOctreeCull : public LLViewerOctreeCull
         }
 
         LLSpatialGroup* group = (LLSpatialGroup*)base_group;
+        if (gPipeline.deferCull(group, mRes))
+        {   // reading the query back needs GL, the main thread finishes this subtree
+            return true;
+        }
         group->checkOcclusion();
 
         if (group->getOctreeNode()->getParent() &&  //never occlusion cull the root node
@@ -1444,23 +1527,62 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
     ((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
 
+    if (usesFlatOctree())
+    {
+        updateFlatOctree();
+        cullFlat(camera);
+    }
+    else
+    {
+        mFlatOctree.reset();
+        cullSubtree(camera, group, 0);
+    }
+
+    return 0;
+}
+
+void LLSpatialPartition::cullFlat(LLCamera& camera)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+    // flags match the frustumCheck() of each culler
     if (LLPipeline::sShadowRender)
     {
         LLOctreeCullShadow culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseFlat(*mFlatOctree, LLFlatOctreeBase::TEST_FAR_PLANE);
     }
     else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
     {
         LLOctreeCullNoFarClip culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseFlat(*mFlatOctree, 0);
     }
     else
     {
         LLOctreeCull culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseFlat(*mFlatOctree, LLFlatOctreeBase::TEST_SPHERE);
     }
+}
 
-    return 0;
+void LLSpatialPartition::cullSubtree(LLCamera& camera, LLSpatialGroup* group, S32 res)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+    const OctreeNode* node = group->getOctreeNode();
+
+    if (LLPipeline::sShadowRender)
+    {
+        LLOctreeCullShadow culler(&camera);
+        culler.traverseFrom(node, res);
+    }
+    else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
+    {
+        LLOctreeCullNoFarClip culler(&camera);
+        culler.traverseFrom(node, res);
+    }
+    else
+    {
+        LLOctreeCull culler(&camera);
+        culler.traverseFrom(node, res);
+    }
 }
 
 void pushVerts(LLDrawInfo* params)
@@ -4205,6 +4327,45 @@ void LLCullResult::pushDrawInfo(U32 type, LLDrawInfo* draw_info)
 }
 
 
+void LLCullResult::append(LLCullResult& other)
+{
+    for (sg_iterator i = other.beginVisibleGroups(); i != other.endVisibleGroups(); ++i)
+    {
+        pushVisibleGroup(*i);
+    }
+    for (sg_iterator i = other.beginAlphaGroups(); i != other.endAlphaGroups(); ++i)
+    {
+        pushAlphaGroup(*i);
+    }
+    for (sg_iterator i = other.beginRiggedAlphaGroups(); i != other.endRiggedAlphaGroups(); ++i)
+    {
+        pushRiggedAlphaGroup(*i);
+    }
+    for (sg_iterator i = other.beginOcclusionGroups(); i != other.endOcclusionGroups(); ++i)
+    {
+        pushOcclusionGroup(*i);
+    }
+    for (sg_iterator i = other.beginDrawableGroups(); i != other.endDrawableGroups(); ++i)
+    {
+        pushDrawableGroup(*i);
+    }
+    for (drawable_iterator i = other.beginVisibleList(); i != other.endVisibleList(); ++i)
+    {
+        pushDrawable(*i);
+    }
+    for (bridge_iterator i = other.beginVisibleBridge(); i != other.endVisibleBridge(); ++i)
+    {
+        pushBridge(*i);
+    }
+    for (U32 type = 0; type < LLRenderPass::NUM_RENDER_TYPES; ++type)
+    {
+        for (drawinfo_iterator i = other.beginRenderMap(type); i != other.endRenderMap(type); ++i)
+        {
+            pushDrawInfo(type, *i);
+        }
+    }
+}
+
 void LLCullResult::assertDrawMapsEmpty()
 {
     for (U32 i = 0; i < LLRenderPass::NUM_RENDER_TYPES; i++)
@@ -55,6 +55,8 @@ class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
 class LLReflectionMap;
+class LLVOVolume;
+class LLVolume;
 
 void pushVerts(LLFace* face);
 
@@ -317,6 +319,7 @@ class LLSpatialGroup final : public LLOcclusionCullingGroup
     virtual void handleRemoval(const TreeNode* node, LLViewerOctreeEntry* face);
     virtual void handleDestruction(const TreeNode* node);
     virtual void handleChildAddition(const OctreeNode* parent, OctreeNode* child);
+    virtual void handleChildRemoval(const OctreeNode* parent, const OctreeNode* child);
 
     // LLViewerOctreeGroup
     virtual void rebound();
@@ -353,6 +356,9 @@ class LLSpatialGroup final : public LLOcclusionCullingGroup
     U32 mRenderOrder = 0;
     // Reflection Probe associated with this node (if any)
     LLPointer<LLReflectionMap> mReflectionProbe = nullptr;
+
+    // slot in the partition's flat octree, if it keeps one
+    U32 mFlatIndex = LLFlatOctreeBase::NO_NODE;
 } LL_ALIGN_POSTFIX(16);
 
 class LLGeometryManager
@@ -400,6 +406,7 @@ class LLSpatialPartition: public LLViewerOctreePartition, public LLGeometryManag
 
     BOOL visibleObjectsInFrustum(LLCamera& camera);
     /*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
+    void cullSubtree(LLCamera& camera, LLSpatialGroup* group, S32 res); // Resume a cull at group (res is the parent's frustum result)
     S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, BOOL for_select); // Cull on arbitrary frustum
 
     BOOL isVisible(const LLVector3& v);
@@ -415,6 +422,23 @@ class LLSpatialPartition: public LLViewerOctreePartition, public LLGeometryManag
 
     BOOL getVisibleExtents(LLCamera& camera, LLVector3& visMin, LLVector3& visMax);
 
+    // Flat octree culling, per partition type (see AlchemyFlatOctreePartitions)
+    bool usesFlatOctree() const { return sFlatOctreeMask & (1 << mPartitionType); }
+    void dirtyFlatOctree() { mFlatOctreeDirty = true; }
+    void refitFlatOctree(LLSpatialGroup* group);
+
+    // One "partition x y z radius" line per drawable, for the flat octree benchmark
+    void dumpScene(std::ostream& out);
+
+    static U32 sFlatOctreeMask; // bit per LLViewerRegion partition type
+
+private:
+    void updateFlatOctree();
+    void cullFlat(LLCamera& camera);
+
+    std::unique_ptr<FlatOctree> mFlatOctree;
+    bool mFlatOctreeDirty;
+
 public:
     LLSpatialBridge* mBridge; // NULL for non-LLSpatialBridge instances, otherwise, mBridge == this
                             // use a pointer instead of making "isBridge" and "asBridge" virtual so it's safe
@@ -444,6 +468,11 @@ class LLSpatialBridge : public LLDrawable, public LLSpatialPartition
     void updateSpatialExtents() override;
     void updateBinRadius() final;
     void setVisible(LLCamera& camera_in, std::vector<LLDrawable*>* results = NULL, BOOL for_select = FALSE) final;
+    // setVisible() in two halves: whether the bridge is drawn at all, which
+    // asks its avatar and must run on the main thread, and the cull of its
+    // own tree, which only touches the bridge and may run on a cull worker
+    bool isCullable();
+    void cullTree(LLCamera& camera_in, std::vector<LLDrawable*>* results = NULL, BOOL for_select = FALSE);
     void updateDistance(LLCamera& camera_in, bool force_update) final;
     void makeActive() final;
     void move(LLDrawable *drawablep, LLSpatialGroup *curp, BOOL immediate = FALSE) final;
@@ -494,6 +523,9 @@ class LLCullResult
 
     void clear();
 
+    // Push everything other holds after what is already here, in order
+    void append(LLCullResult& other);
+
     sg_iterator beginVisibleGroups();
     sg_iterator endVisibleGroups();
 
@@ -665,10 +697,25 @@ class LLVolumeGeometryManager: public LLGeometryManager
     U32 genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace** faces, U32 face_count, BOOL distance_sort = FALSE, BOOL batch_textures = FALSE, BOOL rigged = FALSE);
     void registerFace(LLSpatialGroup* group, LLFace* facep, U32 type);
 
+    // rebuildGeom() only queues face vertex generation; the queue is filled
+    // across the "GeometryRebuild" thread pool and uploaded to GL on the
+    // calling thread when the outermost batch ends (or right away outside
+    // of a batch).  Batching several groups gives the workers more to share.
+    static void initClass();
+    static void cleanupClass();
+    static void beginGeometryBatch();
+    static void endGeometryBatch();
+    static void flushGeometry();
+
 private:
     void allocateFaces(U32 pMaxFaceCount);
     void freeFaces();
 
+    static void queueBuffer(LLVertexBuffer* buffer);
+    static void queueFaceGeometry(LLFace* facep, LLVOVolume* vobj, LLVolume* volume, U32 te_idx, U16 index_offset);
+
+    static S32 sGeometryBatchDepth;
+
     static int32_t sInstanceCount;
     static LLFace** sFullbrightFaces[2];
     static LLFace** sBumpFaces[2];
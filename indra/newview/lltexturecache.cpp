@@ -31,12 +31,16 @@
 #include "llapr.h"
 #include "lldir.h"
 #include "llimage.h"
+#include "llimagedxt.h"
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
+#include "llmappedfile.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h"
+#include "llfilesystem.h"
 #include "llmemory.h"
 
 // Cache organization:
@@ -44,6 +48,8 @@
 //  Unordered array of Entry structs
 // cache/texture.cache
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
+// cache/FastCache.cache
+//  Memory mapped array of small previews, addressed by a hash of the texture id
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
 
@@ -51,12 +57,22 @@
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
 const F32 TEXTURE_CACHE_PURGE_AMOUNT = .20f; // % amount to reduce the cache by when it exceeds its limit
 const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead to regenerate)
-const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = sizeof(S32) * 4; //w, h, c, level
+const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = UUID_BYTES + sizeof(S32) * 4; //id, w, h, c, level
 const S32 TEXTURE_FAST_CACHE_DATA_SIZE = 16 * 16 * 4;
 const S32 TEXTURE_FAST_CACHE_ENTRY_SIZE = TEXTURE_FAST_CACHE_DATA_SIZE + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
+const U32 TEXTURE_FAST_CACHE_MAGIC = 0x43545346; // "FSTC"
+const U32 TEXTURE_FAST_CACHE_VERSION = 2;
+const S32 TEXTURE_FAST_CACHE_HEADER_SIZE = sizeof(U32) * 4; //magic, version, slots, entry size
+const U32 TEXTURE_FAST_CACHE_PROBES = 4; // slots a preview may land in
 const F32 TEXTURE_LAZY_PURGE_TIME_LIMIT = .004f; // 4ms. Would be better to autoadjust, but there is a major cache rework in progress.
 const F32 TEXTURE_PRUNING_MAX_TIME = 15.f;
 
+// Transcoded textures live in the asset cache under id.combine(TRANSCODED_TEXTURE_ID)
+static const LLUUID TRANSCODED_TEXTURE_ID("6d1e9c47-2b8a-4f35-a0c6-93e57f4b1d28");
+const U32 TRANSCODED_TEXTURE_MAGIC = 0x43435854; // "TXCC"
+const U32 TRANSCODED_TEXTURE_VERSION = 1;
+const S32 TRANSCODED_TEXTURE_HEADER_SIZE = sizeof(U32) * 3; //magic, version, level
+
 class LLTextureCacheWorker : public LLWorkerClass
 {
     friend class LLTextureCache;
@@ -578,7 +594,7 @@ bool LLTextureCacheRemoteWorker::doWrite()
                 // mRawImage is not entirely safe here since it is a pointer to one owned by cache worker,
                 // it could have been retrieved via getRequestFinished() and then modified.
                 // If writeToFastCache crashes, something is wrong around fetch worker.
-                if(!mCache->writeToFastCache(mID, idx, mRawImage, mRawDiscardLevel))
+                if(!mCache->writeToFastCache(mID, mRawImage, mRawDiscardLevel))
                 {
                     LL_WARNS() << "writeToFastCache failed" << LL_ENDL;
                     mDataSize = -1; // failed
@@ -797,16 +813,14 @@ LLTextureCache::LLTextureCache(bool threaded)
       mWorkersMutex(),
       mHeaderMutex(),
       mListMutex(),
-      mFastCacheMutex(),
       mHeaderAPRFile(NULL),
       mPrioritizeWriteListEmpty(true),
       mCompletedListEmpty(true),
       mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
       mTexturesSizeTotal(0),
       mDoPurge(FALSE),
-      mFastCachep(NULL),
-      mFastCachePoolp(NULL),
-      mFastCachePadBuffer(NULL)
+      mFastCache(nullptr),
+      mFastCacheLookups(0)
 {
     mHeaderAPRFilePoolp = new LLVolatileAPRPool("Texture Cache Pool"); // is_local = true, because this pool is for headers, headers are under own mutex
 }
@@ -815,10 +829,9 @@ LLTextureCache::~LLTextureCache()
 {
     clearDeleteList() ;
     writeUpdatedEntries() ;
-    delete mFastCachep;
-    delete mFastCachePoolp;
+    mFastCache = nullptr;
+    mFastCacheMaps.clear();
     delete mHeaderAPRFilePoolp;
-    ll_aligned_free_16(mFastCachePadBuffer);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1043,7 +1056,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
     purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
 
     llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
-    openFastCache(true);
+    openFastCache();
 
     return max_size; // unused cache space
 }
@@ -1621,6 +1634,12 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
     mFreeList.clear();
     mUpdatedEntryMap.clear();
 
+    // The old preview file is gone, readers move over to a fresh one
+    if (mFastCache)
+    {
+        openFastCache();
+    }
+
     // Info with 0 entries
     setEntriesHeader();
     writeEntriesHeader();
@@ -2002,65 +2021,145 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
     return handle;
 }
 
-//called in the main thread
-LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
+// Preview slots mapped from FastCache.cache.  A preview may sit in any of
+// TEXTURE_FAST_CACHE_PROBES slots after the one its id hashes to.  Each
+// slot has a sequence number in memory that writers make odd while they
+// copy a record in, so readers can copy without a lock and throw away
+// whatever changed under them.
+struct LLTextureCache::FastCacheMap
 {
-    U32 offset;
+    LLMappedFile mFile;
+    U32 mSlots = 0;
+    bool mWritable = false;
+    std::unique_ptr<std::atomic<U32>[]> mSequence;
+    // Hash of the id in each slot, zero for none.  Filled in by
+    // indexFastCache(), until then readers look at the records themselves.
+    std::unique_ptr<std::atomic<U64>[]> mKeys;
+    std::atomic<bool> mIndexed { false };
+
+    U8* getSlot(U32 slot) const
+    {
+        return mFile.getData() + TEXTURE_FAST_CACHE_HEADER_SIZE + (size_t)slot * TEXTURE_FAST_CACHE_ENTRY_SIZE;
+    }
+
+    U32 getProbeSlot(U64 key, U32 probe) const
+    {
+        return (U32)((key + probe) % mSlots);
+    }
+
+    // Copy the first size bytes of a slot, false if a writer got in the way
+    bool readSlot(U32 slot, U8* out, size_t size) const
+    {
+        U32 before = mSequence[slot].load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            return false;
+        }
+        memcpy(out, getSlot(slot), size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return mSequence[slot].load(std::memory_order_relaxed) == before;
+    }
+
+    // Writers don't wait on each other either, losing a race drops the write
+    bool claimSlot(U32 slot)
     {
-        LLMutexLock lock(&mHeaderMutex);
-        id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-        if(iter == mHeaderIDMap.end())
+        U32 sequence = mSequence[slot].load(std::memory_order_relaxed);
+        if ((sequence & 1) || !mSequence[slot].compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
         {
-            return NULL; //not in the cache
+            return false;
         }
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
 
-        offset = iter->second;
+    void releaseSlot(U32 slot)
+    {
+        mSequence[slot].fetch_add(1, std::memory_order_release);
     }
-    offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
+};
 
-    U8* data;
-    S32 head[4];
+namespace
+{
+    U64 fast_cache_key(const LLUUID& id)
     {
-        LLMutexLock lock(&mFastCacheMutex);
+        U64 key = id.getDigest64();
+        return key ? key : 1;
+    }
 
-        openFastCache();
+    // Width, height, components and discard level of a preview record
+    bool valid_fast_cache_head(const S32* head)
+    {
+        S32 image_size = head[0] * head[1] * head[2];
+        return head[0] > 0 && head[1] > 0 && head[2] > 0 && head[2] <= 4
+               && image_size <= TEXTURE_FAST_CACHE_DATA_SIZE
+               && head[3] >= 0;
+    }
+}
 
-        mFastCachep->seek(APR_SET, offset);
+//called in the main thread
+LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    FastCacheMap* map = mFastCache.load(std::memory_order_acquire);
+    if (!map || id.isNull())
+    {
+        return NULL;
+    }
+
+    U32 lookups = mFastCacheLookups.load(std::memory_order_relaxed);
+    if (lookups != U32_MAX)
+    {
+        mFastCacheLookups.store(lookups + 1, std::memory_order_relaxed);
+    }
+
+    U64 key = fast_cache_key(id);
+    bool indexed = map->mIndexed.load(std::memory_order_acquire);
+    U8 record[TEXTURE_FAST_CACHE_ENTRY_SIZE];
+    for (U32 probe = 0; probe < TEXTURE_FAST_CACHE_PROBES; ++probe)
+    {
+        U32 slot = map->getProbeSlot(key, probe);
+        if (indexed && map->mKeys[slot].load(std::memory_order_relaxed) != key)
+        {
+            continue;
+        }
+        if (!map->readSlot(slot, record, TEXTURE_FAST_CACHE_ENTRY_SIZE)
+            || memcmp(record, id.mData, UUID_BYTES) != 0)
+        {
+            continue;
+        }
 
-        if(mFastCachep->read(head, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD) != TEXTURE_FAST_CACHE_ENTRY_OVERHEAD)
+        S32 head[4];
+        memcpy(head, record + UUID_BYTES, sizeof(head));
+        if (!valid_fast_cache_head(head))
         {
-            //cache corrupted or under thread race condition
-            closeFastCache();
+            //damaged, or written by another viewer while we copied it
             return NULL;
         }
 
         S32 image_size = head[0] * head[1] * head[2];
-        if(image_size <= 0
-           || image_size > TEXTURE_FAST_CACHE_DATA_SIZE
-           || head[3] < 0) //invalid
+        U8* data = (U8*)ll_aligned_malloc_16(image_size);
+        if (!data)
         {
-            closeFastCache();
             return NULL;
         }
+        memcpy(data, record + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, image_size);
         discardlevel = head[3];
 
-        data = (U8*)ll_aligned_malloc_16(image_size);
-        if(mFastCachep->read(data, image_size) != image_size)
+        lookups = mFastCacheLookups.exchange(U32_MAX, std::memory_order_relaxed);
+        if (lookups != U32_MAX)
         {
-            ll_aligned_free_16(data);
-            closeFastCache();
-            return NULL;
+            LL_INFOS("TextureCache") << "First fast cache preview " << mFastCacheTimer.getElapsedTimeF32()
+                                     << " seconds after opening the cache, after " << lookups << " lookups" << LL_ENDL;
         }
 
-        closeFastCache();
+        return new LLImageRaw(data, head[0], head[1], head[2], true);
     }
-    LLPointer<LLImageRaw> raw = new LLImageRaw(data, head[0], head[1], head[2], true);
 
-    return raw;
+    return NULL;
 }
 
 //return the fast cache location
-bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImageRaw> raw, S32 discardlevel)
+bool LLTextureCache::writeToFastCache(const LLUUID& image_id, LLPointer<LLImageRaw> raw, S32 discardlevel)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     //rescale image if needed
@@ -2104,85 +2203,233 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
         }
     }
 
+    FastCacheMap* map = mFastCache.load(std::memory_order_acquire);
+    if (!map || !map->mWritable)
+    {
+        // Nowhere to keep previews, not an error for the caller
+        return true;
+    }
+
     //copy data
-    memcpy(mFastCachePadBuffer, &w, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32), &h, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32) * 2, &c, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32) * 3, &discardlevel, sizeof(S32));
+    U8 record[TEXTURE_FAST_CACHE_ENTRY_SIZE] = {};
+    S32 head[4] = { w, h, c, discardlevel };
+    memcpy(record, image_id.mData, UUID_BYTES);
+    memcpy(record + UUID_BYTES, head, sizeof(head));
 
     S32 copy_size = w * h * c;
     if(copy_size > 0) //valid
     {
-        copy_size = llmin(copy_size, TEXTURE_FAST_CACHE_ENTRY_SIZE - TEXTURE_FAST_CACHE_ENTRY_OVERHEAD);
-        memcpy(mFastCachePadBuffer + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, raw->getData(), copy_size);
+        copy_size = llmin(copy_size, TEXTURE_FAST_CACHE_DATA_SIZE);
+        memcpy(record + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, raw->getData(), copy_size);
     }
-    S32 offset = id * TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
+    // Replace an older preview of the same texture, else take an empty
+    // slot, else evict one picked by the id
+    U64 key = fast_cache_key(image_id);
+    U32 target = map->getProbeSlot(key, (U32)(key >> 32) % TEXTURE_FAST_CACHE_PROBES);
+    bool found_empty = false;
+    for (U32 probe = 0; probe < TEXTURE_FAST_CACHE_PROBES; ++probe)
     {
-        LLMutexLock lock(&mFastCacheMutex);
+        U32 slot = map->getProbeSlot(key, probe);
+        const U8* stored = map->getSlot(slot);
+        if (memcmp(stored, image_id.mData, UUID_BYTES) == 0)
+        {
+            target = slot;
+            break;
+        }
+        if (!found_empty && memcmp(stored, LLUUID::null.mData, UUID_BYTES) == 0)
+        {
+            target = slot;
+            found_empty = true;
+        }
+    }
 
-        openFastCache();
+    if (map->claimSlot(target))
+    {
+        memcpy(map->getSlot(target), record, TEXTURE_FAST_CACHE_ENTRY_SIZE);
+        map->mKeys[target].store(key, std::memory_order_relaxed);
+        map->releaseSlot(target);
+    }
+    // else another thread is writing that slot right now, this preview can wait
 
-        mFastCachep->seek(APR_SET, offset);
+    return true;
+}
 
-        //no need to do this assertion check. When it fails, let it fail quietly.
-        //this failure could happen because other viewer removes the fast cache file when clearing cache.
-        //--> llassert_always(mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE) == TEXTURE_FAST_CACHE_ENTRY_SIZE);
-        mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE);
+//static
+LLPointer<LLImageDXT> LLTextureCache::readTranscoded(const LLUUID& id, S32& discardlevel)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    LLFileSystem file(id.combine(TRANSCODED_TEXTURE_ID), LLAssetType::AT_TEXTURE, LLFileSystem::READ);
+    S32 size = file.getSize();
+    S32 data_size = size - TRANSCODED_TEXTURE_HEADER_SIZE;
+    if (data_size <= (S32)sizeof(LLImageDXT::dxtfile_header_t))
+    {
+        return NULL; //not in the cache
+    }
 
-        closeFastCache(true);
+    U32 head[3];
+    if (!file.read((U8*)head, TRANSCODED_TEXTURE_HEADER_SIZE)
+        || head[0] != TRANSCODED_TEXTURE_MAGIC
+        || head[1] != TRANSCODED_TEXTURE_VERSION
+        || head[2] > (U32)MAX_DISCARD_LEVEL)
+    {
+        return NULL;
     }
 
-    return true;
+    U8* data = (U8*)ll_aligned_malloc_16(data_size);
+    if (!data)
+    {
+        return NULL;
+    }
+    if (!file.read(data, data_size))
+    {
+        ll_aligned_free_16(data);
+        return NULL;
+    }
+
+    // Only ever written by writeTranscoded(), anything else is damage
+    const LLImageDXT::dxtfile_header_t* header = (const LLImageDXT::dxtfile_header_t*)data;
+    LLImageDXT::EFileFormat format = LLImageDXT::getFormat(header->pixel_fmt.fourcc);
+    if (header->fourcc != 0x20534444
+        || (format != LLImageDXT::FORMAT_DXR1 && format != LLImageDXT::FORMAT_DXR5)
+        || header->maxwidth < 1 || header->maxwidth > MAX_IMAGE_SIZE
+        || header->maxheight < 1 || header->maxheight > MAX_IMAGE_SIZE
+        || header->num_mips != LLImageDXT::calcNumMips(header->maxwidth, header->maxheight))
+    {
+        ll_aligned_free_16(data);
+        return NULL;
+    }
+
+    LLPointer<LLImageDXT> image = new LLImageDXT();
+    image->setData(data, data_size);
+    if (!image->updateData() || image->calcDataSize(0) != data_size)
+    {
+        return NULL;
+    }
+
+    discardlevel = head[2];
+    return image;
 }
 
-void LLTextureCache::openFastCache(bool first_time)
+//static
+bool LLTextureCache::writeTranscoded(const LLUUID& id, LLImageDXT* image, S32 discardlevel)
 {
-    if(!mFastCachep)
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (!image || !image->isCompressed() || discardlevel < 0 || discardlevel > MAX_DISCARD_LEVEL)
     {
-        if(first_time)
+        return false;
+    }
+
+    U32 head[3] = { TRANSCODED_TEXTURE_MAGIC, TRANSCODED_TEXTURE_VERSION, (U32)discardlevel };
+    std::vector<U8> buffer(TRANSCODED_TEXTURE_HEADER_SIZE + image->getDataSize());
+    memcpy(buffer.data(), head, TRANSCODED_TEXTURE_HEADER_SIZE);
+    memcpy(buffer.data() + TRANSCODED_TEXTURE_HEADER_SIZE, image->getData(), image->getDataSize());
+
+    LLFileSystem file(id.combine(TRANSCODED_TEXTURE_ID), LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
+    return file.write(buffer.data(), (S32)buffer.size());
+}
+
+// Called from initCache(), and with mHeaderMutex held by purgeAllTextures()
+void LLTextureCache::openFastCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const U32 head[4] = { TEXTURE_FAST_CACHE_MAGIC, TEXTURE_FAST_CACHE_VERSION, sCacheMaxEntries, TEXTURE_FAST_CACHE_ENTRY_SIZE };
+
+    std::shared_ptr<FastCacheMap> map = std::make_shared<FastCacheMap>();
+    U32 slots = 0;
+    if (mReadOnly)
+    {
+        // Use what the viewer owning the cache left, as it is
+        if (map->mFile.open(mFastCacheFileName, LLMappedFile::READ_ONLY)
+            && map->mFile.getSize() >= (size_t)TEXTURE_FAST_CACHE_HEADER_SIZE)
         {
-            if(!mFastCachePadBuffer)
-            {
-                mFastCachePadBuffer = (U8*)ll_aligned_malloc_16(TEXTURE_FAST_CACHE_ENTRY_SIZE);
-            }
-            mFastCachePoolp = new LLVolatileAPRPool("Fast Cache Pool", FALSE); // is_local=false, thread safe mode due to crashes
-            if (LLAPRFile::isExist(mFastCacheFileName, mFastCachePoolp))
+            U32 file_head[4];
+            memcpy(file_head, map->mFile.getData(), sizeof(file_head));
+            if (file_head[0] == head[0] && file_head[1] == head[1] && file_head[3] == head[3]
+                && map->mFile.getSize() >= TEXTURE_FAST_CACHE_HEADER_SIZE + (size_t)file_head[2] * TEXTURE_FAST_CACHE_ENTRY_SIZE)
             {
-                mFastCachep = new LLAPRFile(mFastCacheFileName, APR_READ|APR_WRITE|APR_BINARY, mFastCachePoolp) ;
+                slots = file_head[2];
             }
-            else
+        }
+    }
+    else
+    {
+        size_t size = TEXTURE_FAST_CACHE_HEADER_SIZE + (size_t)sCacheMaxEntries * TEXTURE_FAST_CACHE_ENTRY_SIZE;
+        if (map->mFile.open(mFastCacheFileName, LLMappedFile::READ_WRITE, size)
+            && memcmp(map->mFile.getData(), head, sizeof(head)) != 0)
+        {
+            // New, or laid out for another version or cache size: start
+            // over from an empty file rather than clear it page by page
+            map->mFile.close();
+            LLFile::remove(mFastCacheFileName);
+            if (map->mFile.open(mFastCacheFileName, LLMappedFile::READ_WRITE, size))
             {
-                mFastCachep = new LLAPRFile(mFastCacheFileName, APR_CREATE|APR_READ|APR_WRITE|APR_BINARY, mFastCachePoolp) ;
+                memcpy(map->mFile.getData(), head, sizeof(head));
             }
         }
-        else
+        if (map->mFile.isOpen())
         {
-            mFastCachep = new LLAPRFile(mFastCacheFileName, APR_READ|APR_WRITE|APR_BINARY, mFastCachePoolp) ;
+            slots = sCacheMaxEntries;
+            map->mWritable = true;
         }
+    }
 
-        mFastCacheTimer.reset();
+    if (!slots)
+    {
+        LL_WARNS("TextureCache") << "Could not map the fast cache " << mFastCacheFileName << LL_ENDL;
+        return;
     }
-    return;
-}
 
-void LLTextureCache::closeFastCache(bool forced)
-{
-    static const F32 timeout = 10.f ; //seconds
+    map->mSlots = slots;
+    map->mSequence.reset(new std::atomic<U32>[slots]());
+    map->mKeys.reset(new std::atomic<U64>[slots]());
+
+    mFastCacheMaps.push_back(map);
+    mFastCache.store(map.get(), std::memory_order_release);
+    mFastCacheTimer.reset();
+    mFastCacheLookups = 0;
 
-    if(!mFastCachep)
+    // Readers check the in memory keys once they are known, so misses
+    // stop touching the file
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!general_queue || !general_queue->post([map]() { indexFastCache(map); }))
     {
-        return ;
+        LL_WARNS("TextureCache") << "Could not index the fast cache in the background" << LL_ENDL;
     }
+}
 
-    if(!forced && mFastCacheTimer.getElapsedTimeF32() < timeout)
+//static
+void LLTextureCache::indexFastCache(std::shared_ptr<FastCacheMap> map)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    LLTimer timer;
+    U32 previews = 0;
+    U8 record[TEXTURE_FAST_CACHE_ENTRY_OVERHEAD];
+    for (U32 slot = 0; slot < map->mSlots; ++slot)
     {
-        return ;
+        if (!map->readSlot(slot, record, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD))
+        {
+            continue; // being written, the writer sets its key
+        }
+
+        LLUUID id;
+        S32 head[4];
+        memcpy(id.mData, record, UUID_BYTES);
+        memcpy(head, record + UUID_BYTES, sizeof(head));
+        if (id.isNull() || !valid_fast_cache_head(head))
+        {
+            continue;
+        }
+
+        // A writer that got there first knows better
+        U64 none = 0;
+        map->mKeys[slot].compare_exchange_strong(none, fast_cache_key(id), std::memory_order_relaxed);
+        ++previews;
     }
+    map->mIndexed.store(true, std::memory_order_release);
 
-    delete mFastCachep;
-    mFastCachep = NULL;
-    return;
+    LL_INFOS("TextureCache") << "Indexed " << previews << " fast cache previews in " << map->mSlots
+                             << " slots in " << timer.getElapsedTimeF32() << " seconds" << LL_ENDL;
 }
 
 bool LLTextureCache::writeComplete(handle_t handle, bool abort)
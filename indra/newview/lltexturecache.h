@@ -36,6 +36,10 @@
 
 #include <boost/unordered/unordered_flat_map.hpp>
 
+#include <atomic>
+#include <memory>
+
+class LLImageDXT;
 class LLImageFormatted;
 class LLTextureCacheWorker;
 class LLImageRaw;
@@ -129,7 +133,14 @@ class LLTextureCache final : public LLWorkerThread
     bool readComplete(handle_t handle, bool abort);
     handle_t writeToCache(const LLUUID& id, U8* data, S32 datasize, S32 imagesize, LLPointer<LLImageRaw> rawimage, S32 discardlevel,
                           WriteResponder* responder);
+    // Small preview of id from the fast cache.  Lock free, reads never
+    // wait on writers or on the header mutex.
     LLPointer<LLImageRaw> readFromFastCache(const LLUUID& id, S32& discardlevel);
+
+    // Block compressed copies of decoded textures, kept in the asset disk
+    // cache so they share its budget and eviction.  Safe on any thread.
+    static LLPointer<LLImageDXT> readTranscoded(const LLUUID& id, S32& discardlevel);
+    static bool writeTranscoded(const LLUUID& id, LLImageDXT* image, S32 discardlevel);
     bool writeComplete(handle_t handle, bool abort = false);
     void prioritizeWrite(handle_t handle);
 
@@ -188,18 +199,17 @@ class LLTextureCache final : public LLWorkerThread
     void lockHeaders() { mHeaderMutex.lock(); }
     void unlockHeaders() { mHeaderMutex.unlock(); }
 
-    void openFastCache(bool first_time = false);
-    void closeFastCache(bool forced = false);
-    bool writeToFastCache(LLUUID image_id, S32 cache_id, LLPointer<LLImageRaw> raw, S32 discardlevel);
+    struct FastCacheMap;
+    void openFastCache();
+    bool writeToFastCache(const LLUUID& image_id, LLPointer<LLImageRaw> raw, S32 discardlevel);
+    static void indexFastCache(std::shared_ptr<FastCacheMap> map);
 
 private:
     // Internal
     LLMutex mWorkersMutex;
     LLMutex mHeaderMutex;
     LLMutex mListMutex;
-    LLMutex mFastCacheMutex;
     LLAPRFile* mHeaderAPRFile;
-    LLVolatileAPRPool* mFastCachePoolp;
 
     // mLocalAPRFilePoolp is not thread safe and is meant only for workers
     // howhever mHeaderEntriesFileName is accessed not from workers' threads
@@ -230,9 +240,12 @@ class LLTextureCache final : public LLWorkerThread
     typedef boost::unordered_flat_map<LLUUID, S32> id_map_t;
     id_map_t mHeaderIDMap;
 
-    LLAPRFile*   mFastCachep;
-    LLFrameTimer mFastCacheTimer;
-    U8*          mFastCachePadBuffer;
+    // Mapping readers use.  Mappings replaced by a purge stay alive in
+    // mFastCacheMaps until shutdown since readers hold no lock.
+    std::atomic<FastCacheMap*> mFastCache;
+    std::vector<std::shared_ptr<FastCacheMap> > mFastCacheMaps;
+    LLTimer mFastCacheTimer;                // since the mapping was opened
+    std::atomic<U32> mFastCacheLookups;     // until the first preview is found
 
     // BODIES (TEXTURES minus headers)
     std::string mTexturesDirName;
@@ -70,6 +70,8 @@ LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture_decode_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheWriteLatency("texture_write_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFetchLatency("texture_fetch_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFirstDiscardTime("texture_first_discard_time");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFullResTime("texture_full_res_time");
 
 LLTextureFetchTester* LLTextureFetch::sTesterp = NULL ;
 const std::string sTesterName("TextureFetchTester");
@@ -362,16 +364,6 @@ class LLTextureFetchWorker : public LLWorkerClass, public LLCore::HttpHandler
         LLUUID mID;
     };
 
-    struct Compare
-    {
-        // lhs < rhs
-        bool operator()(const LLTextureFetchWorker* lhs, const LLTextureFetchWorker* rhs) const
-        {
-            // greater priority is "less"
-            return lhs->mImagePriority > rhs->mImagePriority;
-        }
-    };
-
 public:
 
     // Threads:  Ttf
@@ -487,6 +479,12 @@ class LLTextureFetchWorker : public LLWorkerClass, public LLCore::HttpHandler
     // Threads:  Ttf
     void recordTextureDone(bool is_http, F64 byte_count);
 
+    // Sample time-to-first-discard and time-to-full-res the first time
+    // the requester gets a discard level at all and discard level 0.
+    // Threads:  Tmain
+    // Locks:  Mw
+    void recordDiscardDelivered(S32 discard);
+
     void lockWorkMutex() { mWorkMutex.lock(); }
     void unlockWorkMutex() { mWorkMutex.unlock(); }
 
@@ -618,6 +616,11 @@ class LLTextureFetchWorker : public LLWorkerClass, public LLCore::HttpHandler
     U32                     mHttpReplySize,             // Actual received data size
                             mHttpReplyOffset;           // Actual received data offset
     bool                    mHttpHasResource;           // Counts against Fetcher's mHttpSemaphore
+    bool                    mHttpPreempted;             // Active request canceled by preemptHttpRequests()
+
+    LLTimer                 mRequestLifeTimer;          // Since the worker was created
+    bool                    mFirstDiscardDelivered,
+                            mFullResDelivered;
 
     // State history
     U32                     mCacheReadCount,
@@ -934,6 +937,9 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mHttpReplySize(0U),
       mHttpReplyOffset(0U),
       mHttpHasResource(false),
+      mHttpPreempted(false),
+      mFirstDiscardDelivered(false),
+      mFullResDelivered(false),
       mCacheReadCount(0U),
       mCacheWriteCount(0U),
       mResourceWaitCount(0U),
@@ -1040,6 +1046,26 @@ void LLTextureFetchWorker::setImagePriority(F32 priority)
     mImagePriority = priority; //should map to max virtual size, abort if zero
 }
 
+// Threads:  Tmain
+// Locks:  Mw
+void LLTextureFetchWorker::recordDiscardDelivered(S32 discard)
+{
+    if (discard < 0)
+    {
+        return;
+    }
+    if (!mFirstDiscardDelivered)
+    {
+        mFirstDiscardDelivered = true;
+        sample(LLTextureFetch::sTexFirstDiscardTime, F32Seconds(mRequestLifeTimer.getElapsedTimeF32()));
+    }
+    if (discard == 0 && !mFullResDelivered)
+    {
+        mFullResDelivered = true;
+        sample(LLTextureFetch::sTexFullResTime, F32Seconds(mRequestLifeTimer.getElapsedTimeF32()));
+    }
+}
+
 // Locks:  Mw
 void LLTextureFetchWorker::resetFormattedData()
 {
@@ -1399,7 +1425,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
             (mFetcher->getHttpWaitersCount() || ! acquireHttpSemaphore()))
         {
             setState(WAIT_HTTP_RESOURCE2);
-            mFetcher->addHttpWaiter(this->mID);
+            mFetcher->addHttpWaiter(this->mID, mImagePriority);
             ++mResourceWaitCount;
             return false;
         }
@@ -1814,6 +1840,20 @@ bool LLTextureFetchWorker::doWork(S32 param)
 #endif
             return true;
         }
+        if (mFirstDiscardDelivered && !mHaveAllData && mLoadedDiscard > mDesiredDiscard &&
+            mCanUseCapability && mCanUseHTTP && !mUrl.empty() && mUrl.compare(0, 7, "file://") != 0)
+        {
+            // The texture already shows an earlier level and a finer one
+            // was asked for while these bytes came in.  Decoding them now
+            // would be thrown away as soon as the rest arrives, fetch it
+            // first.
+#ifdef SHOW_DEBUG
+            LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE skipped: loaded discard " << mLoadedDiscard
+                               << " desired discard " << mDesiredDiscard << LL_ENDL;
+#endif
+            setState(LOAD_FROM_NETWORK);
+            return false;
+        }
         mDecodeTimer.reset();
         mRawImage = NULL;
         mAuxImage = NULL;
@@ -1831,7 +1871,8 @@ bool LLTextureFetchWorker::doWork(S32 param)
         mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage,
                                                                        discard,
                                                                        mNeedsAux,
-                                                                       new DecodeResponder(mFetcher, mID, this));
+                                                                       new DecodeResponder(mFetcher, mID, this),
+                                                                       mID);
         if (mDecodeHandle == 0)
         {
             // Abort, failed to put into queue.
@@ -1990,6 +2031,22 @@ void LLTextureFetchWorker::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRe
 
     mHttpActive = false;
 
+    if (mHttpPreempted)
+    {
+        mHttpPreempted = false;
+        if (response->getStatus() == LLCore::HttpStatus(LLCore::HttpStatus::LLCORE, LLCore::HE_OP_CANCELED))
+        {
+            // Gave up our slot to a more important texture, queue up
+            // for another one.  Nothing was received so there is
+            // nothing to keep.
+            mFetcher->removeFromHTTPQueue(mID, S32Bytes(0));
+            releaseHttpSemaphore();
+            setState(LOAD_FROM_NETWORK);
+            return;
+        }
+        // else the request finished before the cancel got to it
+    }
+
 #ifndef LL_RELEASE_FOR_DOWNLOAD
     if (log_to_viewer_log || log_to_sim)
     {
@@ -2496,6 +2553,7 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
       mTotalCacheReadCount(0U),
       mTotalCacheWriteCount(0U),
       mTotalResourceWaitCount(0U),
+      mTotalPreemptCount(0U),
       mFetchSource(LLTextureFetch::FROM_ALL),
       mOriginFetchSource(LLTextureFetch::FROM_ALL)
 #ifndef LL_RELEASE_FOR_DOWNLOAD
@@ -2648,6 +2706,7 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
         worker->setImagePriority(priority);
         worker->setDesiredDiscard(desired_discard, desired_size);
         worker->setCanUseHTTP(can_use_http);
+        updateHttpWaiter(id, priority);
 
         //MAINT-4184 url is always empty.  Do not set with it.
 
@@ -2874,6 +2933,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
             logged_state_timers = worker->mStateTimersMap;
             skipped_states_time = worker->mSkippedStatesTime;
             worker->mStateTimer.reset();
+            worker->recordDiscardDelivered(discard_level);
             res = true;
 #ifdef SHOW_DEBUG
             LL_DEBUGS(LOG_TXT) << id << ": Request Finished. State: " << worker->mState << " Discard: " << discard_level << LL_ENDL;
@@ -2908,6 +2968,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
                 discard_level = worker->mDecodedDiscard;
                 raw = worker->mRawImage;
                 aux = worker->mAuxImage;
+                worker->recordDiscardDelivered(discard_level);
             }
             worker->unlockWorkMutex();                                  // -Mw
         }
@@ -2931,6 +2992,7 @@ bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
                 worker->lockWorkMutex();                                        // +Mw
                 worker->setImagePriority(priority);
                 worker->unlockWorkMutex();                                      // -Mw
+                updateHttpWaiter(id, priority);
             }
         });
 
@@ -3283,12 +3345,10 @@ void LLTextureFetch::dump()
     }
 
     LL_INFOS(LOG_TXT) << "LLTextureFetch WAIT_HTTP_RESOURCE:" << LL_ENDL;
-    for (wait_http_res_queue_t::const_iterator iter(mHttpWaitResource.begin());
-         mHttpWaitResource.end() != iter;
-         ++iter)
-    {
-        LL_INFOS(LOG_TXT) << " ID: " << (*iter) << LL_ENDL;
-    }
+    mHttpWaitResource.visitTop(mHttpWaitResource.size(), [](const LLUUID& id, F32 priority)
+        {
+            LL_INFOS(LOG_TXT) << " ID: " << id << " Priority: " << priority << LL_ENDL;
+        });
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3296,10 +3356,10 @@ void LLTextureFetch::dump()
 // HTTP Resource Waiting Methods
 
 // Threads:  Ttf
-void LLTextureFetch::addHttpWaiter(const LLUUID & tid)
+void LLTextureFetch::addHttpWaiter(const LLUUID & tid, F32 priority)
 {
     mNetworkQueueMutex.lock();                                          // +Mfnq
-    mHttpWaitResource.insert(tid);
+    mHttpWaitResource.set(tid, priority);
     mNetworkQueueMutex.unlock();                                        // -Mfnq
 }
 
@@ -3307,11 +3367,15 @@ void LLTextureFetch::addHttpWaiter(const LLUUID & tid)
 void LLTextureFetch::removeHttpWaiter(const LLUUID & tid)
 {
     mNetworkQueueMutex.lock();                                          // +Mfnq
-    wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-    if (mHttpWaitResource.end() != iter)
-    {
-        mHttpWaitResource.erase(iter);
-    }
+    mHttpWaitResource.erase(tid);
+    mNetworkQueueMutex.unlock();                                        // -Mfnq
+}
+
+// Threads:  T*
+void LLTextureFetch::updateHttpWaiter(const LLUUID & tid, F32 priority)
+{
+    mNetworkQueueMutex.lock();                                          // +Mfnq
+    mHttpWaitResource.update(tid, priority);
     mNetworkQueueMutex.unlock();                                        // -Mfnq
 }
 
@@ -3319,8 +3383,7 @@ void LLTextureFetch::removeHttpWaiter(const LLUUID & tid)
 bool LLTextureFetch::isHttpWaiter(const LLUUID & tid)
 {
     mNetworkQueueMutex.lock();                                          // +Mfnq
-    wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-    const bool ret(mHttpWaitResource.end() != iter);
+    const bool ret(mHttpWaitResource.contains(tid));
     mNetworkQueueMutex.unlock();                                        // -Mfnq
     return ret;
 }
@@ -3328,13 +3391,11 @@ bool LLTextureFetch::isHttpWaiter(const LLUUID & tid)
 // Release as many requests as permitted from the WAIT_HTTP_RESOURCE2
 // state to the SEND_HTTP_REQ state based on their current priority.
 //
-// This data structures and code associated with this looks a bit
-// indirect and naive but it's done in the name of safety.  An
-// ordered container may become invalid from time to time due to
-// priority changes caused by actions in other threads.  State itself
-// could also suffer the same fate with canceled operations.  Even
-// done this way, I'm not fully trusting we're truly safe.  This
-// module is due for a major refactoring and we'll deal with it then.
+// The waiters are kept in priority order by mHttpWaitResource, which
+// priority changes from other threads update in place under Mfnq, so
+// the best ones can be picked without a sort.  Picked waiters stay in
+// the heap until they've been released so that deleteOK() keeps their
+// workers alive while we look at them.
 //
 // Threads:  Ttf
 // Locks:  -Mw (must not hold any worker when called)
@@ -3344,7 +3405,10 @@ void LLTextureFetch::releaseHttpWaiters()
     // Use mHttpSemaphore rather than mHTTPTextureQueue.size()
     // to avoid a lock.
     if (mHttpSemaphore >= mHttpLowWater)
+    {
+        preemptHttpRequests();
         return;
+    }
     S32 needed(mHttpHighWater - mHttpSemaphore);
     if (needed <= 0)
     {
@@ -3354,8 +3418,8 @@ void LLTextureFetch::releaseHttpWaiters()
         return;
     }
 
-    // Quickly make a copy of all the LLUIDs.  Get off the
-    // mutex as early as possible.
+    // Quickly copy the best LLUIDs, highest priority first.
+    // Get off the mutex as early as possible.
     typedef std::vector<LLUUID> uuid_vec_t;
     uuid_vec_t tids;
 
@@ -3364,17 +3428,14 @@ void LLTextureFetch::releaseHttpWaiters()
 
         if (mHttpWaitResource.empty())
             return;
-        tids.reserve(mHttpWaitResource.size());
-        tids.assign(mHttpWaitResource.begin(), mHttpWaitResource.end());
+        tids.reserve(needed);
+        mHttpWaitResource.visitTop(needed, [&tids](const LLUUID& tid, F32)
+            {
+                tids.push_back(tid);
+            });
     }                                                                   // -Mfnq
 
-    // Now lookup the UUUIDs to find valid requests and sort
-    // them in priority order, highest to lowest.  We're going
-    // to modify priority later as a side-effect of releasing
-    // these objects.  That, in turn, would violate the partial
-    // ordering assumption of std::set, std::map, etc. so we
-    // don't use those containers.  We use a vector and an explicit
-    // sort to keep the containers valid later.
+    // Now lookup the UUUIDs to find valid requests.
     typedef std::vector<LLTextureFetchWorker *> worker_list_t;
     worker_list_t tids2;
 
@@ -3400,13 +3461,6 @@ void LLTextureFetch::releaseHttpWaiters()
     }
     tids.clear();
 
-    // Sort into priority order, if necessary and only as much as needed
-    if (tids2.size() > needed)
-    {
-        LLTextureFetchWorker::Compare compare;
-        std::partial_sort(tids2.begin(), tids2.begin() + needed, tids2.end(), compare);
-    }
-
     // Release workers up to the high water mark.  Since we aren't
     // holding any locks at this point, we can be in competition
     // with other callers.  Do defensive things like getting
@@ -3443,6 +3497,57 @@ void LLTextureFetch::releaseHttpWaiters()
     }
 }
 
+// Threads:  Ttf
+// Locks:  -Mw (must not hold any worker when called)
+void LLTextureFetch::preemptHttpRequests()
+{
+    LL_PROFILE_ZONE_SCOPED;
+    static LLCachedControl<F32> preempt_ratio(gSavedSettings, "AlchemyTextureFetchPreemptRatio", 8.f);
+    if (preempt_ratio < 1.f || mHttpSemaphore < mHttpHighWater)
+    {
+        return;
+    }
+
+    F32 best_waiter(0.f);
+    std::vector<LLUUID> active;
+    {
+        LLMutexLock lock(&mNetworkQueueMutex);                          // +Mfnq
+
+        if (mHttpWaitResource.empty())
+            return;
+        best_waiter = mHttpWaitResource.topPriority();
+        active.assign(mHTTPTextureQueue.begin(), mHTTPTextureQueue.end());
+    }                                                                   // -Mfnq
+
+    // Find the least important request on the wire.  Server bakes
+    // have their own retry policy, leave them alone.
+    LLTextureFetchWorker * victim(NULL);
+    F32 victim_priority(best_waiter / preempt_ratio);
+    for (const LLUUID & tid : active)
+    {
+        LLTextureFetchWorker * worker(getWorker(tid));
+        if (worker && worker->mFTType != FTT_SERVER_BAKE && worker->getImagePriority() < victim_priority)
+        {
+            victim = worker;
+            victim_priority = worker->getImagePriority();
+        }
+    }
+    if (!victim)
+    {
+        return;
+    }
+
+    // One at a time, the slot comes back through onCompleted()
+    victim->lockWorkMutex();                                            // +Mw
+    if (LLTextureFetchWorker::WAIT_HTTP_REQ == victim->mState && victim->mHttpActive && !victim->mHttpPreempted)
+    {
+        victim->mHttpPreempted = true;
+        mHttpRequest->requestCancel(victim->mHttpHandle, LLCore::HttpHandler::ptr_t());
+        ++mTotalPreemptCount;
+    }
+    victim->unlockWorkMutex();                                          // -Mw
+}
+
 // Threads:  T*
 void LLTextureFetch::cancelHttpWaiters()
 {
@@ -32,6 +32,7 @@
 
 #include "lldir.h"
 #include "llimage.h"
+#include "llindexedheap.h"
 #include "lluuid.h"
 #include "llworkerthread.h"
 #include "lltextureinfo.h"
@@ -184,11 +185,17 @@ class LLTextureFetch final : public LLWorkerThread
     // HTTP resource waiting methods
 
     // Threads:  T*
-    void addHttpWaiter(const LLUUID & tid);
+    void addHttpWaiter(const LLUUID & tid, F32 priority);
 
     // Threads:  T*
     void removeHttpWaiter(const LLUUID & tid);
 
+    // Move a waiting request to its place for a new priority.
+    // No-op for requests which aren't waiting.
+    //
+    // Threads:  T*
+    void updateHttpWaiter(const LLUUID & tid, F32 priority);
+
     // Threads:  T*
     bool isHttpWaiter(const LLUUID & tid);
 
@@ -204,6 +211,15 @@ class LLTextureFetch final : public LLWorkerThread
     // Locks:  -Mw (must not hold any worker when called)
     void releaseHttpWaiters();
 
+    // With every HTTP slot taken, cancel the least important request
+    // in flight when the best waiter is AlchemyTextureFetchPreemptRatio
+    // times more important.  The canceled worker goes back to waiting
+    // for a slot with whatever data it already has.
+    //
+    // Threads:  Ttf
+    // Locks:  -Mw (must not hold any worker when called)
+    void preemptHttpRequests();
+
     // Threads:  T*
     void cancelHttpWaiters();
 
@@ -220,6 +236,10 @@ class LLTextureFetch final : public LLWorkerThread
     // Threads:  T*
     void getStateStats(U32 * cache_read, U32 * cache_write, U32 * res_wait);
 
+    // Number of in-flight requests canceled to make room for better ones
+    // Threads:  T*
+    U32 getPreemptCount() const { return mTotalPreemptCount; }
+
     // ----------------------------------
 
 protected:
@@ -302,6 +322,8 @@ class LLTextureFetch final : public LLWorkerThread
     static LLTrace::SampleStatHandle<F32Seconds> sTexDecodeLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sCacheWriteLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sTexFetchLatency;
+    static LLTrace::SampleStatHandle<F32Seconds> sTexFirstDiscardTime;  // request to first usable image
+    static LLTrace::SampleStatHandle<F32Seconds> sTexFullResTime;       // request to discard level 0
     static LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > sCacheHitRate;
 
 private:
@@ -369,7 +391,9 @@ class LLTextureFetch final : public LLWorkerThread
     // exceed the high water level (but not go below zero).
     LLAtomicS32                         mHttpSemaphore;                 // Ttf
 
-    typedef std::set<LLUUID> wait_http_res_queue_t;
+    // Keyed by texture, ordered by image priority so that releasing
+    // waiters and priority changes don't have to sort every waiter.
+    typedef LLIndexedHeap<LLUUID, F32> wait_http_res_queue_t;
     wait_http_res_queue_t               mHttpWaitResource;              // Mfnq
 
     // Cumulative stats on the states/requests issued by
@@ -377,6 +401,7 @@ class LLTextureFetch final : public LLWorkerThread
     U32 mTotalCacheReadCount;                                           // Mfq
     U32 mTotalCacheWriteCount;                                          // Mfq
     U32 mTotalResourceWaitCount;                                        // Mfq
+    std::atomic<U32> mTotalPreemptCount;                                // <none>
 
 public:
     // A probabilistically-correct indicator that the current
@@ -36,6 +36,7 @@
 #include "llui.h"
 #include "llimageworker.h"
 #include "llrender.h"
+#include "llvertexbuffer.h"
 
 #include "lltooltip.h"
 #include "llappviewer.h"
@@ -527,10 +528,22 @@ void LLGLTexMemBar::draw()
     U32 texFetchLatMed = U32(recording.getMean(LLTextureFetch::sTexFetchLatency).value() * 1000.0f);
     U32 texFetchLatMax = U32(recording.getMax(LLTextureFetch::sTexFetchLatency).value() * 1000.0f);
 
-    text = llformat("GL Free: %d MB Sys Free: %d MB FBO: %d MB Bias: %.2f Cache: %.1f/%.1f MB",
+    U32 texFirstDiscardMed = U32(recording.getMean(LLTextureFetch::sTexFirstDiscardTime).value() * 1000.0f);
+    U32 texFullResMed = U32(recording.getMean(LLTextureFetch::sTexFullResTime).value() * 1000.0f);
+
+    LLVertexBuffer::PoolStats vbo_stats;
+    LLVertexBuffer::getPoolStats(vbo_stats);
+    // share of the arena pages claimed by size classes that holds no buffer data
+    U32 vbo_frag = (U32) (((vbo_stats.mPageBytes - vbo_stats.mRequestedBytes) * 100) / llmax(vbo_stats.mPageBytes, (U64) 1));
+
+    text = llformat("GL Free: %d MB Sys Free: %d MB FBO: %d MB VBO: %d+%d/%d MB (%d%% frag) Bias: %.2f Cache: %.1f/%.1f MB",
                     gViewerWindow->getWindow()->getAvailableVRAMMegabytes(),
                     LLMemory::getAvailableMemKB()/1024,
                     LLRenderTarget::sBytesAllocated/(1024*1024),
+                    (S32) (vbo_stats.mPoolBytes / (1024 * 1024)),
+                    (S32) (vbo_stats.mSlotBytes / (1024 * 1024)),
+                    (S32) (vbo_stats.mArenaBytes / (1024 * 1024)),
+                    vbo_frag,
                     discard_bias,
                     cache_usage,
                     cache_max_usage);
@@ -542,7 +555,7 @@ void LLGLTexMemBar::draw()
     U32 cache_read(0U), cache_write(0U), res_wait(0U);
     LLAppViewer::getTextureFetch()->getStateStats(&cache_read, &cache_write, &res_wait);
 
-    text = llformat("Net Tot Tex: %.1f MB Tot Obj: %.1f MB #Objs/#Cached: %d/%d Tot Htp: %d Cread: %u Cwrite: %u Rwait: %u",
+    text = llformat("Net Tot Tex: %.1f MB Tot Obj: %.1f MB #Objs/#Cached: %d/%d Tot Htp: %d Cread: %u Cwrite: %u Rwait: %u Preempt: %u",
                     total_texture_downloaded.valueInUnits<LLUnits::Megabytes>(),
                     total_object_downloaded.valueInUnits<LLUnits::Megabytes>(),
                     total_objects,
@@ -550,12 +563,13 @@ void LLGLTexMemBar::draw()
                     total_http_requests,
                     cache_read,
                     cache_write,
-                    res_wait);
+                    res_wait,
+                    LLAppViewer::getTextureFetch()->getPreemptCount());
 
     LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*5,
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
-    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
+    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d First/Full: %d/%d",
                     cacheHitRate,
                     cacheReadLatMin,
                     cacheReadLatMed,
@@ -565,7 +579,9 @@ void LLGLTexMemBar::draw()
                     texDecodeLatMax,
                     texFetchLatMin,
                     texFetchLatMed,
-                    texFetchLatMax);
+                    texFetchLatMax,
+                    texFirstDiscardMed,
+                    texFullResMed);
 
     LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*4,
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -563,6 +563,9 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
     stop_glerror();
 
     LLImageGL::updateStats(gFrameTimeSeconds);
+    LLImageGL::updateUploads();
+    LLVertexBuffer::updateClass();
+    LLSkinningUtil::updateMatrixPalettes();
 
     static const LLCachedControl<S32> av_name_tag_mode(gSavedSettings, "AvatarNameTagMode");
     static const LLCachedControl<bool> name_tag_show_grp_title(gSavedSettings, "NameTagShowGroupTitles");
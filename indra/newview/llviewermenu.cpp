@@ -117,6 +117,7 @@
 #include "llscenemonitor.h"
 #include "llselectmgr.h"
 #include "llsidepanelappearance.h"
+#include "llspatialpartition.h"
 #include "llspellcheckmenuhandler.h"
 #include "llstatusbar.h"
 #include "lltextureview.h"
@@ -354,6 +355,7 @@ void handle_debug_avatar_textures(void*);
 void handle_grab_baked_texture(void*);
 BOOL enable_grab_baked_texture(void*);
 void handle_dump_region_object_cache(void*);
+void handle_dump_octree_scene(void*);
 void handle_reset_interest_lists(void *);
 
 BOOL enable_save_into_task_inventory(void*);
@@ -1361,6 +1363,15 @@ class LLAdvancedDumpRegionObjectCache : public view_listener_t
     }
 };
 
+class LLAdvancedDumpOctreeScene : public view_listener_t
+{
+    bool handleEvent(const LLSD& userdata)
+    {
+        handle_dump_octree_scene(NULL);
+        return true;
+    }
+};
+
 class LLAdvancedToggleInterestList360Mode : public view_listener_t
 {
 public:
@@ -4086,6 +4097,32 @@ void handle_dump_region_object_cache(void*)
     }
 }
 
+// Element positions and radii of every partition, in the format the
+// llflatoctree test reads through LL_FLAT_OCTREE_SCENE
+void handle_dump_octree_scene(void*)
+{
+    std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "octree_scene.txt");
+    llofstream out(filename.c_str());
+    if (!out.is_open())
+    {
+        LL_WARNS() << "Could not open " << filename << LL_ENDL;
+        return;
+    }
+
+    for (LLViewerRegion* regionp : LLWorld::getInstance()->getRegionList())
+    {
+        for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; ++i)
+        {
+            LLSpatialPartition* part = regionp->getSpatialPartition(i);
+            if (part && part->mOctree)
+            {
+                part->dumpScene(out);
+            }
+        }
+    }
+    LL_INFOS() << "Octree scene written to " << filename << LL_ENDL;
+}
+
 void handle_reset_interest_lists(void *)
 {
     // Check all regions and reset their interest list
@@ -10266,6 +10303,7 @@ void initialize_menus()
     // Advanced > World
     view_listener_t::addMenu(new LLAdvancedDumpScriptedCamera(), "Advanced.DumpScriptedCamera");
     view_listener_t::addMenu(new LLAdvancedDumpRegionObjectCache(), "Advanced.DumpRegionObjectCache");
+    view_listener_t::addMenu(new LLAdvancedDumpOctreeScene(), "Advanced.DumpOctreeScene");
     view_listener_t::addMenu(new LLAdvancedToggleStatsRecorder(), "Advanced.ToggleStatsRecorder");
     view_listener_t::addMenu(new LLAdvancedCheckStatsRecorder(), "Advanced.CheckStatsRecorder");
     view_listener_t::addMenu(new LLAdvancedToggleInterestList360Mode(), "Advanced.ToggleInterestList360Mode");
@@ -1000,6 +1000,10 @@ void LLViewerObjectList::update(LLAgent &agent)
 
     std::vector<LLViewerObject*>::iterator idle_end = idle_list.begin()+idle_count;
 
+    // other avatars' animation is queued by their idle updates and evaluated
+    // on the animation threads right after the loop
+    LLVOAvatar::beginAnimationJobs();
+
     static const LLCachedControl<bool> freezeTime(gSavedSettings, "FreezeTime");
     if (freezeTime)
     {
@@ -1013,6 +1017,8 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
             }
         }
+
+        LLVOAvatar::runAnimationJobs();
     }
     else
     {
@@ -1024,6 +1030,8 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
         }
 
+        LLVOAvatar::runAnimationJobs();
+
         //update flexible objects
         LLVolumeImplFlexible::updateClass();
 
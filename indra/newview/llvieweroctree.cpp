@@ -1104,6 +1104,13 @@ U32 LLOcclusionCullingGroup::getLastOcclusionIssuedTime()
     return mOcclusionIssued[LLViewerCamera::sCurCameraID];
 }
 
+bool LLOcclusionCullingGroup::needsOcclusionReadback() const
+{
+    return LLPipeline::sUseOcclusion > 1 &&
+        mOcclusionQuery[LLViewerCamera::sCurCameraID] &&
+        isOcclusionState(QUERY_PENDING);
+}
+
 void LLOcclusionCullingGroup::checkOcclusion()
 {
     if (LLPipeline::sUseOcclusion < 2) return;  // 0 - NoOcclusion, 1 = ReadOnly, 2 = ModifyOcclusionState  TODO: DJH 11-2021 ENUM this
@@ -1368,6 +1375,73 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
     }
 }
 
+void LLViewerOctreeCull::traverseFlat(const FlatOctree& flat, U32 flags)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_OCTREE;
+    if (!flat.getSlotCount())
+    {
+        return;
+    }
+
+    // A node that gets frustum checked hands its result down and clears
+    // mRes once its subtree is done, exactly as the recursion does.
+    // END_OF_CHECK on the stack marks where such a subtree ends.
+    const U32 END_OF_CHECK = LLFlatOctreeBase::NO_NODE;
+    thread_local std::vector<U8> results;
+    thread_local std::vector<U32> stack;
+    results.resize(flat.getSlotCount());
+    stack.clear();
+
+    LLFlatOctreeBase::Frustum frustum(*mCamera, flags);
+    flat.test(frustum, 0, 1, &results[0]);
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        U32 index = stack.back();
+        stack.pop_back();
+        if (index == END_OF_CHECK)
+        {
+            mRes = 0;
+            continue;
+        }
+
+        const OctreeNode* node = flat.getNode(index);
+        LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) node->getListener(0);
+        if (earlyFail(group))
+        {
+            continue;
+        }
+
+        if (mRes != 2 &&
+            !(mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
+        {
+            mRes = results[index];
+            if (!mRes)
+            {
+                continue;
+            }
+            stack.push_back(END_OF_CHECK);
+        }
+
+        node->accept(this);
+
+        U32 count = flat.getChildCount(index);
+        if (count)
+        {
+            // nothing under a fully visible node is checked again
+            U32 first = flat.getFirstChild(index);
+            if (mRes != 2)
+            {
+                flat.test(frustum, first, count, &results[first]);
+            }
+            for (U32 i = count; i-- > 0; )
+            {
+                stack.push_back(first + i);
+            }
+        }
+    }
+}
+
 //------------------------------------------
 //agent space group culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
@@ -37,6 +37,7 @@
 #include "llvector4a.h"
 #include "llquaternion.h"
 #include "lloctree.h"
+#include "llflatoctree.h"
 #include "llviewercamera.h"
 
 class LLViewerRegion;
@@ -50,6 +51,7 @@ typedef LLTreeNode<LLViewerOctreeEntry> TreeNode;
 typedef LLOctreeNode<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeNode;
 typedef LLOctreeRoot<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeRoot;
 typedef LLOctreeTraveler<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeTraveler;
+typedef LLFlatOctree<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> FlatOctree;
 
 #if LL_OCTREE_PARANOIA_CHECK
 #define assert_octree_valid(x) x->validate()
@@ -304,6 +306,7 @@ class LLOcclusionCullingGroup : public LLViewerOctreeGroup
     void setOcclusionState(U32 state, S32 mode = STATE_MODE_SINGLE);
     void clearOcclusionState(U32 state, S32 mode = STATE_MODE_SINGLE);
     void checkOcclusion(); //read back last occlusion query (if any)
+    bool needsOcclusionReadback() const; //checkOcclusion() would have to touch GL
     void doOcclusion(LLCamera* camera, const LLVector4a* shift = NULL); //issue occlusion query
     BOOL isOcclusionState(U32 state) const  { return mOcclusionState[LLViewerCamera::sCurCameraID] & state ? TRUE : FALSE; }
     U32  getOcclusionState() const  { return mOcclusionState[LLViewerCamera::sCurCameraID];}
@@ -374,6 +377,11 @@ class LLViewerOctreeCull : public OctreeTraveler
 
     virtual void traverse(const OctreeNode* n);
 
+    // Same walk as traverse() from the root, over a flat mirror whose boxes
+    // are the groups' mBounds and mExtents.  flags are the LLFlatOctreeBase
+    // tests that stand in for frustumCheck().
+    void traverseFlat(const FlatOctree& flat, U32 flags);
+
 protected:
     virtual bool earlyFail(LLViewerOctreeGroup* group);
 
@@ -692,6 +692,13 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
     // Create the object lists
     initStats();
     initPartitions();
+
+    // The handle is all the object cache needs, start reading it while
+    // the region handshake is still on its way.
+    if(LLVOCache::instanceExists())
+    {
+        LLVOCache::instance().prefetchFromCache(mHandle);
+    }
 }
 
 void LLViewerRegion::initPartitions()
@@ -834,6 +841,10 @@ void LLViewerRegion::saveObjectCache()
 {
     if (!mCacheLoaded)
     {
+        if(LLVOCache::instanceExists())
+        {
+            LLVOCache::instance().discardPrefetch(mHandle);
+        }
         return;
     }
 
@@ -65,6 +65,7 @@
 #include "llvoicevivox.h"
 #include "llinventorymodel.h"
 #include "lltranslate.h"
+#include "workqueue.h"
 
 // "Minimal Vulkan" to get max API Version
 
@@ -405,6 +406,8 @@ void update_statistics()
     static const LLCachedControl<bool> use_chat_bubbles(gSavedSettings, "UseChatBubbles");
     sample(LLStatViewer::CHAT_BUBBLES, use_chat_bubbles);
 
+    LL::WorkStealingQueue::sampleStats();
+
     typedef LLTrace::StatType<LLTrace::TimeBlockAccumulator>::instance_tracker_t stat_type_t;
 
     record(LLStatViewer::FRAME_STACKTIME, last_frame_recording.getSum(*stat_type_t::getInstance("Frame")));
@@ -36,8 +36,10 @@
 #include "llhost.h"
 #include "llimage.h"
 #include "llimagebmp.h"
+#include "llimagedxt.h"
 #include "llimagej2c.h"
 #include "llimagetga.h"
+#include "llimageworker.h"
 #include "llstl.h"
 #include "message.h"
 #include "lltimer.h"
@@ -103,6 +105,7 @@ const S32 MAX_CACHED_RAW_SCULPT_IMAGE_AREA = LLViewerTexture::sMaxSculptRez * LL
 const S32 MAX_CACHED_RAW_TERRAIN_IMAGE_AREA = 128 * 128;
 const S32 DEFAULT_ICON_DIMENSIONS = 32;
 const S32 DEFAULT_THUMBNAIL_DIMENSIONS = 256;
+const S32 MIN_TRANSCODED_IMAGE_DIMENSIONS = 64; // smaller images are cheap enough to decode
 U32 LLViewerTexture::sMinLargeImageSize = 65536; //256 * 256.
 U32 LLViewerTexture::sMaxSmallImageSize = MAX_CACHED_RAW_IMAGE_AREA;
 bool LLViewerTexture::sFreezeImageUpdates = false;
@@ -544,6 +547,19 @@ void LLViewerTexture::updateClass()
 
     LLViewerMediaTexture::updateClass();
 
+    // Decoded copies are the first thing to give back when main memory
+    // runs short, nothing more is kept until it recovers
+    static LLCachedControl<U32> decode_cache_size(gSavedSettings, "AlchemyImageDecodeCacheSize", 0);
+    const S32Megabytes MIN_FREE_MAIN_MEMORY_FOR_DECODE_CACHE(512);
+    S32Megabytes gpu_free;
+    S32Megabytes physical_free;
+    getGPUMemoryForTextures(gpu_free, physical_free);
+    U64 decode_cache_bytes = physical_free < MIN_FREE_MAIN_MEMORY_FOR_DECODE_CACHE ? 0 : (U64)decode_cache_size * 1024 * 1024;
+    if (LLAppViewer::getImageDecodeThread())
+    {
+        LLAppViewer::getImageDecodeThread()->getDecodeCache().setMaxBytes(decode_cache_bytes);
+    }
+
     static LLCachedControl<U32> max_vram_budget(gSavedSettings, "RenderMaxVRAMBudget", 0);
 
     F64 texture_bytes_alloc = LLImageGL::getTextureBytesAllocated() / 1024.0 / 512.0;
@@ -1087,6 +1103,8 @@ void LLViewerFetchedTexture::init(bool firstinit)
     mForSculpt = FALSE;
     mIsFetched = FALSE;
     mInFastCacheList = FALSE;
+    mInTranscodedCache = FALSE;
+    mTranscodedDiscardLevel = INVALID_DISCARD_LEVEL;
 
     mCachedRawImage = NULL;
     mCachedRawDiscardLevel = -1;
@@ -1225,6 +1243,182 @@ void LLViewerFetchedTexture::loadFromFastCache()
     {
         record(LLTextureFetch::sCacheHitRate, LLUnits::Ratio::fromValue(0));
     }
+
+    loadFromTranscodedCache();
+}
+
+bool LLViewerFetchedTexture::canTranscode()
+{
+    static LLCachedControl<bool> transcode_cache(gSavedSettings, "AlchemyTextureTranscodeCache", false);
+
+    // Only plain asset textures.  Anything that wants decoded pixels back
+    // (callbacks, saved raw images, sculpts) stays on the J2C path.
+    return transcode_cache
+        && gGLManager.mHasTextureCompressionS3TC
+        && mFTType == FTT_DEFAULT
+        && mUrl.empty()
+        && !mForSculpt
+        && mBoostLevel == LLGLTexture::BOOST_NONE
+        && mGLTexturep.notNull()
+        && !mGLTexturep->getHasExplicitFormat()
+        && mLoadedCallbackList.empty()
+        && !needsToSaveRawImage();
+}
+
+//look for a block compressed copy, fetching waits until the answer is in
+void LLViewerFetchedTexture::loadFromTranscodedCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (mInTranscodedCache || !canTranscode())
+    {
+        return;
+    }
+
+    LL::WorkQueue::ptr_t main_queue = mMainQueue.lock();
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!main_queue || !general_queue)
+    {
+        return;
+    }
+
+    mInTranscodedCache = TRUE;
+    ref();
+    LLUUID id = getID();
+    bool posted = main_queue->postTo(
+        general_queue,
+        [id]() // Work done on general queue
+        {
+            S32 discard_level = INVALID_DISCARD_LEVEL;
+            LLPointer<LLImageDXT> image = LLTextureCache::readTranscoded(id, discard_level);
+            return std::make_pair(image, discard_level);
+        },
+        [this](std::pair<LLPointer<LLImageDXT>, S32> result) // Callback to main thread
+        {
+            createTranscodedTexture(result.first, result.second);
+        });
+    if (!posted)
+    {
+        mInTranscodedCache = FALSE;
+        unref();
+    }
+}
+
+//ends the transcoded cache lookup started by loadFromTranscodedCache()
+void LLViewerFetchedTexture::createTranscodedTexture(LLImageDXT* image, S32 discard_level)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    S32 current_discard = hasGLTexture() ? getDiscardLevel() : INVALID_DISCARD_LEVEL;
+    if (current_discard < 0)
+    {
+        current_discard = INVALID_DISCARD_LEVEL;
+    }
+    if (mNeedsCreateTexture && mRawImage.notNull())
+    {
+        current_discard = llmin(current_discard, (S32)mRawDiscardLevel);
+    }
+
+    S32 full_width = image ? image->getWidth() << discard_level : 0;
+    S32 full_height = image ? image->getHeight() << discard_level : 0;
+    if (!image
+        || image->getFileFormat() != LLImageDXT::FORMAT_DXR1
+        || discard_level >= current_discard
+        || mIsMissingAsset
+        || !canTranscode()
+        || full_width > MAX_IMAGE_SIZE || full_height > MAX_IMAGE_SIZE
+        || (mFullWidth > 0 && (mFullWidth != full_width || mFullHeight != full_height)))
+    {
+        mInTranscodedCache = FALSE;
+        unref();
+        return;
+    }
+
+    mFullWidth = full_width;
+    mFullHeight = full_height;
+    setTexelsPerImage();
+    mTranscodedDiscardLevel = discard_level;
+
+    if (getComponents() != 3)
+    {
+        mComponents = 3;
+        mGLTexturep->setComponents(mComponents);
+        gTextureList.dirtyImage(this);
+    }
+
+    // The smaller mips sit in front of the largest one, as setImage() wants
+    LLPointer<LLImageDXT> data = image;
+    S32 mip_offset = image->getMipOffset(0);
+    auto upload = [this, data, mip_offset, discard_level, full_width, full_height]()
+        {
+            mGLTexturep->createGLTextureCompressed(discard_level, full_width, full_height, 3,
+                                                   GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+                                                   data->getData() + mip_offset, mBoostLevel);
+        };
+
+    // Queued behind any raw image upload already pending, so a worse
+    // image can not land on top of this one
+    auto mainq = LLImageGLThread::sEnabledTextures ? mMainQueue.lock() : nullptr;
+    if (mainq && mainq->postTo(mImageQueue,
+                               [upload]() { upload(); },
+                               [this]()
+                               {
+                                   setActive();
+                                   mInTranscodedCache = FALSE;
+                                   unref();
+                               }))
+    {
+        return;
+    }
+
+    if (mNeedsCreateTexture)
+    {
+        gTextureList.mCreateTextureList.erase(this);
+        mNeedsCreateTexture = false;
+        destroyRawImage();
+    }
+    upload();
+    setActive();
+    mInTranscodedCache = FALSE;
+    unref();
+}
+
+void LLViewerFetchedTexture::saveToTranscodedCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    // Keep the best level the fetcher settles on, opaque images only
+    if (mRawImage.isNull()
+        || !mIsRawImageValid
+        || mRawImage->getComponents() != 3
+        || mRawDiscardLevel < 0
+        || mRawDiscardLevel >= mTranscodedDiscardLevel
+        || mRawDiscardLevel > mDesiredDiscardLevel
+        || mRawImage->getWidth() < MIN_TRANSCODED_IMAGE_DIMENSIONS
+        || mRawImage->getHeight() < MIN_TRANSCODED_IMAGE_DIMENSIONS
+        || !canTranscode())
+    {
+        return;
+    }
+
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!general_queue)
+    {
+        return;
+    }
+
+    LLPointer<LLImageRaw> raw = mRawImage;
+    LLUUID id = getID();
+    S32 discard_level = mRawDiscardLevel;
+    if (general_queue->post([raw, id, discard_level]()
+        {
+            LLPointer<LLImageDXT> image = new LLImageDXT();
+            if (image->encodeCompressed(raw))
+            {
+                LLTextureCache::writeTranscoded(id, image, discard_level);
+            }
+        }))
+    {
+        mTranscodedDiscardLevel = discard_level;
+    }
 }
 
 void LLViewerFetchedTexture::setForSculpt()
@@ -1599,6 +1793,8 @@ void LLViewerFetchedTexture::postCreateTexture()
 
     setActive();
 
+    saveToTranscodedCache();
+
     if (!needsToSaveRawImage())
     {
         mNeedsAux = FALSE;
@@ -1902,6 +2098,11 @@ bool LLViewerFetchedTexture::updateFetch()
         LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("vftuf - in fast cache");
         return false;
     }
+    if (mInTranscodedCache)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("vftuf - in transcoded cache");
+        return false;
+    }
     if (mGLTexturep.isNull())
     { // fix for crash inside getCurrentDiscardLevelForFetching (shouldn't happen but appears to be happening)
         llassert(false);
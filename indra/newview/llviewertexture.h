@@ -45,6 +45,7 @@ extern const S32Megabytes gMinVideoRam;
 extern const S32Megabytes gMaxVideoRam;
 
 class LLFace;
+class LLImageDXT;
 class LLImageGL ;
 class LLImageRaw;
 class LLViewerObject;
@@ -433,6 +434,13 @@ class LLViewerFetchedTexture : public LLViewerTexture
     void saveRawImage() ;
     void setCachedRawImage() ;
 
+    // Block compressed second tier of the texture cache, see
+    // LLTextureCache::readTranscoded()
+    bool canTranscode();
+    void loadFromTranscodedCache();
+    void createTranscodedTexture(LLImageDXT* image, S32 discard_level);
+    void saveToTranscodedCache();
+
     //for atlas
     void resetFaceAtlas() ;
     void invalidateAtlas(BOOL rebuild_geom) ;
@@ -443,6 +451,8 @@ class LLViewerFetchedTexture : public LLViewerTexture
     BOOL  mInDebug;
     BOOL  mUnremovable;
     BOOL  mInFastCacheList;
+    BOOL  mInTranscodedCache;
+    S32   mTranscodedDiscardLevel; // best level known to be in the transcoded cache
     BOOL  mForceCallbackFetch;
 
 protected:
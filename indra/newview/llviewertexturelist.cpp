@@ -1049,6 +1049,11 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
     // decoded, but haven't been pushed into GL).
     //
 
+    // Spread bursts of uploads, such as after a teleport, over several frames
+    static LLCachedControl<U32> upload_budget(gSavedSettings, "AlchemyTextureUploadBudget", 24);
+    const U64 max_bytes = (U64) upload_budget << 20;
+    U64 uploaded_bytes = 0;
+
     LLTimer create_timer;
     image_list_t::iterator enditer = mCreateTextureList.begin();
     for (image_list_t::iterator iter = mCreateTextureList.begin();
@@ -1057,10 +1062,14 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
         image_list_t::iterator curiter = iter++;
         enditer = iter;
         LLViewerFetchedTexture *imagep = *curiter;
+        if (imagep->getRawImage())
+        {
+            uploaded_bytes += imagep->getRawImage()->getDataSize();
+        }
         imagep->createTexture();
         imagep->postCreateTexture();
 
-        if (create_timer.getElapsedTimeF32() > max_time)
+        if (create_timer.getElapsedTimeF32() > max_time || (max_bytes && uploaded_bytes >= max_bytes))
         {
             break;
         }
@@ -1240,6 +1249,7 @@ void LLViewerTextureList::decodeAllImages(F32 max_time)
         if (LLImageGLThread::sEnabledTextures)
         {
             main_queue->runFor(std::chrono::milliseconds(1));
+            LLImageGL::updateUploads();
             fetch_pending += main_queue->size();
         }
 
@@ -744,6 +744,18 @@ class LLDebugText
             addText(xpos, ypos, llformat("%d Render Calls", (U32)last_frame_recording.getSampleCount(LLPipeline::sStatBatchSize)));
             ypos += y_inc;
 
+            U32 queued_draws, indirect_calls;
+            LLVertexBuffer::getDrawStats(queued_draws, indirect_calls);
+            addText(xpos, ypos, llformat("%d Queued Draws in %d GL Calls", queued_draws, indirect_calls));
+            ypos += y_inc;
+
+            const LLSkinningUtil::PaletteStats& palettes = LLSkinningUtil::getMatrixPaletteStats();
+            addText(xpos, ypos, llformat("%d Matrix Palette Binds, %d Uploads (%d%% reused, %d KB)",
+                                         palettes.mBinds, palettes.mUploads,
+                                         palettes.mBinds ? (S32) ((palettes.mBinds - palettes.mUploads) * 100 / palettes.mBinds) : 0,
+                                         (S32) (palettes.mUploadBytes / 1024)));
+            ypos += y_inc;
+
             addText(xpos, ypos, llformat("%d/%d Objects Active", gObjectList.getNumActiveObjects(), gObjectList.getNumObjects()));
             ypos += y_inc;
 
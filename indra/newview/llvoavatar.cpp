@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <sstream>
+#include <thread>
 
 #include "llaudioengine.h"
 #include "noise.h"
@@ -132,6 +133,7 @@
 
 #include "llsidepanelappearance.h"
 #include "llviewermenufile.h"
+#include "threadpool.h"
 
 extern F32 SPEED_ADJUST_MAX;
 extern F32 SPEED_ADJUST_MAX_SEC;
@@ -608,6 +610,8 @@ bool LLVOAvatar::sLimitNonImpostors = false; // True unless RenderAvatarMaxNonIm
 F32 LLVOAvatar::sRenderDistance = 256.f;
 S32 LLVOAvatar::sNumVisibleAvatars = 0;
 S32 LLVOAvatar::sNumLODChangesThisFrame = 0;
+LLVOAvatar::AnimationLODStats LLVOAvatar::sAnimationLODStats;
+LLVOAvatar::AnimationLODStats LLVOAvatar::sLastAnimationLODStats;
 
 const LLUUID LLVOAvatar::sStepSoundOnLand("e8af4a28-aa83-4310-a7c4-c047e15ea0df");
 const LLUUID LLVOAvatar::sStepSounds[LL_MCODE_END] =
@@ -1122,6 +1126,8 @@ void LLVOAvatar::destroyGL()
     deleteCachedImages();
 
     resetImpostors();
+
+    LLSkinningUtil::cleanupMatrixPalettes();
 }
 
 //static
@@ -1153,6 +1159,32 @@ void LLVOAvatar::deleteCachedImages(bool clearAll)
 }
 
 
+namespace
+{
+    // Avatars handed to the animation threads, see runAnimationJobs()
+    struct LLAnimationBatch
+    {
+        std::vector<LLPointer<LLVOAvatar> > mAvatars;
+        std::function<void(LLVOAvatar*)> mTask;
+        size_t mCount = 0;
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<size_t> mDone{ 0 };
+
+        void run()
+        {
+            for (size_t i = mNext++; i < mCount; i = mNext++)
+            {
+                mTask(mAvatars[i].get());
+                ++mDone;
+            }
+        }
+    };
+
+    std::unique_ptr<LL::WorkStealingThreadPool> sAnimationPool;
+    std::vector<LLPointer<LLVOAvatar> > sAnimationQueue;
+    bool sQueueAnimationJobs = false;
+}
+
 //------------------------------------------------------------------------
 // static
 // LLVOAvatar::initClass()
@@ -1181,11 +1213,24 @@ void LLVOAvatar::initClass()
 
     sCloudTexture = LLViewerTextureManager::getFetchedTextureFromFile("SoftDotNoBack.png");
     gSavedSettings.getControl("LipSyncEnabled")->getSignal()->connect(boost::bind(&LLVOAvatar::handleVOAvatarPrefsChanged, _2));
+
+    U32 threads = gSavedSettings.getU32("AlchemyAnimationThreads");
+    if (threads > 0 && !sAnimationPool)
+    {
+        sAnimationPool.reset(new LL::WorkStealingThreadPool("Animation", threads));
+        sAnimationPool->start();
+    }
 }
 
 
 void LLVOAvatar::cleanupClass()
 {
+    if (sAnimationPool)
+    {
+        sAnimationPool->close();
+        sAnimationPool.reset();
+    }
+    sAnimationQueue.clear();
 }
 
 bool LLVOAvatar::handleVOAvatarPrefsChanged(const LLSD &newvalue)
@@ -4925,9 +4970,50 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
     else
     {
         // Might be better to do HIDDEN_UPDATE if cloud
-        updateMotions(LLCharacter::NORMAL_UPDATE);
+        updateAnimationLOD();
+        bool evaluate = prepareMotions(LLCharacter::NORMAL_UPDATE);
+        if (evaluate && !mMotionController.isInterpolating())
+        {
+            sAnimationLODStats.mEvaluated++;
+        }
+
+        if (sQueueAnimationJobs && !isSelf() && !isUIAvatar())
+        {
+            // Evaluated with the other avatars in runAnimationJobs()
+            mAnimationJobEvaluate = evaluate;
+            mAnimationJobSitGround = was_sit_ground_constrained;
+            mAnimationJobVisible = visible;
+            sAnimationQueue.push_back(this);
+            return visible;
+        }
+
+        if (evaluate)
+        {
+            evaluateMotions(LLCharacter::NORMAL_UPDATE);
+        }
     }
 
+    updateSkeleton(was_sit_ground_constrained);
+
+    // Generate footstep sounds when feet hit the ground
+    updateFootstepSounds();
+
+    if (visible)
+    {
+        // System avatar mesh vertices need to be reskinned.
+        mNeedsSkin = TRUE;
+    }
+
+    return visible;
+}
+
+//-----------------------------------------------------------------------------
+// updateSkeleton()
+// Everything updateCharacter() does to the joints once the motions have
+// been applied.  Only touches this avatar, see runAnimationJob().
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateSkeleton(bool was_sit_ground_constrained)
+{
     // Special handling for sitting on ground.
     if (!getParent() && (isSitting() || was_sit_ground_constrained))
     {
@@ -4946,19 +5032,184 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
     // update head position
     updateHeadOffset();
 
-    // Generate footstep sounds when feet hit the ground
-    updateFootstepSounds();
-
     // Update child joints as needed.
     mRoot->updateWorldMatrixChildren();
+}
 
-    if (visible)
+//-----------------------------------------------------------------------------
+// updateAnimationLOD()
+// Pick how often this avatar's motions are evaluated and whether its
+// extended joints are animated at all, from its projected size and its
+// rank among the visible avatars.  Self and UI avatars always animate
+// fully.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateAnimationLOD()
+{
+    static LLCachedControl<bool> lod_enabled(gSavedSettings, "AlchemyAnimationLOD", true);
+    static LLCachedControl<F32> full_rate_size(gSavedSettings, "AlchemyAnimationLODFullRateSize", 160.f);
+    static LLCachedControl<F32> extended_joints_size(gSavedSettings, "AlchemyAnimationLODExtendedJointsSize", 48.f);
+    static LLCachedControl<U32> max_period(gSavedSettings, "AlchemyAnimationLODMaxPeriod", 4);
+    static LLCachedControl<U32> full_rate_budget(gSavedSettings, "AlchemyAnimationLODBudget", 16);
+
+    S32 period = 1;
+    BOOL extended_joints = TRUE;
+    if (lod_enabled && !isSelf() && !isUIAvatar() && mSpecialRenderMode == 0)
+    {
+        // edge of the screen square the avatar's bounding box covers
+        F32 size = sqrtf(llmax(mPixelArea, 0.f));
+
+        // halve the rate each time the avatar halves in size
+        S32 limit = llmax((S32)max_period(), 1);
+        while (size * period < full_rate_size && period * 2 <= limit)
+        {
+            period *= 2;
+        }
+
+        // past the budget, even large avatars skip every other update
+        // (rank 1 is self)
+        if (period == 1 && limit >= 2 && mVisibilityRank > full_rate_budget + 1)
+        {
+            period = 2;
+        }
+
+        extended_joints = size >= extended_joints_size;
+    }
+
+    mMotionController.setUpdatePeriod(period);
+    mMotionController.setAnimateExtendedJoints(extended_joints);
+
+    sAnimationLODStats.mAvatars++;
+    if (period > 1)
+    {
+        sAnimationLODStats.mReducedRate++;
+    }
+    if (!extended_joints)
+    {
+        sAnimationLODStats.mReducedJoints++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// beginAnimationJobs()
+// Also rolls the animation LOD counters over, this is where a frame's
+// avatar animation starts.
+//-----------------------------------------------------------------------------
+//static
+void LLVOAvatar::beginAnimationJobs()
+{
+    sQueueAnimationJobs = sAnimationPool != nullptr;
+
+    sLastAnimationLODStats = sAnimationLODStats;
+    sAnimationLODStats = AnimationLODStats();
+}
+
+//-----------------------------------------------------------------------------
+// runAnimationJobs()
+// Called once the object list's idle updates are done.  Until then the
+// avatars queued here keep last frame's pose, which the name tags and voice
+// visualizers computed after updateCharacter() are happy with.
+//-----------------------------------------------------------------------------
+//static
+void LLVOAvatar::runAnimationJobs()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    sQueueAnimationJobs = false;
+
+    size_t count = sAnimationQueue.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    // helpers hold the batch, one that starts late finds nothing left
+    auto batch = std::make_shared<LLAnimationBatch>();
+    batch->mAvatars.swap(sAnimationQueue);
+    batch->mTask = [](LLVOAvatar* avatar)
+        {
+            if (!avatar->isDead())
+            {
+                avatar->runAnimationJob();
+            }
+        };
+    batch->mCount = count;
+    size_t helpers = sAnimationPool ? llmin(sAnimationPool->getWidth(), count - 1) : 0;
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        sAnimationPool->getQueue().post([batch]() { batch->run(); });
+    }
+    batch->run();
+    while (batch->mDone < count)
+    {
+        std::this_thread::yield();
+    }
+
+    for (LLVOAvatar* avatar : batch->mAvatars)
+    {
+        if (!avatar->isDead())
+        {
+            avatar->finishAnimationJob();
+        }
+    }
+
+    // drop the references here, not on whichever helper lets go of the
+    // batch last, and keep the capacity for next frame
+    batch->mAvatars.clear();
+    sAnimationQueue.swap(batch->mAvatars);
+}
+
+//-----------------------------------------------------------------------------
+// runAnimationJob()
+// Worker thread half of updateCharacter().  Touches nothing outside this
+// avatar's character state, motions and joints.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::runAnimationJob()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    const S32 touches = LLJoint::sNumTouches;
+    const S32 updates = LLJoint::sNumUpdates;
+
+    if (mAnimationJobEvaluate)
+    {
+        mAnimationJobRunning = true;
+        evaluateMotions(LLCharacter::NORMAL_UPDATE);
+        mAnimationJobRunning = false;
+    }
+    updateSkeleton(mAnimationJobSitGround);
+
+    // finishAnimationJob() adds them back on the main thread, whichever
+    // thread ran the job
+    mAnimationJobTouches = LLJoint::sNumTouches - touches;
+    mAnimationJobUpdates = LLJoint::sNumUpdates - updates;
+    LLJoint::sNumTouches = touches;
+    LLJoint::sNumUpdates = updates;
+}
+
+//-----------------------------------------------------------------------------
+// finishAnimationJob()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::finishAnimationJob()
+{
+    // Motions the job deactivated are deleted here, and visual params its
+    // motions changed are applied after the skeleton update instead of
+    // during evaluation
+    finishMotions();
+    if (mAnimationJobVisualParams)
+    {
+        mAnimationJobVisualParams = false;
+        updateVisualParams();
+    }
+
+    LLJoint::sNumTouches += mAnimationJobTouches;
+    LLJoint::sNumUpdates += mAnimationJobUpdates;
+
+    // Audio is main thread only
+    updateFootstepSounds();
+
+    if (mAnimationJobVisible)
     {
         // System avatar mesh vertices need to be reskinned.
         mNeedsSkin = TRUE;
     }
-
-    return visible;
 }
 
 //-----------------------------------------------------------------------------
@@ -7300,6 +7551,14 @@ void LLVOAvatar::initAttachmentPoints(bool ignore_hud_joints)
 //-----------------------------------------------------------------------------
 void LLVOAvatar::updateVisualParams()
 {
+    if (mAnimationJobRunning)
+    {
+        // A motion evaluated on an animation thread.  This can start and
+        // stop motions, so finishAnimationJob() does it on the main thread.
+        mAnimationJobVisualParams = true;
+        return;
+    }
+
     ESex avatar_sex = (getVisualParamWeight("male") > 0.5f) ? SEX_MALE : SEX_FEMALE;
     if (getSex() != avatar_sex)
     {
@@ -9965,6 +10224,7 @@ const LLVOAvatar::MatrixPaletteCache& LLVOAvatar::updateSkinInfoMatrixPalette(co
         LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
 
         entry.mFrame = gFrameCount;
+        entry.mPaletteSlot = LLSkinningUtil::PaletteSlot();
 
         //build matrix palette
         U32 count = LLSkinningUtil::getMeshJointCount(skin);
@@ -57,6 +57,7 @@
 #include "llvovolume.h"
 #include "llavatarrendernotifier.h"
 #include "llmodel.h"
+#include "llskinningutil.h"
 //BD - Poser
 #include "bdanimator.h"
 
@@ -288,6 +289,41 @@ class LLVOAvatar :
     void            updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
     void            updateTimeStep();
     void            updateRootPositionAndRotation(LLAgent &agent, F32 speed, bool was_sit_ground_constrained);
+    void            updateSkeleton(bool was_sit_ground_constrained);
+    void            updateAnimationLOD();
+
+    // What updateAnimationLOD() decided over the last frame
+    struct AnimationLODStats
+    {
+        U32 mAvatars = 0;           // avatars animated
+        U32 mEvaluated = 0;         // of those, evaluating their motions this frame
+        U32 mReducedRate = 0;       // evaluating their motions less than every frame
+        U32 mReducedJoints = 0;     // leaving their extended joints alone
+    };
+    static const AnimationLODStats& getAnimationLODStats() { return sLastAnimationLODStats; }
+
+    // Avatars other than self are animated on the animation threads: between
+    // beginAnimationJobs() and runAnimationJobs() updateCharacter() queues
+    // them instead of evaluating their motions and skeleton inline, and
+    // runAnimationJobs() evaluates the queue in parallel and joins before
+    // finishing each avatar on the main thread.
+    static void     beginAnimationJobs();
+    static void     runAnimationJobs();
+private:
+    void            runAnimationJob();
+    void            finishAnimationJob();
+
+    bool            mAnimationJobEvaluate = false;
+    bool            mAnimationJobSitGround = false;
+    BOOL            mAnimationJobVisible = FALSE;
+    bool            mAnimationJobRunning = false;       // runAnimationJob() is evaluating this avatar
+    bool            mAnimationJobVisualParams = false;  // updateVisualParams() was asked for meanwhile
+    S32             mAnimationJobTouches = 0;           // LLJoint debug counts of the job
+    S32             mAnimationJobUpdates = 0;
+
+    static AnimationLODStats sAnimationLODStats;
+    static AnimationLODStats sLastAnimationLODStats;
+public:
 
     void            idleUpdateVoiceVisualizer(bool voice_enabled, const LLVector3 &position);
     void            idleUpdateMisc(bool detailed_update);
@@ -833,6 +869,9 @@ class LLVOAvatar :
         // Float array ready to be sent to GL
         std::vector<F32> mGLMp;
 
+        // Where mGLMp was last written to the shared palette buffer
+        mutable LLSkinningUtil::PaletteSlot mPaletteSlot;
+
         MatrixPaletteCache() :
             mFrame(gFrameCount - 1)
         {
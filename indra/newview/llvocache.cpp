@@ -26,6 +26,8 @@
 
 #include "llviewerprecompiledheaders.h"
 #include "llvocache.h"
+#include "llcrc.h"
+#include "llmappedfile.h"
 #include "llregionhandle.h"
 #include "llviewercontrol.h"
 #include "llviewerobjectlist.h"
@@ -34,6 +36,7 @@
 #include "llagentcamera.h"
 #include "llsdserialize.h"
 #include "llworld.h" // For LLWorld::getInstance()
+#include "threadpool.h"
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
 F32 LLVOCacheEntry::sNearRadius = 1.0f;
@@ -42,7 +45,6 @@ F32 LLVOCacheEntry::sFrontPixelThreshold = 1.0f;
 F32 LLVOCacheEntry::sRearPixelThreshold = 1.0f;
 BOOL LLVOCachePartition::sNeedsOcclusionCheck = FALSE;
 
-const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
 const S32 MAX_ENTRY_BODY_SIZE = 10000;
 
 BOOL check_read(LLAPRFile* apr_file, void* src, S32 n_bytes)
@@ -50,6 +52,16 @@ BOOL check_read(LLAPRFile* apr_file, void* src, S32 n_bytes)
     return apr_file->read(src, n_bytes) == n_bytes ;
 }
 
+static U32 body_checksum(const U8* body, S32 size)
+{
+    LLCRC crc;
+    if (body && size > 0)
+    {
+        crc.update(body, size);
+    }
+    return crc.getCRC();
+}
+
 BOOL check_write(LLAPRFile* apr_file, void* src, S32 n_bytes)
 {
     return apr_file->write(src, n_bytes) == n_bytes ;
@@ -167,11 +179,13 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
     mSceneContrib(0.f),
     mValid(TRUE),
     mParentID(0),
-    mBSphereRadius(-1.0f)
+    mBSphereRadius(-1.0f),
+    mNeedsValidation(false)
 {
     mBuffer = new U8[dp.getBufferSize()];
     mDP.assignBuffer(mBuffer, dp.getBufferSize());
     mDP = dp;
+    mBodyChecksum = body_checksum(mBuffer, dp.getBufferSize());
 }
 
 LLVOCacheEntry::LLVOCacheEntry()
@@ -187,81 +201,53 @@ LLVOCacheEntry::LLVOCacheEntry()
     mSceneContrib(0.f),
     mValid(TRUE),
     mParentID(0),
-    mBSphereRadius(-1.0f)
+    mBSphereRadius(-1.0f),
+    mBodyChecksum(0),
+    mNeedsValidation(false)
 {
     mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const std::shared_ptr<LLMappedFile>& mapping, const FileRecord& record)
 :   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
-    mBuffer(NULL),
+    mLocalID(record.mLocalID),
+    mCRC(record.mCRC),
     mUpdateFlags(-1),
+    mHitCount(record.mHitCount),
+    mDupeCount(record.mDupeCount),
+    mCRCChangeCount(record.mCRCChangeCount),
+    mBuffer(NULL),
     mState(INACTIVE),
     mSceneContrib(0.f),
-    mValid(FALSE),
+    mValid(TRUE),
     mParentID(0),
-    mBSphereRadius(-1.0f)
-{
-    S32 size = -1;
-    BOOL success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
-
-    mDP.assignBuffer(mBuffer, 0);
+    mBSphereRadius(-1.0f),
+    mBodyChecksum(record.mBodyChecksum),
+    mMapping(mapping),
+    mNeedsValidation(true)
+{
+    // The cache file is mapped copy-on-write, so unpacking (or even
+    // packing) through mDP never touches the file itself.
+    mDP.assignBuffer(mapping->getData() + record.mBodyOffset, record.mBodySize);
+}
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
-    if (success)
-    {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
+LLVOCacheEntry::~LLVOCacheEntry()
+{
+    releaseBody();
+}
 
-        // Corruption in the cache entries
-        if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
-        {
-            // We've got a bogus size, skip reading it.
-            // We won't bother seeking, because the rest of this file
-            // is likely bogus, and will be tossed anyway.
-            LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
-            success = FALSE;
-        }
-    }
-    if(success && size > 0)
+void LLVOCacheEntry::releaseBody() const
+{
+    if (mMapping)
     {
-        mBuffer = new U8[size];
-        success = check_read(apr_file, mBuffer, size);
-
-        if(success)
-        {
-            mDP.assignBuffer(mBuffer, size);
-        }
-        else
-        {
-            // Improve logging around vocache
-            LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-            delete[] mBuffer ;
-            mBuffer = NULL ;
-        }
+        mDP.releaseBuffer();
+        mMapping.reset();
     }
-
-    if(!success)
+    else
     {
-        mLocalID = 0;
-        mCRC = 0;
-        mHitCount = 0;
-        mDupeCount = 0;
-        mCRCChangeCount = 0;
-        mBuffer = NULL;
-        mEntry = NULL;
-        mState = INACTIVE;
+        mDP.freeBuffer();
     }
-}
-
-LLVOCacheEntry::~LLVOCacheEntry()
-{
-    mDP.freeBuffer();
+    mNeedsValidation = false;
 }
 
 void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
@@ -272,12 +258,13 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
         mCRCChangeCount++;
     }
 
-    mDP.freeBuffer();
+    releaseBody();
 
     llassert_always(dp.getBufferSize() > 0);
     mBuffer = new U8[dp.getBufferSize()];
     mDP.assignBuffer(mBuffer, dp.getBufferSize());
     mDP = dp;
+    mBodyChecksum = body_checksum(mBuffer, dp.getBufferSize());
 }
 
 void LLVOCacheEntry::setParentID(U32 id)
@@ -405,6 +392,18 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP() const
 {
+    if (mNeedsValidation)
+    {
+        // Entries read from a cache file are only checked the first time
+        // they are actually used.
+        mNeedsValidation = false;
+        if (body_checksum(mDP.getBuffer(), mDP.getBufferSize()) != mBodyChecksum)
+        {
+            LL_WARNS() << "Cache entry " << mLocalID << " failed validation, discarding" << LL_ENDL;
+            releaseBody();
+        }
+    }
+
     if (mDP.getBufferSize() == 0)
     {
         //LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -430,25 +429,31 @@ void LLVOCacheEntry::dump() const
         << LL_ENDL;
 }
 
-S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
+bool LLVOCacheEntry::fillFileRecord(FileRecord& record) const
 {
     S32 size = mDP.getBufferSize();
 
     if (size > MAX_ENTRY_BODY_SIZE)
     {
         LL_WARNS() << "Failed to write entry with size above allowed limit: " << size << LL_ENDL;
-        return 0;
+        return false;
+    }
+
+    if (size < 1)
+    {
+        return false;
     }
 
-    memcpy(data_buffer, &mLocalID, sizeof(U32));
-    memcpy(data_buffer + sizeof(U32), &mCRC, sizeof(U32));
-    memcpy(data_buffer + (2 * sizeof(U32)), &mHitCount, sizeof(S32));
-    memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
-    memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
-    memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
+    record.mLocalID = mLocalID;
+    record.mCRC = mCRC;
+    record.mHitCount = mHitCount;
+    record.mDupeCount = mDupeCount;
+    record.mCRCChangeCount = mCRCChangeCount;
+    record.mBodyOffset = 0;
+    record.mBodySize = size;
+    record.mBodyChecksum = mBodyChecksum;
 
-    return ENTRY_HEADER_SIZE + size;
+    return true;
 }
 
 #ifndef LL_TEST
@@ -1136,22 +1141,48 @@ const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
 
+// Region object cache file layout: an ObjectCacheFileHeader, a table of
+// LLVOCacheEntry::FileRecord and then all of the entry bodies. The file is
+// memory mapped when read and written back in one go.
+const char OBJECT_CACHE_FILE_MAGIC[4] = { 'S', 'L', 'O', 'C' };
+const U32 OBJECT_CACHE_FILE_VERSION = 1;
+
+struct ObjectCacheFileHeader
+{
+    char mMagic[4];
+    U32  mVersion;
+    U8   mRegionID[UUID_BYTES];
+    U32  mNumEntries;
+};
+
 
 LLVOCache::LLVOCache(bool read_only) :
     mInitialized(false),
     mReadOnly(read_only),
     mNumEntries(0),
     mCacheSize(1),
-    mEnabled(true)
+    mEnabled(true),
+    mPendingWriteBytes(0),
+    mMaxPendingWriteBytes(32 * 1024 * 1024),
+    mWritesInFlight(0)
 {
 #ifndef LL_TEST
     mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
+    mMaxPendingWriteBytes = (size_t)gSavedSettings.getU32("AlchemyObjectCacheWriteBehindSize") * 1024 * 1024;
 #endif
     mLocalAPRFilePoolp = new LLVolatileAPRPool("VOCache Pool") ;
 }
 
 LLVOCache::~LLVOCache()
 {
+    // Regions queue their cache writes on the way out, this is where
+    // shutdown waits for them to reach the disk.
+    waitForPendingIO();
+    if (mThreadPool)
+    {
+        mThreadPool->close();
+    }
+
     if(mEnabled)
     {
         writeCacheHeader();
@@ -1186,6 +1217,14 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
     {
         LLFile::mkdir(mObjectCacheDirName);
     }
+
+    if (!mThreadPool)
+    {
+        // A single thread keeps the file operations in order. It is closed
+        // by the destructor, after the last writes of the session.
+        mThreadPool.reset(new LL::ThreadPool("VOCache", 1, 1024 * 1024, false));
+        mThreadPool->start();
+    }
     mCacheSize = llclamp(size, MIN_ENTRIES_TO_PURGE, MAX_NUM_OBJECT_ENTRIES);
     mMetaInfo.mVersion = cache_version;
 
@@ -1232,6 +1271,7 @@ void LLVOCache::removeCache(ELLPath location, bool started)
     }
 
     LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
+    waitForPendingIO();
 
     std::string mask = "*";
     std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
@@ -1257,6 +1297,8 @@ void LLVOCache::removeCache()
         return ;
     }
 
+    waitForPendingIO();
+
     std::string mask = "*";
     LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
     gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask);
@@ -1357,13 +1399,14 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
     std::string filename;
     getObjectCacheFilename(entry->mHandle, filename);
     LL_WARNS("GLTF", "VOCache") << "Removing object cache for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
-    LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+    discardPrefetch(entry->mHandle);
+    queueRemove(filename);
 
     // Note: `removeFromCache` should take responsibility for cleaning up all cache artefacts specfic to the handle/entry.
     // as such this now includes the generic extras
     filename = getObjectCacheExtrasFilename(entry->mHandle);
     LL_WARNS("GLTF", "VOCache") << "Removing generic extras for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
-    LLFile::remove(filename);
+    queueRemove(filename);
 
     entry->mTime = INVALID_TIME ;
     updateEntry(entry) ; //update the head file.
@@ -1527,47 +1570,31 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
     if(iter == mHandleEntryMap.end()) //no cache
     {
         LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
+        discardPrefetch(handle);
         return false; // arguably no a problem, but we'll mark this as dirty anyway.
     }
 
-    bool success = true ;
-    S32 num_entries = 0 ; // lifted out of inner loop.
-    std::string filename; // lifted out of loop
-    {
-        LLUUID cache_id;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-
-        success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+    std::string filename;
+    getObjectCacheFilename(handle, filename);
 
-        if(success)
+    // Usually the files were prefetched when the region was created and
+    // this does not block.
+    CacheReadResult* result = getReadResult(handle);
+    bool success = result && result->mSuccess;
+    if (result && result->mCacheID != id)
+    {
+        if (success)
         {
-            if(cache_id != id)
-            {
-                LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-                success = false ;
-            }
-
-            if(success)
-            {
-                success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-
-                if(success)
-                {
-                    for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-                    {
-                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-                        if (!entry->getLocalID())
-                        {
-                            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-                            success = false ;
-                            break ;
-                        }
-                        cache_entry_map[entry->getLocalID()] = entry;
-                    }
-                }
-            }
+            LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
         }
+        success = false;
+        result->mEntries.clear();
+    }
+
+    if (result)
+    {
+        // a corrupted file still yields the entries in front of the corruption
+        cache_entry_map.swap(result->mEntries);
     }
 
     if(!success)
@@ -1578,7 +1605,7 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
         }
     }
 
-    LL_DEBUGS("GLTF", "VOCache") << "Read " << cache_entry_map.size() << " entries from object cache " << filename << ", expected " << num_entries << ", success=" << (success?"True":"False") << LL_ENDL;
+    LL_DEBUGS("GLTF", "VOCache") << "Read " << cache_entry_map.size() << " entries from object cache " << filename << ", expected " << (result ? result->mNumEntries : 0) << ", success=" << (success?"True":"False") << LL_ENDL;
     return success;
 }
 
@@ -1600,20 +1627,206 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
     if(iter == mHandleEntryMap.end()) //no cache
     {
         LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
+        discardPrefetch(handle);
+        return;
+    }
+
+    CacheReadResult* result = getReadResult(handle);
+    if (!result)
+    {
         return;
     }
 
-    std::string filename(getObjectCacheExtrasFilename(handle));
+    bool success = result->mExtrasSuccess;
+    if (success && result->mExtrasCacheID != id)
+    {
+        // if the cache id doesn't match the expected region we should just kill the file.
+        LL_WARNS() << "Cache ID doesn't match for this region, deleting it" << LL_ENDL;
+        success = false;
+        result->mExtras.clear();
+    }
+
+    LL_DEBUGS("GLTF") << "Beginning reading extras cache for handle " << handle << " from " << getObjectCacheExtrasFilename(handle) << LL_ENDL;
+
+    for (const LLSD& entry_llsd : result->mExtras)
+    {
+        LLGLTFOverrideCacheEntry entry;
+        entry.fromLLSD(entry_llsd);
+        U32 local_id = entry_llsd["local_id"].asInteger();
+        // only add entries that exist in the primary cache
+        // this is a self-healing test that avoids us polluting the cache with entries that are no longer valid based on the main cache.
+        if(cache_entry_map.find(local_id)!= cache_entry_map.end())
+        {
+            // attempt to backfill a null objectId, though these shouldn't be in the persisted cache really
+            if(entry.mObjectId.isNull() && pRegion)
+            {
+                gObjectList.getUUIDFromLocal( entry.mObjectId, local_id, pRegion->getHost().getAddress(), pRegion->getHost().getPort() );
+            }
+            cache_extras_entry_map[local_id] = entry;
+            loaded++;
+        }
+        else
+        {
+            discarded++;
+        }
+    }
+
+    // the read is fully consumed now
+    discardPrefetch(handle);
+
+    if (!success)
+    {
+        LL_WARNS() << "Failed reading extras cache for handle " << handle << LL_ENDL;
+        removeGenericExtrasForHandle(handle);
+    }
+    LL_DEBUGS("GLTF") << "Completed reading extras cache for handle " << handle << ", " << loaded << " loaded, " << discarded << " discarded" << LL_ENDL;
+}
+
+void LLVOCache::prefetchFromCache(U64 handle)
+{
+    if (!mEnabled || !mInitialized)
+    {
+        return;
+    }
+
+    if (mHandleEntryMap.find(handle) == mHandleEntryMap.end() || mPendingReads.find(handle) != mPendingReads.end())
+    {
+        return;
+    }
+
+    std::string filename;
+    getObjectCacheFilename(handle, filename);
+    std::string extras_filename = getObjectCacheExtrasFilename(handle);
+
+    std::shared_ptr<CacheReadResult> result = std::make_shared<CacheReadResult>();
+    std::shared_ptr<std::promise<void>> done = std::make_shared<std::promise<void>>();
+
+    PendingRead& read = mPendingReads[handle];
+    read.mResult = result;
+    read.mDone = done->get_future();
+
+    auto work = [filename, extras_filename, result, done]()
+    {
+        readCacheFiles(filename, extras_filename, *result);
+        done->set_value();
+    };
+    if (!postIO(work))
+    {
+        work();
+    }
+}
+
+void LLVOCache::discardPrefetch(U64 handle)
+{
+    // The worker owns a reference to the result, no need to wait for it.
+    mPendingReads.erase(handle);
+}
+
+LLVOCache::CacheReadResult* LLVOCache::getReadResult(U64 handle)
+{
+    pending_read_map_t::iterator iter = mPendingReads.find(handle);
+    if (iter == mPendingReads.end())
+    {
+        prefetchFromCache(handle);
+        iter = mPendingReads.find(handle);
+        if (iter == mPendingReads.end())
+        {
+            return nullptr;
+        }
+    }
+
+    LL_PROFILE_ZONE_SCOPED;
+    iter->second.mDone.wait();
+    return iter->second.mResult.get();
+}
+
+void LLVOCache::waitForPendingIO()
+{
+    for (pending_read_map_t::value_type& pending : mPendingReads)
+    {
+        pending.second.mDone.wait();
+    }
+    mPendingReads.clear();
+
+    flushPendingWrites();
+}
+
+bool LLVOCache::postIO(const std::function<void()>& work)
+{
+    return mThreadPool && mThreadPool->getQueue().post(work);
+}
+
+//static
+void LLVOCache::readCacheFiles(const std::string& filename, const std::string& extras_filename, CacheReadResult& result)
+{
+    result.mSuccess = readCacheFile(filename, result);
+    result.mExtrasSuccess = readExtrasFile(extras_filename, result);
+}
+
+//static
+bool LLVOCache::readCacheFile(const std::string& filename, CacheReadResult& result)
+{
+    // Only the file header is checked here, the entries point straight
+    // into the mapping and check their own body on first use.
+    std::shared_ptr<LLMappedFile> mapping = std::make_shared<LLMappedFile>();
+    if (!mapping->open(filename, LLMappedFile::COPY_ON_WRITE))
+    {
+        return false;
+    }
+
+    ObjectCacheFileHeader header;
+    if (mapping->getSize() < sizeof(header))
+    {
+        LL_WARNS() << "Unknown object cache file format in " << filename << ", discarding" << LL_ENDL;
+        return false;
+    }
+
+    memcpy(&header, mapping->getData(), sizeof(header));
+    if (memcmp(header.mMagic, OBJECT_CACHE_FILE_MAGIC, sizeof(header.mMagic)) != 0
+        || header.mVersion != OBJECT_CACHE_FILE_VERSION)
+    {
+        LL_WARNS() << "Unknown object cache file format in " << filename << ", discarding" << LL_ENDL;
+        return false;
+    }
+
+    memcpy(result.mCacheID.mData, header.mRegionID, UUID_BYTES);
+    result.mNumEntries = header.mNumEntries;
+
+    const size_t file_size = mapping->getSize();
+    const size_t table_end = sizeof(header) + (size_t)header.mNumEntries * sizeof(LLVOCacheEntry::FileRecord);
+    if (table_end > file_size)
+    {
+        LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+        return false;
+    }
+
+    const U8* table = mapping->getData() + sizeof(header);
+    for (U32 i = 0; i < header.mNumEntries; i++)
+    {
+        LLVOCacheEntry::FileRecord record;
+        memcpy(&record, table + i * sizeof(record), sizeof(record));
+        if (!record.mLocalID || record.mBodySize < 1 || record.mBodySize > (U32)MAX_ENTRY_BODY_SIZE
+            || record.mBodyOffset < table_end || (size_t)record.mBodyOffset + record.mBodySize > file_size)
+        {
+            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+            return false;
+        }
+        result.mEntries[record.mLocalID] = new LLVOCacheEntry(mapping, record);
+    }
+
+    return true;
+}
+
+//static
+bool LLVOCache::readExtrasFile(const std::string& filename, CacheReadResult& result)
+{
     llifstream in(filename, std::ios::in | std::ios::binary);
 
     std::string line;
     std::getline(in, line);
     if(!in.good())
     {
-        LL_WARNS() << "Failed reading extras cache for handle " << handle << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
+        return false;
     }
     // file formats need versions, let's add one. legacy cache files will be considered version 0
     // This will make it easier to upgrade/revise later.
@@ -1627,40 +1840,24 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
     // The important thing is to make sure it gets removed.
     if(versionNumber != LLGLTFOverrideCacheEntry::VERSION)
     {
-        LL_WARNS() << "Unexpected version number " << versionNumber << " for extras cache for handle " << handle << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
+        LL_WARNS() << "Unexpected version number " << versionNumber << " for extras cache " << filename << LL_ENDL;
+        return false;
     }
 
-    LL_DEBUGS("VOCache") << "Reading extras cache for handle " << handle << ", version " << versionNumber << LL_ENDL;
+    LL_DEBUGS("VOCache") << "Reading extras cache " << filename << ", version " << versionNumber << LL_ENDL;
     std::getline(in, line);
     if(!LLUUID::validate(line))
     {
-        LL_WARNS() << "Failed reading extras cache for handle" << handle << ". invalid uuid line: '" << line << "'" << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
-
-    LLUUID cache_id(line);
-    if(cache_id != id)
-    {
-        // if the cache id doesn't match the expected region we should just kill the file.
-        LL_WARNS() << "Cache ID doesn't match for this region, deleting it" << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
+        LL_WARNS() << "Failed reading extras cache " << filename << ". invalid uuid line: '" << line << "'" << LL_ENDL;
+        return false;
     }
+    result.mExtrasCacheID.set(line);
 
     U32 num_entries;  // if removal was enabled during write num_entries might be wrong
     std::getline(in, line);
     if(!in.good())
     {
-        LL_WARNS() << "Failed reading extras cache for handle " << handle << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
+        return false;
     }
     try
     {
@@ -1668,49 +1865,25 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
     }
     catch(const std::logic_error&)  // either invalid_argument or out_of_range
     {
-        LL_WARNS() << "Failed reading extras cache for handle " << handle << ". unreadable num_entries" << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        return;
+        LL_WARNS() << "Failed reading extras cache " << filename << ". unreadable num_entries" << LL_ENDL;
+        return false;
     }
 
-    LL_DEBUGS("GLTF") << "Beginning reading extras cache for handle " << handle << " from " << getObjectCacheExtrasFilename(handle) << LL_ENDL;
-
-    LLSD entry_llsd;
     for (U32 i = 0; i < num_entries && !in.eof(); i++)
     {
         static const U32 max_size = 4096;
+        LLSD entry_llsd;
         bool success = LLSDSerialize::deserialize(entry_llsd, in, max_size);
         // check bool(in) this time since eof is not a failure condition here
         if(!success || !in)
         {
-            LL_WARNS() << "Failed reading extras cache for handle " << handle << ", entry number " << i << " cache patrtial load only." << LL_ENDL;
-            in.close();
-            removeGenericExtrasForHandle(handle);
-            break;
-        }
-
-        LLGLTFOverrideCacheEntry entry;
-        entry.fromLLSD(entry_llsd);
-        U32 local_id = entry_llsd["local_id"].asInteger();
-        // only add entries that exist in the primary cache
-        // this is a self-healing test that avoids us polluting the cache with entries that are no longer valid based on the main cache.
-        if(cache_entry_map.find(local_id)!= cache_entry_map.end())
-        {
-            // attempt to backfill a null objectId, though these shouldn't be in the persisted cache really
-            if(entry.mObjectId.isNull() && pRegion)
-            {
-                gObjectList.getUUIDFromLocal( entry.mObjectId, local_id, pRegion->getHost().getAddress(), pRegion->getHost().getPort() );
-            }
-            cache_extras_entry_map[local_id] = entry;
-            loaded++;
-        }
-        else
-        {
-            discarded++;
+            LL_WARNS() << "Failed reading extras cache " << filename << ", entry number " << i << " cache patrtial load only." << LL_ENDL;
+            return false;
         }
+        result.mExtras.push_back(entry_llsd);
     }
-    LL_DEBUGS("GLTF") << "Completed reading extras cache for handle " << handle << ", " << loaded << " loaded, " << discarded << " discarded" << LL_ENDL;
+
+    return true;
 }
 
 void LLVOCache::purgeEntries(U32 size)
@@ -1789,66 +1962,58 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
     //write to cache file
     bool success = true ;
     {
-        std::string filename;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_FOPEN_CREATE|APR_FOPEN_WRITE|APR_FOPEN_BINARY|APR_FOPEN_TRUNCATE, mLocalAPRFilePoolp);
+        // Lay out the whole file in memory first: header, record table
+        // and bodies, then write it with a single sequential write.
+        std::vector<LLVOCacheEntry::FileRecord> records;
+        std::vector<const LLVOCacheEntry*> entries;
+        records.reserve(cache_entry_map.size());
+        entries.reserve(cache_entry_map.size());
 
-        success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-
-        if(success)
+        size_t bodies_size = 0;
+        for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
         {
-            S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-            success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
+            if (!removal_enabled || iter->second->isValid())
             {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
+                LLVOCacheEntry::FileRecord record;
+                if (!iter->second->fillFileRecord(record))
                 {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
-                                break;
-                            }
-                        }
-                    }
+                    LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
+                    success = false;
+                    break;
                 }
+                records.push_back(record);
+                entries.push_back(iter->second.get());
+                bodies_size += record.mBodySize;
+            }
+        }
 
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    if(!success)
-                    {
-                        LL_WARNS() << "Failed to write cache entry to disk " << filename << LL_ENDL;
-                    }
-                    size_in_buffer = 0;
-                }
-                LL_DEBUGS("VOCache") << "Wrote " << num_entries << " entries to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
+        if (success)
+        {
+            ObjectCacheFileHeader header;
+            memcpy(header.mMagic, OBJECT_CACHE_FILE_MAGIC, sizeof(header.mMagic));
+            header.mVersion = OBJECT_CACHE_FILE_VERSION;
+            memcpy(header.mRegionID, id.mData, UUID_BYTES);
+            header.mNumEntries = (U32)records.size();
+
+            const size_t table_size = records.size() * sizeof(LLVOCacheEntry::FileRecord);
+            std::vector<U8> data(sizeof(header) + table_size + bodies_size);
+            memcpy(data.data(), &header, sizeof(header));
+
+            U32 body_offset = (U32)(sizeof(header) + table_size);
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                records[i].mBodyOffset = body_offset;
+                memcpy(data.data() + body_offset, entries[i]->getBody(), records[i].mBodySize);
+                body_offset += records[i].mBodySize;
+            }
+            if (table_size)
+            {
+                memcpy(data.data() + sizeof(header), records.data(), table_size);
             }
+
+            // The worker thread writes the file, a failed write removes it.
+            queueWrite(filename, std::move(data));
+            LL_DEBUGS("VOCache") << "Queued " << records.size() << " entries for the primary VOCache file " << filename << LL_ENDL;
         }
     }
 
@@ -1860,6 +2025,136 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
     return ;
 }
 
+void LLVOCache::queueWrite(const std::string& filename, std::vector<U8>&& data)
+{
+    {
+        std::unique_lock<std::mutex> lock(mWriteMutex);
+        auto found = mPendingWrites.find(filename);
+        if (found != mPendingWrites.end())
+        {
+            // Not picked up by the worker yet, the queued write will use the new data.
+            mPendingWriteBytes = mPendingWriteBytes - found->second.size() + data.size();
+            found->second = std::move(data);
+            return;
+        }
+
+        // Keep the write-behind buffer bounded: wait for the worker to catch
+        // up instead of buffering without limit.
+        mWriteCondition.wait(lock, [this, &data]()
+            {
+                return mPendingWriteBytes == 0 || mPendingWriteBytes + data.size() <= mMaxPendingWriteBytes;
+            });
+
+        mPendingWriteBytes += data.size();
+        mPendingWrites[filename] = std::move(data);
+    }
+
+    if (!postIO([this, filename]() { flushWrite(filename); }))
+    {
+        flushWrite(filename);
+    }
+}
+
+void LLVOCache::queueRemove(const std::string& filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        auto found = mPendingWrites.find(filename);
+        if (found != mPendingWrites.end())
+        {
+            mPendingWriteBytes -= found->second.size();
+            mPendingWrites.erase(found);
+        }
+    }
+    mWriteCondition.notify_all();
+
+    // Goes through the worker so that it happens after a write in progress.
+    auto work = [filename]() { LLFile::remove(filename, ENOENT); };
+    if (!postIO(work))
+    {
+        work();
+    }
+}
+
+void LLVOCache::flushWrite(const std::string& filename)
+{
+    std::vector<U8> data;
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        auto found = mPendingWrites.find(filename);
+        if (found == mPendingWrites.end())
+        {
+            // removed or written already
+            return;
+        }
+        data = std::move(found->second);
+        mPendingWrites.erase(found);
+        mWritesInFlight++;
+    }
+
+    if (!writeCacheFile(filename, data))
+    {
+        // Better no file than a stale one, the next read rebuilds the cache.
+        LLFile::remove(filename, ENOENT);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        mPendingWriteBytes -= data.size();
+        mWritesInFlight--;
+    }
+    mWriteCondition.notify_all();
+}
+
+void LLVOCache::flushPendingWrites()
+{
+    LL_PROFILE_ZONE_SCOPED;
+    std::unique_lock<std::mutex> lock(mWriteMutex);
+    mWriteCondition.wait(lock, [this]() { return mPendingWrites.empty() && !mWritesInFlight; });
+}
+
+//static
+bool LLVOCache::writeCacheFile(const std::string& filename, const std::vector<U8>& data)
+{
+    // Entries of the region may still point into the current file through
+    // its mapping, so never overwrite it in place: write a new file and
+    // swap it in.
+    std::string temp_filename = filename + ".tmp";
+    LLFILE* file = LLFile::fopen(temp_filename, "wb");
+    if (!file)
+    {
+        LL_WARNS() << "Failed to open cache file " << temp_filename << " for writing" << LL_ENDL;
+        return false;
+    }
+
+    bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+    LLFile::close(file);
+    if (!success)
+    {
+        LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
+        LLFile::remove(temp_filename);
+        return false;
+    }
+
+    if (LLFile::rename(temp_filename, filename, ENOENT) != 0)
+    {
+        // Windows refuses to replace a file that is still mapped, but the
+        // mapped file itself can be moved out of the way.
+        std::string old_filename = filename + ".old";
+        LLFile::remove(old_filename, ENOENT);
+        if (LLFile::rename(filename, old_filename, ENOENT) != 0 || LLFile::rename(temp_filename, filename) != 0)
+        {
+            LL_WARNS() << "Failed to replace cache file " << filename << LL_ENDL;
+            LLFile::remove(temp_filename);
+            return false;
+        }
+        // fails while still mapped, the next replace or cache clear gets it
+        LLFile::remove(old_filename, ENOENT);
+    }
+
+    return true;
+}
+
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
 {
     if(mReadOnly)
@@ -1878,7 +2173,7 @@ void LLVOCache::removeGenericExtrasForHandle(U64 handle)
     {
         //shouldn't happen, but if it does, we should remove the extras file since it's orphaned
         LL_WARNS("GLTF", "VOCache") << "Removing generic extras for handle " << handle << "Filename: " << getObjectCacheExtrasFilename(handle) << LL_ENDL;
-        LLFile::remove(getObjectCacheExtrasFilename(handle));
+        queueRemove(getObjectCacheExtrasFilename(handle));
     }
 }
 
@@ -1900,13 +2195,8 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
     // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
     std::string filename = getObjectCacheExtrasFilename(handle);
     // </FS:Beq>
-    llofstream out(filename, std::ios::out | std::ios::binary);
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
+    // Built in memory, the file is written by the worker thread.
+    std::ostringstream out;
     // It is good practice to version file formats so let's add one.
     // legacy versions will be treated as version 0.
     out << LLGLTFOverrideCacheEntry::VERSION_LABEL << ":" << LLGLTFOverrideCacheEntry::VERSION << '\n';
@@ -1978,5 +2268,8 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         removeGenericExtrasForHandle(handle);
         return;
     }
+
+    std::string data = out.str();
+    queueWrite(filename, std::vector<U8>(data.begin(), data.end()));
     LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << num_entries << " entries. Total in RAM: " << inmem_entries << " skipped (no persist): " << skipped << LL_ENDL;
 }
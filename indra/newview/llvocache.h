@@ -33,9 +33,17 @@
 #include "llvieweroctree.h"
 #include "llapr.h"
 #include "llgltfmaterial.h"
+#include "threadpool_fwd.h"
 
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
+class LLMappedFile;
+
 //---------------------------------------------------------------------------
 // Cache entries
 class LLCamera;
@@ -98,11 +106,27 @@ class LLVOCacheEntry final
         }
     };
 
+    // On-disk record of an entry in a region object cache file. The records
+    // form a table after the file header, the bodies follow the table.
+    struct FileRecord
+    {
+        U32 mLocalID;
+        U32 mCRC;
+        S32 mHitCount;
+        S32 mDupeCount;
+        S32 mCRCChangeCount;
+        U32 mBodyOffset;    // from the start of the file
+        U32 mBodySize;
+        U32 mBodyChecksum;  // LLCRC of the body, checked on first use
+    };
+
 protected:
     ~LLVOCacheEntry();
 public:
     LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-    LLVOCacheEntry(LLAPRFile* apr_file);
+    // The body is not copied; the entry points into the mapping until
+    // it is updated or detached.
+    LLVOCacheEntry(const std::shared_ptr<LLMappedFile>& mapping, const FileRecord& record);
     LLVOCacheEntry();
 
     void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -125,8 +149,12 @@ class LLVOCacheEntry final
     F32 getSceneContribution() const             { return mSceneContrib;}
 
     void dump() const;
-    S32 writeToBuffer(U8 *data_buffer) const;
+    // Fill in everything but the body offset. Returns false if the body
+    // is invalid or too large to be cached.
+    bool fillFileRecord(FileRecord& record) const;
+    const U8* getBody() const { return mDP.getBuffer(); }
     LLDataPackerBinaryBuffer *getDP() const;
+
     void recordHit();
     void recordDupe() { mDupeCount++; }
 
@@ -157,6 +185,7 @@ class LLVOCacheEntry final
 
 private:
     void updateParentBoundingInfo(const LLVOCacheEntry* child);
+    void releaseBody() const;
 
 public:
     typedef std::map<U32, LLPointer<LLVOCacheEntry> >      vocache_entry_map_t;
@@ -181,6 +210,10 @@ class LLVOCacheEntry final
     S32                         mCRCChangeCount;
     mutable LLDataPackerBinaryBuffer    mDP;
     U8                          *mBuffer;
+    U32                         mBodyChecksum;
+    // Set when mDP points into a mapped cache file instead of mBuffer
+    mutable std::shared_ptr<LLMappedFile> mMapping;
+    mutable bool                mNeedsValidation;
 
     F32                         mSceneContrib; //projected scene contributuion of this object.
     U32                         mState; //high 16 bits reserved for special use.
@@ -246,7 +279,9 @@ class LLVOCachePartition final : public LLViewerOctreePartition
 };
 
 //
-//Note: LLVOCache is not thread-safe
+//Note: LLVOCache is not thread-safe. Only the file IO runs on its worker
+//thread: region cache files are read ahead of time and written behind the
+//main thread, see prefetchFromCache() and writeToCache().
 //
 class LLVOCache final : public LLParamSingleton<LLVOCache>
 {
@@ -285,11 +320,39 @@ class LLVOCache final : public LLParamSingleton<LLVOCache>
     typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
     typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
 
+    // Cache files of a region as read by the worker thread.
+    struct CacheReadResult
+    {
+        LLUUID mCacheID;
+        LLVOCacheEntry::vocache_entry_map_t mEntries;
+        U32 mNumEntries = 0;
+        bool mSuccess = false;
+
+        LLUUID mExtrasCacheID;
+        std::vector<LLSD> mExtras;
+        bool mExtrasSuccess = false;
+    };
+
+    struct PendingRead
+    {
+        std::shared_ptr<CacheReadResult> mResult;
+        std::future<void> mDone;
+    };
+    typedef std::map<U64, PendingRead> pending_read_map_t;
+
 public:
     // We need this init to be separate from constructor, since we might construct cache, purge it, then init.
     void initCache(ELLPath location, U32 size, U32 cache_version);
     void removeCache(ELLPath location, bool started = false) ;
 
+    // Start reading the cache files of a region on the worker thread. The
+    // result is picked up by readFromCache() and readGenericExtrasFromCache().
+    void prefetchFromCache(U64 handle);
+    // Forget a prefetch for a region that never asked for its cache.
+    void discardPrefetch(U64 handle);
+    // Block until every queued cache file write has reached the disk.
+    void flushPendingWrites();
+
     bool readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
     void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
 
@@ -315,6 +378,23 @@ class LLVOCache final : public LLParamSingleton<LLVOCache>
     void purgeEntries(U32 size);
     BOOL updateEntry(const HeaderEntryInfo* entry);
 
+    // wait for the prefetch of handle, starting it if needed. Returns nullptr if the region has no cache.
+    CacheReadResult* getReadResult(U64 handle);
+    void waitForPendingIO();
+
+    // Write-behind buffer. Writes to the same file that are still queued are coalesced.
+    void queueWrite(const std::string& filename, std::vector<U8>&& data);
+    void queueRemove(const std::string& filename);
+    void flushWrite(const std::string& filename);
+    bool postIO(const std::function<void()>& work);
+
+    // File IO, safe to call from the worker thread.
+    static void readCacheFiles(const std::string& filename, const std::string& extras_filename, CacheReadResult& result);
+    static bool readCacheFile(const std::string& filename, CacheReadResult& result);
+    static bool readExtrasFile(const std::string& filename, CacheReadResult& result);
+    // write data to a temporary file and swap it in for filename
+    static bool writeCacheFile(const std::string& filename, const std::vector<U8>& data);
+
 private:
     bool                 mEnabled;
     bool                 mInitialized ;
@@ -327,6 +407,16 @@ class LLVOCache final : public LLParamSingleton<LLVOCache>
     LLVolatileAPRPool*   mLocalAPRFilePoolp ;
     header_entry_queue_t mHeaderEntryQueue;
     handle_entry_map_t   mHandleEntryMap;
+
+    std::unique_ptr<LL::ThreadPool> mThreadPool;
+    pending_read_map_t   mPendingReads;
+
+    std::mutex           mWriteMutex;
+    std::condition_variable mWriteCondition;
+    std::map<std::string, std::vector<U8>> mPendingWrites;
+    size_t               mPendingWriteBytes;
+    size_t               mMaxPendingWriteBytes;
+    U32                  mWritesInFlight;
 };
 
 #endif
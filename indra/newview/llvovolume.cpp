@@ -30,7 +30,9 @@
 
 #include "llvovolume.h"
 
+#include <atomic>
 #include <sstream>
+#include <thread>
 
 #include "alglmath.h"
 #include "llviewercontrol.h"
@@ -91,6 +93,7 @@
 #include "llavatarappearancedefines.h"
 #include "llgltfmateriallist.h"
 #include "lltoolmgr.h"
+#include "threadpool.h"
 // [RLVa:KB] - Checked: RLVa-2.0.0
 #include "rlvactions.h"
 #include "rlvlocks.h"
@@ -331,6 +334,8 @@ void LLVOVolume::markDead()
 // static
 void LLVOVolume::initClass()
 {
+    LLVolumeGeometryManager::initClass();
+
     // gSavedSettings better be around
     if (gSavedSettings.getBOOL("PrimMediaMasterEnabled"))
     {
@@ -349,6 +354,7 @@ void LLVOVolume::initClass()
 // static
 void LLVOVolume::cleanupClass()
 {
+    LLVolumeGeometryManager::cleanupClass();
     sObjectMediaClient = NULL;
     sObjectMediaNavigateClient = NULL;
 }
@@ -5269,6 +5275,182 @@ void LLVolumeGeometryManager::freeFaces()
     }
 }
 
+namespace
+{
+    // One face's vertex generation, deferred out of genDrawInfo()
+    struct FaceGeometryJob
+    {
+        LLFace* mFace;
+        LLVOVolume* mVObj;
+        LLPointer<LLVolume> mVolume;
+        U32 mTEOffset;
+        U16 mIndexOffset;
+    };
+
+    // A buffer's mapped region bookkeeping isn't thread safe, so each
+    // buffer is filled by a single thread, one batch per buffer.
+    struct BufferGeometryJob
+    {
+        LLPointer<LLVertexBuffer> mBuffer;
+        std::vector<FaceGeometryJob> mFaces;
+        U32 mVertexCount = 0;
+    };
+
+    struct GeometryBatch
+    {
+        std::vector<BufferGeometryJob> mBuffers;
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<size_t> mDone{ 0 };
+
+        // Claim and fill buffers until none are left
+        void run()
+        {
+            for (size_t i = mNext++; i < mBuffers.size(); i = mNext++)
+            {
+                for (const FaceGeometryJob& job : mBuffers[i].mFaces)
+                {
+                    if (!job.mFace->getGeometryVolume(*job.mVolume, job.mTEOffset,
+                        job.mVObj->getRelativeXform(), job.mVObj->getRelativeXformInvTrans(), job.mIndexOffset, true))
+                    {
+                        LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+                    }
+                }
+                ++mDone;
+            }
+        }
+    };
+
+    std::shared_ptr<GeometryBatch> sPendingGeometry;
+    std::unique_ptr<LL::WorkStealingThreadPool> sGeometryPool;
+
+    // below this many queued vertices waking the pool costs more than it saves
+    constexpr U32 MIN_PARALLEL_GEOMETRY_VERTICES = 4096;
+}
+
+S32 LLVolumeGeometryManager::sGeometryBatchDepth = 0;
+
+//static
+void LLVolumeGeometryManager::initClass()
+{
+    U32 threads = gSavedSettings.getU32("AlchemyGeometryRebuildThreads");
+    if (threads > 0 && !sGeometryPool)
+    {
+        sGeometryPool.reset(new LL::WorkStealingThreadPool("GeometryRebuild", threads));
+        sGeometryPool->start();
+    }
+}
+
+//static
+void LLVolumeGeometryManager::cleanupClass()
+{
+    flushGeometry();
+    if (sGeometryPool)
+    {
+        sGeometryPool->close();
+        sGeometryPool.reset();
+    }
+}
+
+//static
+void LLVolumeGeometryManager::beginGeometryBatch()
+{
+    ++sGeometryBatchDepth;
+}
+
+//static
+void LLVolumeGeometryManager::endGeometryBatch()
+{
+    llassert(sGeometryBatchDepth > 0);
+    if (--sGeometryBatchDepth == 0)
+    {
+        flushGeometry();
+    }
+}
+
+//static
+void LLVolumeGeometryManager::queueBuffer(LLVertexBuffer* buffer)
+{
+    if (!sPendingGeometry)
+    {
+        sPendingGeometry = std::make_shared<GeometryBatch>();
+    }
+    sPendingGeometry->mBuffers.emplace_back();
+    sPendingGeometry->mBuffers.back().mBuffer = buffer;
+}
+
+//static
+void LLVolumeGeometryManager::queueFaceGeometry(LLFace* facep, LLVOVolume* vobj, LLVolume* volume, U32 te_idx, U16 index_offset)
+{
+    llassert(sPendingGeometry && !sPendingGeometry->mBuffers.empty());
+    BufferGeometryJob& job = sPendingGeometry->mBuffers.back();
+    llassert(job.mBuffer == facep->getVertexBuffer());
+
+    // getGeometryVolume() generates missing tangents on the shared volume,
+    // which other objects' faces may be reading concurrently; do it here
+    const LLTextureEntry* te = facep->getTextureEntry();
+    if (te && (te->getBumpmap() || te->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT ||
+        job.mBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT) || job.mBuffer->hasDataType(LLVertexBuffer::TYPE_TEXCOORD1)))
+    {
+        if (vobj->getVolume() && (S32)te_idx < vobj->getVolume()->getNumVolumeFaces())
+        {
+            vobj->getVolume()->genTangents(te_idx);
+        }
+    }
+
+    job.mFaces.push_back({ facep, vobj, volume, te_idx, index_offset });
+    job.mVertexCount += facep->getGeomCount();
+}
+
+//static
+void LLVolumeGeometryManager::flushGeometry()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+    if (!sPendingGeometry)
+    {
+        return;
+    }
+
+    std::shared_ptr<GeometryBatch> batch;
+    batch.swap(sPendingGeometry);
+
+    U32 vertex_count = 0;
+    for (const BufferGeometryJob& job : batch->mBuffers)
+    {
+        vertex_count += job.mVertexCount;
+    }
+
+    size_t buffer_count = batch->mBuffers.size();
+    if (sGeometryPool && buffer_count > 1 && vertex_count >= MIN_PARALLEL_GEOMETRY_VERTICES)
+    {
+        // Helpers hold the batch, so one that only starts after the work
+        // is done still has something to look at
+        size_t helpers = llmin(sGeometryPool->getWidth(), buffer_count - 1);
+        auto& queue = sGeometryPool->getQueue();
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            queue.post([batch]() { batch->run(); });
+        }
+    }
+
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("flushGeometry - fill");
+        batch->run();
+        while (batch->mDone < buffer_count)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    {
+        // only the upload needs GL
+        LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("flushGeometry - upload");
+        for (BufferGeometryJob& job : batch->mBuffers)
+        {
+            job.mBuffer->unmapBuffer();
+        }
+    }
+}
+
 void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep, U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -6048,6 +6230,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
     U32 extra_mask = LLVertexBuffer::MAP_TEXTURE_INDEX;
     BOOL alpha_sort = TRUE;
     BOOL rigged = FALSE;
+    beginGeometryBatch();
     for (int i = 0; i < 2; ++i) //two sets, static and rigged)
     {
         geometryBytes += genDrawInfo(group, simple_mask | extra_mask, sSimpleFaces[i], simple_count[i], FALSE, batch_textures, rigged);
@@ -6063,6 +6246,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
         extra_mask |= LLVertexBuffer::MAP_WEIGHT4;
         rigged = TRUE;
     }
+    endGeometryBatch();
 
     group->mGeometryBytes = geometryBytes;
 
@@ -6448,6 +6632,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
         {
             geometryBytes += buffer->getSize() + buffer->getIndicesSize();
             buffer_map[mask][*face_iter].push_back(buffer);
+            queueBuffer(buffer);
         }
 
         //add face geometry
@@ -6493,16 +6678,21 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
                     U32 te_idx = facep->getTEOffset();
 
-                    if (!facep->getGeometryVolume(*volume, te_idx,
-                        vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
-                    {
-                        LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
-                    }
-
                     if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
                     {
+                        // the relative xform is only swapped for the copy, so it can't be deferred
+                        if (!facep->getGeometryVolume(*volume, te_idx,
+                            vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
+                        {
+                            LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+                        }
+
                         vobj->updateRelativeXform(false);
                     }
+                    else
+                    {
+                        queueFaceGeometry(facep, vobj, volume, te_idx, index_offset);
+                    }
                 }
             }
 
@@ -6849,11 +7039,6 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
             ++face_iter;
         }
-
-        if (buffer)
-        {
-            buffer->unmapBuffer();
-        }
     }
 
     auto& mask_buffer_map = buffer_map[mask];
@@ -126,6 +126,11 @@
 #include "SMAA/AreaTex.h"
 #include "SMAA/SearchTex.h"
 #include "llimagepng.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
 
 extern BOOL gSnapshot;
 bool gShiftFrame = false;
@@ -306,7 +311,134 @@ bool    LLPipeline::sUseDepthTexture = false;
 // EventHost API LLPipeline listener.
 static LLPipelineListener sPipelineListener;
 
-static LLCullResult* sCull = NULL;
+// Per thread: cull workers point it at their task's shard while they run
+static thread_local LLCullResult* sCull = NULL;
+
+namespace
+{
+    // What one cull task found.  Workers never touch the frame's
+    // LLCullResult or the pipeline queues; anything that has to happen on
+    // the main thread is recorded here and replayed when the shards are
+    // merged, in task order, so the result doesn't depend on scheduling.
+    struct LLCullShard
+    {
+        LLCullResult mResult;
+        std::vector<std::pair<LLSpatialGroup*, S32> > mDeferred; // subtrees waiting on an occlusion readback
+        std::vector<LLSpatialGroup*> mRebuild;                   // markRebuild() calls
+        S32 mVisibleNodes = 0;
+
+        void reset()
+        {
+            mResult.clear();
+            mDeferred.clear();
+            mRebuild.clear();
+            mVisibleNodes = 0;
+        }
+    };
+
+    struct LLCullBatch
+    {
+        std::function<void(size_t)> mTask;
+        size_t mCount = 0;
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<size_t> mDone{ 0 };
+
+        void run();
+    };
+
+    thread_local LLCullShard* sCullShard = nullptr;
+    std::unique_ptr<LL::WorkStealingThreadPool> sCullPool;
+    std::vector<std::unique_ptr<LLCullShard> > sCullShards;
+
+    void LLCullBatch::run()
+    {
+        for (size_t i = mNext++; i < mCount; i = mNext++)
+        {
+            LLCullShard* shard = sCullShards[i].get();
+            LLCullResult* cull = sCull;
+            sCull = &shard->mResult;
+            sCullShard = shard;
+            mTask(i);
+            sCullShard = nullptr;
+            sCull = cull;
+            ++mDone;
+        }
+    }
+
+    // Run task(0..count-1) across the cull pool and this thread, each with
+    // its own shard, then merge the shards into sCull in task order.
+    void run_cull_tasks(size_t count, LLCamera& camera, const std::function<void(size_t)>& task)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+        if (!sCullPool || count < 2)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        while (sCullShards.size() < count)
+        {
+            sCullShards.emplace_back(new LLCullShard);
+        }
+
+        // helpers hold the batch, one that starts late finds nothing left
+        auto batch = std::make_shared<LLCullBatch>();
+        batch->mTask = task;
+        batch->mCount = count;
+        size_t helpers = llmin(sCullPool->getWidth(), count - 1);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            sCullPool->getQueue().post([batch]() { batch->run(); });
+        }
+        batch->run();
+        while (batch->mDone < count)
+        {
+            std::this_thread::yield();
+        }
+
+        LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("cull merge");
+        for (size_t i = 0; i < count; ++i)
+        {
+            LLCullShard* shard = sCullShards[i].get();
+            sCull->append(shard->mResult);
+            gPipeline.mNumVisibleNodes += shard->mVisibleNodes;
+            for (const auto& deferred : shard->mDeferred)
+            {
+                deferred.first->getSpatialPartition()->cullSubtree(camera, deferred.first, deferred.second);
+            }
+            for (LLSpatialGroup* group : shard->mRebuild)
+            {
+                gPipeline.markRebuild(group);
+            }
+            shard->reset();
+        }
+    }
+}
+
+//static
+void LLPipeline::initCullThreads()
+{
+    U32 threads = gSavedSettings.getU32("AlchemyCullThreads");
+    if (threads > 0 && !sCullPool)
+    {
+        sCullPool.reset(new LL::WorkStealingThreadPool("Cull", threads));
+        sCullPool->start();
+    }
+}
+
+//static
+void LLPipeline::cleanupCullThreads()
+{
+    if (sCullPool)
+    {
+        sCullPool->close();
+        sCullPool.reset();
+    }
+    sCullShards.clear();
+}
 
 void validate_framebuffer_object();
 
@@ -370,6 +502,8 @@ LLPipeline::LLPipeline() :
     mOldRenderDebugMask(0),
     mMeshDirtyQueryObject(0),
     mGroupQ1Locked(false),
+    mGeomUpdateMaxTime(0.f),
+    mDeferBridgeCull(false),
     mResetVertexBuffers(false),
     mLastRebuildPool(NULL),
     mLightMask(0),
@@ -416,6 +550,8 @@ void LLPipeline::init()
     sRenderAttachedLights = gSavedSettings.getBOOL("RenderAttachedLights");
     sRenderAttachedParticles = gSavedSettings.getBOOL("RenderAttachedParticles");
 
+    initCullThreads();
+
     mInitialized = true;
 
     stop_glerror();
@@ -597,6 +733,8 @@ void LLPipeline::init()
     connectRefreshCachedSettingsSafe("RenderFocusPointLocked");
     connectRefreshCachedSettingsSafe("RenderFocusPointFollowsPointer");
     connectRefreshCachedSettingsSafe("RenderDepthOfFieldNearBlur");
+    connectRefreshCachedSettingsSafe("AlchemyFlatOctreePartitions");
+    connectRefreshCachedSettingsSafe("AlchemyMultiDrawIndirect");
 }
 
 LLPipeline::~LLPipeline()
@@ -607,6 +745,8 @@ void LLPipeline::cleanup()
 {
     assertInitialized();
 
+    cleanupCullThreads();
+
     mGroupQ1.clear() ;
     mGroupSaveQ1.clear();
     mMeshDirtyGroup.clear();
@@ -1052,6 +1192,8 @@ void LLPipeline::refreshCachedSettings()
             (!gUseWireframe
             && LLFeatureManager::getInstance()->isFeatureAvailable("UseOcclusion")
             && gSavedSettings.getBOOL("UseOcclusion")) ? 2 : 0;
+    LLSpatialPartition::sFlatOctreeMask = gSavedSettings.getU32("AlchemyFlatOctreePartitions");
+    LLVertexBuffer::sMultiDrawIndirect = gSavedSettings.getBOOL("AlchemyMultiDrawIndirect");
 
     WindLightUseAtmosShaders = TRUE; // DEPRECATED -- gSavedSettings.getBOOL("WindLightUseAtmosShaders");
     RenderDeferred = TRUE; // DEPRECATED -- gSavedSettings.getBOOL("RenderDeferred");
@@ -2454,11 +2596,12 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
 
     sCull->clear();
 
-    for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin();
-            iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+    // Each partition is its own task.  The VO cache trees update their
+    // region and the camera's region planes, so they stay on this thread.
+    static std::vector<LLSpatialPartition*> partitions;
+    partitions.clear();
+    for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
     {
-        LLViewerRegion* region = *iter;
-
         for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
         {
             LLSpatialPartition* part = region->getSpatialPartition(i);
@@ -2466,11 +2609,15 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
             {
                 if (hasRenderType(part->mDrawableType))
                 {
-                    part->cull(camera);
+                    partitions.push_back(part);
                 }
             }
         }
+    }
+    run_cull_tasks(partitions.size(), camera, [&camera](size_t i) { partitions[i]->cull(camera); });
 
+    for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
+    {
         //scan the VO Cache tree
         LLVOCachePartition* vo_part = region->getVOCachePartition();
         if(vo_part)
@@ -2531,7 +2678,25 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
         // an occlusion query to find out if it's an occluder
         markOccluder(group);
     }
-    mNumVisibleNodes++;
+
+    if (sCullShard)
+    {
+        sCullShard->mVisibleNodes++;
+    }
+    else
+    {
+        mNumVisibleNodes++;
+    }
+}
+
+bool LLPipeline::deferCull(LLSpatialGroup* group, S32 res)
+{
+    if (!sCullShard || !group->needsOcclusionReadback())
+    {
+        return false;
+    }
+    sCullShard->mDeferred.emplace_back(group, res);
+    return true;
 }
 
 void LLPipeline::markOccluder(LLSpatialGroup* group)
@@ -2747,16 +2912,51 @@ void LLPipeline::rebuildPriorityGroups()
 
     gMeshRepo.notifyLoadedMeshes();
 
+    // Groups go through in geometry batches so the vertex generation of a
+    // batch is spread over the rebuild threads.  Once the updateGeom()
+    // budget is spent the rest wait for the next frame, still flagged
+    // IN_BUILD_Q1, except for HUD groups which can't be left stale.
+    const size_t GROUPS_PER_BATCH = 16;
+
     mGroupQ1Locked = true;
-    // Iterate through all drawables on the priority build queue,
-    for (LLSpatialGroup* group : mGroupQ1)
+    size_t count = mGroupQ1.size();
+    size_t built = 0;
+    while (built < count)
     {
-        group->rebuildGeom();
-        group->clearState(LLSpatialGroup::IN_BUILD_Q1);
+        LLVolumeGeometryManager::beginGeometryBatch();
+        for (size_t end = llmin(built + GROUPS_PER_BATCH, count); built < end; ++built)
+        {
+            LLSpatialGroup* group = mGroupQ1[built];
+            group->rebuildGeom();
+            group->clearState(LLSpatialGroup::IN_BUILD_Q1);
+        }
+        LLVolumeGeometryManager::endGeometryBatch();
+
+        if (mGeomUpdateMaxTime > 0.f && update_timer.getElapsedTimeF32() > mGeomUpdateMaxTime)
+        {
+            break;
+        }
     }
 
+    LLSpatialGroup::sg_vector_t deferred;
+    LLVolumeGeometryManager::beginGeometryBatch();
+    for (size_t i = built; i < count; ++i)
+    {
+        LLSpatialGroup* group = mGroupQ1[i];
+        if (group->isHUDGroup())
+        {
+            group->rebuildGeom();
+            group->clearState(LLSpatialGroup::IN_BUILD_Q1);
+        }
+        else
+        {
+            deferred.push_back(group);
+        }
+    }
+    LLVolumeGeometryManager::endGeometryBatch();
+
     mGroupSaveQ1 = mGroupQ1;
-    mGroupQ1.clear();
+    mGroupQ1.swap(deferred);
     mGroupQ1Locked = false;
 
 }
@@ -2772,6 +2972,8 @@ void LLPipeline::updateGeom(F32 max_dtime)
         return;
     }
 
+    mGeomUpdateMaxTime = max_dtime;
+
     assertInitialized();
 
     // notify various object types to reset internal cost metrics, etc.
@@ -2838,6 +3040,17 @@ void LLPipeline::markVisible(LLDrawable *drawablep, LLCamera& camera)
                 }
             }
             sCull->pushBridge((LLSpatialBridge*) drawablep);
+
+            if (mDeferBridgeCull)
+            {   // stateSort() culls the bridge's own tree as a task, whether
+                // its avatar lets it draw is decided here on the main thread
+                LLSpatialBridge* bridge = (LLSpatialBridge*) drawablep;
+                if (bridge->isCullable())
+                {
+                    mDeferredBridges.push_back(bridge);
+                }
+                return;
+            }
         }
         else
         {
@@ -3006,6 +3219,12 @@ void LLPipeline::markMeshDirty(LLSpatialGroup* group)
 
 void LLPipeline::markRebuild(LLSpatialGroup* group)
 {
+    if (sCullShard)
+    {   // cull worker, the build queue belongs to the main thread
+        sCullShard->mRebuild.push_back(group);
+        return;
+    }
+
     if (group && !group->isDead() && group->getSpatialPartition())
     {
         if (!group->hasState(LLSpatialGroup::IN_BUILD_Q1))
@@ -3057,6 +3276,13 @@ void LLPipeline::stateSort(LLCamera& camera, LLCullResult &result)
     //LLVertexBuffer::unbind();
 
     grabReferences(result);
+
+    // Bridges found below are culled afterwards, one task each.  Culling a
+    // bridge only appends past where this loop stops, so merging them in
+    // order leaves the visible and drawable group lists as inline culling
+    // would; only occluders may interleave differently.
+    mDeferBridgeCull = sCullPool != nullptr;
+    mDeferredBridges.clear();
     for (LLCullResult::sg_iterator iter = sCull->beginDrawableGroups(), iter_end = sCull->endDrawableGroups(); iter != iter_end; ++iter)
     {
         LLSpatialGroup* group = *iter;
@@ -3084,6 +3310,10 @@ void LLPipeline::stateSort(LLCamera& camera, LLCullResult &result)
         }
     }
 
+    mDeferBridgeCull = false;
+    run_cull_tasks(mDeferredBridges.size(), camera, [this, &camera](size_t i) { mDeferredBridges[i]->cullTree(camera); });
+    mDeferredBridges.clear();
+
     if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD && !gCubeSnapshot)
     {
         LLSpatialGroup* last_group = NULL;
@@ -3499,6 +3729,7 @@ void LLPipeline::postSort(LLCamera &camera)
     if (!gCubeSnapshot)
     {
         // rebuild drawable geometry
+        LLVolumeGeometryManager::beginGeometryBatch();
         for (LLCullResult::sg_iterator i = sCull->beginDrawableGroups(); i != sCull->endDrawableGroups(); ++i)
         {
             LLSpatialGroup *group = *i;
@@ -3511,6 +3742,7 @@ void LLPipeline::postSort(LLCamera &camera)
                 group->rebuildGeom();
             }
         }
+        LLVolumeGeometryManager::endGeometryBatch();
         LL_PUSH_CALLSTACKS();
         // rebuild groups
         sCull->assertDrawMapsEmpty();
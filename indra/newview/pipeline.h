@@ -173,6 +173,10 @@ class LLPipeline
 
     void        doOcclusion(LLCamera& camera);
     void        markNotCulled(LLSpatialGroup* group, LLCamera &camera);
+    // On a cull worker, hand a subtree whose occlusion query must be read
+    // back (res is its parent's frustum result) to the main thread.
+    // Returns false when the caller should carry on as usual.
+    bool        deferCull(LLSpatialGroup* group, S32 res);
     void        markMoved(LLDrawable *drawablep, bool damped_motion = false);
     void        markShift(LLDrawable *drawablep);
     void        markTextured(LLDrawable *drawablep);
@@ -245,6 +249,8 @@ class LLPipeline
     void processPartitionQ();
     void updateGeom(F32 max_dtime);
     void updateGL();
+    static void initCullThreads();
+    static void cleanupCullThreads();
     void rebuildPriorityGroups();
     void rebuildGroups();
     void clearRebuildGroups();
@@ -839,6 +845,11 @@ class LLPipeline
 
     bool mGroupQ1Locked;
 
+    F32 mGeomUpdateMaxTime; // updateGeom()'s budget, also caps rebuildPriorityGroups()
+
+    bool mDeferBridgeCull; // stateSort() collects bridges to cull them in parallel
+    std::vector<LLSpatialBridge*> mDeferredBridges;
+
     bool mResetVertexBuffers; //if true, clear vertex buffers on next update
 
     LLViewerObject::vobj_list_t     mCreateQ;